@@ -0,0 +1,556 @@
+// Generated by tools/can_codegen from src/canbus/tractor.dbc - do not edit
+
+#ifndef CAN_MESSAGES_H
+#define CAN_MESSAGES_H
+
+#include <stdint.h>
+
+// Frame words: byte i of an Intel (little-endian) frame is bits 8i..8i+7
+// of the LE word; byte i of a Motorola frame is bits 56-8i..63-8i of the
+// BE word. Loops have constant trip counts and unroll.
+static inline uint64_t can_load_le(const uint8_t* data, int dlc) {
+    uint64_t word = 0;
+    for (int i = 0; i < dlc; i++) word |= (uint64_t)data[i] << (8 * i);
+    return word;
+}
+
+static inline uint64_t can_load_be(const uint8_t* data, int dlc) {
+    uint64_t word = 0;
+    for (int i = 0; i < dlc; i++) word |= (uint64_t)data[i] << (56 - 8 * i);
+    return word;
+}
+
+static inline void can_store(uint8_t* data, int dlc, uint64_t le, uint64_t be) {
+    for (int i = 0; i < dlc; i++) data[i] = (uint8_t)(le >> (8 * i)) | (uint8_t)(be >> (56 - 8 * i));
+}
+
+static inline int64_t can_sign_extend(uint64_t raw, int length) {
+    return (int64_t)(raw << (64 - length)) >> (64 - length);
+}
+
+// Physical value to raw: scale, clamp to the signal range and round to
+// nearest. The compares compile to min/max instructions (NaN goes to
+// the minimum) and rounding is a truncation of a value made
+// non-negative, so no libm calls and no branches.
+static inline uint64_t can_raw_f(float value, float offset, float inv_scale, float raw_min, float raw_max) {
+    float x = (value - offset) * inv_scale;
+    x = x > raw_min ? x : raw_min;
+    x = x < raw_max ? x : raw_max;
+    return (uint64_t)((int64_t)(x - raw_min + 0.5f) + (int64_t)raw_min);
+}
+
+static inline uint64_t can_raw_d(double value, double offset, double inv_scale, double raw_min, double raw_max) {
+    double x = (value - offset) * inv_scale;
+    x = x > raw_min ? x : raw_min;
+    x = x < raw_max ? x : raw_max;
+    return (uint64_t)((int64_t)(x - raw_min + 0.5) + (int64_t)raw_min);
+}
+
+// EngineStatus (0x100, 8 bytes)
+#define CAN_ID_ENGINE_STATUS 0x100
+#define CAN_DLC_ENGINE_STATUS 8
+
+typedef struct {
+    float engine_speed;             // rpm, 0..8000
+    float target_speed;             // rpm, 0..8000
+    float engine_load;              // %, 0..125
+    float coolant_temp;             // degC, -40..210
+    float fuel_rate;                // L/h, 0..3276.75
+} CanEngineStatus;
+
+static inline void can_pack_engine_status(uint8_t data[CAN_DLC_ENGINE_STATUS], const CanEngineStatus* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_f(msg->engine_speed, 0.0f, 1.0f, 0.0f, 8000.0f) & 0xFFFFull) << 0;
+    le |= (can_raw_f(msg->target_speed, 0.0f, 1.0f, 0.0f, 8000.0f) & 0xFFFFull) << 16;
+    le |= (can_raw_f(msg->engine_load, 0.0f, 2.0f, 0.0f, 250.0f) & 0xFFull) << 32;
+    le |= (can_raw_f(msg->coolant_temp, -40.0f, 1.0f, 0.0f, 250.0f) & 0xFFull) << 40;
+    le |= (can_raw_f(msg->fuel_rate, 0.0f, 20.0f, 0.0f, 65535.0f) & 0xFFFFull) << 48;
+    can_store(data, CAN_DLC_ENGINE_STATUS, le, be);
+}
+
+static inline void can_unpack_engine_status(const uint8_t data[CAN_DLC_ENGINE_STATUS], CanEngineStatus* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_ENGINE_STATUS);
+    msg->engine_speed = (float)((le >> 0) & 0xFFFFull) * 1.0f + 0.0f;
+    msg->target_speed = (float)((le >> 16) & 0xFFFFull) * 1.0f + 0.0f;
+    msg->engine_load = (float)((le >> 32) & 0xFFull) * 0.5f + 0.0f;
+    msg->coolant_temp = (float)((le >> 40) & 0xFFull) * 1.0f + -40.0f;
+    msg->fuel_rate = (float)((le >> 48) & 0xFFFFull) * 0.05f + 0.0f;
+}
+
+// HydraulicStatus (0x200, 8 bytes)
+#define CAN_ID_HYDRAULIC_STATUS 0x200
+#define CAN_DLC_HYDRAULIC_STATUS 8
+
+typedef struct {
+    float system_pressure;          // psi, 0..6553.5
+    float flow_rate;                // gpm, 0..655.35
+    float oil_temp;                 // degC, -40..210
+    float reservoir_level;          // %, 0..100
+} CanHydraulicStatus;
+
+static inline void can_pack_hydraulic_status(uint8_t data[CAN_DLC_HYDRAULIC_STATUS], const CanHydraulicStatus* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_f(msg->system_pressure, 0.0f, 10.0f, 0.0f, 65535.0f) & 0xFFFFull) << 0;
+    le |= (can_raw_f(msg->flow_rate, 0.0f, 100.0f, 0.0f, 65535.0f) & 0xFFFFull) << 16;
+    le |= (can_raw_f(msg->oil_temp, -40.0f, 1.0f, 0.0f, 250.0f) & 0xFFull) << 32;
+    le |= (can_raw_f(msg->reservoir_level, 0.0f, 2.5f, 0.0f, 250.0f) & 0xFFull) << 40;
+    can_store(data, CAN_DLC_HYDRAULIC_STATUS, le, be);
+}
+
+static inline void can_unpack_hydraulic_status(const uint8_t data[CAN_DLC_HYDRAULIC_STATUS], CanHydraulicStatus* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_HYDRAULIC_STATUS);
+    msg->system_pressure = (float)((le >> 0) & 0xFFFFull) * 0.1f + 0.0f;
+    msg->flow_rate = (float)((le >> 16) & 0xFFFFull) * 0.01f + 0.0f;
+    msg->oil_temp = (float)((le >> 32) & 0xFFull) * 1.0f + -40.0f;
+    msg->reservoir_level = (float)((le >> 40) & 0xFFull) * 0.4f + 0.0f;
+}
+
+// HydraulicFlowShare (0x201, 8 bytes)
+#define CAN_ID_HYDRAULIC_FLOW_SHARE 0x201
+#define CAN_DLC_HYDRAULIC_FLOW_SHARE 8
+
+typedef struct {
+    float steering_share;           // %, 0..100
+    float pto_clutch_share;         // %, 0..100
+    float hitch_share;              // %, 0..100
+    float scv1_share;               // %, 0..100
+    float scv2_share;               // %, 0..100
+    float scv3_share;               // %, 0..100
+    float scv4_share;               // %, 0..100
+    uint8_t starved_mask;           // Bit per hydraulic consumer, steering first
+} CanHydraulicFlowShare;
+
+static inline void can_pack_hydraulic_flow_share(uint8_t data[CAN_DLC_HYDRAULIC_FLOW_SHARE], const CanHydraulicFlowShare* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_f(msg->steering_share, 0.0f, 1.0f, 0.0f, 100.0f) & 0xFFull) << 0;
+    le |= (can_raw_f(msg->pto_clutch_share, 0.0f, 1.0f, 0.0f, 100.0f) & 0xFFull) << 8;
+    le |= (can_raw_f(msg->hitch_share, 0.0f, 1.0f, 0.0f, 100.0f) & 0xFFull) << 16;
+    le |= (can_raw_f(msg->scv1_share, 0.0f, 1.0f, 0.0f, 100.0f) & 0xFFull) << 24;
+    le |= (can_raw_f(msg->scv2_share, 0.0f, 1.0f, 0.0f, 100.0f) & 0xFFull) << 32;
+    le |= (can_raw_f(msg->scv3_share, 0.0f, 1.0f, 0.0f, 100.0f) & 0xFFull) << 40;
+    le |= (can_raw_f(msg->scv4_share, 0.0f, 1.0f, 0.0f, 100.0f) & 0xFFull) << 48;
+    le |= ((uint64_t)msg->starved_mask & 0xFFull) << 56;
+    can_store(data, CAN_DLC_HYDRAULIC_FLOW_SHARE, le, be);
+}
+
+static inline void can_unpack_hydraulic_flow_share(const uint8_t data[CAN_DLC_HYDRAULIC_FLOW_SHARE], CanHydraulicFlowShare* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_HYDRAULIC_FLOW_SHARE);
+    msg->steering_share = (float)((le >> 0) & 0xFFull) * 1.0f + 0.0f;
+    msg->pto_clutch_share = (float)((le >> 8) & 0xFFull) * 1.0f + 0.0f;
+    msg->hitch_share = (float)((le >> 16) & 0xFFull) * 1.0f + 0.0f;
+    msg->scv1_share = (float)((le >> 24) & 0xFFull) * 1.0f + 0.0f;
+    msg->scv2_share = (float)((le >> 32) & 0xFFull) * 1.0f + 0.0f;
+    msg->scv3_share = (float)((le >> 40) & 0xFFull) * 1.0f + 0.0f;
+    msg->scv4_share = (float)((le >> 48) & 0xFFull) * 1.0f + 0.0f;
+    msg->starved_mask = (uint8_t)((le >> 56) & 0xFFull);
+}
+
+// PtoCommand (0x220, 8 bytes)
+#define CAN_ID_PTO_COMMAND 0x220
+#define CAN_DLC_PTO_COMMAND 8
+
+typedef struct {
+    uint8_t engage;
+    uint16_t target_speed;
+} CanPtoCommand;
+
+static inline void can_pack_pto_command(uint8_t data[CAN_DLC_PTO_COMMAND], const CanPtoCommand* msg) {
+    uint64_t le = 0, be = 0;
+    le |= ((uint64_t)msg->engage & 0xFFull) << 0;
+    be |= ((uint64_t)msg->target_speed & 0xFFFFull) << 40;
+    can_store(data, CAN_DLC_PTO_COMMAND, le, be);
+}
+
+static inline void can_unpack_pto_command(const uint8_t data[CAN_DLC_PTO_COMMAND], CanPtoCommand* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_PTO_COMMAND);
+    uint64_t be = can_load_be(data, CAN_DLC_PTO_COMMAND);
+    msg->engage = (uint8_t)((le >> 0) & 0xFFull);
+    msg->target_speed = (uint16_t)((be >> 40) & 0xFFFFull);
+}
+
+// PtoStatus (0x221, 8 bytes)
+#define CAN_ID_PTO_STATUS 0x221
+#define CAN_DLC_PTO_STATUS 8
+
+typedef struct {
+    uint16_t shaft_speed;
+    float load;                     // %, 0..250
+    float torque;                   // Nm, 0..2550
+    float block_peak;               // Nm, 0..65535 - Peak torque of the last 100 ms analysis block
+    float crest_factor;             // 0..25.5
+} CanPtoStatus;
+
+static inline void can_pack_pto_status(uint8_t data[CAN_DLC_PTO_STATUS], const CanPtoStatus* msg) {
+    uint64_t le = 0, be = 0;
+    be |= ((uint64_t)msg->shaft_speed & 0xFFFFull) << 48;
+    le |= (can_raw_f(msg->load, 0.0f, 1.0f, 0.0f, 250.0f) & 0xFFull) << 16;
+    le |= (can_raw_f(msg->torque, 0.0f, 0.1f, 0.0f, 255.0f) & 0xFFull) << 24;
+    be |= (can_raw_f(msg->block_peak, 0.0f, 1.0f, 0.0f, 65535.0f) & 0xFFFFull) << 16;
+    le |= (can_raw_f(msg->crest_factor, 0.0f, 10.0f, 0.0f, 255.0f) & 0xFFull) << 48;
+    can_store(data, CAN_DLC_PTO_STATUS, le, be);
+}
+
+static inline void can_unpack_pto_status(const uint8_t data[CAN_DLC_PTO_STATUS], CanPtoStatus* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_PTO_STATUS);
+    uint64_t be = can_load_be(data, CAN_DLC_PTO_STATUS);
+    msg->shaft_speed = (uint16_t)((be >> 48) & 0xFFFFull);
+    msg->load = (float)((le >> 16) & 0xFFull) * 1.0f + 0.0f;
+    msg->torque = (float)((le >> 24) & 0xFFull) * 10.0f + 0.0f;
+    msg->block_peak = (float)((be >> 16) & 0xFFFFull) * 1.0f + 0.0f;
+    msg->crest_factor = (float)((le >> 48) & 0xFFull) * 0.1f + 0.0f;
+}
+
+// GpsPosition (0x230, 8 bytes)
+#define CAN_ID_GPS_POSITION 0x230
+#define CAN_DLC_GPS_POSITION 8
+
+typedef struct {
+    double latitude;                // deg, -90..90
+    double longitude;               // deg, -180..180
+} CanGpsPosition;
+
+static inline void can_pack_gps_position(uint8_t data[CAN_DLC_GPS_POSITION], const CanGpsPosition* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_d(msg->latitude, 0.0, 10000000.0, -900000000.0, 900000000.0) & 0xFFFFFFFFull) << 0;
+    le |= (can_raw_d(msg->longitude, 0.0, 10000000.0, -1800000000.0, 1800000000.0) & 0xFFFFFFFFull) << 32;
+    can_store(data, CAN_DLC_GPS_POSITION, le, be);
+}
+
+static inline void can_unpack_gps_position(const uint8_t data[CAN_DLC_GPS_POSITION], CanGpsPosition* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_GPS_POSITION);
+    msg->latitude = (double)can_sign_extend(((le >> 0) & 0xFFFFFFFFull), 32) * 9.9999999999999995e-08 + 0.0;
+    msg->longitude = (double)can_sign_extend(((le >> 32) & 0xFFFFFFFFull), 32) * 9.9999999999999995e-08 + 0.0;
+}
+
+// GpsStatus (0x231, 8 bytes)
+#define CAN_ID_GPS_STATUS 0x231
+#define CAN_DLC_GPS_STATUS 8
+
+typedef struct {
+    float speed;                    // km/h, 0..655.35
+    float heading;                  // deg, 0..359.99
+    uint8_t satellites;
+    float signal_strength;          // %, 0..100
+} CanGpsStatus;
+
+static inline void can_pack_gps_status(uint8_t data[CAN_DLC_GPS_STATUS], const CanGpsStatus* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_f(msg->speed, 0.0f, 100.0f, 0.0f, 65535.0f) & 0xFFFFull) << 0;
+    le |= (can_raw_f(msg->heading, 0.0f, 100.0f, 0.0f, 35999.0f) & 0xFFFFull) << 16;
+    le |= ((uint64_t)msg->satellites & 0xFFull) << 32;
+    le |= (can_raw_f(msg->signal_strength, 0.0f, 2.0f, 0.0f, 200.0f) & 0xFFull) << 40;
+    can_store(data, CAN_DLC_GPS_STATUS, le, be);
+}
+
+static inline void can_unpack_gps_status(const uint8_t data[CAN_DLC_GPS_STATUS], CanGpsStatus* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_GPS_STATUS);
+    msg->speed = (float)((le >> 0) & 0xFFFFull) * 0.01f + 0.0f;
+    msg->heading = (float)((le >> 16) & 0xFFFFull) * 0.01f + 0.0f;
+    msg->satellites = (uint8_t)((le >> 32) & 0xFFull);
+    msg->signal_strength = (float)((le >> 40) & 0xFFull) * 0.5f + 0.0f;
+}
+
+// ImplementAttach (0x240, 8 bytes)
+#define CAN_ID_IMPLEMENT_ATTACH 0x240
+#define CAN_DLC_IMPLEMENT_ATTACH 8
+
+typedef struct {
+    uint8_t attached;
+    uint8_t implement_type;
+    uint8_t rows;
+    uint32_t profile_id;            // Implement profile database ID
+} CanImplementAttach;
+
+static inline void can_pack_implement_attach(uint8_t data[CAN_DLC_IMPLEMENT_ATTACH], const CanImplementAttach* msg) {
+    uint64_t le = 0, be = 0;
+    le |= ((uint64_t)msg->attached & 0xFFull) << 0;
+    le |= ((uint64_t)msg->implement_type & 0xFFull) << 8;
+    le |= ((uint64_t)msg->rows & 0xFFull) << 16;
+    be |= ((uint64_t)msg->profile_id & 0xFFFFFFFFull) << 8;
+    can_store(data, CAN_DLC_IMPLEMENT_ATTACH, le, be);
+}
+
+static inline void can_unpack_implement_attach(const uint8_t data[CAN_DLC_IMPLEMENT_ATTACH], CanImplementAttach* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_IMPLEMENT_ATTACH);
+    uint64_t be = can_load_be(data, CAN_DLC_IMPLEMENT_ATTACH);
+    msg->attached = (uint8_t)((le >> 0) & 0xFFull);
+    msg->implement_type = (uint8_t)((le >> 8) & 0xFFull);
+    msg->rows = (uint8_t)((le >> 16) & 0xFFull);
+    msg->profile_id = (uint32_t)((be >> 8) & 0xFFFFFFFFull);
+}
+
+// ImplementHitch (0x241, 8 bytes)
+#define CAN_ID_IMPLEMENT_HITCH 0x241
+#define CAN_DLC_IMPLEMENT_HITCH 8
+
+typedef struct {
+    uint8_t lowered;
+    float target_depth;             // cm, 0..51
+} CanImplementHitch;
+
+static inline void can_pack_implement_hitch(uint8_t data[CAN_DLC_IMPLEMENT_HITCH], const CanImplementHitch* msg) {
+    uint64_t le = 0, be = 0;
+    le |= ((uint64_t)msg->lowered & 0xFFull) << 0;
+    le |= (can_raw_f(msg->target_depth, 0.0f, 5.0f, 0.0f, 255.0f) & 0xFFull) << 8;
+    can_store(data, CAN_DLC_IMPLEMENT_HITCH, le, be);
+}
+
+static inline void can_unpack_implement_hitch(const uint8_t data[CAN_DLC_IMPLEMENT_HITCH], CanImplementHitch* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_IMPLEMENT_HITCH);
+    msg->lowered = (uint8_t)((le >> 0) & 0xFFull);
+    msg->target_depth = (float)((le >> 8) & 0xFFull) * 0.2f + 0.0f;
+}
+
+// ImplementStatus (0x242, 8 bytes)
+#define CAN_ID_IMPLEMENT_STATUS 0x242
+#define CAN_DLC_IMPLEMENT_STATUS 8
+
+typedef struct {
+    uint8_t status;
+    float working_depth;            // cm, 0..51
+    float pressure;                 // psi, 0..6553.5
+    float flow;                     // L/min, 0..250
+    float coverage_rate;            // ha/h, 0..6553.5
+} CanImplementStatus;
+
+static inline void can_pack_implement_status(uint8_t data[CAN_DLC_IMPLEMENT_STATUS], const CanImplementStatus* msg) {
+    uint64_t le = 0, be = 0;
+    le |= ((uint64_t)msg->status & 0xFFull) << 0;
+    le |= (can_raw_f(msg->working_depth, 0.0f, 5.0f, 0.0f, 255.0f) & 0xFFull) << 8;
+    le |= (can_raw_f(msg->pressure, 0.0f, 10.0f, 0.0f, 65535.0f) & 0xFFFFull) << 16;
+    le |= (can_raw_f(msg->flow, 0.0f, 1.0f, 0.0f, 250.0f) & 0xFFull) << 32;
+    le |= (can_raw_f(msg->coverage_rate, 0.0f, 10.0f, 0.0f, 65535.0f) & 0xFFFFull) << 40;
+    can_store(data, CAN_DLC_IMPLEMENT_STATUS, le, be);
+}
+
+static inline void can_unpack_implement_status(const uint8_t data[CAN_DLC_IMPLEMENT_STATUS], CanImplementStatus* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_IMPLEMENT_STATUS);
+    msg->status = (uint8_t)((le >> 0) & 0xFFull);
+    msg->working_depth = (float)((le >> 8) & 0xFFull) * 0.2f + 0.0f;
+    msg->pressure = (float)((le >> 16) & 0xFFFFull) * 0.1f + 0.0f;
+    msg->flow = (float)((le >> 32) & 0xFFull) * 1.0f + 0.0f;
+    msg->coverage_rate = (float)((le >> 40) & 0xFFFFull) * 0.1f + 0.0f;
+}
+
+// SectionState (0x243, 8 bytes)
+#define CAN_ID_SECTION_STATE 0x243
+#define CAN_DLC_SECTION_STATE 8
+
+typedef struct {
+    uint64_t section_mask;          // Bit i = section or row i on, from the left end
+} CanSectionState;
+
+static inline void can_pack_section_state(uint8_t data[CAN_DLC_SECTION_STATE], const CanSectionState* msg) {
+    uint64_t le = 0, be = 0;
+    le |= ((uint64_t)msg->section_mask & 0xFFFFFFFFFFFFFFFFull) << 0;
+    can_store(data, CAN_DLC_SECTION_STATE, le, be);
+}
+
+static inline void can_unpack_section_state(const uint8_t data[CAN_DLC_SECTION_STATE], CanSectionState* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_SECTION_STATE);
+    msg->section_mask = (uint64_t)((le >> 0) & 0xFFFFFFFFFFFFFFFFull);
+}
+
+// ApplicationRate (0x244, 8 bytes)
+#define CAN_ID_APPLICATION_RATE 0x244
+#define CAN_DLC_APPLICATION_RATE 8
+
+typedef struct {
+    double rate;                    // 0..4.29497e+07 - Seeds/ha or L/ha, per the implement profile units
+    uint8_t prescription_active;
+} CanApplicationRate;
+
+static inline void can_pack_application_rate(uint8_t data[CAN_DLC_APPLICATION_RATE], const CanApplicationRate* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_d(msg->rate, 0.0, 100.0, 0.0, 4294967295.0) & 0xFFFFFFFFull) << 0;
+    le |= ((uint64_t)msg->prescription_active & 0xFFull) << 32;
+    can_store(data, CAN_DLC_APPLICATION_RATE, le, be);
+}
+
+static inline void can_unpack_application_rate(const uint8_t data[CAN_DLC_APPLICATION_RATE], CanApplicationRate* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_APPLICATION_RATE);
+    msg->rate = (double)((le >> 0) & 0xFFFFFFFFull) * 0.01 + 0.0;
+    msg->prescription_active = (uint8_t)((le >> 32) & 0xFFull);
+}
+
+// GeofenceEvent (0x250, 8 bytes)
+#define CAN_ID_GEOFENCE_EVENT 0x250
+#define CAN_DLC_GEOFENCE_EVENT 8
+
+typedef struct {
+    uint8_t inside_mask;
+    uint8_t entered_mask;
+    uint8_t exited_mask;
+    float boundary_distance;        // m, 0..6553.5 - 6553.5 = outside every field boundary
+} CanGeofenceEvent;
+
+static inline void can_pack_geofence_event(uint8_t data[CAN_DLC_GEOFENCE_EVENT], const CanGeofenceEvent* msg) {
+    uint64_t le = 0, be = 0;
+    le |= ((uint64_t)msg->inside_mask & 0xFFull) << 0;
+    le |= ((uint64_t)msg->entered_mask & 0xFFull) << 8;
+    le |= ((uint64_t)msg->exited_mask & 0xFFull) << 16;
+    be |= (can_raw_f(msg->boundary_distance, 0.0f, 10.0f, 0.0f, 65535.0f) & 0xFFFFull) << 24;
+    can_store(data, CAN_DLC_GEOFENCE_EVENT, le, be);
+}
+
+static inline void can_unpack_geofence_event(const uint8_t data[CAN_DLC_GEOFENCE_EVENT], CanGeofenceEvent* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_GEOFENCE_EVENT);
+    uint64_t be = can_load_be(data, CAN_DLC_GEOFENCE_EVENT);
+    msg->inside_mask = (uint8_t)((le >> 0) & 0xFFull);
+    msg->entered_mask = (uint8_t)((le >> 8) & 0xFFull);
+    msg->exited_mask = (uint8_t)((le >> 16) & 0xFFull);
+    msg->boundary_distance = (float)((be >> 24) & 0xFFFFull) * 0.1f + 0.0f;
+}
+
+// GuidanceStatus (0x260, 8 bytes)
+#define CAN_ID_GUIDANCE_STATUS 0x260
+#define CAN_DLC_GUIDANCE_STATUS 8
+
+typedef struct {
+    float cross_track;              // m, -32.767..32.767
+    float heading_error;            // deg, -180..180
+    int16_t pass;                   // Pass number from the guidance line, negative to the left
+    uint8_t mode;
+} CanGuidanceStatus;
+
+static inline void can_pack_guidance_status(uint8_t data[CAN_DLC_GUIDANCE_STATUS], const CanGuidanceStatus* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_f(msg->cross_track, 0.0f, 1000.0f, -32767.0f, 32767.0f) & 0xFFFFull) << 0;
+    le |= (can_raw_f(msg->heading_error, 0.0f, 100.0f, -18000.0f, 18000.0f) & 0xFFFFull) << 16;
+    le |= ((uint64_t)(int64_t)msg->pass & 0xFFFFull) << 32;
+    le |= ((uint64_t)msg->mode & 0xFFull) << 48;
+    can_store(data, CAN_DLC_GUIDANCE_STATUS, le, be);
+}
+
+static inline void can_unpack_guidance_status(const uint8_t data[CAN_DLC_GUIDANCE_STATUS], CanGuidanceStatus* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_GUIDANCE_STATUS);
+    msg->cross_track = (float)can_sign_extend(((le >> 0) & 0xFFFFull), 16) * 0.001f + 0.0f;
+    msg->heading_error = (float)can_sign_extend(((le >> 16) & 0xFFFFull), 16) * 0.01f + 0.0f;
+    msg->pass = (int16_t)can_sign_extend(((le >> 32) & 0xFFFFull), 16);
+    msg->mode = (uint8_t)((le >> 48) & 0xFFull);
+}
+
+// TransmissionStatus (0x300, 4 bytes)
+#define CAN_ID_TRANSMISSION_STATUS 0x300
+#define CAN_DLC_TRANSMISSION_STATUS 4
+
+typedef struct {
+    float output_speed;             // rpm, 0..16383.8
+    uint8_t gear;
+    uint8_t clutch_engaged;
+} CanTransmissionStatus;
+
+static inline void can_pack_transmission_status(uint8_t data[CAN_DLC_TRANSMISSION_STATUS], const CanTransmissionStatus* msg) {
+    uint64_t le = 0, be = 0;
+    le |= (can_raw_f(msg->output_speed, 0.0f, 4.0f, 0.0f, 65535.0f) & 0xFFFFull) << 0;
+    le |= ((uint64_t)msg->gear & 0xFFull) << 16;
+    le |= ((uint64_t)msg->clutch_engaged & 0xFFull) << 24;
+    can_store(data, CAN_DLC_TRANSMISSION_STATUS, le, be);
+}
+
+static inline void can_unpack_transmission_status(const uint8_t data[CAN_DLC_TRANSMISSION_STATUS], CanTransmissionStatus* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_TRANSMISSION_STATUS);
+    msg->output_speed = (float)((le >> 0) & 0xFFFFull) * 0.25f + 0.0f;
+    msg->gear = (uint8_t)((le >> 16) & 0xFFull);
+    msg->clutch_engaged = (uint8_t)((le >> 24) & 0xFFull);
+}
+
+// DiagnosticSummary (0x400, 2 bytes)
+#define CAN_ID_DIAGNOSTIC_SUMMARY 0x400
+#define CAN_DLC_DIAGNOSTIC_SUMMARY 2
+
+typedef struct {
+    uint16_t active_faults;
+} CanDiagnosticSummary;
+
+static inline void can_pack_diagnostic_summary(uint8_t data[CAN_DLC_DIAGNOSTIC_SUMMARY], const CanDiagnosticSummary* msg) {
+    uint64_t le = 0, be = 0;
+    le |= ((uint64_t)msg->active_faults & 0xFFFFull) << 0;
+    can_store(data, CAN_DLC_DIAGNOSTIC_SUMMARY, le, be);
+}
+
+static inline void can_unpack_diagnostic_summary(const uint8_t data[CAN_DLC_DIAGNOSTIC_SUMMARY], CanDiagnosticSummary* msg) {
+    uint64_t le = can_load_le(data, CAN_DLC_DIAGNOSTIC_SUMMARY);
+    msg->active_faults = (uint16_t)((le >> 0) & 0xFFFFull);
+}
+
+// Tables for tools: X(message, struct, id, dlc) and
+// X(message, field, start, length, big endian, signed, scale, offset, min, max)
+// with min/max the physical range the packer clamps to
+#define CAN_MESSAGES(X) \
+    X(engine_status, CanEngineStatus, 0x100, 8) \
+    X(hydraulic_status, CanHydraulicStatus, 0x200, 8) \
+    X(hydraulic_flow_share, CanHydraulicFlowShare, 0x201, 8) \
+    X(pto_command, CanPtoCommand, 0x220, 8) \
+    X(pto_status, CanPtoStatus, 0x221, 8) \
+    X(gps_position, CanGpsPosition, 0x230, 8) \
+    X(gps_status, CanGpsStatus, 0x231, 8) \
+    X(implement_attach, CanImplementAttach, 0x240, 8) \
+    X(implement_hitch, CanImplementHitch, 0x241, 8) \
+    X(implement_status, CanImplementStatus, 0x242, 8) \
+    X(section_state, CanSectionState, 0x243, 8) \
+    X(application_rate, CanApplicationRate, 0x244, 8) \
+    X(geofence_event, CanGeofenceEvent, 0x250, 8) \
+    X(guidance_status, CanGuidanceStatus, 0x260, 8) \
+    X(transmission_status, CanTransmissionStatus, 0x300, 4) \
+    X(diagnostic_summary, CanDiagnosticSummary, 0x400, 2)
+
+#define CAN_SIGNALS(X) \
+    X(engine_status, engine_speed, 0, 16, 0, 0, 1, 0, 0, 8000) \
+    X(engine_status, target_speed, 16, 16, 0, 0, 1, 0, 0, 8000) \
+    X(engine_status, engine_load, 32, 8, 0, 0, 0.5, 0, 0, 125) \
+    X(engine_status, coolant_temp, 40, 8, 0, 0, 1, -40, -40, 210) \
+    X(engine_status, fuel_rate, 48, 16, 0, 0, 0.050000000000000003, 0, 0, 3276.75) \
+    X(hydraulic_status, system_pressure, 0, 16, 0, 0, 0.10000000000000001, 0, 0, 6553.5) \
+    X(hydraulic_status, flow_rate, 16, 16, 0, 0, 0.01, 0, 0, 655.35000000000002) \
+    X(hydraulic_status, oil_temp, 32, 8, 0, 0, 1, -40, -40, 210) \
+    X(hydraulic_status, reservoir_level, 40, 8, 0, 0, 0.40000000000000002, 0, 0, 100) \
+    X(hydraulic_flow_share, steering_share, 0, 8, 0, 0, 1, 0, 0, 100) \
+    X(hydraulic_flow_share, pto_clutch_share, 8, 8, 0, 0, 1, 0, 0, 100) \
+    X(hydraulic_flow_share, hitch_share, 16, 8, 0, 0, 1, 0, 0, 100) \
+    X(hydraulic_flow_share, scv1_share, 24, 8, 0, 0, 1, 0, 0, 100) \
+    X(hydraulic_flow_share, scv2_share, 32, 8, 0, 0, 1, 0, 0, 100) \
+    X(hydraulic_flow_share, scv3_share, 40, 8, 0, 0, 1, 0, 0, 100) \
+    X(hydraulic_flow_share, scv4_share, 48, 8, 0, 0, 1, 0, 0, 100) \
+    X(hydraulic_flow_share, starved_mask, 56, 8, 0, 0, 1, 0, 0, 255) \
+    X(pto_command, engage, 0, 8, 0, 0, 1, 0, 0, 255) \
+    X(pto_command, target_speed, 15, 16, 1, 0, 1, 0, 0, 65535) \
+    X(pto_status, shaft_speed, 7, 16, 1, 0, 1, 0, 0, 65535) \
+    X(pto_status, load, 16, 8, 0, 0, 1, 0, 0, 250) \
+    X(pto_status, torque, 24, 8, 0, 0, 10, 0, 0, 2550) \
+    X(pto_status, block_peak, 39, 16, 1, 0, 1, 0, 0, 65535) \
+    X(pto_status, crest_factor, 48, 8, 0, 0, 0.10000000000000001, 0, 0, 25.5) \
+    X(gps_position, latitude, 0, 32, 0, 1, 9.9999999999999995e-08, 0, -90, 90) \
+    X(gps_position, longitude, 32, 32, 0, 1, 9.9999999999999995e-08, 0, -180, 180) \
+    X(gps_status, speed, 0, 16, 0, 0, 0.01, 0, 0, 655.35000000000002) \
+    X(gps_status, heading, 16, 16, 0, 0, 0.01, 0, 0, 359.99000000000001) \
+    X(gps_status, satellites, 32, 8, 0, 0, 1, 0, 0, 255) \
+    X(gps_status, signal_strength, 40, 8, 0, 0, 0.5, 0, 0, 100) \
+    X(implement_attach, attached, 0, 8, 0, 0, 1, 0, 0, 255) \
+    X(implement_attach, implement_type, 8, 8, 0, 0, 1, 0, 0, 255) \
+    X(implement_attach, rows, 16, 8, 0, 0, 1, 0, 0, 255) \
+    X(implement_attach, profile_id, 31, 32, 1, 0, 1, 0, 0, 4294967295) \
+    X(implement_hitch, lowered, 0, 8, 0, 0, 1, 0, 0, 255) \
+    X(implement_hitch, target_depth, 8, 8, 0, 0, 0.20000000000000001, 0, 0, 51) \
+    X(implement_status, status, 0, 8, 0, 0, 1, 0, 0, 255) \
+    X(implement_status, working_depth, 8, 8, 0, 0, 0.20000000000000001, 0, 0, 51) \
+    X(implement_status, pressure, 16, 16, 0, 0, 0.10000000000000001, 0, 0, 6553.5) \
+    X(implement_status, flow, 32, 8, 0, 0, 1, 0, 0, 250) \
+    X(implement_status, coverage_rate, 40, 16, 0, 0, 0.10000000000000001, 0, 0, 6553.5) \
+    X(section_state, section_mask, 0, 64, 0, 0, 1, 0, 0, 1.8446744073709552e+19) \
+    X(application_rate, rate, 0, 32, 0, 0, 0.01, 0, 0, 42949672.950000003) \
+    X(application_rate, prescription_active, 32, 8, 0, 0, 1, 0, 0, 255) \
+    X(geofence_event, inside_mask, 0, 8, 0, 0, 1, 0, 0, 255) \
+    X(geofence_event, entered_mask, 8, 8, 0, 0, 1, 0, 0, 255) \
+    X(geofence_event, exited_mask, 16, 8, 0, 0, 1, 0, 0, 255) \
+    X(geofence_event, boundary_distance, 31, 16, 1, 0, 0.10000000000000001, 0, 0, 6553.5) \
+    X(guidance_status, cross_track, 0, 16, 0, 1, 0.001, 0, -32.767000000000003, 32.767000000000003) \
+    X(guidance_status, heading_error, 16, 16, 0, 1, 0.01, 0, -180, 180) \
+    X(guidance_status, pass, 32, 16, 0, 1, 1, 0, -32768, 32767) \
+    X(guidance_status, mode, 48, 8, 0, 0, 1, 0, 0, 255) \
+    X(transmission_status, output_speed, 0, 16, 0, 0, 0.25, 0, 0, 16383.75) \
+    X(transmission_status, gear, 16, 8, 0, 0, 1, 0, 0, 255) \
+    X(transmission_status, clutch_engaged, 24, 8, 0, 0, 1, 0, 0, 255) \
+    X(diagnostic_summary, active_faults, 0, 16, 0, 0, 1, 0, 0, 65535)
+
+#endif // CAN_MESSAGES_H
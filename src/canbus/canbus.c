@@ -1,79 +1,285 @@
 #include "canbus.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <time.h>
+#include <pthread.h>
 
-static CANBusState canbus_state = {0};
+typedef struct {
+    uint32_t id;
+    CanRxHandler handler;
+    void* context;
+} Subscriber;
+
+// Frame waiting for a local subscriber and/or the bus tap
+typedef struct {
+    CANMessage message;
+    uint64_t queued_ns;
+    bool tapped;               // Shown to the tap (false for forwarded frames)
+} QueuedFrame;
+
+// Bus data first, then the handler wiring, which holds pointers and is
+// set up again by the subscribers' inits; checkpoints cover the data only
+typedef struct {
+    CANBusState state;
+
+    // Loopback queue - frames for local receivers, in send order
+    QueuedFrame loopback[CANBUS_LOOPBACK_FRAMES];
+    uint32_t loopback_head;
+    uint32_t loopback_count;
+
+    Subscriber subscribers[CANBUS_MAX_SUBSCRIBERS];
+    int subscriber_count;
+    CanTapHandler tap;
+    void* tap_context;
+} CanBus;
+
+static CanBus buses[CAN_BUS_COUNT];
+
+static const char* const bus_names[CAN_BUS_COUNT] = { "tractor", "implement" };
+
+// The guidance worker sends from its own thread
+static pthread_mutex_t bus_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void canbus_init(void) {
     printf("[CANBUS] Initializing CAN bus module\n");
-    canbus_state.message_count = 0;
-    canbus_state.messages_sent = 0;
-    canbus_state.messages_received = 0;
-    canbus_state.bus_load_percent = 0.0;
-    canbus_state.status = STATUS_OK;
-    memset(canbus_state.message_buffer, 0, sizeof(canbus_state.message_buffer));
+    for (int b = 0; b < CAN_BUS_COUNT; b++) {
+        CanBus* bus = &buses[b];
+        memset(&bus->state, 0, sizeof(bus->state));
+        bus->state.bus_load_percent = 0.0;
+        bus->state.status = STATUS_OK;
+        bus->subscriber_count = 0;
+        bus->tap = NULL;
+        bus->tap_context = NULL;
+        bus->loopback_head = bus->loopback_count = 0;
+    }
+    checkpoint_register("canbus.tractor", &buses[CAN_BUS_TRACTOR], offsetof(CanBus, subscribers));
+    checkpoint_register("canbus.implement", &buses[CAN_BUS_IMPLEMENT], offsetof(CanBus, subscribers));
 }
 
 void canbus_update(void) {
-    // Calculate bus load based on message count
-    canbus_state.bus_load_percent = (canbus_state.message_count / (float)MAX_CAN_MESSAGES) * 100.0;
+    pthread_mutex_lock(&bus_lock);
+    for (int b = 0; b < CAN_BUS_COUNT; b++) {
+        CANBusState* state = &buses[b].state;
+
+        // Calculate bus load based on message count
+        state->bus_load_percent = (state->message_count / (float)MAX_CAN_MESSAGES) * 100.0;
 
-    // Clear old messages if buffer is getting full
-    if (canbus_state.message_count > MAX_CAN_MESSAGES * 0.8) {
-        printf("[CANBUS] Buffer 80%% full, clearing old messages\n");
-        canbus_state.message_count = 0;
+        // Clear old messages if buffer is getting full
+        if (state->message_count > MAX_CAN_MESSAGES * 0.8) {
+            printf("[CANBUS] Buffer 80%% full on the %s bus, clearing old messages\n", bus_names[b]);
+            state->message_count = 0;
+        }
+
+        // Update status based on bus load
+        if (state->bus_load_percent > 90.0) {
+            state->status = STATUS_WARNING;
+        } else {
+            state->status = STATUS_OK;
+        }
     }
+    pthread_mutex_unlock(&bus_lock);
+
+    // Hand received frames to local subscribers and the gateway
+    canbus_dispatch(0);
+}
 
-    // Update status based on bus load
-    if (canbus_state.bus_load_percent > 90.0) {
-        canbus_state.status = STATUS_WARNING;
-    } else {
-        canbus_state.status = STATUS_OK;
+uint64_t canbus_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int find_subscriber(const CanBus* bus, uint32_t id) {
+    for (int i = 0; i < bus->subscriber_count; i++) {
+        if (bus->subscribers[i].id == id) return i;
     }
+    return -1;
 }
 
-void canbus_send_message(uint32_t id, uint8_t* data, uint8_t length) {
+static bool transmit(CanBusId bus_id, uint32_t id, const uint8_t* data, uint8_t length, bool tapped) {
+    if ((unsigned)bus_id >= CAN_BUS_COUNT) return false;
     if (length > 8) length = 8;
+    CanBus* bus = &buses[bus_id];
+    CANBusState* state = &bus->state;
 
-    if (canbus_state.message_count < MAX_CAN_MESSAGES) {
-        CANMessage* msg = &canbus_state.message_buffer[canbus_state.message_count];
+    pthread_mutex_lock(&bus_lock);
+    tapped = tapped && bus->tap != NULL;
+    bool subscribed = find_subscriber(bus, id) >= 0;
+    if (tapped || subscribed) {
+        if (bus->loopback_count == CANBUS_LOOPBACK_FRAMES) {
+            state->loopback_dropped++;
+            // A local receiver would miss it: push back so the sender retries.
+            // A copy only the tap wanted is lost; the frame still goes out.
+            if (subscribed) {
+                pthread_mutex_unlock(&bus_lock);
+                return false;
+            }
+        } else {
+            QueuedFrame* queued = &bus->loopback[(bus->loopback_head + bus->loopback_count) %
+                                                 CANBUS_LOOPBACK_FRAMES];
+            queued->message.message_id = id;
+            queued->message.length = length;
+            memcpy(queued->message.data, data, length);
+            queued->queued_ns = canbus_now_ns();
+            queued->tapped = tapped;
+            bus->loopback_count++;
+        }
+    }
+    if (state->message_count < MAX_CAN_MESSAGES) {
+        CANMessage* msg = &state->message_buffer[state->message_count];
         msg->message_id = id;
         msg->length = length;
         memcpy(msg->data, data, length);
         msg->timestamp = (uint32_t)time(NULL);
 
-        canbus_state.message_count++;
-        canbus_state.messages_sent++;
+        state->message_count++;
+        state->messages_sent++;
     }
+    pthread_mutex_unlock(&bus_lock);
+    return true;
+}
+
+bool canbus_send_message(uint32_t id, uint8_t* data, uint8_t length) {
+    return transmit(CAN_BUS_TRACTOR, id, data, length, true);
+}
+
+bool canbus_send_on(CanBusId bus, uint32_t id, const uint8_t* data, uint8_t length) {
+    return transmit(bus, id, data, length, true);
+}
+
+bool canbus_forward(CanBusId bus, const CANMessage* message) {
+    return transmit(bus, message->message_id, message->data, message->length, false);
 }
 
 bool canbus_receive_message(CANMessage* message) {
-    if (canbus_state.message_count > 0) {
-        memcpy(message, &canbus_state.message_buffer[0], sizeof(CANMessage));
-        canbus_state.messages_received++;
-        return true;
+    bool received = false;
+    CANBusState* state = &buses[CAN_BUS_TRACTOR].state;
+    pthread_mutex_lock(&bus_lock);
+    if (state->message_count > 0) {
+        memcpy(message, &state->message_buffer[0], sizeof(CANMessage));
+        state->messages_received++;
+        received = true;
+    }
+    pthread_mutex_unlock(&bus_lock);
+    return received;
+}
+
+bool canbus_subscribe_on(CanBusId bus_id, uint32_t id, CanRxHandler handler, void* context) {
+    if ((unsigned)bus_id >= CAN_BUS_COUNT) return false;
+    CanBus* bus = &buses[bus_id];
+    pthread_mutex_lock(&bus_lock);
+    int index = find_subscriber(bus, id);
+    if (index < 0 && bus->subscriber_count < CANBUS_MAX_SUBSCRIBERS) {
+        index = bus->subscriber_count++;
+    }
+    if (index >= 0) {
+        bus->subscribers[index] = (Subscriber){ id, handler, context };
     }
-    return false;
+    pthread_mutex_unlock(&bus_lock);
+    return index >= 0;
+}
+
+bool canbus_subscribe(uint32_t id, CanRxHandler handler, void* context) {
+    return canbus_subscribe_on(CAN_BUS_TRACTOR, id, handler, context);
+}
+
+void canbus_set_tap(CanBusId bus_id, CanTapHandler handler, void* context) {
+    if ((unsigned)bus_id >= CAN_BUS_COUNT) return;
+    pthread_mutex_lock(&bus_lock);
+    buses[bus_id].tap = handler;
+    buses[bus_id].tap_context = context;
+    pthread_mutex_unlock(&bus_lock);
+}
+
+// Deliver the oldest queued frame of one bus; false if it had none
+static bool dispatch_one(CanBusId bus_id) {
+    CanBus* bus = &buses[bus_id];
+    QueuedFrame frame;
+    Subscriber target = {0};
+    CanTapHandler tap = NULL;
+    void* tap_context = NULL;
+
+    pthread_mutex_lock(&bus_lock);
+    if (bus->loopback_count == 0) {
+        pthread_mutex_unlock(&bus_lock);
+        return false;
+    }
+    frame = bus->loopback[bus->loopback_head];
+    bus->loopback_head = (bus->loopback_head + 1) % CANBUS_LOOPBACK_FRAMES;
+    bus->loopback_count--;
+    int index = find_subscriber(bus, frame.message.message_id);
+    if (index >= 0) target = bus->subscribers[index];
+    if (frame.tapped) {
+        tap = bus->tap;
+        tap_context = bus->tap_context;
+    }
+    bus->state.messages_received++;
+    bus->state.loopback_delivered++;
+    pthread_mutex_unlock(&bus_lock);
+
+    if (index >= 0) {
+        target.handler(&frame.message, target.context);
+    }
+    if (tap != NULL) {
+        tap(bus_id, &frame.message, frame.queued_ns, tap_context);
+    }
+    return true;
+}
+
+int canbus_dispatch(int max_frames) {
+    // One frame per bus per round, so a flooded bus cannot starve the other
+    int delivered = 0;
+    bool pending = true;
+    while (pending && (max_frames <= 0 || delivered < max_frames)) {
+        pending = false;
+        for (int b = 0; b < CAN_BUS_COUNT && (max_frames <= 0 || delivered < max_frames); b++) {
+            if (dispatch_one((CanBusId)b)) {
+                delivered++;
+                pending = true;
+            }
+        }
+    }
+    return delivered;
+}
+
+const char* canbus_bus_name(CanBusId bus) {
+    return (unsigned)bus < CAN_BUS_COUNT ? bus_names[bus] : "unknown";
 }
 
 void canbus_print_stats(void) {
+    const CANBusState* tractor = &buses[CAN_BUS_TRACTOR].state;
     printf("\n=== CAN BUS STATISTICS ===\n");
-    printf("Messages sent: %u\n", canbus_state.messages_sent);
-    printf("Messages received: %u\n", canbus_state.messages_received);
-    printf("Current buffer count: %u\n", canbus_state.message_count);
-    printf("Bus load: %.1f%%\n", canbus_state.bus_load_percent);
+    printf("Messages sent: %u\n", tractor->messages_sent);
+    printf("Messages received: %u\n", tractor->messages_received);
+    printf("Current buffer count: %u\n", tractor->message_count);
+    if (tractor->loopback_delivered > 0 || tractor->loopback_dropped > 0) {
+        printf("Loopback: %u delivered, %u refused (queue full)\n",
+               tractor->loopback_delivered, tractor->loopback_dropped);
+    }
+    printf("Bus load: %.1f%%\n", tractor->bus_load_percent);
     printf("Status: ");
 
-    switch (canbus_state.status) {
+    switch (tractor->status) {
         case STATUS_OK: printf("OK\n"); break;
         case STATUS_WARNING: printf("WARNING\n"); break;
         case STATUS_ERROR: printf("ERROR\n"); break;
         case STATUS_CRITICAL: printf("CRITICAL\n"); break;
     }
+    for (int b = CAN_BUS_TRACTOR + 1; b < CAN_BUS_COUNT; b++) {
+        const CANBusState* state = &buses[b].state;
+        printf("Bus '%s': %u sent, %u received, load %.1f%%, %u refused (queue full)\n",
+               bus_names[b], state->messages_sent,
+               state->messages_received, state->bus_load_percent, state->loopback_dropped);
+    }
     printf("==========================\n\n");
 }
 
 CANBusState* canbus_get_state(void) {
-    return &canbus_state;
+    return &buses[CAN_BUS_TRACTOR].state;
+}
+
+CANBusState* canbus_get_bus_state(CanBusId bus) {
+    return (unsigned)bus < CAN_BUS_COUNT ? &buses[bus].state : NULL;
 }
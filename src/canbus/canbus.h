@@ -4,6 +4,17 @@
 #include "../common/types.h"
 
 #define MAX_CAN_MESSAGES 100
+#define CANBUS_MAX_SUBSCRIBERS  8
+#define CANBUS_LOOPBACK_FRAMES  256   // Frames in flight to local subscribers, per bus
+
+// Physical bus instances. The powertrain modules share the tractor bus;
+// the ISOBUS implement network is separate and only reaches the tractor
+// bus through the gateway (canbus/gateway.h).
+typedef enum {
+    CAN_BUS_TRACTOR = 0,
+    CAN_BUS_IMPLEMENT,
+    CAN_BUS_COUNT
+} CanBusId;
 
 // CAN bus communication module - handles inter-module communication
 typedef struct {
@@ -13,21 +24,49 @@ typedef struct {
     uint32_t timestamp;
 } CANMessage;
 
+// Local receiver for frames sent on one ID (loopback delivery)
+typedef void (*CanRxHandler)(const CANMessage* message, void* context);
+
+// Sees every frame sent on a bus by its nodes (one tap per bus, used by
+// the gateway); queued_ns is when the frame was sent, on canbus_now_ns
+typedef void (*CanTapHandler)(CanBusId bus, const CANMessage* message, uint64_t queued_ns, void* context);
+
 typedef struct {
     CANMessage message_buffer[MAX_CAN_MESSAGES];
     uint16_t message_count;
     uint32_t messages_sent;
     uint32_t messages_received;
+    uint32_t loopback_delivered;
+    uint32_t loopback_dropped;     // Full loopback queue: sends refused, or tap copies lost
     float bus_load_percent;
     SystemStatus status;
 } CANBusState;
 
-// Core module - all other modules depend on this for communication
+// Core module - all other modules depend on this for communication.
+// The calls without a bus argument use the tractor bus.
 void canbus_init(void);
 void canbus_update(void);
-void canbus_send_message(uint32_t id, uint8_t* data, uint8_t length);
+// False only when the frame has a local subscriber whose queue is full;
+// the sender should retry it later. A frame only the bus tap wants is
+// always sent - if the queue is full just the tap's copy is lost.
+bool canbus_send_message(uint32_t id, uint8_t* data, uint8_t length);
+bool canbus_send_on(CanBusId bus, uint32_t id, const uint8_t* data, uint8_t length);
+// Send without showing the frame to the bus tap - the gateway's own
+// transmissions, so forwarded frames are never routed again
+bool canbus_forward(CanBusId bus, const CANMessage* message);
 bool canbus_receive_message(CANMessage* message);
+
+// Frames sent on a subscribed ID are queued and handed to the handler by
+// canbus_dispatch, outside the bus lock so handlers may send. Subscribing
+// an ID again replaces its handler.
+bool canbus_subscribe(uint32_t id, CanRxHandler handler, void* context);
+bool canbus_subscribe_on(CanBusId bus, uint32_t id, CanRxHandler handler, void* context);
+void canbus_set_tap(CanBusId bus, CanTapHandler handler, void* context);
+int canbus_dispatch(int max_frames);   // max_frames <= 0 drains every bus
+uint64_t canbus_now_ns(void);
+const char* canbus_bus_name(CanBusId bus);
 void canbus_print_stats(void);
 CANBusState* canbus_get_state(void);
+CANBusState* canbus_get_bus_state(CanBusId bus);
 
 #endif // CANBUS_H
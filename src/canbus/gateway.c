@@ -0,0 +1,137 @@
+#include "gateway.h"
+#include "can_messages.h"
+#include "../common/checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    CanBusId source;
+    CanBusId destination;
+    uint32_t destination_id;
+    uint64_t keep_mask;
+    uint64_t interval_ns;
+} GatewayRoute;
+
+#define GATEWAY_ROUTE_ENTRY(name, src, src_id, dst, dst_id, keep, interval) \
+    { src, dst, dst_id, keep, (uint64_t)(interval) * 1000000u },
+static const GatewayRoute routes[GATEWAY_ROUTE_COUNT] = {
+    GATEWAY_ROUTES(GATEWAY_ROUTE_ENTRY)
+};
+#undef GATEWAY_ROUTE_ENTRY
+
+#define GATEWAY_ROUTE_NAME(name, src, src_id, dst, dst_id, keep, interval) #name,
+static const char* const route_names[GATEWAY_ROUTE_COUNT] = {
+    GATEWAY_ROUTES(GATEWAY_ROUTE_NAME)
+};
+#undef GATEWAY_ROUTE_NAME
+
+// Route lookup by source bus and ID, built by the compiler from the
+// routing table: route index + 1, 0 = no route. An ID outside the 11-bit
+// space fails to compile, a duplicate source ID warns (-Woverride-init).
+#define GATEWAY_ROUTE_SLOT(name, src, src_id, dst, dst_id, keep, interval) [src][src_id] = name + 1,
+static const uint8_t route_lookup[CAN_BUS_COUNT][GATEWAY_ID_SPACE] = {
+    GATEWAY_ROUTES(GATEWAY_ROUTE_SLOT)
+};
+#undef GATEWAY_ROUTE_SLOT
+
+_Static_assert(GATEWAY_ROUTE_COUNT < 255, "route index must fit the lookup table");
+
+static GatewayState gateway_state = {0};
+
+static uint64_t load_le64(const uint8_t* data) {
+    uint64_t word = 0;
+    for (int i = 0; i < 8; i++) word |= (uint64_t)data[i] << (8 * i);
+    return word;
+}
+
+static void store_le64(uint8_t* data, uint64_t word) {
+    for (int i = 0; i < 8; i++) data[i] = (uint8_t)(word >> (8 * i));
+}
+
+// Tap on every bus, called from canbus_dispatch. Only the dispatching
+// thread runs it, so the counters need no lock.
+static void route_frame(CanBusId bus, const CANMessage* message, uint64_t queued_ns, void* context) {
+    (void)context;
+    uint64_t start = canbus_now_ns();
+    gateway_state.seen[bus]++;
+
+    uint32_t id = message->message_id;
+    unsigned slot = id < GATEWAY_ID_SPACE ? route_lookup[bus][id] : 0;
+    if (slot == 0) {
+        gateway_state.unrouted[bus]++;
+        gateway_state.lookup_ns += canbus_now_ns() - start;
+        return;
+    }
+
+    const GatewayRoute* route = &routes[slot - 1];
+    GatewayRouteStats* stats = &gateway_state.routes[slot - 1];
+    if (route->interval_ns > 0 && stats->forwarded > 0 &&
+        queued_ns - stats->last_forward_ns < route->interval_ns) {
+        stats->filtered++;
+        gateway_state.lookup_ns += canbus_now_ns() - start;
+        return;
+    }
+
+    CANMessage out = *message;
+    out.message_id = route->destination_id;
+    if (route->keep_mask != GATEWAY_KEEP_ALL) {
+        uint8_t payload[8] = {0};
+        memcpy(payload, out.data, out.length);
+        store_le64(payload, load_le64(payload) & route->keep_mask);
+        memcpy(out.data, payload, out.length);
+    }
+    if (!canbus_forward(route->destination, &out)) {
+        stats->refused++;
+        gateway_state.lookup_ns += canbus_now_ns() - start;
+        return;
+    }
+
+    uint64_t now = canbus_now_ns();
+    uint64_t latency = now - queued_ns;
+    stats->forwarded++;
+    stats->latency_total_ns += latency;
+    if (latency > stats->latency_max_ns) stats->latency_max_ns = latency;
+    stats->last_forward_ns = queued_ns;
+    gateway_state.lookup_ns += now - start;
+}
+
+void gateway_init(void) {
+    printf("[GATEWAY] Initializing CAN gateway (%d routes)\n", GATEWAY_ROUTE_COUNT);
+    memset(&gateway_state, 0, sizeof(gateway_state));
+    for (int b = 0; b < CAN_BUS_COUNT; b++) {
+        canbus_set_tap((CanBusId)b, route_frame, NULL);
+    }
+    CHECKPOINT_VAR("gateway", gateway_state);
+}
+
+const char* gateway_route_name(GatewayRouteId route) {
+    return (unsigned)route < GATEWAY_ROUTE_COUNT ? route_names[route] : "unknown";
+}
+
+void gateway_print_status(void) {
+    printf("\n=== CAN Gateway ===\n");
+    uint32_t seen = 0;
+    for (int b = 0; b < CAN_BUS_COUNT; b++) {
+        seen += gateway_state.seen[b];
+        printf("%-9s bus: %u frames seen, %u kept local (no route)\n",
+               canbus_bus_name((CanBusId)b), gateway_state.seen[b], gateway_state.unrouted[b]);
+    }
+    printf("%-24s %-9s %-9s %9s %8s %7s %9s %9s\n", "Route", "From", "To", "Forwarded",
+           "Filtered", "Refused", "Avg us", "Max us");
+    for (int r = 0; r < GATEWAY_ROUTE_COUNT; r++) {
+        const GatewayRouteStats* stats = &gateway_state.routes[r];
+        double average_us = stats->forwarded > 0 ? stats->latency_total_ns / 1000.0 / stats->forwarded : 0.0;
+        printf("%-24s %-9s %-9s %9u %8u %7u %9.1f %9.1f\n", route_names[r],
+               canbus_bus_name(routes[r].source), canbus_bus_name(routes[r].destination),
+               stats->forwarded, stats->filtered, stats->refused, average_us,
+               stats->latency_max_ns / 1000.0);
+    }
+    if (seen > 0) {
+        printf("Routing cost: %.0f ns per frame\n", (double)gateway_state.lookup_ns / seen);
+    }
+    printf("===================\n");
+}
+
+GatewayState* gateway_get_state(void) {
+    return &gateway_state;
+}
@@ -0,0 +1,57 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include "canbus.h"
+
+#define GATEWAY_ID_SPACE    0x800     // 11-bit identifiers; one lookup slot each per bus
+#define GATEWAY_KEEP_ALL    0xFFFFFFFFFFFFFFFFull
+
+// Routing table: X(name, source bus, source ID, destination bus,
+// destination ID, payload keep mask, minimum interval ms).
+// The keep mask is applied to the 8 payload bytes as a little-endian
+// uint64 (byte 0 = bits 0-7); cleared bytes go out as 0. Frames on the
+// same route closer together than the interval are filtered, so a fast
+// implement status never sets the powertrain bus rate. IDs without a
+// route stay on their own bus.
+#define GATEWAY_ROUTES(X) \
+    /* Tractor ECU data the implement needs (ISOBUS TECU role) */ \
+    X(ROUTE_GROUND_SPEED,     CAN_BUS_TRACTOR,   CAN_ID_GPS_STATUS,         CAN_BUS_IMPLEMENT, CAN_ID_GPS_STATUS,         GATEWAY_KEEP_ALL,     100) \
+    X(ROUTE_PTO_SPEED,        CAN_BUS_TRACTOR,   CAN_ID_PTO_STATUS,         CAN_BUS_IMPLEMENT, CAN_ID_PTO_STATUS,         0x0000000000FFFFFFull, 100) \
+    X(ROUTE_ENGINE_SPEED,     CAN_BUS_TRACTOR,   CAN_ID_ENGINE_STATUS,      CAN_BUS_IMPLEMENT, GATEWAY_ID_ENGINE_SPEED,   0x000000000000FFFFull, 100) \
+    X(ROUTE_HITCH_COMMAND,    CAN_BUS_TRACTOR,   CAN_ID_IMPLEMENT_HITCH,    CAN_BUS_IMPLEMENT, CAN_ID_IMPLEMENT_HITCH,    GATEWAY_KEEP_ALL,     0) \
+    /* Implement reports the powertrain side uses */ \
+    X(ROUTE_IMPLEMENT_ATTACH, CAN_BUS_IMPLEMENT, CAN_ID_IMPLEMENT_ATTACH,   CAN_BUS_TRACTOR,   CAN_ID_IMPLEMENT_ATTACH,   GATEWAY_KEEP_ALL,     0) \
+    X(ROUTE_IMPLEMENT_STATUS, CAN_BUS_IMPLEMENT, CAN_ID_IMPLEMENT_STATUS,   CAN_BUS_TRACTOR,   CAN_ID_IMPLEMENT_STATUS,   GATEWAY_KEEP_ALL,     500)
+
+#define GATEWAY_ID_ENGINE_SPEED   0x108   // Engine speed only, as the implement bus sees it
+
+#define GATEWAY_ROUTE_ID(name, src, src_id, dst, dst_id, keep, interval) name,
+typedef enum {
+    GATEWAY_ROUTES(GATEWAY_ROUTE_ID)
+    GATEWAY_ROUTE_COUNT
+} GatewayRouteId;
+#undef GATEWAY_ROUTE_ID
+
+typedef struct {
+    uint32_t forwarded;
+    uint32_t filtered;             // Inside the route's minimum interval
+    uint32_t refused;              // Destination bus queue full
+    uint64_t latency_total_ns;     // Sent on the source bus to sent on the destination
+    uint64_t latency_max_ns;
+    uint64_t last_forward_ns;
+} GatewayRouteStats;
+
+typedef struct {
+    GatewayRouteStats routes[GATEWAY_ROUTE_COUNT];
+    uint32_t seen[CAN_BUS_COUNT];          // Frames the gateway looked up, per source bus
+    uint32_t unrouted[CAN_BUS_COUNT];      // No route - kept on the source bus
+    uint64_t lookup_ns;                    // Time spent routing, for the per-frame cost
+} GatewayState;
+
+// Dependencies: CANBus (taps on every bus, forwards with canbus_forward)
+void gateway_init(void);
+void gateway_print_status(void);
+const char* gateway_route_name(GatewayRouteId route);
+GatewayState* gateway_get_state(void);
+
+#endif // GATEWAY_H
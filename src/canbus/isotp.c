@@ -0,0 +1,227 @@
+#include "isotp.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void frame_received(const CANMessage* frame, void* context) {
+    isotp_on_frame(context, frame);
+}
+
+void isotp_init(IsoTpLink* link, uint32_t tx_id, uint32_t rx_id, uint8_t block_size,
+                uint8_t st_min, IsoTpReceive on_receive, void* context) {
+    memset(link, 0, sizeof(*link));
+    link->tx_id = tx_id;
+    link->rx_id = rx_id;
+    link->block_size = block_size;
+    link->st_min = st_min;
+    link->on_receive = on_receive;
+    link->context = context;
+    canbus_subscribe(rx_id, frame_received, link);
+}
+
+uint32_t isotp_st_min_us(uint8_t st_min) {
+    if (st_min <= 0x7F) return st_min * 1000u;
+    if (st_min >= 0xF1 && st_min <= 0xF9) return (st_min - 0xF0) * 100u;
+    return 0x7F * 1000u;   // Reserved values mean the longest gap
+}
+
+// Every frame is padded to the full 8 bytes
+static bool send_frame(IsoTpLink* link, uint8_t* frame) {
+    if (!canbus_send_message(link->tx_id, frame, 8)) {
+        return false;
+    }
+    link->stats.frames_sent++;
+    return true;
+}
+
+static void send_flow_control(IsoTpLink* link, uint8_t status) {
+    uint8_t frame[8] = { ISOTP_PCI_FLOW_CONTROL | status, link->block_size, link->st_min,
+                         ISOTP_PAD_BYTE, ISOTP_PAD_BYTE, ISOTP_PAD_BYTE, ISOTP_PAD_BYTE,
+                         ISOTP_PAD_BYTE };
+    if (send_frame(link, frame)) {
+        link->stats.flow_controls_sent++;
+    }
+}
+
+bool isotp_busy(const IsoTpLink* link) {
+    return link->tx_state != ISOTP_TX_IDLE;
+}
+
+bool isotp_send(IsoTpLink* link, const uint8_t* data, uint32_t length) {
+    if (length == 0 || length > ISOTP_MAX_PAYLOAD) return false;
+    if (link->tx_state != ISOTP_TX_IDLE) {
+        link->stats.busy++;
+        return false;
+    }
+
+    uint8_t frame[8];
+    memset(frame, ISOTP_PAD_BYTE, sizeof(frame));
+    if (length <= 7) {
+        frame[0] = ISOTP_PCI_SINGLE | (uint8_t)length;
+        memcpy(frame + 1, data, length);
+        if (!send_frame(link, frame)) return false;
+        link->stats.messages_sent++;
+        return true;
+    }
+
+    frame[0] = ISOTP_PCI_FIRST | (uint8_t)(length >> 8);
+    frame[1] = (uint8_t)length;
+    memcpy(frame + 2, data, 6);
+    if (!send_frame(link, frame)) return false;
+
+    memcpy(link->tx_buffer, data, length);
+    link->tx_length = length;
+    link->tx_offset = 6;
+    link->tx_sequence = 1;
+    link->tx_state = ISOTP_TX_WAIT_FC;
+    link->tx_deadline_us = monotonic_us() + ISOTP_TIMEOUT_US;
+    return true;
+}
+
+// Send as many consecutive frames as the block size and STmin allow now
+static void send_consecutive(IsoTpLink* link, uint64_t now) {
+    while (link->tx_state == ISOTP_TX_SENDING) {
+        if (link->tx_st_min_us > 0 && now < link->tx_next_us) break;
+
+        uint8_t frame[8];
+        uint32_t chunk = link->tx_length - link->tx_offset;
+        if (chunk > 7) {
+            chunk = 7;
+        } else {
+            memset(frame, ISOTP_PAD_BYTE, sizeof(frame));
+        }
+        frame[0] = ISOTP_PCI_CONSECUTIVE | link->tx_sequence;
+        memcpy(frame + 1, link->tx_buffer + link->tx_offset, chunk);
+        if (!send_frame(link, frame)) break;   // Bus queue full - resume on the next poll
+
+        link->tx_offset += chunk;
+        link->tx_sequence = (link->tx_sequence + 1) & 0x0F;
+        if (link->tx_offset >= link->tx_length) {
+            link->tx_state = ISOTP_TX_IDLE;
+            link->stats.messages_sent++;
+            break;
+        }
+        if (link->tx_block_size > 0 && --link->tx_block_left == 0) {
+            link->tx_state = ISOTP_TX_WAIT_FC;
+            link->tx_deadline_us = now + ISOTP_TIMEOUT_US;
+            break;
+        }
+        if (link->tx_st_min_us > 0) {
+            link->tx_next_us = now + link->tx_st_min_us;
+            break;
+        }
+    }
+}
+
+static void deliver(IsoTpLink* link, const uint8_t* data, uint32_t length) {
+    link->stats.messages_received++;
+    if (link->on_receive != NULL) {
+        link->on_receive(link, data, length, link->context);
+    }
+}
+
+void isotp_on_frame(IsoTpLink* link, const CANMessage* frame) {
+    const uint8_t* data = frame->data;
+    if (frame->length < 1) return;
+    link->stats.frames_received++;
+
+    switch (data[0] & 0xF0) {
+        case ISOTP_PCI_SINGLE: {
+            uint32_t length = data[0] & 0x0F;
+            if (length == 0 || length > 7 || length + 1 > frame->length) return;
+            link->rx_active = false;   // A new message aborts one in progress
+            deliver(link, data + 1, length);
+            break;
+        }
+        case ISOTP_PCI_FIRST: {
+            if (frame->length < 8) return;
+            uint32_t length = ((uint32_t)(data[0] & 0x0F) << 8) | data[1];
+            if (length <= 7) return;
+            link->rx_active = false;
+            if (length > sizeof(link->rx_buffer)) {
+                link->stats.overflows++;
+                send_flow_control(link, ISOTP_FC_OVERFLOW);
+                return;
+            }
+            memcpy(link->rx_buffer, data + 2, 6);
+            link->rx_length = length;
+            link->rx_offset = 6;
+            link->rx_sequence = 1;
+            link->rx_block_count = 0;
+            link->rx_active = true;
+            link->rx_deadline_us = monotonic_us() + ISOTP_TIMEOUT_US;
+            send_flow_control(link, ISOTP_FC_CONTINUE);
+            break;
+        }
+        case ISOTP_PCI_CONSECUTIVE: {
+            if (!link->rx_active) return;
+            if ((data[0] & 0x0F) != link->rx_sequence) {
+                link->stats.sequence_errors++;
+                link->rx_active = false;
+                return;
+            }
+            uint32_t chunk = link->rx_length - link->rx_offset;
+            if (chunk > 7) chunk = 7;
+            if (chunk + 1 > frame->length) return;
+            memcpy(link->rx_buffer + link->rx_offset, data + 1, chunk);
+            link->rx_offset += chunk;
+            link->rx_sequence = (link->rx_sequence + 1) & 0x0F;
+            if (link->rx_offset >= link->rx_length) {
+                link->rx_active = false;
+                deliver(link, link->rx_buffer, link->rx_length);
+            } else {
+                link->rx_deadline_us = monotonic_us() + ISOTP_TIMEOUT_US;
+                if (link->block_size > 0 && ++link->rx_block_count == link->block_size) {
+                    link->rx_block_count = 0;
+                    send_flow_control(link, ISOTP_FC_CONTINUE);
+                }
+            }
+            break;
+        }
+        case ISOTP_PCI_FLOW_CONTROL: {
+            if (link->tx_state != ISOTP_TX_WAIT_FC || frame->length < 3) return;
+            uint64_t now = monotonic_us();
+            switch (data[0] & 0x0F) {
+                case ISOTP_FC_CONTINUE:
+                    link->tx_block_size = data[1];
+                    link->tx_block_left = data[1];
+                    link->tx_st_min_us = isotp_st_min_us(data[2]);
+                    link->tx_next_us = now;
+                    link->tx_state = ISOTP_TX_SENDING;
+                    send_consecutive(link, now);   // Start the block without waiting for a poll
+                    break;
+                case ISOTP_FC_WAIT:
+                    link->tx_deadline_us = now + ISOTP_TIMEOUT_US;
+                    break;
+                default:
+                    link->stats.overflows++;
+                    link->tx_state = ISOTP_TX_IDLE;
+                    break;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void isotp_poll(IsoTpLink* link) {
+    if (link->tx_state == ISOTP_TX_IDLE && !link->rx_active) return;
+    uint64_t now = monotonic_us();
+    if (link->tx_state == ISOTP_TX_SENDING) {
+        send_consecutive(link, now);
+    } else if (link->tx_state == ISOTP_TX_WAIT_FC && now > link->tx_deadline_us) {
+        link->tx_state = ISOTP_TX_IDLE;
+        link->stats.timeouts++;
+    }
+    if (link->rx_active && now > link->rx_deadline_us) {
+        link->rx_active = false;
+        link->stats.timeouts++;
+    }
+}
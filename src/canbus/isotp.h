@@ -0,0 +1,95 @@
+#ifndef ISOTP_H
+#define ISOTP_H
+
+#include "canbus.h"
+
+#define ISOTP_MAX_PAYLOAD   4095      // 12-bit first-frame length
+#define ISOTP_TIMEOUT_US    1000000   // N_Bs (waiting for flow control) and N_Cr (waiting for a CF)
+#define ISOTP_PAD_BYTE      0xCC
+
+// ISO 15765-2 protocol control information, high nibble of byte 0
+#define ISOTP_PCI_SINGLE        0x00
+#define ISOTP_PCI_FIRST         0x10
+#define ISOTP_PCI_CONSECUTIVE   0x20
+#define ISOTP_PCI_FLOW_CONTROL  0x30
+
+#define ISOTP_FC_CONTINUE   0
+#define ISOTP_FC_WAIT       1
+#define ISOTP_FC_OVERFLOW   2
+
+typedef struct IsoTpLink IsoTpLink;
+
+// Called with each complete received message
+typedef void (*IsoTpReceive)(IsoTpLink* link, const uint8_t* data, uint32_t length, void* context);
+
+typedef enum {
+    ISOTP_TX_IDLE = 0,
+    ISOTP_TX_WAIT_FC,          // First frame or a full block sent, waiting for the receiver
+    ISOTP_TX_SENDING           // Consecutive frames due, paced by the receiver's STmin
+} IsoTpTxState;
+
+typedef struct {
+    uint32_t messages_sent;
+    uint32_t messages_received;
+    uint32_t frames_sent;
+    uint32_t frames_received;
+    uint32_t flow_controls_sent;
+    uint32_t timeouts;
+    uint32_t sequence_errors;
+    uint32_t overflows;        // Messages refused by the receiver (or by us) as too long
+    uint32_t busy;             // isotp_send while a message was still going out
+} IsoTpStats;
+
+// One point-to-point ISO-TP connection over a pair of CAN IDs. Buffers
+// live in the link, so a link never allocates.
+struct IsoTpLink {
+    uint32_t tx_id;
+    uint32_t rx_id;
+    uint8_t block_size;        // Advertised in our flow control (0 = no further FC)
+    uint8_t st_min;            // Advertised in our flow control (ISO STmin encoding)
+    IsoTpReceive on_receive;
+    void* context;
+
+    // Transmit
+    IsoTpTxState tx_state;
+    uint8_t tx_buffer[ISOTP_MAX_PAYLOAD];
+    uint32_t tx_length;
+    uint32_t tx_offset;
+    uint8_t tx_sequence;
+    uint8_t tx_block_size;     // From the receiver's flow control
+    uint16_t tx_block_left;
+    uint32_t tx_st_min_us;
+    uint64_t tx_next_us;
+    uint64_t tx_deadline_us;
+
+    // Receive
+    bool rx_active;
+    uint8_t rx_buffer[ISOTP_MAX_PAYLOAD];
+    uint32_t rx_length;
+    uint32_t rx_offset;
+    uint8_t rx_sequence;
+    uint16_t rx_block_count;
+    uint64_t rx_deadline_us;
+
+    IsoTpStats stats;
+};
+
+// Dependencies: CANBus (frames out, loopback subscription for rx_id)
+void isotp_init(IsoTpLink* link, uint32_t tx_id, uint32_t rx_id, uint8_t block_size,
+                uint8_t st_min, IsoTpReceive on_receive, void* context);
+
+// Start sending a message; a single frame goes out at once, longer ones
+// continue from flow control and isotp_poll. False if busy or too long.
+bool isotp_send(IsoTpLink* link, const uint8_t* data, uint32_t length);
+bool isotp_busy(const IsoTpLink* link);
+
+// Feed one received frame (done by the canbus subscription)
+void isotp_on_frame(IsoTpLink* link, const CANMessage* frame);
+
+// Send consecutive frames that are due and expire timed-out transfers
+void isotp_poll(IsoTpLink* link);
+
+// STmin byte to microseconds (0-127 ms, 0xF1-0xF9 = 100-900 us)
+uint32_t isotp_st_min_us(uint8_t st_min);
+
+#endif // ISOTP_H
@@ -0,0 +1,140 @@
+#include "budget.h"
+#include "../diagnostics/diagnostics.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BUDGET_MAX_TASKS   16
+#define ESTIMATE_DECAY     0.95f   // Per run or shed; a one-off spike fades in ~50 cycles
+
+static const char* const class_names[] = { "critical", "deferrable", "sheddable" };
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static float elapsed_us(uint64_t start_ns) {
+    return (float)(monotonic_ns() - start_ns) / 1000.0f;
+}
+
+void budget_cycle_init(BudgetCycle* cycle, const char* name, BudgetTask* tasks, int task_count,
+                       uint32_t deadline_us) {
+    memset(cycle, 0, sizeof(*cycle));
+    cycle->name = name;
+    cycle->tasks = tasks;
+    cycle->task_count = task_count < BUDGET_MAX_TASKS ? task_count : BUDGET_MAX_TASKS;
+    cycle->deadline_us = deadline_us > 0 ? deadline_us : BUDGET_DEFAULT_DEADLINE_US;
+    for (int i = 0; i < cycle->task_count; i++) {
+        BudgetTask* task = &tasks[i];
+        task->last_us = task->wcet_us = task->estimate_us = 0.0f;
+        task->runs = task->overruns = task->deferred = task->shed = task->shed_streak = 0;
+    }
+    printf("[BUDGET] %s cycle: %d tasks, %u us deadline\n", name, cycle->task_count,
+           cycle->deadline_us);
+}
+
+static void run_task(BudgetTask* task) {
+    uint64_t start = monotonic_ns();
+    task->run();
+    float us = elapsed_us(start);
+
+    task->last_us = us;
+    task->runs++;
+    if (us > task->wcet_us) task->wcet_us = us;
+    task->estimate_us = us > task->estimate_us * ESTIMATE_DECAY ? us
+                                                              : task->estimate_us * ESTIMATE_DECAY;
+    if (task->budget_us > 0 && us > (float)task->budget_us) {
+        task->overruns++;
+    }
+}
+
+static bool task_due(const BudgetCycle* cycle, const BudgetTask* task) {
+    return task->period_cycles <= 1 || cycle->cycles % task->period_cycles == 0;
+}
+
+void budget_run_cycle(BudgetCycle* cycle) {
+    uint64_t start = monotonic_ns();
+    float deadline = (float)cycle->deadline_us;
+    bool pending[BUDGET_MAX_TASKS] = {false};
+    bool any_pending = false;
+
+    // Predicted time of the critical tasks still to run this cycle
+    float critical_left = 0.0f;
+    for (int i = 0; i < cycle->task_count; i++) {
+        const BudgetTask* task = &cycle->tasks[i];
+        if (task->task_class == BUDGET_CRITICAL && task_due(cycle, task)) {
+            critical_left += task->estimate_us;
+        }
+    }
+
+    for (int i = 0; i < cycle->task_count; i++) {
+        BudgetTask* task = &cycle->tasks[i];
+        if (!task_due(cycle, task)) continue;
+        if (task->task_class == BUDGET_CRITICAL) {
+            critical_left -= task->estimate_us;
+            run_task(task);
+        } else if (elapsed_us(start) + task->estimate_us + critical_left <= deadline) {
+            task->shed_streak = 0;
+            run_task(task);
+        } else {
+            pending[i] = true;
+            any_pending = true;
+        }
+    }
+
+    // Slack pass: deferred tasks run in whatever time the critical ones left
+    for (int i = 0; i < cycle->task_count && any_pending; i++) {
+        BudgetTask* task = &cycle->tasks[i];
+        if (!pending[i]) continue;
+        bool forced = task->task_class == BUDGET_DEFERRABLE &&
+                      task->shed_streak >= BUDGET_MAX_DEFERRALS;
+        if (forced || elapsed_us(start) + task->estimate_us <= deadline) {
+            task->deferred++;
+            task->shed_streak = 0;
+            run_task(task);
+        } else {
+            // Let a stale estimate decay so the task gets retried
+            task->shed++;
+            task->shed_streak++;
+            task->estimate_us *= ESTIMATE_DECAY;
+        }
+    }
+
+    float us = elapsed_us(start);
+    cycle->last_us = us;
+    if (us > cycle->worst_us) cycle->worst_us = us;
+    if (us > deadline) cycle->missed++;
+    cycle->cycles++;
+
+    if (any_pending) {
+        cycle->degraded_cycles++;
+        cycle->clean_streak = 0;
+        if (!cycle->degraded) {
+            cycle->degraded = true;
+            printf("[BUDGET] %s cycle degraded - deferring non-critical tasks\n", cycle->name);
+            diagnostics_report_fault(FAULT_CYCLE_DEGRADED);
+        }
+    } else if (cycle->degraded && ++cycle->clean_streak >= BUDGET_RECOVERY_CYCLES) {
+        cycle->degraded = false;
+        printf("[BUDGET] %s cycle back within budget\n", cycle->name);
+        diagnostics_clear_fault(SPN_ECU_TASK_SCHEDULE, FMI_ABNORMAL_UPDATE);
+    }
+}
+
+void budget_print_status(const BudgetCycle* cycle) {
+    printf("\n=== Cycle Budget (%s) ===\n", cycle->name);
+    printf("Deadline %u us  Cycles %u  Missed %u  Degraded %u  Last %.1f us / worst %.1f us  Mode: %s\n",
+           cycle->deadline_us, cycle->cycles, cycle->missed, cycle->degraded_cycles,
+           cycle->last_us, cycle->worst_us, cycle->degraded ? "DEGRADED" : "NORMAL");
+    printf("%-12s %-10s %8s %9s %9s %6s %8s %8s %6s\n", "Task", "Class", "Budget", "Last us",
+           "WCET us", "Runs", "Overrun", "Deferred", "Shed");
+    for (int i = 0; i < cycle->task_count; i++) {
+        const BudgetTask* task = &cycle->tasks[i];
+        printf("%-12s %-10s %8u %9.1f %9.1f %6u %8u %8u %6u\n", task->name,
+               class_names[task->task_class], task->budget_us, task->last_us, task->wcet_us,
+               task->runs, task->overruns, task->deferred, task->shed);
+    }
+    printf("===========================\n");
+}
@@ -0,0 +1,67 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BUDGET_DEFAULT_DEADLINE_US  10000  // One 100 Hz frame for the whole cycle
+#define BUDGET_MAX_DEFERRALS        5      // A deferrable task runs at least this often
+#define BUDGET_RECOVERY_CYCLES      10     // Clean cycles before degraded mode clears
+
+// How a task may be treated when the cycle is about to miss its deadline
+typedef enum {
+    BUDGET_CRITICAL = 0,   // Always runs, in order
+    BUDGET_DEFERRABLE,     // Moved to the end of the cycle, dropped for the
+                           // cycle if there is still no room, forced after
+                           // BUDGET_MAX_DEFERRALS dropped cycles in a row
+    BUDGET_SHEDDABLE       // Moved to the end of the cycle, dropped outright
+                           // if there is still no room
+} BudgetClass;
+
+// One subsystem update with its execution-time budget and measurements
+typedef struct {
+    const char* name;
+    void (*run)(void);
+    uint32_t budget_us;        // Overrun when one run takes longer
+    BudgetClass task_class;
+    uint32_t period_cycles;    // Runs every this many cycles (0 or 1 = every cycle)
+
+    float last_us;
+    float wcet_us;             // Worst case measured since init
+    float estimate_us;         // Decaying peak, used to predict the next run
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t deferred;         // Runs moved to the end of the cycle
+    uint32_t shed;             // Cycles the task was dropped from
+    uint32_t shed_streak;
+} BudgetTask;
+
+// A cycle of tasks run in table order against one deadline
+typedef struct {
+    const char* name;
+    BudgetTask* tasks;
+    int task_count;
+    uint32_t deadline_us;
+
+    uint32_t cycles;
+    uint32_t missed;           // Cycles that finished past the deadline
+    uint32_t degraded_cycles;  // Cycles that deferred or shed a task
+    uint32_t clean_streak;
+    float last_us;
+    float worst_us;
+    bool degraded;
+} BudgetCycle;
+
+// Dependencies: Diagnostics (degraded mode fault)
+void budget_cycle_init(BudgetCycle* cycle, const char* name, BudgetTask* tasks, int task_count,
+                       uint32_t deadline_us);
+
+// Run one cycle. A non-critical task only runs in its slot if its
+// predicted time plus that of the critical tasks still to come fits the
+// deadline; otherwise it moves to a slack pass after the critical tasks.
+// Any deferral or shed puts the cycle in degraded mode and reports
+// FAULT_CYCLE_DEGRADED; BUDGET_RECOVERY_CYCLES clean cycles clear it.
+void budget_run_cycle(BudgetCycle* cycle);
+void budget_print_status(const BudgetCycle* cycle);
+
+#endif // BUDGET_H
@@ -0,0 +1,69 @@
+#include "change.h"
+#include <stdio.h>
+#include <string.h>
+
+static ChangeTracker* trackers[CHANGE_MAX_TRACKERS];
+static int tracker_count = 0;
+static bool tracking_enabled = true;
+
+void change_tracker_init(ChangeTracker* tracker, const char* name) {
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->name = name;
+
+    // Modules are re-initialised between bench runs; register each tracker once
+    for (int i = 0; i < tracker_count; i++) {
+        if (trackers[i] == tracker) return;
+    }
+    if (tracker_count < CHANGE_MAX_TRACKERS) {
+        trackers[tracker_count++] = tracker;
+    }
+}
+
+bool change_tracker_update(ChangeTracker* tracker, const uint32_t* inputs, int count) {
+    if (count > CHANGE_MAX_INPUTS) count = CHANGE_MAX_INPUTS;
+    bool moved = !tracker->primed || !tracking_enabled ||
+                 ++tracker->since_full >= CHANGE_REFRESH_CYCLES;
+    for (int i = 0; i < count; i++) {
+        moved |= inputs[i] != tracker->seen[i];
+        tracker->seen[i] = inputs[i];
+    }
+    if (moved) {
+        tracker->primed = true;
+        tracker->since_full = 0;
+        tracker->full_updates++;
+    } else {
+        tracker->skipped_updates++;
+    }
+    return moved;
+}
+
+void change_set_enabled(bool enabled) {
+    tracking_enabled = enabled;
+}
+
+bool change_is_enabled(void) {
+    return tracking_enabled;
+}
+
+void change_get_totals(uint32_t* full_updates, uint32_t* skipped_updates) {
+    *full_updates = 0;
+    *skipped_updates = 0;
+    for (int i = 0; i < tracker_count; i++) {
+        *full_updates += trackers[i]->full_updates;
+        *skipped_updates += trackers[i]->skipped_updates;
+    }
+}
+
+void change_print_status(void) {
+    printf("\n=== Change-Driven Updates ===\n");
+    if (!tracking_enabled) {
+        printf("Tracking disabled - every update is a full one\n");
+    }
+    for (int i = 0; i < tracker_count; i++) {
+        const ChangeTracker* t = trackers[i];
+        uint32_t total = t->full_updates + t->skipped_updates;
+        printf("%-14s %6u full  %6u skipped  (%.0f%% skipped)\n", t->name, t->full_updates,
+               t->skipped_updates, total > 0 ? 100.0 * t->skipped_updates / total : 0.0);
+    }
+    printf("=============================\n");
+}
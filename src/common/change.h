@@ -0,0 +1,46 @@
+#ifndef CHANGE_H
+#define CHANGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CHANGE_MAX_INPUTS       4
+#define CHANGE_MAX_TRACKERS     8
+#define CHANGE_REFRESH_CYCLES   50    // Full update at least every this many cycles
+
+// Change-driven updates. A module that publishes state keeps a generation
+// counter in its state struct and bumps it whenever a value it publishes
+// changes. A module that reads other modules' state keeps a ChangeTracker
+// over the generations it reads and skips its recompute (and the CAN frame
+// that would repeat it) when none of them moved. A full update is still
+// forced every CHANGE_REFRESH_CYCLES, as a heartbeat for periodic frames
+// and so a missed bump cannot freeze a module.
+typedef struct {
+    const char* name;
+    uint32_t seen[CHANGE_MAX_INPUTS];  // Input generations at the last full update
+    uint32_t since_full;
+    uint32_t full_updates;
+    uint32_t skipped_updates;
+    bool primed;                       // False until the first full update
+} ChangeTracker;
+
+// Bump a published generation when the value behind it changed
+static inline void change_publish(uint32_t* generation, bool changed) {
+    *generation += changed ? 1u : 0u;
+}
+
+// Dependencies: none
+void change_tracker_init(ChangeTracker* tracker, const char* name);
+
+// True when the caller must run its full update: an input generation
+// moved, the tracker is new or the refresh interval ran out. Counts the
+// outcome either way.
+bool change_tracker_update(ChangeTracker* tracker, const uint32_t* inputs, int count);
+
+// With tracking disabled every update is a full one (to compare against)
+void change_set_enabled(bool enabled);
+bool change_is_enabled(void);
+void change_get_totals(uint32_t* full_updates, uint32_t* skipped_updates);
+void change_print_status(void);
+
+#endif // CHANGE_H
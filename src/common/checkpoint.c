@@ -0,0 +1,286 @@
+#include "checkpoint.h"
+#include "rng.h"
+#include "fixed.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FNV_OFFSET 0x811C9DC5u
+#define FNV_PRIME  0x01000193u
+
+typedef struct {
+    const char* name;
+    uint32_t name_hash;
+    void* data;
+    size_t size;
+    uint32_t image_offset;       // Resolved against the open image, 0 = not present
+} Block;
+
+static Block blocks[CHECKPOINT_MAX_SECTIONS];
+static CheckpointState checkpoint_state = {0};
+static const uint8_t* image = NULL;
+static bool resolved = false;    // image_offset valid for every block
+
+static uint32_t fnv1a(uint32_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static double elapsed_us(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e6 + (end.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static size_t align_up(size_t value) {
+    return (value + CHECKPOINT_ALIGN - 1) & ~(size_t)(CHECKPOINT_ALIGN - 1);
+}
+
+// Independent of registration order, so programs that initialise the
+// modules in a different order share images
+static uint32_t layout_hash(void) {
+    uint32_t hash = sizeof(real_t) == sizeof(float) ? 0x4C464C54u : 0x51313631u;
+    for (int i = 0; i < checkpoint_state.section_count; i++) {
+        uint32_t size = (uint32_t)blocks[i].size;
+        hash += fnv1a(blocks[i].name_hash, &size, sizeof(size)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+void checkpoint_register(const char* name, void* data, size_t size) {
+    uint32_t name_hash = fnv1a(FNV_OFFSET, name, strlen(name));
+    int index = 0;
+    while (index < checkpoint_state.section_count && blocks[index].name_hash != name_hash) {
+        index++;
+    }
+    if (index == checkpoint_state.section_count) {
+        if (index == CHECKPOINT_MAX_SECTIONS) {
+            printf("[CHECKPOINT] Section table full - cannot register %s\n", name);
+            checkpoint_state.table_full = true;
+            return;
+        }
+        checkpoint_state.section_count++;
+    } else {
+        checkpoint_state.state_bytes -= blocks[index].size;
+    }
+    blocks[index] = (Block){ name, name_hash, data, size, 0 };
+    checkpoint_state.state_bytes += size;
+    resolved = false;
+}
+
+bool checkpoint_save(const char* path) {
+    if (checkpoint_state.table_full) {
+        printf("[CHECKPOINT] Cannot save %s: some state did not fit the section table\n", path);
+        return false;
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int count = checkpoint_state.section_count;
+    size_t offset = align_up(sizeof(CheckpointHeader) + count * sizeof(CheckpointSection));
+    size_t total = offset;
+    for (int i = 0; i < count; i++) {
+        total += align_up(blocks[i].size);
+    }
+    uint8_t* buffer = calloc(1, total);
+    if (buffer == NULL) return false;
+
+    CheckpointHeader* header = (CheckpointHeader*)buffer;
+    CheckpointSection* sections = (CheckpointSection*)(buffer + sizeof(CheckpointHeader));
+    size_t payload_start = offset;
+    for (int i = 0; i < count; i++) {
+        sections[i] = (CheckpointSection){ blocks[i].name_hash, (uint32_t)offset, (uint32_t)blocks[i].size, 0 };
+        memcpy(buffer + offset, blocks[i].data, blocks[i].size);
+        offset += align_up(blocks[i].size);
+    }
+    *header = (CheckpointHeader){
+        .magic = CHECKPOINT_MAGIC,
+        .version = CHECKPOINT_VERSION,
+        .header_bytes = sizeof(CheckpointHeader),
+        .section_count = (uint32_t)count,
+        .layout_hash = layout_hash(),
+        .seed = rng_get_seed(),
+        .saved_unix = (uint64_t)time(NULL),
+        .image_bytes = (uint32_t)total,
+        .payload_hash = fnv1a(FNV_OFFSET, buffer + payload_start, total - payload_start),
+    };
+
+    // Write beside the target and rename over it, so a reset mid-save
+    // leaves the previous image intact
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && write(fd, buffer, total) == (ssize_t)total;
+    ok = fd >= 0 && close(fd) == 0 && ok;
+    ok = ok && rename(temp_path, path) == 0;
+    free(buffer);
+    if (!ok) {
+        printf("[CHECKPOINT] Cannot write %s\n", path);
+        unlink(temp_path);
+        return false;
+    }
+    checkpoint_state.saves++;
+    checkpoint_state.save_us = (float)elapsed_us(&start);
+    return true;
+}
+
+void checkpoint_close(void) {
+    if (image != NULL) {
+        munmap((void*)image, checkpoint_state.image_bytes);
+    }
+    image = NULL;
+    resolved = false;
+    checkpoint_state.image_open = false;
+    checkpoint_state.image_bytes = 0;
+}
+
+// Find each registered block's payload in the image
+static bool resolve(void) {
+    const CheckpointHeader* header = (const CheckpointHeader*)image;
+    const CheckpointSection* sections = (const CheckpointSection*)(image + sizeof(CheckpointHeader));
+    if (header->layout_hash != layout_hash() || header->section_count != (uint32_t)checkpoint_state.section_count) {
+        return false;
+    }
+    for (int i = 0; i < checkpoint_state.section_count; i++) {
+        blocks[i].image_offset = 0;
+        for (uint32_t s = 0; s < header->section_count; s++) {
+            if (sections[s].name_hash == blocks[i].name_hash && sections[s].size == blocks[i].size) {
+                blocks[i].image_offset = sections[s].offset;
+                break;
+            }
+        }
+        if (blocks[i].image_offset == 0) return false;
+    }
+    resolved = true;
+    return true;
+}
+
+static bool reject(const char* path, const char* reason) {
+    printf("[CHECKPOINT] %s rejected: %s\n", path, reason);
+    checkpoint_state.rejected++;
+    checkpoint_close();
+    return false;
+}
+
+bool checkpoint_open(const char* path) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    checkpoint_close();
+    if (checkpoint_state.table_full) {
+        printf("[CHECKPOINT] Cannot open %s: some state did not fit the section table\n", path);
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("[CHECKPOINT] Cannot open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(CheckpointHeader)) {
+        close(fd);
+        return reject(path, "too short");
+    }
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("[CHECKPOINT] Cannot map %s\n", path);
+        return false;
+    }
+    image = map;
+    checkpoint_state.image_bytes = size;
+    checkpoint_state.image_path = path;
+
+    const CheckpointHeader* header = map;
+    if (header->magic != CHECKPOINT_MAGIC || header->version != CHECKPOINT_VERSION ||
+        header->header_bytes != sizeof(CheckpointHeader) || header->image_bytes != size ||
+        header->section_count > CHECKPOINT_MAX_SECTIONS) {
+        return reject(path, "not a checkpoint image of this version");
+    }
+    size_t payload_start = align_up(sizeof(CheckpointHeader) + header->section_count * sizeof(CheckpointSection));
+    const CheckpointSection* sections = (const CheckpointSection*)(image + sizeof(CheckpointHeader));
+    for (uint32_t s = 0; s < header->section_count; s++) {
+        if (sections[s].offset < payload_start || (uint64_t)sections[s].offset + sections[s].size > size) {
+            return reject(path, "section outside the image");
+        }
+    }
+    if (payload_start > size || fnv1a(FNV_OFFSET, image + payload_start, size - payload_start) != header->payload_hash) {
+        return reject(path, "payload checksum mismatch");
+    }
+    if (!resolve()) {
+        return reject(path, "state layout differs from this build");
+    }
+
+    checkpoint_state.image_open = true;
+    checkpoint_state.image_seed = header->seed;
+    checkpoint_state.open_us = (float)elapsed_us(&start);
+    return true;
+}
+
+bool checkpoint_restore(void) {
+    if (image == NULL) return false;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // A module registered again with a new size since the image was opened
+    if (!resolved && !resolve()) {
+        printf("[CHECKPOINT] %s no longer matches the registered state\n", checkpoint_state.image_path);
+        return false;
+    }
+    for (int i = 0; i < checkpoint_state.section_count; i++) {
+        memcpy(blocks[i].data, image + blocks[i].image_offset, blocks[i].size);
+    }
+    rng_set_seed(checkpoint_state.image_seed);
+
+    float us = (float)elapsed_us(&start);
+    checkpoint_state.restores++;
+    checkpoint_state.restore_us = us;
+    if (us > checkpoint_state.max_restore_us) checkpoint_state.max_restore_us = us;
+    return true;
+}
+
+uint32_t checkpoint_digest(void) {
+    uint32_t hash = FNV_OFFSET;
+    for (int i = 0; i < checkpoint_state.section_count; i++) {
+        hash = fnv1a(hash, blocks[i].data, blocks[i].size);
+    }
+    return hash;
+}
+
+void checkpoint_print_status(void) {
+    printf("\n=== Checkpoint ===\n");
+    printf("Registered state: %d sections, %zu bytes\n",
+           checkpoint_state.section_count, checkpoint_state.state_bytes);
+    if (checkpoint_state.saves > 0) {
+        printf("Saves: %u (last %.0f us)\n", checkpoint_state.saves, checkpoint_state.save_us);
+    }
+    if (checkpoint_state.image_open) {
+        printf("Image: %s, %zu bytes, seed %llu (mapped and checked in %.0f us)\n",
+               checkpoint_state.image_path, checkpoint_state.image_bytes,
+               (unsigned long long)checkpoint_state.image_seed, checkpoint_state.open_us);
+    }
+    if (checkpoint_state.restores > 0) {
+        printf("Restores: %u (last %.1f us, max %.1f us)\n", checkpoint_state.restores,
+               checkpoint_state.restore_us, checkpoint_state.max_restore_us);
+    }
+    if (checkpoint_state.table_full) {
+        printf("Section table full (%d sections) - checkpoints disabled\n", CHECKPOINT_MAX_SECTIONS);
+    }
+    if (checkpoint_state.rejected > 0) {
+        printf("Rejected images: %u\n", checkpoint_state.rejected);
+    }
+    printf("==================\n");
+}
+
+CheckpointState* checkpoint_get_state(void) {
+    return &checkpoint_state;
+}
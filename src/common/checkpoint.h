@@ -0,0 +1,90 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CHECKPOINT_MAGIC         0x314B4345u   // "ECK1"
+#define CHECKPOINT_VERSION       1
+#define CHECKPOINT_MAX_SECTIONS  128           // Headroom well above what the modules register
+#define CHECKPOINT_ALIGN         16            // Payload alignment in the image
+
+// Whole-ECU checkpoints. Each module registers the blocks of static state
+// that make up its run state from its init; a checkpoint is a copy of
+// all of them. Blocks must hold no pointers (addresses differ between
+// runs), so a module registers pointer-free parts only and rebuilds the
+// rest - file mappings, handlers, worker threads - in its init as usual.
+//
+// Image file (little-endian):
+//   CheckpointHeader
+//   CheckpointSection[section_count]
+//   payloads, CHECKPOINT_ALIGN-aligned, in section order
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_bytes;       // sizeof(CheckpointHeader)
+    uint32_t section_count;
+    uint32_t layout_hash;        // Section names and sizes, and the real_t build
+    uint64_t seed;               // Run seed the state was produced with
+    uint64_t saved_unix;
+    uint32_t image_bytes;
+    uint32_t payload_hash;       // FNV-1a over all payloads
+} CheckpointHeader;
+
+typedef struct {
+    uint32_t name_hash;
+    uint32_t offset;             // From the start of the image
+    uint32_t size;
+    uint32_t reserved;
+} CheckpointSection;
+
+typedef struct {
+    int section_count;           // Registered blocks
+    bool table_full;             // A block was refused; saves and opens fail
+    size_t state_bytes;
+    bool image_open;
+    const char* image_path;
+    size_t image_bytes;
+    uint64_t image_seed;
+    uint32_t saves;
+    uint32_t restores;
+    uint32_t rejected;           // Images that failed validation
+    float save_us;
+    float open_us;               // Map and validate
+    float restore_us;            // Last restore
+    float max_restore_us;
+} CheckpointState;
+
+// Register a block of module state. Registering a name again (modules
+// are re-initialised between bench runs) replaces its block. A block that
+// does not fit the section table makes every later save and open fail,
+// rather than leave that module out of the image.
+void checkpoint_register(const char* name, void* data, size_t size);
+
+// Register a variable under "prefix.variable", or the tail of a struct
+// from one field on (to skip a leading name pointer)
+#define CHECKPOINT_VAR(prefix, var) \
+    checkpoint_register(prefix "." #var, &(var), sizeof(var))
+#define CHECKPOINT_VAR_FROM(prefix, var, field) \
+    checkpoint_register(prefix "." #var, (char*)&(var) + offsetof(__typeof__(var), field), \
+                        sizeof(var) - offsetof(__typeof__(var), field))
+
+// Dependencies: none (modules register with it)
+bool checkpoint_save(const char* path);
+
+// Map an image and check it matches this build's registered layout; the
+// image stays mapped so it can be restored any number of times
+bool checkpoint_open(const char* path);
+
+// Copy the open image over every registered block. Call with the worker
+// threads stopped or not yet started.
+bool checkpoint_restore(void);
+void checkpoint_close(void);
+
+// FNV-1a over the live registered state, to compare two states
+uint32_t checkpoint_digest(void);
+void checkpoint_print_status(void);
+CheckpointState* checkpoint_get_state(void);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,107 @@
+#include "fft.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef float v4f __attribute__((vector_size(16)));
+
+// Unaligned vector load/store; compiles to a single movups/ld1
+static inline v4f load4(const float* p) {
+    v4f v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store4(float* p, v4f v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+void fft_plan_free(FftPlan* plan) {
+    free(plan->bit_reverse);
+    free(plan->twiddle_re);
+    free(plan->twiddle_im);
+    memset(plan, 0, sizeof(*plan));
+}
+
+bool fft_plan_init(FftPlan* plan, uint32_t size) {
+    memset(plan, 0, sizeof(*plan));
+    if (size < 4 || size > FFT_MAX_SIZE || (size & (size - 1)) != 0) return false;
+
+    plan->size = size;
+    while ((1u << plan->log2_size) < size) plan->log2_size++;
+    plan->bit_reverse = malloc(size * sizeof(uint16_t));
+    plan->twiddle_re = malloc(size * sizeof(float));
+    plan->twiddle_im = malloc(size * sizeof(float));
+    if (plan->bit_reverse == NULL || plan->twiddle_re == NULL || plan->twiddle_im == NULL) {
+        fft_plan_free(plan);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        uint32_t reversed = 0;
+        for (uint32_t b = 0; b < plan->log2_size; b++) {
+            reversed |= ((i >> b) & 1u) << (plan->log2_size - 1 - b);
+        }
+        plan->bit_reverse[i] = (uint16_t)reversed;
+    }
+
+    // One contiguous twiddle run per stage, so the vector loop reads them linearly
+    for (uint32_t half = 1; half < size; half <<= 1) {
+        for (uint32_t k = 0; k < half; k++) {
+            double angle = -M_PI * k / half;
+            plan->twiddle_re[half - 1 + k] = (float)cos(angle);
+            plan->twiddle_im[half - 1 + k] = (float)sin(angle);
+        }
+    }
+    return true;
+}
+
+void fft_forward(const FftPlan* plan, float* re, float* im) {
+    uint32_t n = plan->size;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = plan->bit_reverse[i];
+        if (j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // Half-widths 1 and 2 are narrower than a vector
+    for (uint32_t half = 1; half < 4; half <<= 1) {
+        const float* wr = plan->twiddle_re + half - 1;
+        const float* wi = plan->twiddle_im + half - 1;
+        for (uint32_t start = 0; start < n; start += 2 * half) {
+            for (uint32_t k = 0; k < half; k++) {
+                uint32_t a = start + k, b = a + half;
+                float tr = re[b] * wr[k] - im[b] * wi[k];
+                float ti = re[b] * wi[k] + im[b] * wr[k];
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+
+    for (uint32_t half = 4; half < n; half <<= 1) {
+        const float* wr = plan->twiddle_re + half - 1;
+        const float* wi = plan->twiddle_im + half - 1;
+        for (uint32_t start = 0; start < n; start += 2 * half) {
+            float* ar = re + start;
+            float* ai = im + start;
+            float* br = ar + half;
+            float* bi = ai + half;
+            for (uint32_t k = 0; k < half; k += 4) {
+                v4f xr = load4(br + k), xi = load4(bi + k);
+                v4f cr = load4(wr + k), ci = load4(wi + k);
+                v4f tr = xr * cr - xi * ci;
+                v4f ti = xr * ci + xi * cr;
+                v4f ur = load4(ar + k), ui = load4(ai + k);
+                store4(ar + k, ur + tr);
+                store4(ai + k, ui + ti);
+                store4(br + k, ur - tr);
+                store4(bi + k, ui - ti);
+            }
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FFT_MAX_SIZE 4096
+
+// Radix-2 complex FFT on split real/imaginary arrays. The butterflies of
+// every stage wider than 4 run four at a time in GCC vector types, which
+// compile to SSE on x86-64 and NEON on ARM without target flags.
+// Analysis code, not control code: always float, also in FIXED_POINT builds.
+typedef struct {
+    uint32_t size;
+    uint32_t log2_size;
+    uint16_t* bit_reverse;     // Input permutation
+    float* twiddle_re;         // Stage with half-width h starts at index h - 1
+    float* twiddle_im;
+} FftPlan;
+
+bool fft_plan_init(FftPlan* plan, uint32_t size);
+void fft_plan_free(FftPlan* plan);
+
+// In-place forward transform; re and im hold plan->size values each
+void fft_forward(const FftPlan* plan, float* re, float* im);
+
+#endif // FFT_H
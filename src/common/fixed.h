@@ -0,0 +1,97 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Arithmetic type for the control models (engine, transmission, hydraulics,
+// PTO, implement, PID loops). Builds with -DECU_FIXED_POINT (make FIXED_POINT=1) use
+// signed Q16.16 with saturating helpers for FPU-less controllers: range
+// +/-32767.99, resolution 1.5e-5. Other builds use float. Model code goes
+// through the helpers only, so both builds share one source; outside the
+// models, read values with real_to_float().
+//
+// Fixed vs float agreement is checked by `make fixed-check`, which replays
+// a scripted drive cycle in both builds and fails if any model output
+// differs by more than FIXED_TOLERANCE_PERCENT of its full-scale range.
+
+#define FIXED_TOLERANCE_PERCENT 0.5f
+
+#ifdef ECU_FIXED_POINT
+
+typedef int32_t real_t;
+
+#define REAL_FRAC_BITS 16
+#define REAL_ONE       (1 << REAL_FRAC_BITS)
+#define REAL_MAX       INT32_MAX
+#define REAL_MIN       (-INT32_MAX)
+
+// Compile-time constant, rounded to nearest
+#define REAL(x) ((real_t)((x) * 65536.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+static inline real_t real_saturate(int64_t value) {
+    return value > REAL_MAX ? REAL_MAX : (value < REAL_MIN ? REAL_MIN : (real_t)value);
+}
+
+static inline real_t real_add(real_t a, real_t b) {
+    return real_saturate((int64_t)a + b);
+}
+
+static inline real_t real_sub(real_t a, real_t b) {
+    return real_saturate((int64_t)a - b);
+}
+
+static inline real_t real_mul(real_t a, real_t b) {
+    int64_t product = (int64_t)a * b;
+    return real_saturate((product + (product < 0 ? -(REAL_ONE / 2) : REAL_ONE / 2)) / REAL_ONE);
+}
+
+static inline real_t real_div(real_t a, real_t b) {
+    if (b == 0) return a >= 0 ? REAL_MAX : REAL_MIN;
+    int64_t numerator = (int64_t)a * REAL_ONE;
+    int64_t half = (b < 0 ? -(int64_t)b : b) / 2;
+    return real_saturate((numerator + ((numerator < 0) != (b < 0) ? -half : half)) / b);
+}
+
+static inline real_t real_from_int(int32_t value) {
+    return real_saturate((int64_t)value * REAL_ONE);
+}
+
+// Truncates toward zero, like a C cast
+static inline int32_t real_to_int(real_t value) {
+    return value / REAL_ONE;
+}
+
+static inline float real_to_float(real_t value) {
+    return value * (1.0f / REAL_ONE);
+}
+
+static inline real_t real_from_float(float value) {
+    return real_saturate((int64_t)lroundf(value * REAL_ONE));
+}
+
+static inline real_t real_min(real_t a, real_t b) { return a < b ? a : b; }
+static inline real_t real_max(real_t a, real_t b) { return a > b ? a : b; }
+static inline real_t real_abs(real_t a) { return a < 0 ? real_saturate(-(int64_t)a) : a; }
+
+#else
+
+typedef float real_t;
+
+#define REAL(x) ((real_t)(x))
+
+static inline real_t real_add(real_t a, real_t b) { return a + b; }
+static inline real_t real_sub(real_t a, real_t b) { return a - b; }
+static inline real_t real_mul(real_t a, real_t b) { return a * b; }
+static inline real_t real_div(real_t a, real_t b) { return a / b; }
+static inline real_t real_from_int(int32_t value) { return (real_t)value; }
+static inline int32_t real_to_int(real_t value) { return (int32_t)value; }
+static inline float real_to_float(real_t value) { return value; }
+static inline real_t real_from_float(float value) { return value; }
+static inline real_t real_min(real_t a, real_t b) { return fminf(a, b); }
+static inline real_t real_max(real_t a, real_t b) { return fmaxf(a, b); }
+static inline real_t real_abs(real_t a) { return fabsf(a); }
+
+#endif // ECU_FIXED_POINT
+
+#endif // FIXED_H
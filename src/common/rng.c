@@ -0,0 +1,44 @@
+#include "rng.h"
+
+static uint64_t run_seed = RNG_DEFAULT_SEED;
+
+void rng_set_seed(uint64_t seed) {
+    run_seed = seed;
+}
+
+uint64_t rng_get_seed(void) {
+    return run_seed;
+}
+
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Expand (seed, stream) through SplitMix64 - never yields the all-zero state
+void rng_seed(Rng* rng, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ull);
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&x);
+    }
+}
+
+void rng_fill_u64(Rng* rng, uint64_t* out, size_t count) {
+    // Local copy keeps the state in registers across the loop
+    Rng local = *rng;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = rng_next(&local);
+    }
+    *rng = local;
+}
+
+void rng_fill_uniform(Rng* rng, float* out, size_t count, float low, float high) {
+    Rng local = *rng;
+    float span = high - low;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = low + span * ((rng_next(&local) >> 40) * 0x1.0p-24f);
+    }
+    *rng = local;
+}
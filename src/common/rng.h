@@ -0,0 +1,58 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RNG_DEFAULT_SEED 0x5EEDull
+
+// Per-instance xoshiro256** generator. Each module (or simulated vehicle)
+// owns one and seeds it from the run seed plus its own stream number, so
+// streams never interleave and the same seed replays a run bit-for-bit.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(Rng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+// Uniform integer in [0, bound) - multiply-shift with rejection, no modulo bias
+static inline uint32_t rng_below(Rng* rng, uint32_t bound) {
+    uint64_t m = (rng_next(rng) >> 32) * bound;
+    if ((uint32_t)m < bound) {
+        uint32_t threshold = -bound % bound;
+        while ((uint32_t)m < threshold) {
+            m = (rng_next(rng) >> 32) * bound;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+// Uniform double in [0, 1) from the top 53 bits
+static inline double rng_uniform(Rng* rng) {
+    return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+// Run-wide seed (--seed), read by each module's init
+void rng_set_seed(uint64_t seed);
+uint64_t rng_get_seed(void);
+
+void rng_seed(Rng* rng, uint64_t seed, uint64_t stream);
+void rng_fill_u64(Rng* rng, uint64_t* out, size_t count);
+void rng_fill_uniform(Rng* rng, float* out, size_t count, float low, float high);
+
+#endif // RNG_H
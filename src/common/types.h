@@ -19,11 +19,25 @@ typedef enum {
     LOG_CRITICAL = 3
 } LogLevel;
 
+// Module IDs - module names are interned in a static string table
+// (see diagnostics_module_name) so records carry a byte instead of a copy
+typedef enum {
+    MODULE_ENGINE = 0,
+    MODULE_HYDRAULICS,
+    MODULE_TRANSMISSION,
+    MODULE_PTO,
+    MODULE_TELEMATICS,
+    MODULE_IMPLEMENT,
+    MODULE_DIAGNOSTICS,
+    MODULE_CANBUS,
+    MODULE_COUNT
+} ModuleId;
+
 typedef struct {
     uint32_t timestamp;
-    LogLevel level;
-    char message[256];
-    char module[64];
+    uint16_t message_id;     // FaultId - text via diagnostics_fault_description
+    uint8_t level;           // LogLevel
+    uint8_t module_id;       // ModuleId
 } LogEntry;
 
 typedef struct {
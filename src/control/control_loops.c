@@ -0,0 +1,345 @@
+#include "control_loops.h"
+#include "../common/rng.h"
+#include "../common/checkpoint.h"
+#include "../common/types.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#define PERIOD_NS (1000000000L / CONTROL_RATE_HZ)
+#define TICK_S    (1.0 / CONTROL_RATE_HZ)
+
+// Hitch plant: valve flow scales with supply pressure; working tines pull
+// the implement deeper, which the depth loop cancels by feed-forward
+#define VALVE_CM_S_PER_PCT  0.12    // Hitch speed per % valve opening at nominal pressure
+#define NOMINAL_PSI         2000.0
+#define MIN_VALVE_PSI       100.0   // Below this the valve cannot move the hitch
+#define SUCTION_CM_S        2.0     // Tine suction with the valve closed
+#define HITCH_MAX_DEPTH_CM  40.0
+#define DEPTH_NOISE_CM      0.05    // Position sensor noise, peak
+
+// Draft plant
+#define SOIL_KN_PER_CM_M    0.22    // Draft per cm of depth per metre of width, average soil
+#define SOIL_WANDER         0.003   // Per draft tick random walk of the soil resistance
+#define SOIL_MIN            0.7
+#define SOIL_MAX            1.3
+#define DRAFT_FILTER_S      0.2     // Hitch pin sensor filter
+
+#define CONTROL_RNG_STREAM  (MODULE_COUNT + MODULE_IMPLEMENT)
+
+static ControlState control_state = {0};
+
+// The worker ticks under this lock; input setters and status reads from
+// the main loop take it too
+static pthread_mutex_t control_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t worker;
+
+static const char* loop_names[CONTROL_LOOP_COUNT] = { "Depth", "Draft", "PTO speed" };
+static const uint32_t loop_dividers[CONTROL_LOOP_COUNT] = {
+    CONTROL_DEPTH_DIVIDER, CONTROL_DRAFT_DIVIDER, CONTROL_PTO_DIVIDER
+};
+
+static const PidGains default_gains[CONTROL_LOOP_COUNT] = {
+    // kp, ki, kd, derivative filter, output range, setpoint weight
+    [CONTROL_LOOP_DEPTH]     = { REAL(50),  REAL(15),  REAL(1.5), REAL(0.05), REAL(-100), REAL(100),  REAL(1) },  // valve %
+    // The target depth already carries setpoint steps; the draft loop only
+    // corrects for soil, so its P term acts on the measurement alone
+    [CONTROL_LOOP_DRAFT]     = { REAL(0.2), REAL(0.5), REAL(0),   REAL(0.1),  REAL(-5),   REAL(5),    REAL(0) },  // depth trim cm
+    [CONTROL_LOOP_PTO_SPEED] = { REAL(3),   REAL(0.8), REAL(0),   REAL(0.1),  REAL(1500), REAL(2400), REAL(1) },  // engine rpm
+};
+
+static Pid loops[CONTROL_LOOP_COUNT];
+
+// Latest inputs from the main loop
+static struct {
+    bool working;
+    real_t target_depth_cm;
+    real_t width_m;
+    bool draft_control;
+    real_t pressure_psi;
+    real_t flow_share;
+    bool pto_engaged;
+    int pto_target_rpm;
+    int pto_rpm;
+} inputs;
+
+// Plant state
+static Rng control_rng;
+static real_t hitch_depth_cm;
+static real_t soil_factor;
+
+static float elapsed_us(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1e6f + (end->tv_nsec - start->tv_nsec) / 1e3f;
+}
+
+void control_init(void) {
+    printf("[CONTROL] Initializing control loops at %d Hz\n", CONTROL_RATE_HZ);
+    pthread_mutex_lock(&control_lock);
+    memset(&control_state, 0, sizeof(control_state));
+    memset(&inputs, 0, sizeof(inputs));
+    inputs.flow_share = REAL(1);
+    for (int i = 0; i < CONTROL_LOOP_COUNT; i++) {
+        pid_init(&loops[i], &default_gains[i]);
+    }
+    rng_seed(&control_rng, rng_get_seed(), CONTROL_RNG_STREAM);
+    hitch_depth_cm = REAL(0);
+    soil_factor = REAL(1);
+    control_state.active[CONTROL_LOOP_DEPTH] = true;
+    pthread_mutex_unlock(&control_lock);
+
+    CHECKPOINT_VAR("control", control_state);
+    CHECKPOINT_VAR("control", inputs);
+    CHECKPOINT_VAR("control", loops);
+    CHECKPOINT_VAR("control", control_rng);
+    CHECKPOINT_VAR("control", hitch_depth_cm);
+    CHECKPOINT_VAR("control", soil_factor);
+}
+
+void control_set_gains(ControlLoopId loop, const PidGains* gains) {
+    if (loop >= CONTROL_LOOP_COUNT) return;
+    pthread_mutex_lock(&control_lock);
+    loops[loop].gains = *gains;
+    pthread_mutex_unlock(&control_lock);
+}
+
+void control_get_gains(ControlLoopId loop, PidGains* gains) {
+    if (loop >= CONTROL_LOOP_COUNT) return;
+    pthread_mutex_lock(&control_lock);
+    *gains = loops[loop].gains;
+    pthread_mutex_unlock(&control_lock);
+}
+
+void control_set_hitch(bool working, real_t target_depth_cm, real_t width_m,
+                       bool draft_control, real_t pressure_psi) {
+    pthread_mutex_lock(&control_lock);
+    inputs.working = working;
+    inputs.target_depth_cm = target_depth_cm;
+    inputs.width_m = width_m;
+    inputs.draft_control = draft_control;
+    inputs.pressure_psi = pressure_psi;
+    pthread_mutex_unlock(&control_lock);
+}
+
+void control_set_hitch_flow_share(real_t share) {
+    pthread_mutex_lock(&control_lock);
+    inputs.flow_share = real_min(real_max(share, REAL(0)), REAL(1));
+    pthread_mutex_unlock(&control_lock);
+}
+
+void control_set_pto_speed(bool engaged, int target_rpm, int measured_rpm) {
+    pthread_mutex_lock(&control_lock);
+    inputs.pto_engaged = engaged && target_rpm > 0;
+    inputs.pto_target_rpm = target_rpm;
+    inputs.pto_rpm = measured_rpm;
+    pthread_mutex_unlock(&control_lock);
+}
+
+// Uniform in [-peak, peak] in steps of peak/100; the fraction is formed
+// first so both builds draw the same values
+static real_t sensor_noise(real_t peak) {
+    real_t fraction = real_div(real_from_int((int32_t)rng_below(&control_rng, 201) - 100), REAL(100));
+    return real_mul(peak, fraction);
+}
+
+// Valve speed gain at the current supply pressure and flow share, cm/s per %
+static real_t valve_gain(void) {
+    if (inputs.pressure_psi < REAL(MIN_VALVE_PSI)) return REAL(0);
+    real_t gain = real_mul(REAL(VALVE_CM_S_PER_PCT), real_div(inputs.pressure_psi, REAL(NOMINAL_PSI)));
+    return real_mul(gain, inputs.flow_share);
+}
+
+// Hitch and draft plants, integrated every tick with the last valve command
+static void update_plant(real_t dt) {
+    real_t speed = real_mul(valve_gain(), control_state.valve_percent);
+    if (inputs.working && hitch_depth_cm > REAL(0)) {
+        speed = real_add(speed, REAL(SUCTION_CM_S));
+    }
+    hitch_depth_cm = real_add(hitch_depth_cm, real_mul(speed, dt));
+    hitch_depth_cm = real_min(real_max(hitch_depth_cm, REAL(0)), REAL(HITCH_MAX_DEPTH_CM));
+
+    real_t draft = REAL(0);
+    if (inputs.working) {
+        draft = real_mul(real_mul(REAL(SOIL_KN_PER_CM_M), inputs.width_m),
+                         real_mul(hitch_depth_cm, soil_factor));
+    }
+    real_t alpha = real_div(dt, REAL(DRAFT_FILTER_S + TICK_S));
+    control_state.draft_kn = real_add(control_state.draft_kn,
+                                      real_mul(alpha, real_sub(draft, control_state.draft_kn)));
+}
+
+static void run_draft(real_t dt) {
+    bool active = inputs.working && inputs.draft_control && inputs.target_depth_cm > REAL(0);
+    if (active != control_state.active[CONTROL_LOOP_DRAFT]) {
+        pid_reset(&loops[CONTROL_LOOP_DRAFT], REAL(0));
+        control_state.active[CONTROL_LOOP_DRAFT] = active;
+    }
+    // Soil resistance wanders across the field
+    soil_factor = real_add(soil_factor, sensor_noise(REAL(SOIL_WANDER)));
+    soil_factor = real_min(real_max(soil_factor, REAL(SOIL_MIN)), REAL(SOIL_MAX));
+
+    if (!active) {
+        control_state.depth_trim_cm = REAL(0);
+        control_state.draft_setpoint_kn = REAL(0);
+        return;
+    }
+    // Hold the draft the target depth gives in average soil
+    control_state.draft_setpoint_kn = real_mul(real_mul(REAL(SOIL_KN_PER_CM_M), inputs.width_m),
+                                               inputs.target_depth_cm);
+    control_state.depth_trim_cm = pid_update(&loops[CONTROL_LOOP_DRAFT], control_state.draft_setpoint_kn,
+                                             control_state.draft_kn, REAL(0), dt);
+}
+
+static void run_depth(real_t dt) {
+    real_t setpoint = REAL(0);
+    real_t feed_forward = REAL(0);
+    if (inputs.working) {
+        setpoint = real_max(real_add(inputs.target_depth_cm, control_state.depth_trim_cm), REAL(0));
+        // Valve opening that cancels tine suction at the current pressure
+        real_t gain = valve_gain();
+        if (gain > REAL(0)) {
+            feed_forward = real_max(real_div(REAL(-SUCTION_CM_S), gain), REAL(-100));
+        }
+    }
+    control_state.depth_setpoint_cm = setpoint;
+    real_t measured = real_max(real_add(hitch_depth_cm, sensor_noise(REAL(DEPTH_NOISE_CM))), REAL(0));
+    control_state.valve_percent = pid_update(&loops[CONTROL_LOOP_DEPTH], setpoint, measured, feed_forward, dt);
+    control_state.depth_cm = hitch_depth_cm;
+}
+
+static void run_pto_speed(real_t dt) {
+    bool active = inputs.pto_engaged;
+    Pid* pid = &loops[CONTROL_LOOP_PTO_SPEED];
+    if (active && !control_state.active[CONTROL_LOOP_PTO_SPEED]) {
+        // Bumpless start from the engine speed that gives the measured PTO speed
+        real_t engine_rpm = real_mul(real_from_int(inputs.pto_rpm),
+                                     real_div(REAL(CONTROL_PTO_RATED_ENGINE_RPM), real_from_int(inputs.pto_target_rpm)));
+        pid_reset(pid, real_sub(engine_rpm, REAL(CONTROL_PTO_RATED_ENGINE_RPM)));
+    }
+    control_state.active[CONTROL_LOOP_PTO_SPEED] = active;
+    control_state.pto_rpm = inputs.pto_rpm;
+    if (!active) {
+        control_state.engine_request_rpm = REAL(0);
+        return;
+    }
+    control_state.engine_request_rpm = pid_update(pid, real_from_int(inputs.pto_target_rpm),
+                                                  real_from_int(inputs.pto_rpm),
+                                                  REAL(CONTROL_PTO_RATED_ENGINE_RPM), dt);
+}
+
+// One executive tick; loops run at their divided rates, outer before inner
+static void tick(void) {
+    uint32_t n = control_state.ticks++;
+    update_plant(REAL(TICK_S));
+    if (n % CONTROL_DRAFT_DIVIDER == 0) run_draft(REAL(CONTROL_DRAFT_DIVIDER * TICK_S));
+    if (n % CONTROL_DEPTH_DIVIDER == 0) run_depth(REAL(CONTROL_DEPTH_DIVIDER * TICK_S));
+    if (n % CONTROL_PTO_DIVIDER == 0) run_pto_speed(REAL(CONTROL_PTO_DIVIDER * TICK_S));
+    for (int i = 0; i < CONTROL_LOOP_COUNT; i++) {
+        control_state.saturated[i] = control_state.active[i] && loops[i].saturated;
+    }
+}
+
+void control_run_for(float seconds) {
+    long ticks = lroundf(seconds * CONTROL_RATE_HZ);
+    pthread_mutex_lock(&control_lock);
+    for (long i = 0; i < ticks; i++) {
+        tick();
+    }
+    pthread_mutex_unlock(&control_lock);
+}
+
+static void* control_thread(void* arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (;;) {
+        next.tv_nsec += PERIOD_NS;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        pthread_mutex_lock(&control_lock);
+        if (!control_state.running) {
+            pthread_mutex_unlock(&control_lock);
+            break;
+        }
+        // Missed a whole period: count it and restart the schedule from now
+        if (elapsed_us(&next, &start) > PERIOD_NS / 1000.0f) {
+            control_state.overruns++;
+            next = start;
+        }
+        tick();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        control_state.last_tick_us = elapsed_us(&start, &end);
+        if (control_state.last_tick_us > control_state.max_tick_us) {
+            control_state.max_tick_us = control_state.last_tick_us;
+        }
+        pthread_mutex_unlock(&control_lock);
+    }
+    return NULL;
+}
+
+bool control_start(void) {
+    pthread_mutex_lock(&control_lock);
+    bool already = control_state.running;
+    control_state.running = true;
+    pthread_mutex_unlock(&control_lock);
+    if (already) return true;
+
+    if (pthread_create(&worker, NULL, control_thread, NULL) != 0) {
+        printf("[CONTROL] Cannot start the control worker\n");
+        pthread_mutex_lock(&control_lock);
+        control_state.running = false;
+        pthread_mutex_unlock(&control_lock);
+        return false;
+    }
+    printf("[CONTROL] Depth %d Hz, draft %d Hz, PTO speed %d Hz\n",
+           CONTROL_RATE_HZ / CONTROL_DEPTH_DIVIDER, CONTROL_RATE_HZ / CONTROL_DRAFT_DIVIDER,
+           CONTROL_RATE_HZ / CONTROL_PTO_DIVIDER);
+    return true;
+}
+
+void control_stop(void) {
+    pthread_mutex_lock(&control_lock);
+    bool was_running = control_state.running;
+    control_state.running = false;
+    pthread_mutex_unlock(&control_lock);
+    if (was_running) {
+        pthread_join(worker, NULL);
+    }
+}
+
+void control_get_state(ControlState* out) {
+    pthread_mutex_lock(&control_lock);
+    *out = control_state;
+    pthread_mutex_unlock(&control_lock);
+}
+
+void control_print_status(void) {
+    ControlState s;
+    control_get_state(&s);
+
+    printf("\n=== CONTROL LOOPS ===\n");
+    for (int i = 0; i < CONTROL_LOOP_COUNT; i++) {
+        printf("%-10s %3d Hz  %-8s%s\n", loop_names[i], CONTROL_RATE_HZ / (int)loop_dividers[i],
+               s.active[i] ? "active" : "idle", s.saturated[i] ? "  (saturated)" : "");
+    }
+    printf("Hitch: %.2f cm (setpoint %.2f cm), valve %+.1f%%\n",
+           real_to_float(s.depth_cm), real_to_float(s.depth_setpoint_cm), real_to_float(s.valve_percent));
+    if (s.active[CONTROL_LOOP_DRAFT]) {
+        printf("Draft: %.1f kN (setpoint %.1f kN), depth trim %+.2f cm\n",
+               real_to_float(s.draft_kn), real_to_float(s.draft_setpoint_kn), real_to_float(s.depth_trim_cm));
+    }
+    if (s.active[CONTROL_LOOP_PTO_SPEED]) {
+        printf("PTO: %d RPM, engine speed request %.0f RPM\n", s.pto_rpm, real_to_float(s.engine_request_rpm));
+    }
+    printf("Ticks: %u at %d Hz, %u overruns, compute last %.2f us / max %.2f us\n",
+           s.ticks, CONTROL_RATE_HZ, s.overruns, s.last_tick_us, s.max_tick_us);
+    printf("=====================\n\n");
+}
@@ -0,0 +1,66 @@
+#ifndef CONTROL_LOOPS_H
+#define CONTROL_LOOPS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pid.h"
+
+#define CONTROL_RATE_HZ         100   // Executive tick; each loop runs every divider ticks
+#define CONTROL_DEPTH_DIVIDER   1     // Hitch position, 100 Hz
+#define CONTROL_PTO_DIVIDER     2     // PTO speed, 50 Hz
+#define CONTROL_DRAFT_DIVIDER   5     // Draft (outer loop over depth), 20 Hz
+
+#define CONTROL_PTO_RATED_ENGINE_RPM  2100  // Engine speed that gives rated PTO speed
+
+typedef enum {
+    CONTROL_LOOP_DEPTH = 0,
+    CONTROL_LOOP_DRAFT,
+    CONTROL_LOOP_PTO_SPEED,
+    CONTROL_LOOP_COUNT
+} ControlLoopId;
+
+// Control loops - a fixed-rate executive, independent of the slow main loop,
+// runs each PID at its own rate on a worker thread:
+//   depth:     hitch valve command (%) from hitch position, with a
+//              feed-forward that holds the implement weight at the
+//              current hydraulic pressure
+//   draft:     trims the depth setpoint to hold the nominal draft force
+//              for tillage implements
+//   PTO speed: engine speed request that holds the PTO at its rated speed
+//              against governor droop
+// The hitch and draft plants are simulated here at the loop rate.
+typedef struct {
+    bool running;
+    bool active[CONTROL_LOOP_COUNT];
+    bool saturated[CONTROL_LOOP_COUNT];
+    real_t depth_cm;              // Hitch position below ground
+    real_t depth_setpoint_cm;     // Implement target plus draft trim
+    real_t valve_percent;         // -100 raise .. +100 lower
+    real_t draft_kn;              // Filtered hitch pin force
+    real_t draft_setpoint_kn;
+    real_t depth_trim_cm;
+    int pto_rpm;                  // Measured, from the main loop
+    real_t engine_request_rpm;
+    uint32_t ticks;
+    uint32_t overruns;            // Ticks that started a full period late
+    float last_tick_us;
+    float max_tick_us;
+} ControlState;
+
+// Dependencies: none at runtime. Implement and PTO push their inputs;
+// Implement reads the hitch position back and Engine the speed request.
+void control_init(void);
+void control_set_gains(ControlLoopId loop, const PidGains* gains);
+void control_get_gains(ControlLoopId loop, PidGains* gains);
+void control_set_hitch(bool working, real_t target_depth_cm, real_t width_m,
+                       bool draft_control, real_t pressure_psi);
+// Fraction of the commanded hitch valve flow the pump delivers (flow sharing)
+void control_set_hitch_flow_share(real_t share);
+void control_set_pto_speed(bool engaged, int target_rpm, int measured_rpm);
+void control_run_for(float seconds);    // Synchronous ticks, for offline runs
+bool control_start(void);
+void control_stop(void);
+void control_get_state(ControlState* out);
+void control_print_status(void);
+
+#endif // CONTROL_LOOPS_H
@@ -0,0 +1,51 @@
+#include "pid.h"
+
+void pid_init(Pid* pid, const PidGains* gains) {
+    pid->gains = *gains;
+    pid_reset(pid, REAL(0));
+}
+
+void pid_reset(Pid* pid, real_t integral) {
+    pid->integral = integral;
+    pid->derivative = REAL(0);
+    pid->prev_measurement = REAL(0);
+    pid->output = REAL(0);
+    pid->primed = false;
+    pid->saturated = false;
+}
+
+real_t pid_update(Pid* pid, real_t setpoint, real_t measurement, real_t feed_forward, real_t dt_s) {
+    const PidGains* g = &pid->gains;
+    real_t error = real_sub(setpoint, measurement);
+
+    if (!pid->primed) {
+        pid->prev_measurement = measurement;
+        pid->primed = true;
+    }
+
+    // Low-pass the measurement rate: alpha = dt / (tau + dt). Skipped for
+    // PI loops, whose measurement steps could overflow the Q16.16 rate.
+    if (g->kd != REAL(0)) {
+        real_t rate = real_div(real_sub(measurement, pid->prev_measurement), dt_s);
+        real_t alpha = real_div(dt_s, real_add(g->derivative_tau_s, dt_s));
+        pid->derivative = real_add(pid->derivative, real_mul(alpha, real_sub(rate, pid->derivative)));
+    }
+    pid->prev_measurement = measurement;
+
+    real_t proportional = real_mul(g->kp, real_sub(real_mul(g->setpoint_weight, setpoint), measurement));
+    real_t damping = real_mul(g->kd, pid->derivative);
+    real_t candidate = real_add(pid->integral, real_mul(real_mul(g->ki, error), dt_s));
+    real_t unclamped = real_sub(real_add(real_add(feed_forward, proportional), candidate), damping);
+
+    // Anti-windup: only integrate when it does not push further into saturation
+    bool pushing_high = unclamped > g->out_max && error > REAL(0);
+    bool pushing_low = unclamped < g->out_min && error < REAL(0);
+    if (!pushing_high && !pushing_low) {
+        pid->integral = candidate;
+    }
+
+    real_t output = real_sub(real_add(real_add(feed_forward, proportional), pid->integral), damping);
+    pid->output = real_min(real_max(output, g->out_min), g->out_max);
+    pid->saturated = pid->output != output;
+    return pid->output;
+}
@@ -0,0 +1,40 @@
+#ifndef PID_H
+#define PID_H
+
+#include <stdbool.h>
+#include "../common/fixed.h"
+
+typedef struct {
+    real_t kp;                 // Output per unit error
+    real_t ki;                 // Output per unit error-second
+    real_t kd;                 // Output per unit error/second
+    real_t derivative_tau_s;   // First-order filter on the derivative term
+    real_t out_min;
+    real_t out_max;
+    real_t setpoint_weight;    // Share of the setpoint in the P term; 0 = P on measurement
+} PidGains;
+
+// PID with derivative on the filtered measurement (no kick on setpoint
+// steps), setpoint weighting on the P term, and conditional integration:
+// the integrator holds while the output is saturated in the direction the
+// error is pushing.
+typedef struct {
+    PidGains gains;
+    real_t integral;           // Integrator contribution, in output units
+    real_t derivative;         // Filtered d(measurement)/dt
+    real_t prev_measurement;
+    real_t output;
+    bool primed;               // prev_measurement is valid
+    bool saturated;            // Last output was clamped
+} Pid;
+
+void pid_init(Pid* pid, const PidGains* gains);
+
+// Clears the history; integral preloads the integrator for a bumpless start
+void pid_reset(Pid* pid, real_t integral);
+
+// One controller step of dt_s seconds; feed_forward is added to the output
+// before clamping
+real_t pid_update(Pid* pid, real_t setpoint, real_t measurement, real_t feed_forward, real_t dt_s);
+
+#endif // PID_H
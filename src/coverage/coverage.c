@@ -0,0 +1,317 @@
+#include "coverage.h"
+#include "../telematics/telematics.h"
+#include "../implement/implement.h"
+#include "../common/checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static CoverageState coverage_state = { .fd = -1 };
+static uint32_t grid_cells = 0;   // Cells per side
+
+static void update_statistics(void) {
+    CoverageHeader* header = coverage_state.header;
+    float cell_ha = COVERAGE_CELL_SIZE_M * COVERAGE_CELL_SIZE_M / 10000.0f;
+
+    coverage_state.covered_ha = (float)header->covered_cells * cell_ha;
+    coverage_state.overlap_ha = (float)header->overlap_cells * cell_ha;
+    coverage_state.coverage_percent = header->field_area_ha > 0.0f ?
+        coverage_state.covered_ha / header->field_area_ha * 100.0f : 0.0f;
+    if (coverage_state.coverage_percent > 100.0f) coverage_state.coverage_percent = 100.0f;
+    coverage_state.overlap_percent = header->covered_cells > 0 ?
+        (float)header->overlap_cells / (float)header->covered_cells * 100.0f : 0.0f;
+}
+
+static void reset_header(uint32_t tiles) {
+    CoverageHeader* header = coverage_state.header;
+    TelematicsState* telem = telematics_get_state();
+
+    memset(header, 0, sizeof(*header));
+    header->magic = COVERAGE_MAGIC;
+    header->version = COVERAGE_VERSION;
+    header->cell_size_mm = (uint16_t)(COVERAGE_CELL_SIZE_M * 1000.0f);
+    header->tiles_x = tiles;
+    header->tiles_y = tiles;
+    header->origin_lat = telem->field_origin_lat;
+    header->origin_lon = telem->field_origin_lon;
+    header->field_area_ha = COVERAGE_DEFAULT_FIELD_HA;
+}
+
+bool coverage_init(const char* path) {
+    printf("[COVERAGE] Initializing field coverage map\n");
+
+    uint32_t tiles = (uint32_t)ceilf(COVERAGE_FIELD_EXTENT_M / COVERAGE_CELL_SIZE_M / COVERAGE_TILE_CELLS);
+    size_t size = COVERAGE_HEADER_BYTES + (size_t)tiles * tiles * COVERAGE_TILE_BYTES;
+    grid_cells = tiles * COVERAGE_TILE_CELLS;
+
+    // Map the field file; untouched tiles stay sparse on disk
+    void* map = MAP_FAILED;
+    bool fresh = false;
+    int fd = path != NULL ? open(path, O_RDWR | O_CREAT, 0644) : -1;
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && (size_t)st.st_size != size) {
+            fresh = true;
+            if (ftruncate(fd, 0) < 0 || ftruncate(fd, (off_t)size) < 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+    if (fd >= 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (map == MAP_FAILED) {
+        printf("[COVERAGE] Map file unavailable - keeping coverage in memory only\n");
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        fresh = true;
+    }
+
+    coverage_state.fd = fd;
+    coverage_state.mapped_bytes = size;
+    coverage_state.header = (CoverageHeader*)map;
+    coverage_state.tiles = (uint8_t*)map + COVERAGE_HEADER_BYTES;
+    coverage_state.has_last_position = false;
+
+    CoverageHeader* header = coverage_state.header;
+    bool valid = header->magic == COVERAGE_MAGIC && header->version == COVERAGE_VERSION &&
+                 header->tiles_x == tiles && header->tiles_y == tiles &&
+                 header->cell_size_mm == (uint16_t)(COVERAGE_CELL_SIZE_M * 1000.0f);
+    if (fresh || !valid) {
+        if (!fresh) {
+            memset(coverage_state.tiles, 0, size - COVERAGE_HEADER_BYTES);
+        }
+        reset_header(tiles);
+        printf("[COVERAGE] New %ux%u-tile map (%.0f m x %.0f m at %.2f m cells)\n",
+               tiles, tiles, COVERAGE_FIELD_EXTENT_M, COVERAGE_FIELD_EXTENT_M, COVERAGE_CELL_SIZE_M);
+    } else {
+        // Resume the field: share its frame with the other field modules
+        telematics_set_field_origin(header->origin_lat, header->origin_lon);
+        printf("[COVERAGE] Resumed map %s (%.2f ha covered)\n", path,
+               (double)header->covered_cells * COVERAGE_CELL_SIZE_M * COVERAGE_CELL_SIZE_M / 10000.0);
+    }
+
+    update_statistics();
+
+    // The map is shared with its file, so a restore rewrites it from the image
+    checkpoint_register("coverage.map", map, size);
+    CHECKPOINT_VAR_FROM("coverage", coverage_state, has_last_position);
+    return true;
+}
+
+// Saturating 2-bit pass counter for one cell
+static inline void bump_cell(uint32_t cx, uint32_t cy) {
+    CoverageHeader* header = coverage_state.header;
+    uint32_t tile = (cy >> COVERAGE_TILE_SHIFT) * header->tiles_x + (cx >> COVERAGE_TILE_SHIFT);
+    uint32_t index = ((cy & (COVERAGE_TILE_CELLS - 1)) << COVERAGE_TILE_SHIFT) | (cx & (COVERAGE_TILE_CELLS - 1));
+    uint8_t* byte = &coverage_state.tiles[(size_t)tile * COVERAGE_TILE_BYTES + (index >> 2)];
+    uint32_t shift = (index & 3) * 2;
+    uint32_t count = (*byte >> shift) & 3;
+
+    if (count < 3) {
+        *byte += (uint8_t)(1u << shift);
+        if (count == 0) header->covered_cells++;
+        else if (count == 1) header->overlap_cells++;
+    }
+}
+
+void coverage_paint_swath(float east0, float north0, float east1, float north1, float width_m) {
+    coverage_paint_band(east0, north0, east1, north1, -width_m * 0.5f, width_m * 0.5f);
+}
+
+void coverage_paint_band(float east0, float north0, float east1, float north1,
+                         float left_m, float right_m) {
+    coverage_state.cells_last_update = 0;
+    if (coverage_state.header == NULL || right_m <= left_m) return;
+
+    float dx = east1 - east0;
+    float dy = north1 - north0;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length < 1e-3f) return;
+
+    // Work in cell units with the grid corner at (0, 0)
+    float half_extent = grid_cells * 0.5f;
+    float inv_cell = 1.0f / COVERAGE_CELL_SIZE_M;
+    float ux = dx / length;
+    float uy = dy / length;
+    float left = left_m * inv_cell;
+    float right = right_m * inv_cell;
+    float x0 = east0 * inv_cell + half_extent;
+    float y0 = north0 * inv_cell + half_extent;
+    float len_cells = length * inv_cell;
+
+    // Swept rectangle between the lateral offsets (positive = right of travel),
+    // corners in order around the perimeter
+    float qx[4] = { x0 + uy * left, x0 + uy * left + ux * len_cells, x0 + uy * right + ux * len_cells, x0 + uy * right };
+    float qy[4] = { y0 - ux * left, y0 - ux * left + uy * len_cells, y0 - ux * right + uy * len_cells, y0 - ux * right };
+
+    float ymin = qy[0], ymax = qy[0];
+    for (int i = 1; i < 4; i++) {
+        if (qy[i] < ymin) ymin = qy[i];
+        if (qy[i] > ymax) ymax = qy[i];
+    }
+    int row_start = (int)ceilf(ymin - 0.5f);
+    int row_end = (int)floorf(ymax - 0.5f);
+    if (row_start < 0) row_start = 0;
+    if (row_end > (int)grid_cells - 1) row_end = (int)grid_cells - 1;
+
+    // Scanline fill of the convex quad: cost is rows + cells in the swath
+    for (int row = row_start; row <= row_end; row++) {
+        float yc = row + 0.5f;
+        float xl = INFINITY, xr = -INFINITY;
+        for (int i = 0; i < 4; i++) {
+            int j = (i + 1) & 3;
+            float ya = qy[i], yb = qy[j];
+            if ((yc < ya && yc < yb) || (yc > ya && yc > yb)) continue;
+            float x = ya == yb ? qx[i] : qx[i] + (yc - ya) * (qx[j] - qx[i]) / (yb - ya);
+            if (x < xl) xl = x;
+            if (x > xr) xr = x;
+            if (ya == yb) {
+                if (qx[j] < xl) xl = qx[j];
+                if (qx[j] > xr) xr = qx[j];
+            }
+        }
+        int col_start = (int)ceilf(xl - 0.5f);
+        int col_end = (int)floorf(xr - 0.5f);
+        if (col_start < 0) col_start = 0;
+        if (col_end > (int)grid_cells - 1) col_end = (int)grid_cells - 1;
+
+        for (int col = col_start; col <= col_end; col++) {
+            // Half-open along track so consecutive segments never share a cell
+            float along = (col + 0.5f - x0) * ux + (yc - y0) * uy;
+            if (along >= len_cells) continue;
+            bump_cell((uint32_t)col, (uint32_t)row);
+            coverage_state.cells_last_update++;
+        }
+    }
+}
+
+uint8_t coverage_pass_count(float east_m, float north_m) {
+    if (coverage_state.header == NULL) return 0;
+    float half_extent = grid_cells * 0.5f;
+    float fx = east_m / COVERAGE_CELL_SIZE_M + half_extent;
+    float fy = north_m / COVERAGE_CELL_SIZE_M + half_extent;
+    if (fx < 0.0f || fy < 0.0f || fx >= grid_cells || fy >= grid_cells) return 0;
+
+    uint32_t cx = (uint32_t)fx;
+    uint32_t cy = (uint32_t)fy;
+    uint32_t tile = (cy >> COVERAGE_TILE_SHIFT) * coverage_state.header->tiles_x + (cx >> COVERAGE_TILE_SHIFT);
+    uint32_t index = ((cy & (COVERAGE_TILE_CELLS - 1)) << COVERAGE_TILE_SHIFT) | (cx & (COVERAGE_TILE_CELLS - 1));
+    uint8_t byte = coverage_state.tiles[(size_t)tile * COVERAGE_TILE_BYTES + (index >> 2)];
+    return (byte >> ((index & 3) * 2)) & 3;
+}
+
+void coverage_pass_counts(const float* east_m, const float* north_m, uint8_t* counts, int n) {
+    if (coverage_state.header == NULL) {
+        memset(counts, 0, (size_t)n);
+        return;
+    }
+
+    // Branch-free index pass (vectorizes); points off the grid read cell 0
+    // and are masked out in the gather pass
+    uint32_t offset[n];
+    uint8_t valid[n];
+    float half_extent = grid_cells * 0.5f;
+    float inv_cell = 1.0f / COVERAGE_CELL_SIZE_M;
+    float limit = (float)grid_cells;
+    uint32_t tiles_x = coverage_state.header->tiles_x;
+    for (int i = 0; i < n; i++) {
+        float fx = east_m[i] * inv_cell + half_extent;
+        float fy = north_m[i] * inv_cell + half_extent;
+        valid[i] = (fx >= 0.0f) & (fy >= 0.0f) & (fx < limit) & (fy < limit);
+        uint32_t cx = valid[i] ? (uint32_t)fx : 0;
+        uint32_t cy = valid[i] ? (uint32_t)fy : 0;
+        uint32_t tile = (cy >> COVERAGE_TILE_SHIFT) * tiles_x + (cx >> COVERAGE_TILE_SHIFT);
+        uint32_t index = ((cy & (COVERAGE_TILE_CELLS - 1)) << COVERAGE_TILE_SHIFT) | (cx & (COVERAGE_TILE_CELLS - 1));
+        offset[i] = (tile * COVERAGE_TILE_BYTES + (index >> 2)) << 3 | (index & 3) * 2;
+    }
+    for (int i = 0; i < n; i++) {
+        uint8_t byte = coverage_state.tiles[offset[i] >> 3];
+        counts[i] = (uint8_t)((byte >> (offset[i] & 7)) & 3) & (uint8_t)-valid[i];
+    }
+}
+
+void coverage_update(void) {
+    TelematicsState* telem = telematics_get_state();
+    ImplementState* impl = implement_get_state();
+    if (coverage_state.header == NULL) return;
+
+    if (!telem->gps.gps_fix) {
+        coverage_state.has_last_position = false;
+        return;
+    }
+
+    float east, north;
+    telematics_to_local(telem->gps.latitude, telem->gps.longitude, &east, &north);
+
+    // Only ground passed with the implement down and its sections on counts
+    // as covered; each run of adjacent active sections is one band
+    if (coverage_state.has_last_position && impl->status == IMPLEMENT_WORKING &&
+        impl->rows_or_sections > 0) {
+        float working_width = real_to_float(impl->working_width_m);
+        float section_width = working_width / impl->rows_or_sections;
+        float left_edge = -working_width * 0.5f;
+        uint32_t painted = 0;
+        int section = 0;
+        while (section < impl->rows_or_sections) {
+            if (!(impl->section_mask & (1ull << section))) {
+                section++;
+                continue;
+            }
+            int run_start = section;
+            while (section < impl->rows_or_sections && (impl->section_mask & (1ull << section))) {
+                section++;
+            }
+            coverage_paint_band(coverage_state.last_east_m, coverage_state.last_north_m, east, north,
+                                left_edge + run_start * section_width, left_edge + section * section_width);
+            painted += coverage_state.cells_last_update;
+        }
+        coverage_state.cells_last_update = painted;
+        update_statistics();
+    } else {
+        coverage_state.cells_last_update = 0;
+    }
+
+    coverage_state.last_east_m = east;
+    coverage_state.last_north_m = north;
+    coverage_state.has_last_position = true;
+}
+
+void coverage_set_field_area(float hectares) {
+    if (coverage_state.header == NULL || hectares <= 0.0f) return;
+    coverage_state.header->field_area_ha = hectares;
+    update_statistics();
+}
+
+void coverage_sync(void) {
+    if (coverage_state.fd >= 0) {
+        msync(coverage_state.header, coverage_state.mapped_bytes, MS_SYNC);
+    }
+}
+
+void coverage_print_status(void) {
+    if (coverage_state.header == NULL) return;
+    printf("\n=== FIELD COVERAGE ===\n");
+    printf("Covered: %.2f ha of %.1f ha (%.1f%%)\n", coverage_state.covered_ha,
+           coverage_state.header->field_area_ha, coverage_state.coverage_percent);
+    printf("Overlap: %.2f ha (%.1f%% of covered area)\n",
+           coverage_state.overlap_ha, coverage_state.overlap_percent);
+    printf("Map: %s, %.1f MB mapped\n", coverage_state.fd >= 0 ? "file-backed" : "memory-only",
+           coverage_state.mapped_bytes / (1024.0 * 1024.0));
+    printf("======================\n\n");
+}
+
+CoverageState* coverage_get_state(void) {
+    return &coverage_state;
+}
@@ -0,0 +1,64 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define COVERAGE_DEFAULT_FILE     "field_coverage.map"
+#define COVERAGE_MAGIC            0x31564F43u   // "COV1"
+#define COVERAGE_VERSION          1
+#define COVERAGE_CELL_SIZE_M      0.5f
+#define COVERAGE_TILE_SHIFT       6             // 64 x 64 cells per tile
+#define COVERAGE_TILE_CELLS       (1 << COVERAGE_TILE_SHIFT)
+#define COVERAGE_TILE_BYTES       (COVERAGE_TILE_CELLS * COVERAGE_TILE_CELLS / 4)  // 2 bits per cell
+#define COVERAGE_FIELD_EXTENT_M   2048.0f       // Square grid centred on the field origin (~420 ha)
+#define COVERAGE_DEFAULT_FIELD_HA 40.0f
+#define COVERAGE_HEADER_BYTES     4096          // Page-aligned so tiles start on a page
+
+// On-disk header at the start of the map file. Tiles follow at
+// COVERAGE_HEADER_BYTES in row-major tile order; within a tile, cells are
+// row-major with 2-bit saturating pass counts (0 = bare, 1 = once, 2 = twice, 3 = 3+).
+// The file is sparse, so untouched tiles cost no disk.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t cell_size_mm;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    double origin_lat;           // Field frame origin (grid centre)
+    double origin_lon;
+    uint64_t covered_cells;      // Cells passed at least once
+    uint64_t overlap_cells;      // Cells passed at least twice
+    float field_area_ha;
+} CoverageHeader;
+
+// Field coverage map - rasterizes the implement swath along the GPS track
+typedef struct {
+    CoverageHeader* header;      // Points into the mapping
+    uint8_t* tiles;
+    size_t mapped_bytes;
+    int fd;                      // -1 when the map is memory-only
+    bool has_last_position;
+    float last_east_m;
+    float last_north_m;
+    uint32_t cells_last_update;  // Cells visited by the last swath
+    float covered_ha;
+    float overlap_ha;
+    float coverage_percent;
+    float overlap_percent;       // Share of covered area passed more than once
+} CoverageState;
+
+// Dependencies: Telematics (GPS, field frame), Implement (status, width, section mask)
+bool coverage_init(const char* path);
+void coverage_update(void);
+void coverage_paint_swath(float east0, float north0, float east1, float north1, float width_m);
+void coverage_paint_band(float east0, float north0, float east1, float north1, float left_m, float right_m);
+uint8_t coverage_pass_count(float east_m, float north_m);
+void coverage_pass_counts(const float* east_m, const float* north_m, uint8_t* counts, int n);
+void coverage_set_field_area(float hectares);
+void coverage_sync(void);
+void coverage_print_status(void);
+CoverageState* coverage_get_state(void);
+
+#endif // COVERAGE_H
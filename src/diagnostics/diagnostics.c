@@ -1,17 +1,47 @@
 #include "diagnostics.h"
 #include "../canbus/canbus.h"
+#include "can_messages.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 
 static DiagnosticsState diagnostics_state = {0};
 
+// Interned module names, indexed by ModuleId
+static const char* const module_names[MODULE_COUNT] = {
+    [MODULE_ENGINE]       = "Engine",
+    [MODULE_HYDRAULICS]   = "Hydraulics",
+    [MODULE_TRANSMISSION] = "Transmission",
+    [MODULE_PTO]          = "PTO",
+    [MODULE_TELEMATICS]   = "Telematics",
+    [MODULE_IMPLEMENT]    = "Implement",
+    [MODULE_DIAGNOSTICS]  = "Diagnostics",
+    [MODULE_CANBUS]       = "CANBus"
+};
+
+// Interned fault definitions, indexed by FaultId (generated from DIAGNOSTIC_FAULT_TABLE)
+typedef struct {
+    uint32_t spn;
+    uint8_t fmi;
+    uint8_t module_id;
+    const char* description;
+} FaultDefinition;
+
+static const FaultDefinition fault_table[FAULT_COUNT] = {
+#define DIAGNOSTIC_FAULT_DEFINITION(id, spn, fmi, module, description) \
+    [id] = { spn, fmi, module, description },
+    DIAGNOSTIC_FAULT_TABLE(DIAGNOSTIC_FAULT_DEFINITION)
+#undef DIAGNOSTIC_FAULT_DEFINITION
+};
+
 void diagnostics_init(void) {
     printf("[DIAGNOSTICS] Initializing diagnostics module\n");
     diagnostics_state.fault_count = 0;
     diagnostics_state.active_fault_count = 0;
     diagnostics_state.overall_status = STATUS_OK;
     memset(diagnostics_state.faults, 0, sizeof(diagnostics_state.faults));
+    CHECKPOINT_VAR("diagnostics", diagnostics_state);
 }
 
 void diagnostics_update(void) {
@@ -31,14 +61,19 @@ void diagnostics_update(void) {
 
     // Send diagnostic summary to CAN bus
     if (diagnostics_state.active_fault_count > 0) {
-        canbus_send_message(0x400, (uint8_t*)&diagnostics_state.active_fault_count, 2);
+        CanDiagnosticSummary summary = { .active_faults = (uint16_t)diagnostics_state.active_fault_count };
+        uint8_t data[CAN_DLC_DIAGNOSTIC_SUMMARY];
+        can_pack_diagnostic_summary(data, &summary);
+        canbus_send_message(CAN_ID_DIAGNOSTIC_SUMMARY, data, sizeof(data));
     }
 }
 
-void diagnostics_report_fault(uint32_t spn, uint8_t fmi, const char* module, const char* description) {
+void diagnostics_report_fault(FaultId fault) {
+    if (fault >= FAULT_COUNT) return;
+
     // Check if fault already exists
     for (int i = 0; i < diagnostics_state.fault_count; i++) {
-        if (diagnostics_state.faults[i].spn == spn && diagnostics_state.faults[i].fmi == fmi) {
+        if (diagnostics_state.faults[i].fault_id == fault) {
             diagnostics_state.faults[i].active = true;
             diagnostics_state.faults[i].timestamp = (uint32_t)time(NULL);
             return;
@@ -47,16 +82,18 @@ void diagnostics_report_fault(uint32_t spn, uint8_t fmi, const char* module, con
 
     // Add new fault
     if (diagnostics_state.fault_count < MAX_FAULTS) {
-        FaultRecord* fault = &diagnostics_state.faults[diagnostics_state.fault_count];
-        fault->spn = spn;
-        fault->fmi = fmi;
-        strncpy(fault->module, module, sizeof(fault->module) - 1);
-        strncpy(fault->description, description, sizeof(fault->description) - 1);
-        fault->timestamp = (uint32_t)time(NULL);
-        fault->active = true;
+        const FaultDefinition* def = &fault_table[fault];
+        FaultRecord* record = &diagnostics_state.faults[diagnostics_state.fault_count];
+        record->spn = def->spn;
+        record->fmi = def->fmi;
+        record->fault_id = (uint8_t)fault;
+        record->module_id = def->module_id;
+        record->timestamp = (uint32_t)time(NULL);
+        record->active = true;
         diagnostics_state.fault_count++;
 
-        printf("[DIAGNOSTICS] FAULT %06u.%02u in %s: %s\n", spn, fmi, module, description);
+        printf("[DIAGNOSTICS] FAULT %06u.%02u in %s: %s\n", def->spn, def->fmi,
+               module_names[def->module_id], def->description);
     }
 }
 
@@ -90,14 +127,29 @@ void diagnostics_print_status(void) {
                 printf("  [%06u.%02u] %s: %s\n",
                     diagnostics_state.faults[i].spn,
                     diagnostics_state.faults[i].fmi,
-                    diagnostics_state.faults[i].module,
-                    diagnostics_state.faults[i].description);
+                    module_names[diagnostics_state.faults[i].module_id],
+                    fault_table[diagnostics_state.faults[i].fault_id].description);
             }
         }
     }
     printf("==========================\n\n");
 }
 
+const char* diagnostics_module_name(ModuleId module) {
+    return module < MODULE_COUNT ? module_names[module] : "Unknown";
+}
+
+const char* diagnostics_fault_description(FaultId fault) {
+    return fault < FAULT_COUNT ? fault_table[fault].description : "Unknown fault";
+}
+
+bool diagnostics_fault_code(FaultId fault, uint32_t* spn, uint8_t* fmi) {
+    if (fault >= FAULT_COUNT) return false;
+    *spn = fault_table[fault].spn;
+    *fmi = fault_table[fault].fmi;
+    return true;
+}
+
 DiagnosticsState* diagnostics_get_state(void) {
     return &diagnostics_state;
 }
@@ -50,6 +50,7 @@
 #define SPN_PTO_ENGAGEMENT          558
 #define SPN_PTO_SPEED               559
 #define SPN_PTO_SHAFT_SPEED        1483
+#define SPN_PTO_SHAFT_TORQUE       1484
 
 // Telematics codes
 #define SPN_GPS_LATITUDE            2829
@@ -61,13 +62,62 @@
 #define SPN_IMPLEMENT_DEPTH         1811
 #define SPN_IMPLEMENT_PRESSURE      1812
 
+// Controller codes
+#define SPN_ECU_TASK_SCHEDULE       1485
+#define SPN_ECU_TEMPERATURE         1136
+#define SPN_BATTERY_POTENTIAL       168
+#define SPN_ALTERNATOR_CURRENT      115
+
+// Circuit faults of one analogue input (see SENSOR_CHANNELS in sensors.h):
+// FAULT_SENSOR_<name>_LOW, _HIGH and _STUCK
+#define DIAGNOSTIC_SENSOR_FAULTS(X, name, spn, module, label) \
+    X(FAULT_SENSOR_##name##_LOW,   spn, FMI_VOLTAGE_LOW,  module, label " sensor circuit shorted to ground") \
+    X(FAULT_SENSOR_##name##_HIGH,  spn, FMI_VOLTAGE_HIGH, module, label " sensor circuit open or shorted to supply") \
+    X(FAULT_SENSOR_##name##_STUCK, spn, FMI_DATA_ERRATIC, module, label " sensor reading frozen")
+
+// Fault definitions - one entry per reportable fault:
+//   X(fault id, SPN, FMI, reporting module, description)
+// The table expands into the FaultId enum below and into the interned
+// description table in diagnostics.c, so fault records carry small IDs
+// instead of copies of the strings.
+#define DIAGNOSTIC_FAULT_TABLE(X) \
+    X(FAULT_ENGINE_COOLANT_HIGH,      SPN_ENGINE_COOLANT_TEMP, FMI_DATA_ABOVE_NORMAL, MODULE_ENGINE,       "Engine coolant temperature extremely high") \
+    X(FAULT_HYDRAULIC_PRESSURE_LOW,   SPN_HYDRAULIC_PRESSURE,  FMI_DATA_BELOW_NORMAL, MODULE_HYDRAULICS,   "Hydraulic system pressure below normal operating range") \
+    X(FAULT_HYDRAULIC_FLOW_STARVED,   SPN_HYDRAULIC_FLOW_RATE, FMI_DATA_BELOW_NORMAL, MODULE_HYDRAULICS,   "Hydraulic pump flow insufficient - consumer starved") \
+    X(FAULT_TRANS_OIL_TEMP_HIGH,      SPN_TRANS_OIL_TEMP,      FMI_DATA_ABOVE_NORMAL, MODULE_TRANSMISSION, "Transmission oil temperature above normal operating range") \
+    X(FAULT_PTO_ENGAGE_RPM_LOW,       SPN_PTO_ENGAGEMENT,      FMI_MECHANICAL_FAULT,  MODULE_PTO,          "PTO engagement failed - engine RPM below minimum threshold") \
+    X(FAULT_PTO_OVERLOAD,             SPN_PTO_SHAFT_SPEED,     FMI_DATA_ABOVE_NORMAL, MODULE_PTO,          "PTO overload detected - shaft load exceeds maximum rating") \
+    X(FAULT_PTO_SHOCK_LOAD,           SPN_PTO_SHAFT_TORQUE,    FMI_DATA_ABOVE_NORMAL, MODULE_PTO,          "PTO shock load above shear bolt rating") \
+    X(FAULT_PTO_DRIVELINE_VIBRATION,  SPN_PTO_SHAFT_TORQUE,    FMI_ABNORMAL_FREQUENCY, MODULE_PTO,         "PTO driveline torsional vibration above limit") \
+    X(FAULT_CELLULAR_SIGNAL_LOW,      SPN_CELLULAR_SIGNAL,     FMI_DATA_BELOW_NORMAL, MODULE_TELEMATICS,   "Cellular signal strength below minimum threshold") \
+    X(FAULT_IMPLEMENT_LOWER_FAILED,   SPN_IMPLEMENT_POSITION,  FMI_MECHANICAL_FAULT,  MODULE_IMPLEMENT,    "Implement lowering failed - hydraulic pressure insufficient") \
+    X(FAULT_IMPLEMENT_PRESSURE_LOW,   SPN_IMPLEMENT_PRESSURE,  FMI_DATA_BELOW_NORMAL, MODULE_IMPLEMENT,    "Implement hydraulic pressure below normal operating range") \
+    X(FAULT_IMPLEMENT_PTO_REQUIRED,   SPN_PTO_ENGAGEMENT,      FMI_MECHANICAL_FAULT,  MODULE_IMPLEMENT,    "PTO not engaged - required for implement operation") \
+    X(FAULT_CYCLE_DEGRADED,           SPN_ECU_TASK_SCHEDULE,   FMI_ABNORMAL_UPDATE,   MODULE_DIAGNOSTICS,  "Control cycle over budget - non-critical tasks deferred or shed") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, COOLANT_TEMP,       SPN_ENGINE_COOLANT_TEMP, MODULE_ENGINE,       "Coolant temperature") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, OIL_PRESSURE,       SPN_ENGINE_OIL_PRESSURE, MODULE_ENGINE,       "Engine oil pressure") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, TRANS_OIL_TEMP,     SPN_TRANS_OIL_TEMP,      MODULE_TRANSMISSION, "Transmission oil temperature") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, HYD_OIL_TEMP,       SPN_HYDRAULIC_OIL_TEMP,  MODULE_HYDRAULICS,   "Hydraulic oil temperature") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, HYD_RESERVOIR,      SPN_HYDRAULIC_RESERVOIR, MODULE_HYDRAULICS,   "Hydraulic reservoir level") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, BATTERY_VOLTAGE,    SPN_BATTERY_POTENTIAL,   MODULE_DIAGNOSTICS,  "Battery voltage") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, ALTERNATOR_CURRENT, SPN_ALTERNATOR_CURRENT,  MODULE_ENGINE,       "Alternator current") \
+    DIAGNOSTIC_SENSOR_FAULTS(X, ECU_TEMP,           SPN_ECU_TEMPERATURE,     MODULE_DIAGNOSTICS,  "ECU board temperature")
+
+typedef enum {
+#define DIAGNOSTIC_FAULT_ID(id, spn, fmi, module, description) id,
+    DIAGNOSTIC_FAULT_TABLE(DIAGNOSTIC_FAULT_ID)
+#undef DIAGNOSTIC_FAULT_ID
+    FAULT_COUNT
+} FaultId;
+
 // Diagnostics module - tracks faults, logs events, health monitoring
+// Records hold interned IDs only (12 bytes) - names come from the string tables
 typedef struct {
     uint32_t spn;        // Suspect Parameter Number (6 digits)
-    uint8_t fmi;         // Failure Mode Identifier (2 digits)
-    char module[32];
-    char description[128];
     uint32_t timestamp;
+    uint8_t fmi;         // Failure Mode Identifier (2 digits)
+    uint8_t fault_id;    // FaultId - indexes the description table
+    uint8_t module_id;   // ModuleId - indexes the module name table
     bool active;
 } FaultRecord;
 
@@ -81,9 +131,12 @@ typedef struct {
 // Dependencies: CANBus (send diagnostic data to external tools)
 void diagnostics_init(void);
 void diagnostics_update(void);
-void diagnostics_report_fault(uint32_t spn, uint8_t fmi, const char* module, const char* description);
+void diagnostics_report_fault(FaultId fault);
 void diagnostics_clear_fault(uint32_t spn, uint8_t fmi);
 void diagnostics_print_status(void);
+const char* diagnostics_module_name(ModuleId module);
+const char* diagnostics_fault_description(FaultId fault);
+bool diagnostics_fault_code(FaultId fault, uint32_t* spn, uint8_t* fmi);
 DiagnosticsState* diagnostics_get_state(void);
 
 #endif // DIAGNOSTICS_H
@@ -0,0 +1,415 @@
+#include "uds.h"
+#include "diagnostics.h"
+#include "../engine/engine_control.h"
+#include "../hydraulics/hydraulics.h"
+#include "../transmission/transmission.h"
+#include "../pto/pto.h"
+#include "../telematics/telematics.h"
+#include "../implement/implement.h"
+#include "../common/checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SNAPSHOT_RECORD     0x01      // Single freeze frame record per DTC (first failure)
+#define SNAPSHOT_MAX_BYTES  32
+
+static UdsServerState uds_state;
+static UdsRegion regions[UDS_MAX_REGIONS];
+static int region_count = 0;
+static uint8_t response[ISOTP_MAX_PAYLOAD];
+
+// Freeze frames, indexed like the diagnostics fault records
+static uint8_t snapshots[MAX_FAULTS][SNAPSHOT_MAX_BYTES];
+static uint16_t snapshot_length[MAX_FAULTS];
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void put_u16(uint8_t* out, uint32_t value) {
+    value = value > 0xFFFF ? 0xFFFF : value;
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+}
+
+static uint32_t scaled(float value, float scale) {
+    float raw = value * scale;
+    return raw <= 0.0f ? 0u : (uint32_t)(raw + 0.5f);
+}
+
+static uint8_t temperature(real_t celsius) {
+    uint32_t raw = scaled(real_to_float(celsius) + 40.0f, 1.0f);
+    return (uint8_t)(raw > 0xFF ? 0xFF : raw);
+}
+
+// Data identifier readers - big-endian, fixed size per DID
+static void read_engine_speed(uint8_t* out)  { put_u16(out, engine_get_state()->current_rpm); }
+static void read_coolant_temp(uint8_t* out)  { out[0] = temperature(engine_get_state()->coolant_temp); }
+static void read_hyd_pressure(uint8_t* out)  { put_u16(out, scaled(real_to_float(hydraulics_get_state()->system_pressure), 1.0f)); }
+static void read_ground_speed(uint8_t* out)  { put_u16(out, scaled(telematics_get_state()->gps.speed_kmh, 10.0f)); }
+static void read_pto_speed(uint8_t* out)     { put_u16(out, pto_get_state()->current_rpm); }
+static void read_impl_depth(uint8_t* out)    { put_u16(out, scaled(real_to_float(implement_get_state()->working_depth_cm), 10.0f)); }
+static void read_fuel_rate(uint8_t* out)     { put_u16(out, scaled(real_to_float(engine_get_state()->fuel_rate), 10.0f)); }
+static void read_trans_oil_temp(uint8_t* out) { out[0] = temperature(transmission_get_state()->transmission_temp); }
+static void read_ecu_serial(uint8_t* out)    { memcpy(out, "ECU-000001", 10); }
+static void read_vin(uint8_t* out)           { memcpy(out, "TRACTORECU0000001", 17); }
+static void read_software_version(uint8_t* out) { memcpy(out, "v1.0", 4); }
+
+typedef struct {
+    uint16_t did;
+    uint8_t size;
+    bool snapshot;             // Captured into freeze frames
+    void (*read)(uint8_t* out);
+} DidEntry;
+
+static const DidEntry did_table[] = {
+    { UDS_DID_ENGINE_SPEED,     2,  true,  read_engine_speed },
+    { UDS_DID_COOLANT_TEMP,     1,  true,  read_coolant_temp },
+    { UDS_DID_HYD_PRESSURE,     2,  true,  read_hyd_pressure },
+    { UDS_DID_GROUND_SPEED,     2,  true,  read_ground_speed },
+    { UDS_DID_PTO_SPEED,        2,  true,  read_pto_speed },
+    { UDS_DID_IMPLEMENT_DEPTH,  2,  true,  read_impl_depth },
+    { UDS_DID_FUEL_RATE,        2,  false, read_fuel_rate },
+    { UDS_DID_TRANS_OIL_TEMP,   1,  false, read_trans_oil_temp },
+    { UDS_DID_ECU_SERIAL,       10, false, read_ecu_serial },
+    { UDS_DID_VIN,              17, false, read_vin },
+    { UDS_DID_SOFTWARE_VERSION, 4,  false, read_software_version },
+};
+#define DID_COUNT (sizeof(did_table) / sizeof(did_table[0]))
+
+static const DidEntry* find_did(uint16_t did) {
+    for (size_t i = 0; i < DID_COUNT; i++) {
+        if (did_table[i].did == did) return &did_table[i];
+    }
+    return NULL;
+}
+
+void uds_encode_dtc(uint8_t* out, uint32_t spn, uint8_t fmi) {
+    out[0] = (uint8_t)spn;
+    out[1] = (uint8_t)(spn >> 8);
+    out[2] = (uint8_t)(((spn >> 11) & 0xE0) | (fmi & 0x1F));
+}
+
+static uint32_t negative(uint8_t sid, uint8_t nrc) {
+    response[0] = UDS_NEGATIVE_RESPONSE;
+    response[1] = sid;
+    response[2] = nrc;
+    uds_state.negative_responses++;
+    return 3;
+}
+
+static void end_upload(void) {
+    uds_state.upload_active = false;
+    uds_state.upload_region = NULL;
+}
+
+static uint32_t session_control(const uint8_t* request, uint32_t length) {
+    if (length != 2) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    uint8_t session = request[1] & 0x7F;
+    if (session != UDS_SESSION_DEFAULT && session != UDS_SESSION_EXTENDED) {
+        return negative(request[0], UDS_NRC_SUBFUNCTION_NOT_SUPPORTED);
+    }
+    if (session == UDS_SESSION_DEFAULT) end_upload();
+    uds_state.session = session;
+    response[0] = UDS_POSITIVE(UDS_SID_SESSION_CONTROL);
+    response[1] = session;
+    put_u16(response + 2, UDS_P2_MS);
+    put_u16(response + 4, UDS_P2_STAR_MS / 10);
+    return (request[1] & 0x80) ? 0 : 6;
+}
+
+static uint32_t tester_present(const uint8_t* request, uint32_t length) {
+    if (length != 2) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    if ((request[1] & 0x7F) != 0) return negative(request[0], UDS_NRC_SUBFUNCTION_NOT_SUPPORTED);
+    response[0] = UDS_POSITIVE(UDS_SID_TESTER_PRESENT);
+    response[1] = 0;
+    return (request[1] & 0x80) ? 0 : 2;
+}
+
+static uint32_t read_data_by_id(const uint8_t* request, uint32_t length) {
+    if (length < 3 || (length - 1) % 2 != 0) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    uint32_t out = 1;
+    response[0] = UDS_POSITIVE(UDS_SID_READ_DATA_BY_ID);
+    for (uint32_t i = 1; i < length; i += 2) {
+        const DidEntry* entry = find_did((uint16_t)(request[i] << 8 | request[i + 1]));
+        if (entry == NULL) return negative(request[0], UDS_NRC_REQUEST_OUT_OF_RANGE);
+        if (out + 2 + entry->size > sizeof(response)) {
+            return negative(request[0], UDS_NRC_RESPONSE_TOO_LONG);
+        }
+        response[out++] = request[i];
+        response[out++] = request[i + 1];
+        entry->read(response + out);
+        out += entry->size;
+    }
+    return out;
+}
+
+static uint8_t dtc_status(const FaultRecord* record) {
+    return UDS_DTC_CONFIRMED | (record->active ? UDS_DTC_TEST_FAILED : 0);
+}
+
+static uint32_t read_dtc_information(const uint8_t* request, uint32_t length) {
+    if (length < 2) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    const DiagnosticsState* diag = diagnostics_get_state();
+    uint8_t sub = request[1] & 0x7F;
+    response[0] = UDS_POSITIVE(UDS_SID_READ_DTC);
+    response[1] = sub;
+    uint32_t out = 2;
+
+    switch (sub) {
+        case UDS_DTC_COUNT_BY_MASK:
+        case UDS_DTC_BY_MASK: {
+            if (length != 3) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+            uint8_t mask = request[2];
+            uint16_t count = 0;
+            response[out++] = UDS_DTC_AVAILABILITY_MASK;
+            if (sub == UDS_DTC_COUNT_BY_MASK) response[out++] = UDS_DTC_FORMAT_J1939;
+            for (int i = 0; i < diag->fault_count; i++) {
+                const FaultRecord* record = &diag->faults[i];
+                if ((dtc_status(record) & mask) == 0) continue;
+                count++;
+                if (sub == UDS_DTC_BY_MASK) {
+                    uds_encode_dtc(response + out, record->spn, record->fmi);
+                    response[out + 3] = dtc_status(record);
+                    out += 4;
+                }
+            }
+            if (sub == UDS_DTC_COUNT_BY_MASK) {
+                put_u16(response + out, count);
+                out += 2;
+            }
+            return out;
+        }
+        case UDS_DTC_SNAPSHOT_BY_DTC: {
+            if (length != 6) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+            uint8_t record_number = request[5];
+            if (record_number != SNAPSHOT_RECORD && record_number != 0xFF) {
+                return negative(request[0], UDS_NRC_REQUEST_OUT_OF_RANGE);
+            }
+            for (int i = 0; i < diag->fault_count; i++) {
+                const FaultRecord* record = &diag->faults[i];
+                uint8_t dtc[3];
+                uds_encode_dtc(dtc, record->spn, record->fmi);
+                if (memcmp(dtc, request + 2, 3) != 0) continue;
+                memcpy(response + out, dtc, 3);
+                response[out + 3] = dtc_status(record);
+                out += 4;
+                if (snapshot_length[i] > 0) {
+                    memcpy(response + out, snapshots[i], snapshot_length[i]);
+                    out += snapshot_length[i];
+                }
+                return out;
+            }
+            return negative(request[0], UDS_NRC_REQUEST_OUT_OF_RANGE);
+        }
+        case UDS_DTC_SUPPORTED: {
+            if (length != 2) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+            response[out++] = UDS_DTC_AVAILABILITY_MASK;
+            for (int f = 0; f < FAULT_COUNT; f++) {
+                // Status of the recorded fault, 0 if it never occurred
+                uint8_t status = 0;
+                uint32_t spn = 0;
+                uint8_t fmi = 0;
+                diagnostics_fault_code((FaultId)f, &spn, &fmi);
+                for (int i = 0; i < diag->fault_count; i++) {
+                    if (diag->faults[i].fault_id == f) status = dtc_status(&diag->faults[i]);
+                }
+                uds_encode_dtc(response + out, spn, fmi);
+                response[out + 3] = status;
+                out += 4;
+            }
+            return out;
+        }
+        default:
+            return negative(request[0], UDS_NRC_SUBFUNCTION_NOT_SUPPORTED);
+    }
+}
+
+static uint32_t read_be(const uint8_t* data, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; i++) value = value << 8 | data[i];
+    return value;
+}
+
+static uint32_t request_upload(const uint8_t* request, uint32_t length) {
+    if (uds_state.session != UDS_SESSION_EXTENDED) {
+        return negative(request[0], UDS_NRC_NOT_IN_ACTIVE_SESSION);
+    }
+    if (length < 3) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    int size_bytes = request[2] >> 4, address_bytes = request[2] & 0x0F;
+    if (size_bytes < 1 || size_bytes > 4 || address_bytes < 1 || address_bytes > 4) {
+        return negative(request[0], UDS_NRC_REQUEST_OUT_OF_RANGE);
+    }
+    if (length != 3u + (uint32_t)size_bytes + (uint32_t)address_bytes) {
+        return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    }
+    if (request[1] != 0x00) {   // No compression or encryption
+        return negative(request[0], UDS_NRC_REQUEST_OUT_OF_RANGE);
+    }
+    if (uds_state.upload_active) return negative(request[0], UDS_NRC_UPLOAD_NOT_ACCEPTED);
+
+    uint32_t address = read_be(request + 3, address_bytes);
+    uint32_t size = read_be(request + 3 + address_bytes, size_bytes);
+    for (int i = 0; i < region_count; i++) {
+        const UdsRegion* region = &regions[i];
+        if (size == 0 || address < region->address ||
+            address - region->address > region->size ||
+            size > region->size - (address - region->address)) {
+            continue;
+        }
+        uds_state.upload_active = true;
+        uds_state.upload_region = region;
+        uds_state.upload_offset = address - region->address;
+        uds_state.upload_end = uds_state.upload_offset + size;
+        uds_state.block_offset = uds_state.upload_offset;
+        uds_state.block_counter = 0;
+
+        // Blocks as large as the transport carries, to keep request turnarounds rare
+        response[0] = UDS_POSITIVE(UDS_SID_REQUEST_UPLOAD);
+        response[1] = 0x20;
+        put_u16(response + 2, ISOTP_MAX_PAYLOAD);
+        return 4;
+    }
+    return negative(request[0], UDS_NRC_REQUEST_OUT_OF_RANGE);
+}
+
+static uint32_t transfer_data(const uint8_t* request, uint32_t length) {
+    if (length != 2) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    if (!uds_state.upload_active) return negative(request[0], UDS_NRC_REQUEST_SEQUENCE_ERROR);
+
+    uint8_t counter = request[1];
+    uint8_t expected = (uint8_t)(uds_state.block_counter + 1);
+    if (counter == expected) {
+        if (uds_state.upload_offset >= uds_state.upload_end) {
+            return negative(request[0], UDS_NRC_REQUEST_SEQUENCE_ERROR);
+        }
+        uds_state.block_offset = uds_state.upload_offset;
+        uds_state.block_counter = counter;
+    } else if (counter != uds_state.block_counter || uds_state.block_offset == uds_state.upload_offset) {
+        return negative(request[0], UDS_NRC_WRONG_BLOCK_COUNTER);
+    }
+    // A repeated counter resends the last block (the tester lost our response)
+
+    uint32_t chunk = uds_state.upload_end - uds_state.block_offset;
+    if (chunk > ISOTP_MAX_PAYLOAD - 2) chunk = ISOTP_MAX_PAYLOAD - 2;
+    response[0] = UDS_POSITIVE(UDS_SID_TRANSFER_DATA);
+    response[1] = counter;
+    memcpy(response + 2, uds_state.upload_region->data + uds_state.block_offset, chunk);
+    if (counter == expected) {
+        uds_state.upload_offset = uds_state.block_offset + chunk;
+        uds_state.bytes_uploaded += chunk;
+    }
+    return 2 + chunk;
+}
+
+static uint32_t transfer_exit(const uint8_t* request, uint32_t length) {
+    if (length != 1) return negative(request[0], UDS_NRC_INCORRECT_LENGTH);
+    if (!uds_state.upload_active || uds_state.upload_offset < uds_state.upload_end) {
+        return negative(request[0], UDS_NRC_REQUEST_SEQUENCE_ERROR);
+    }
+    end_upload();
+    uds_state.uploads_completed++;
+    response[0] = UDS_POSITIVE(UDS_SID_TRANSFER_EXIT);
+    return 1;
+}
+
+static void handle_request(IsoTpLink* link, const uint8_t* request, uint32_t length, void* context) {
+    (void)context;
+    uds_state.requests++;
+    uds_state.last_request_ms = monotonic_ms();
+
+    uint32_t out;
+    switch (request[0]) {
+        case UDS_SID_SESSION_CONTROL:  out = session_control(request, length); break;
+        case UDS_SID_TESTER_PRESENT:   out = tester_present(request, length); break;
+        case UDS_SID_READ_DATA_BY_ID:  out = read_data_by_id(request, length); break;
+        case UDS_SID_READ_DTC:         out = read_dtc_information(request, length); break;
+        case UDS_SID_REQUEST_UPLOAD:   out = request_upload(request, length); break;
+        case UDS_SID_TRANSFER_DATA:    out = transfer_data(request, length); break;
+        case UDS_SID_TRANSFER_EXIT:    out = transfer_exit(request, length); break;
+        default:                       out = negative(request[0], UDS_NRC_SERVICE_NOT_SUPPORTED); break;
+    }
+    if (out > 0) {
+        isotp_send(link, response, out);
+    }
+}
+
+void uds_init(uint8_t block_size, uint8_t st_min) {
+    memset(&uds_state, 0, sizeof(uds_state));
+    memset(snapshot_length, 0, sizeof(snapshot_length));
+    region_count = 0;
+    uds_state.session = UDS_SESSION_DEFAULT;
+    isotp_init(&uds_state.link, UDS_RESPONSE_ID, UDS_REQUEST_ID, block_size, st_min,
+               handle_request, NULL);
+
+    // Freeze frames belong with the fault table; sessions start over
+    CHECKPOINT_VAR("uds", snapshots);
+    CHECKPOINT_VAR("uds", snapshot_length);
+    CHECKPOINT_VAR("uds", uds_state.freeze_frames);
+    printf("[UDS] Diagnostic server on 0x%03X/0x%03X (block size %u, STmin 0x%02X)\n",
+           UDS_REQUEST_ID, UDS_RESPONSE_ID, block_size, st_min);
+}
+
+bool uds_add_region(uint32_t address, const void* data, uint32_t size, const char* name) {
+    if (region_count >= UDS_MAX_REGIONS || data == NULL || size == 0) return false;
+    regions[region_count++] = (UdsRegion){ address, size, data, name };
+    return true;
+}
+
+// Record the first-failure freeze frame of each newly recorded fault:
+// record number, DID count, then DID and value for each snapshot DID
+static void capture_freeze_frames(void) {
+    const DiagnosticsState* diag = diagnostics_get_state();
+    while (uds_state.freeze_frames < diag->fault_count) {
+        uint8_t* out = snapshots[uds_state.freeze_frames];
+        uint32_t length = 2;
+        uint8_t count = 0;
+        for (size_t i = 0; i < DID_COUNT; i++) {
+            const DidEntry* entry = &did_table[i];
+            if (!entry->snapshot || length + 2 + entry->size > SNAPSHOT_MAX_BYTES) continue;
+            out[length++] = (uint8_t)(entry->did >> 8);
+            out[length++] = (uint8_t)entry->did;
+            entry->read(out + length);
+            length += entry->size;
+            count++;
+        }
+        out[0] = SNAPSHOT_RECORD;
+        out[1] = count;
+        snapshot_length[uds_state.freeze_frames++] = (uint16_t)length;
+    }
+}
+
+void uds_update(void) {
+    isotp_poll(&uds_state.link);
+    capture_freeze_frames();
+
+    if (uds_state.session != UDS_SESSION_DEFAULT &&
+        monotonic_ms() - uds_state.last_request_ms > UDS_S3_TIMEOUT_MS) {
+        uds_state.session = UDS_SESSION_DEFAULT;
+        end_upload();
+        printf("[UDS] Session timed out - back to default session\n");
+    }
+}
+
+void uds_print_status(void) {
+    const IsoTpStats* link = &uds_state.link.stats;
+    printf("\n=== UDS Diagnostic Server ===\n");
+    printf("Session: %s  Requests: %u (%u negative)  Freeze frames: %u\n",
+           uds_state.session == UDS_SESSION_EXTENDED ? "extended" : "default",
+           uds_state.requests, uds_state.negative_responses, uds_state.freeze_frames);
+    printf("Uploads: %u complete, %llu bytes\n", uds_state.uploads_completed,
+           (unsigned long long)uds_state.bytes_uploaded);
+    for (int i = 0; i < region_count; i++) {
+        printf("  Region 0x%08X %-16s %9u bytes\n", regions[i].address, regions[i].name, regions[i].size);
+    }
+    printf("ISO-TP: %u frames out, %u in, %u timeouts, %u sequence errors\n",
+           link->frames_sent, link->frames_received, link->timeouts, link->sequence_errors);
+    printf("=============================\n");
+}
+
+UdsServerState* uds_get_state(void) {
+    return &uds_state;
+}
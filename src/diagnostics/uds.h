@@ -0,0 +1,108 @@
+#ifndef UDS_H
+#define UDS_H
+
+#include "../common/types.h"
+#include "../canbus/isotp.h"
+
+#define UDS_REQUEST_ID      0x7E0     // Physical request from the service tool
+#define UDS_RESPONSE_ID     0x7E8
+#define UDS_S3_TIMEOUT_MS   5000      // Non-default session falls back without TesterPresent
+#define UDS_MAX_REGIONS     8
+#define UDS_P2_MS           50        // Reported server response times
+#define UDS_P2_STAR_MS      5000
+#define UDS_REGION_FAULTS   0x00010000   // Upload addresses registered by main
+#define UDS_REGION_HISTORY  0x01000000
+
+// Services (ISO 14229-1)
+#define UDS_SID_SESSION_CONTROL     0x10
+#define UDS_SID_READ_DTC            0x19
+#define UDS_SID_READ_DATA_BY_ID     0x22
+#define UDS_SID_REQUEST_UPLOAD      0x35
+#define UDS_SID_TRANSFER_DATA       0x36
+#define UDS_SID_TRANSFER_EXIT       0x37
+#define UDS_SID_TESTER_PRESENT      0x3E
+#define UDS_NEGATIVE_RESPONSE       0x7F
+#define UDS_POSITIVE(sid)           ((uint8_t)((sid) + 0x40))
+
+#define UDS_SESSION_DEFAULT         0x01
+#define UDS_SESSION_EXTENDED        0x03
+
+// ReadDTCInformation sub-functions
+#define UDS_DTC_COUNT_BY_MASK       0x01
+#define UDS_DTC_BY_MASK             0x02
+#define UDS_DTC_SNAPSHOT_BY_DTC     0x04
+#define UDS_DTC_SUPPORTED           0x0A
+
+// DTC status bits reported (testFailed, confirmedDTC)
+#define UDS_DTC_TEST_FAILED         0x01
+#define UDS_DTC_CONFIRMED           0x08
+#define UDS_DTC_AVAILABILITY_MASK   (UDS_DTC_TEST_FAILED | UDS_DTC_CONFIRMED)
+#define UDS_DTC_FORMAT_J1939        0x02   // DTC = SPN (19 bits) + FMI (5 bits), J1939-73 layout
+
+// Negative response codes
+#define UDS_NRC_SERVICE_NOT_SUPPORTED       0x11
+#define UDS_NRC_SUBFUNCTION_NOT_SUPPORTED   0x12
+#define UDS_NRC_INCORRECT_LENGTH            0x13
+#define UDS_NRC_RESPONSE_TOO_LONG           0x14
+#define UDS_NRC_CONDITIONS_NOT_CORRECT      0x22
+#define UDS_NRC_REQUEST_SEQUENCE_ERROR      0x24
+#define UDS_NRC_REQUEST_OUT_OF_RANGE        0x31
+#define UDS_NRC_UPLOAD_NOT_ACCEPTED         0x70
+#define UDS_NRC_WRONG_BLOCK_COUNTER         0x73
+#define UDS_NRC_NOT_IN_ACTIVE_SESSION       0x7F
+
+// Data identifiers
+#define UDS_DID_ENGINE_SPEED        0x0100   // rpm, u16
+#define UDS_DID_COOLANT_TEMP        0x0101   // °C + 40, u8
+#define UDS_DID_HYD_PRESSURE        0x0102   // PSI, u16
+#define UDS_DID_GROUND_SPEED        0x0103   // 0.1 km/h, u16
+#define UDS_DID_PTO_SPEED           0x0104   // rpm, u16
+#define UDS_DID_IMPLEMENT_DEPTH     0x0105   // 0.1 cm, u16
+#define UDS_DID_FUEL_RATE           0x0106   // 0.1 L/hr, u16
+#define UDS_DID_TRANS_OIL_TEMP      0x0107   // °C + 40, u8
+#define UDS_DID_ECU_SERIAL          0xF18C
+#define UDS_DID_VIN                 0xF190
+#define UDS_DID_SOFTWARE_VERSION    0xF195
+
+// Memory that RequestUpload can read out, e.g. the fault history or the
+// signal historian store
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+    const uint8_t* data;
+    const char* name;
+} UdsRegion;
+
+typedef struct {
+    IsoTpLink link;
+    uint8_t session;
+    uint64_t last_request_ms;
+
+    // Upload in progress
+    bool upload_active;
+    const UdsRegion* upload_region;
+    uint32_t upload_offset;        // Next byte to send, relative to the region
+    uint32_t upload_end;
+    uint32_t block_offset;         // Start of the last block sent, for repeats
+    uint8_t block_counter;         // Counter of the last block sent
+
+    uint32_t requests;
+    uint32_t negative_responses;
+    uint32_t uploads_completed;
+    uint64_t bytes_uploaded;
+    uint16_t freeze_frames;
+} UdsServerState;
+
+// Dependencies: CANBus and ISO-TP (transport), Diagnostics (fault history),
+// Engine, Hydraulics, Transmission, PTO, Telematics, Implement (data identifiers
+// and freeze frames)
+void uds_init(uint8_t block_size, uint8_t st_min);
+void uds_update(void);    // Transport timers, S3 timeout and freeze frame capture
+bool uds_add_region(uint32_t address, const void* data, uint32_t size, const char* name);
+void uds_print_status(void);
+UdsServerState* uds_get_state(void);
+
+// J1939-73 DTC bytes for an SPN/FMI pair
+void uds_encode_dtc(uint8_t* out, uint32_t spn, uint8_t fmi);
+
+#endif // UDS_H
@@ -0,0 +1,140 @@
+#include "calibration.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define DIESEL_DENSITY_G_PER_L 835.0f
+
+static const float rpm_axis[] = { 800, 1000, 1200, 1400, 1600, 1800, 2000, 2200, 2400, 2600 };
+static const float full_load_torque[] = { 620, 780, 900, 960, 950, 900, 830, 740, 520, 0 };
+static const float load_axis[] = { 0, 10, 25, 50, 75, 100 };
+static const float bsfc_g_per_kwh[] = { 260, 240, 222, 212, 208, 215 };  // By load
+
+static void set_axis(float* axis, float* values, uint32_t* count,
+                     const float* from_axis, const float* from_values, uint32_t n) {
+    *count = n;
+    memcpy(axis, from_axis, n * sizeof(float));
+    memcpy(values, from_values, n * sizeof(float));
+}
+
+// Stock calibration for the simulated 6.8 L engine
+void calibration_defaults(CalibrationSet* set) {
+    memset(set, 0, sizeof(*set));
+    snprintf(set->name, sizeof(set->name), "stock");
+
+    static const float throttle_axis[] = { 0, 25, 50, 75, 100 };
+    static const float set_speed[] = { 800, 1250, 1700, 2150, 2600 };
+    set_axis(set->throttle_speed.axis, set->throttle_speed.values, &set->throttle_speed.count,
+             throttle_axis, set_speed, 5);
+
+    set_axis(set->torque_curve.axis, set->torque_curve.values, &set->torque_curve.count,
+             rpm_axis, full_load_torque, 10);
+
+    static const float droop_axis[] = { 0, 50, 100 };
+    static const float droop_rpm[] = { 0, 55, 120 };
+    set_axis(set->governor_droop.axis, set->governor_droop.values, &set->governor_droop.count,
+             droop_axis, droop_rpm, 3);
+
+    // Fuel = friction/idle flow + brake power x BSFC
+    CalMap2D* fuel = &set->fuel_map;
+    fuel->x_count = 10;
+    fuel->y_count = 6;
+    memcpy(fuel->x_axis, rpm_axis, sizeof(rpm_axis));
+    memcpy(fuel->y_axis, load_axis, sizeof(load_axis));
+    for (uint32_t j = 0; j < fuel->y_count; j++) {
+        for (uint32_t i = 0; i < fuel->x_count; i++) {
+            float power_kw = full_load_torque[i] * load_axis[j] / 100.0f * rpm_axis[i] * 2.0f * (float)M_PI / 60000.0f;
+            float idle_lph = 1.1f * rpm_axis[i] / 800.0f;
+            fuel->values[j][i] = idle_lph + power_kw * bsfc_g_per_kwh[j] / DIESEL_DENSITY_G_PER_L;
+        }
+    }
+    calibration_prepare(set);
+}
+
+static bool prepare_axis(const float* axis, uint32_t count, real_t* lut_axis) {
+    if (count < 2 || count > CAL_AXIS_MAX) return false;
+    for (uint32_t i = 0; i < CAL_AXIS_MAX; i++) {
+        if (i < count && !isfinite(axis[i])) return false;
+        if (i > 0 && i < count && !(axis[i] > axis[i - 1])) return false;
+        lut_axis[i] = i < count ? real_from_float(axis[i]) : REAL(0);
+    }
+    return true;
+}
+
+// Values plus the slope of each segment, computed in float so the rounding
+// to real_t happens once per coefficient rather than per lookup
+static bool prepare_values(const float* axis, const float* values, uint32_t count,
+                           real_t* lut_values, real_t* lut_slope) {
+    for (uint32_t i = 0; i < CAL_AXIS_MAX; i++) {
+        if (i < count && !isfinite(values[i])) return false;
+        lut_values[i] = i < count ? real_from_float(values[i]) : REAL(0);
+        lut_slope[i] = i + 1 < count
+            ? real_from_float((values[i + 1] - values[i]) / (axis[i + 1] - axis[i]))
+            : REAL(0);
+    }
+    return true;
+}
+
+// Validate axes and values, then build the lookup arrays
+bool calibration_prepare(CalibrationSet* set) {
+    CalMap1D* maps[] = { &set->throttle_speed, &set->torque_curve, &set->governor_droop };
+    for (int m = 0; m < 3; m++) {
+        if (!prepare_axis(maps[m]->axis, maps[m]->count, maps[m]->lut_axis) ||
+            !prepare_values(maps[m]->axis, maps[m]->values, maps[m]->count,
+                            maps[m]->lut_values, maps[m]->lut_slope)) {
+            return false;
+        }
+    }
+    CalMap2D* fuel = &set->fuel_map;
+    if (!prepare_axis(fuel->x_axis, fuel->x_count, fuel->lut_x_axis) ||
+        !prepare_axis(fuel->y_axis, fuel->y_count, fuel->lut_y_axis)) {
+        return false;
+    }
+    for (uint32_t j = 0; j < CAL_AXIS_MAX; j++) {
+        fuel->lut_y_inv_step[j] = j + 1 < fuel->y_count
+            ? real_from_float(1.0f / (fuel->y_axis[j + 1] - fuel->y_axis[j]))
+            : REAL(0);
+        if (!prepare_values(fuel->x_axis, fuel->values[j], j < fuel->y_count ? fuel->x_count : 0,
+                            fuel->lut_values[j], fuel->lut_x_slope[j])) {
+            return false;
+        }
+    }
+    set->name[sizeof(set->name) - 1] = '\0';
+    return true;
+}
+
+static uint32_t fnv1a(const uint8_t* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool calibration_load(const char* path, CalibrationSet* set) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return false;
+
+    uint32_t header[4];
+    bool ok = fread(header, sizeof(header), 1, file) == 1 &&
+              header[0] == CALIBRATION_MAGIC &&
+              (header[1] & 0xFFFF) == CALIBRATION_VERSION &&
+              header[2] == sizeof(CalibrationSet) &&
+              fread(set, sizeof(CalibrationSet), 1, file) == 1 &&
+              fnv1a((const uint8_t*)set, sizeof(CalibrationSet)) == header[3];
+    fclose(file);
+    return ok && calibration_prepare(set);
+}
+
+bool calibration_save(const char* path, const CalibrationSet* set) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return false;
+
+    uint32_t header[4] = {
+        CALIBRATION_MAGIC, CALIBRATION_VERSION, sizeof(CalibrationSet),
+        fnv1a((const uint8_t*)set, sizeof(CalibrationSet))
+    };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(set, sizeof(CalibrationSet), 1, file) == 1;
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,84 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../common/fixed.h"
+
+#define CALIBRATION_MAGIC    0x314C4143u   // "CAL1"
+#define CALIBRATION_VERSION  2
+#define CAL_AXIS_MAX         16
+
+// 1D table: values[i] at axis[i]; inputs are clamped to the axis ends.
+// axis/values are the calibration data as stored in the file; the lut_
+// arrays are filled by calibration_prepare in the build's real_t arithmetic.
+typedef struct {
+    uint32_t count;
+    float axis[CAL_AXIS_MAX];
+    float values[CAL_AXIS_MAX];
+    real_t lut_axis[CAL_AXIS_MAX];
+    real_t lut_values[CAL_AXIS_MAX];
+    real_t lut_slope[CAL_AXIS_MAX];      // Per-segment slope, exact at breakpoints
+} CalMap1D;
+
+// 2D table: values[j][i] at (x_axis[i], y_axis[j])
+typedef struct {
+    uint32_t x_count;
+    uint32_t y_count;
+    float x_axis[CAL_AXIS_MAX];
+    float y_axis[CAL_AXIS_MAX];
+    float values[CAL_AXIS_MAX][CAL_AXIS_MAX];
+    real_t lut_x_axis[CAL_AXIS_MAX];
+    real_t lut_y_axis[CAL_AXIS_MAX];
+    real_t lut_y_inv_step[CAL_AXIS_MAX]; // 1 / (y_axis[j+1] - y_axis[j])
+    real_t lut_values[CAL_AXIS_MAX][CAL_AXIS_MAX];
+    real_t lut_x_slope[CAL_AXIS_MAX][CAL_AXIS_MAX];
+} CalMap2D;
+
+// One complete engine calibration
+typedef struct {
+    char name[32];
+    CalMap1D throttle_speed;     // Throttle % -> governor set speed (RPM)
+    CalMap1D torque_curve;       // RPM -> full-load torque (Nm)
+    CalMap1D governor_droop;     // Load % -> speed droop below set speed (RPM)
+    CalMap2D fuel_map;           // RPM x load % -> fuel rate (L/hr)
+} CalibrationSet;
+
+// Calibration file (little-endian): u32 magic | u16 version | u16 reserved |
+// u32 payload bytes | u32 FNV-1a of payload | payload = CalibrationSet
+// (the lut_ arrays in the payload are ignored and rebuilt on load)
+
+// Segment of a clamped input: counts interior breakpoints at or below it
+// over a fixed trip count, so the search has no data-dependent branches
+static inline uint32_t cal_segment(const real_t* axis, uint32_t count, real_t v) {
+    uint32_t segment = 0;
+    for (uint32_t k = 1; k < CAL_AXIS_MAX - 1; k++) {
+        segment += (uint32_t)(v >= axis[k]) & (uint32_t)(k + 1 < count);
+    }
+    return segment;
+}
+
+static inline real_t cal_lookup_1d(const CalMap1D* map, real_t x) {
+    x = real_min(real_max(x, map->lut_axis[0]), map->lut_axis[map->count - 1]);
+    uint32_t i = cal_segment(map->lut_axis, map->count, x);
+    return real_add(map->lut_values[i], real_mul(real_sub(x, map->lut_axis[i]), map->lut_slope[i]));
+}
+
+static inline real_t cal_lookup_2d(const CalMap2D* map, real_t x, real_t y) {
+    x = real_min(real_max(x, map->lut_x_axis[0]), map->lut_x_axis[map->x_count - 1]);
+    y = real_min(real_max(y, map->lut_y_axis[0]), map->lut_y_axis[map->y_count - 1]);
+    uint32_t i = cal_segment(map->lut_x_axis, map->x_count, x);
+    uint32_t j = cal_segment(map->lut_y_axis, map->y_count, y);
+    real_t dx = real_sub(x, map->lut_x_axis[i]);
+    real_t low = real_add(map->lut_values[j][i], real_mul(dx, map->lut_x_slope[j][i]));
+    real_t high = real_add(map->lut_values[j + 1][i], real_mul(dx, map->lut_x_slope[j + 1][i]));
+    real_t ty = real_mul(real_sub(y, map->lut_y_axis[j]), map->lut_y_inv_step[j]);
+    return real_add(low, real_mul(ty, real_sub(high, low)));
+}
+
+void calibration_defaults(CalibrationSet* set);
+bool calibration_prepare(CalibrationSet* set);
+bool calibration_load(const char* path, CalibrationSet* set);
+bool calibration_save(const char* path, const CalibrationSet* set);
+
+#endif // CALIBRATION_H
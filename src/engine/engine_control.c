@@ -1,63 +1,161 @@
 #include "engine_control.h"
+#include "calibration.h"
 #include "../canbus/canbus.h"
+#include "can_messages.h"
 #include "../diagnostics/diagnostics.h"
+#include "../pto/pto.h"
+#include "../transmission/transmission.h"
+#include "../sensors/sensors.h"
+#include "../control/control_loops.h"
+#include "../common/change.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <sys/stat.h>
+
+#define ENGINE_ACCESSORY_NM  REAL(60)   // Fan, alternator, charge pump
+#define ENGINE_DRIVELINE_NM  REAL(180)  // Rolling resistance in field work
 
 static EngineState engine_state = {0};
+static uint8_t throttle_setting = 0;
+
+// Double-buffered calibration: a new file is loaded into the standby set
+// and published with one pointer store, so the loop never sees a partial map
+static CalibrationSet calibrations[2];
+static const CalibrationSet* active_calibration = &calibrations[0];
+static const char* calibration_path = NULL;
+static struct timespec calibration_mtime;
+
+static const CalibrationSet* current_calibration(void) {
+    return __atomic_load_n(&active_calibration, __ATOMIC_ACQUIRE);
+}
+
+static void poll_calibration(void) {
+    struct stat st;
+    if (calibration_path == NULL || stat(calibration_path, &st) != 0) return;
+    if (st.st_mtim.tv_sec == calibration_mtime.tv_sec && st.st_mtim.tv_nsec == calibration_mtime.tv_nsec) return;
+    calibration_mtime = st.st_mtim;
+
+    CalibrationSet* standby = active_calibration == &calibrations[0] ? &calibrations[1] : &calibrations[0];
+    if (!calibration_load(calibration_path, standby)) {
+        printf("[ENGINE] Calibration file %s rejected - keeping '%s'\n",
+               calibration_path, active_calibration->name);
+        return;
+    }
+    __atomic_store_n(&active_calibration, standby, __ATOMIC_RELEASE);
+    printf("[ENGINE] Calibration '%s' active from %s\n", standby->name, calibration_path);
+}
+
+void engine_set_calibration_file(const char* path) {
+    calibration_path = path;
+    calibration_mtime.tv_sec = 0;
+    calibration_mtime.tv_nsec = 0;
+}
+
+const char* engine_calibration_name(void) {
+    return current_calibration()->name;
+}
 
 void engine_init(void) {
     printf("[ENGINE] Initializing engine control module\n");
     engine_state.current_rpm = 0;
     engine_state.target_rpm = 0;
-    engine_state.fuel_rate = 0.0;
-    engine_state.oil_pressure = 45.0;
-    engine_state.coolant_temp = 20.0;
+    engine_state.fuel_rate = REAL(0);
+    engine_state.oil_pressure = REAL(45);
+    engine_state.coolant_temp = REAL(20);
     engine_state.engine_running = false;
     engine_state.status = STATUS_OK;
+
+    calibration_defaults(&calibrations[0]);
+    active_calibration = &calibrations[0];
+    poll_calibration();
+
+    // The calibration itself is reloaded from its file, not checkpointed
+    CHECKPOINT_VAR("engine", engine_state);
+    CHECKPOINT_VAR("engine", throttle_setting);
 }
 
 void engine_update(void) {
+    poll_calibration();
+    engine_state.coolant_temp = sensors_read(SENSOR_COOLANT_TEMP);
+    engine_state.oil_pressure = sensors_read(SENSOR_OIL_PRESSURE);
     if (!engine_state.engine_running) {
         return;
     }
+    const CalibrationSet* cal = current_calibration();
+    real_t rpm = real_from_int(engine_state.current_rpm);
 
-    // Simulate RPM control
-    if (engine_state.current_rpm < engine_state.target_rpm) {
-        engine_state.current_rpm += 50;
-    } else if (engine_state.current_rpm > engine_state.target_rpm) {
-        engine_state.current_rpm -= 50;
+    // Load demand: accessories, PTO shaft torque reflected to the crank, driveline.
+    // The speed ratio is formed first so the product stays in Q16.16 range.
+    real_t demand = ENGINE_ACCESSORY_NM;
+    PTOState* pto = pto_get_state();
+    if (pto->status == PTO_ENGAGED && engine_state.current_rpm > 0) {
+        real_t ratio = real_div(real_from_int(pto->current_rpm), rpm);
+        demand = real_add(demand, real_mul(pto->torque_nm, ratio));
     }
+    TransmissionState* transmission = transmission_get_state();
+    if (transmission->clutch_engaged && transmission->current_gear > GEAR_NEUTRAL) {
+        demand = real_add(demand, ENGINE_DRIVELINE_NM);
+    }
+    real_t full_load = cal_lookup_1d(&cal->torque_curve, rpm);
+    engine_state.load_percent = full_load > REAL(0)
+        ? real_min(real_mul(real_div(demand, full_load), REAL(100)), REAL(100))
+        : REAL(100);
+    engine_state.torque_nm = real_min(demand, full_load);
 
-    // Simulate fuel consumption based on RPM
-    engine_state.fuel_rate = (engine_state.current_rpm / 2200.0) * 15.0;
-
-    // Simulate temperature increase
-    if (engine_state.current_rpm > 1000) {
-        engine_state.coolant_temp += 0.5;
+    // Governor: throttle sets the speed, load pulls it down by the droop
+    engine_state.target_rpm = (uint16_t)real_to_int(cal_lookup_1d(&cal->throttle_speed, real_from_int(throttle_setting)));
+    // While the PTO is engaged its speed loop sets the engine speed instead
+    ControlState control;
+    control_get_state(&control);
+    if (control.active[CONTROL_LOOP_PTO_SPEED]) {
+        engine_state.target_rpm = (uint16_t)real_to_int(control.engine_request_rpm);
     }
+    int governed = engine_state.target_rpm - real_to_int(cal_lookup_1d(&cal->governor_droop, engine_state.load_percent));
+    int error = governed - engine_state.current_rpm;
+    if (error > 50) error = 50;
+    if (error < -50) error = -50;
+    engine_state.current_rpm = (uint16_t)(engine_state.current_rpm + error);
+    change_publish(&engine_state.generation, error != 0);
+
+    // Fuel consumption from the calibrated RPM x load map
+    engine_state.fuel_rate = cal_lookup_2d(&cal->fuel_map, real_from_int(engine_state.current_rpm),
+                                           engine_state.load_percent);
 
     // Send data to CAN bus
-    canbus_send_message(0x100, (uint8_t*)&engine_state.current_rpm, 2);
+    CanEngineStatus status = {
+        .engine_speed = engine_state.current_rpm,
+        .target_speed = engine_state.target_rpm,
+        .engine_load = real_to_float(engine_state.load_percent),
+        .coolant_temp = real_to_float(engine_state.coolant_temp),
+        .fuel_rate = real_to_float(engine_state.fuel_rate),
+    };
+    uint8_t data[CAN_DLC_ENGINE_STATUS];
+    can_pack_engine_status(data, &status);
+    canbus_send_message(CAN_ID_ENGINE_STATUS, data, sizeof(data));
 
     // Check for fault conditions
     SystemStatus health = engine_check_health();
     if (health != STATUS_OK) {
-        diagnostics_report_fault(SPN_ENGINE_COOLANT_TEMP, FMI_DATA_ABOVE_NORMAL, "Engine", "Engine coolant temperature extremely high");
+        diagnostics_report_fault(FAULT_ENGINE_COOLANT_HIGH);
     }
 }
 
 void engine_set_throttle(uint8_t throttle_percent) {
     if (throttle_percent > 100) throttle_percent = 100;
-    engine_state.target_rpm = 800 + (throttle_percent * 18); // Idle at 800, max at 2600
+    throttle_setting = throttle_percent;
+    engine_state.target_rpm = (uint16_t)real_to_int(cal_lookup_1d(&current_calibration()->throttle_speed,
+                                                                 real_from_int(throttle_percent)));
     printf("[ENGINE] Throttle set to %d%%, target RPM: %d\n", throttle_percent, engine_state.target_rpm);
 }
 
 void engine_start(void) {
     printf("[ENGINE] Starting engine\n");
     engine_state.engine_running = true;
-    engine_state.target_rpm = 800; // Idle RPM
+    change_publish(&engine_state.generation, true);
+    throttle_setting = 0;   // Idle
+    engine_state.target_rpm = (uint16_t)real_to_int(cal_lookup_1d(&current_calibration()->throttle_speed, REAL(0)));
 }
 
 void engine_stop(void) {
@@ -65,6 +163,7 @@ void engine_stop(void) {
     engine_state.engine_running = false;
     engine_state.current_rpm = 0;
     engine_state.target_rpm = 0;
+    change_publish(&engine_state.generation, true);
 }
 
 EngineState* engine_get_state(void) {
@@ -72,11 +171,11 @@ EngineState* engine_get_state(void) {
 }
 
 SystemStatus engine_check_health(void) {
-    if (engine_state.coolant_temp > 105.0) {
+    if (engine_state.coolant_temp > REAL(105)) {
         engine_state.status = STATUS_CRITICAL;
         return STATUS_CRITICAL;
     }
-    if (engine_state.oil_pressure < 20.0) {
+    if (engine_state.oil_pressure < REAL(20)) {
         engine_state.status = STATUS_WARNING;
         return STATUS_WARNING;
     }
@@ -2,22 +2,30 @@
 #define ENGINE_CONTROL_H
 
 #include "../common/types.h"
+#include "../common/fixed.h"
 
 // Engine control module - manages RPM, fuel injection, timing
 typedef struct {
     uint16_t current_rpm;
     uint16_t target_rpm;
-    float fuel_rate;          // L/hr
-    float oil_pressure;       // PSI
-    float coolant_temp;       // Celsius
+    real_t fuel_rate;          // L/hr
+    real_t oil_pressure;       // PSI
+    real_t coolant_temp;       // Celsius
+    real_t load_percent;       // Demanded torque vs full-load torque at current RPM
+    real_t torque_nm;          // Delivered torque
     bool engine_running;
     SystemStatus status;
+    uint32_t generation;       // Bumped when current_rpm or engine_running changes
 } EngineState;
 
-// Dependencies: CANBus (send RPM data), Diagnostics (report faults)
+// Dependencies: CANBus (send RPM data), Diagnostics (report faults),
+// PTO and Transmission (load demand), Sensors (coolant temperature, oil pressure),
+// Control (engine speed request from the PTO speed loop)
 void engine_init(void);
 void engine_update(void);
 void engine_set_throttle(uint8_t throttle_percent);
+void engine_set_calibration_file(const char* path);
+const char* engine_calibration_name(void);
 void engine_start(void);
 void engine_stop(void);
 EngineState* engine_get_state(void);
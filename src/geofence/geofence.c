@@ -0,0 +1,381 @@
+#include "geofence.h"
+#include "../telematics/telematics.h"
+#include "../coverage/coverage.h"
+#include "../canbus/canbus.h"
+#include "can_messages.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+typedef struct {
+    uint32_t id;
+    uint8_t kind;
+    uint32_t first_vertex;
+    uint32_t vertex_count;
+    float min_x, min_y, max_x, max_y;
+} GeofencePolygon;
+
+static GeofenceState geofence_state = { .nearest_polygon_id = -1 };
+
+// Polygon and vertex pools (structure of arrays for the edge loops)
+static GeofencePolygon polygons[GEOFENCE_MAX_POLYGONS];
+static float vertex_x[GEOFENCE_MAX_VERTICES];
+static float vertex_y[GEOFENCE_MAX_VERTICES];
+
+// Uniform grid in CSR layout: cell i lists cell_entries[cell_start[i] .. cell_start[i+1])
+static uint32_t cell_start[GEOFENCE_MAX_GRID_CELLS + 1];
+static uint16_t cell_entries[GEOFENCE_MAX_ENTRIES];
+static float grid_min_x, grid_min_y;
+
+static const char* kind_names[GEOFENCE_KIND_COUNT] = {
+    "field boundary", "headland", "waterway", "no-spray zone", "exclusion zone"
+};
+
+void geofence_init(void) {
+    printf("[GEOFENCE] Initializing geofence engine\n");
+    memset(&geofence_state, 0, sizeof(geofence_state));
+    geofence_state.nearest_polygon_id = -1;
+    geofence_state.boundary_distance_m = -1.0f;
+}
+
+bool geofence_add_polygon(uint32_t id, GeofenceKind kind, const float* east_m, const float* north_m, uint32_t count) {
+    if (count < 3 || kind >= GEOFENCE_KIND_COUNT ||
+        geofence_state.polygon_count >= GEOFENCE_MAX_POLYGONS ||
+        geofence_state.vertex_count + count > GEOFENCE_MAX_VERTICES) {
+        return false;
+    }
+
+    GeofencePolygon* polygon = &polygons[geofence_state.polygon_count++];
+    polygon->id = id;
+    polygon->kind = (uint8_t)kind;
+    polygon->first_vertex = geofence_state.vertex_count;
+    polygon->vertex_count = count;
+    polygon->min_x = polygon->max_x = east_m[0];
+    polygon->min_y = polygon->max_y = north_m[0];
+
+    for (uint32_t i = 0; i < count; i++) {
+        vertex_x[polygon->first_vertex + i] = east_m[i];
+        vertex_y[polygon->first_vertex + i] = north_m[i];
+        if (east_m[i] < polygon->min_x) polygon->min_x = east_m[i];
+        if (east_m[i] > polygon->max_x) polygon->max_x = east_m[i];
+        if (north_m[i] < polygon->min_y) polygon->min_y = north_m[i];
+        if (north_m[i] > polygon->max_y) polygon->max_y = north_m[i];
+    }
+    geofence_state.vertex_count += count;
+    return true;
+}
+
+static void cell_range(const GeofencePolygon* polygon, float cell_size,
+                       uint32_t* x0, uint32_t* y0, uint32_t* x1, uint32_t* y1) {
+    *x0 = (uint32_t)((polygon->min_x - grid_min_x) / cell_size);
+    *y0 = (uint32_t)((polygon->min_y - grid_min_y) / cell_size);
+    *x1 = (uint32_t)((polygon->max_x - grid_min_x) / cell_size);
+    *y1 = (uint32_t)((polygon->max_y - grid_min_y) / cell_size);
+    if (*x1 >= geofence_state.grid_width) *x1 = geofence_state.grid_width - 1;
+    if (*y1 >= geofence_state.grid_height) *y1 = geofence_state.grid_height - 1;
+}
+
+void geofence_build_index(void) {
+    uint32_t count = geofence_state.polygon_count;
+    geofence_state.grid_width = 0;
+    geofence_state.grid_height = 0;
+    if (count == 0) return;
+
+    float min_x = polygons[0].min_x, min_y = polygons[0].min_y;
+    float max_x = polygons[0].max_x, max_y = polygons[0].max_y;
+    for (uint32_t p = 1; p < count; p++) {
+        if (polygons[p].min_x < min_x) min_x = polygons[p].min_x;
+        if (polygons[p].min_y < min_y) min_y = polygons[p].min_y;
+        if (polygons[p].max_x > max_x) max_x = polygons[p].max_x;
+        if (polygons[p].max_y > max_y) max_y = polygons[p].max_y;
+    }
+    float width = fmaxf(max_x - min_x, 1.0f);
+    float height = fmaxf(max_y - min_y, 1.0f);
+    grid_min_x = min_x;
+    grid_min_y = min_y;
+
+    // Aim for a few cells per polygon, then coarsen until the index fits
+    uint32_t target = count * 4 < GEOFENCE_MAX_GRID_CELLS ? count * 4 : GEOFENCE_MAX_GRID_CELLS;
+    float cell_size = sqrtf(width * height / (float)target);
+    for (;;) {
+        uint32_t gw = (uint32_t)(width / cell_size) + 1;
+        uint32_t gh = (uint32_t)(height / cell_size) + 1;
+        if ((uint64_t)gw * gh > GEOFENCE_MAX_GRID_CELLS) {
+            cell_size *= 1.25f;
+            continue;
+        }
+        geofence_state.grid_width = gw;
+        geofence_state.grid_height = gh;
+
+        // Count pass
+        uint32_t cells = gw * gh;
+        memset(cell_start, 0, (cells + 1) * sizeof(cell_start[0]));
+        uint64_t entries = 0;
+        for (uint32_t p = 0; p < count; p++) {
+            uint32_t x0, y0, x1, y1;
+            cell_range(&polygons[p], cell_size, &x0, &y0, &x1, &y1);
+            for (uint32_t y = y0; y <= y1; y++) {
+                for (uint32_t x = x0; x <= x1; x++) {
+                    cell_start[y * gw + x + 1]++;
+                }
+            }
+            entries += (uint64_t)(x1 - x0 + 1) * (y1 - y0 + 1);
+        }
+        if (entries > GEOFENCE_MAX_ENTRIES) {
+            cell_size *= 1.25f;
+            continue;
+        }
+
+        // Prefix sums, then fill pass
+        for (uint32_t c = 0; c < cells; c++) {
+            cell_start[c + 1] += cell_start[c];
+        }
+        static uint32_t fill[GEOFENCE_MAX_GRID_CELLS];
+        memcpy(fill, cell_start, cells * sizeof(fill[0]));
+        for (uint32_t p = 0; p < count; p++) {
+            uint32_t x0, y0, x1, y1;
+            cell_range(&polygons[p], cell_size, &x0, &y0, &x1, &y1);
+            for (uint32_t y = y0; y <= y1; y++) {
+                for (uint32_t x = x0; x <= x1; x++) {
+                    cell_entries[fill[y * gw + x]++] = (uint16_t)p;
+                }
+            }
+        }
+        geofence_state.cell_size_m = cell_size;
+        printf("[GEOFENCE] Indexed %u polygons (%u vertices) in a %ux%u grid of %.1f m cells, %llu entries\n",
+               count, geofence_state.vertex_count, gw, gh, cell_size, (unsigned long long)entries);
+        return;
+    }
+}
+
+static float polygon_area(const GeofencePolygon* polygon) {
+    float area = 0.0f;
+    uint32_t n = polygon->vertex_count;
+    const float* x = &vertex_x[polygon->first_vertex];
+    const float* y = &vertex_y[polygon->first_vertex];
+    for (uint32_t i = 0, j = n - 1; i < n; j = i++) {
+        area += x[j] * y[i] - x[i] * y[j];
+    }
+    return fabsf(area) * 0.5f;
+}
+
+bool geofence_load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("[GEOFENCE] Cannot open %s\n", path);
+        return false;
+    }
+
+    uint32_t header[2];
+    if (fread(header, sizeof(header), 1, file) != 1 || header[0] != GEOFENCE_MAGIC) {
+        printf("[GEOFENCE] %s is not a geofence polygon set\n", path);
+        fclose(file);
+        return false;
+    }
+
+    static int32_t raw[GEOFENCE_MAX_VERTICES * 2];
+    static float east[GEOFENCE_MAX_VERTICES];
+    static float north[GEOFENCE_MAX_VERTICES];
+    uint32_t loaded = 0;
+
+    for (uint32_t p = 0; p < header[1]; p++) {
+        uint32_t record[3];
+        if (fread(record, sizeof(record), 1, file) != 1) break;
+        uint32_t count = record[2];
+        if (count > GEOFENCE_MAX_VERTICES || fread(raw, sizeof(int32_t) * 2, count, file) != count) break;
+
+        for (uint32_t i = 0; i < count; i++) {
+            telematics_to_local(raw[2 * i] / 1e7, raw[2 * i + 1] / 1e7, &east[i], &north[i]);
+        }
+        if (geofence_add_polygon(record[0], (GeofenceKind)(record[1] & 0xFF), east, north, count)) {
+            loaded++;
+        }
+    }
+    fclose(file);
+
+    printf("[GEOFENCE] Loaded %u of %u polygons from %s\n", loaded, header[1], path);
+    geofence_build_index();
+
+    // Workable field area = boundary minus zones that are never worked
+    float area = 0.0f;
+    for (uint32_t p = 0; p < geofence_state.polygon_count; p++) {
+        if (polygons[p].kind == GEOFENCE_FIELD_BOUNDARY) area += polygon_area(&polygons[p]);
+        else if (polygons[p].kind == GEOFENCE_WATERWAY || polygons[p].kind == GEOFENCE_EXCLUSION) area -= polygon_area(&polygons[p]);
+    }
+    if (area > 0.0f) {
+        coverage_set_field_area(area / 10000.0f);
+    }
+    return loaded == header[1];
+}
+
+// Crossing-number test and nearest edge of one polygon in a single pass
+static bool test_polygon(const GeofencePolygon* polygon, float east_m, float north_m, float* nearest_sq) {
+    const float* x = &vertex_x[polygon->first_vertex];
+    const float* y = &vertex_y[polygon->first_vertex];
+    uint32_t n = polygon->vertex_count;
+    bool inside = false;
+    *nearest_sq = INFINITY;
+
+    for (uint32_t i = 0, j = n - 1; i < n; j = i++) {
+        float ex = x[i] - x[j];
+        float ey = y[i] - y[j];
+        if ((y[i] > north_m) != (y[j] > north_m) &&
+            east_m < x[j] + ex * (north_m - y[j]) / ey) {
+            inside = !inside;
+        }
+        float px = east_m - x[j];
+        float py = north_m - y[j];
+        float length_sq = ex * ex + ey * ey;
+        float t = length_sq > 0.0f ? (px * ex + py * ey) / length_sq : 0.0f;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        float dx = px - t * ex;
+        float dy = py - t * ey;
+        float d_sq = dx * dx + dy * dy;
+        if (d_sq < *nearest_sq) *nearest_sq = d_sq;
+    }
+    return inside;
+}
+
+// Squared distance from a point to a polygon's bounding box (0 inside it)
+static float box_distance_sq(const GeofencePolygon* polygon, float east_m, float north_m) {
+    float dx = fmaxf(fmaxf(polygon->min_x - east_m, east_m - polygon->max_x), 0.0f);
+    float dy = fmaxf(fmaxf(polygon->min_y - north_m, north_m - polygon->max_y), 0.0f);
+    return dx * dx + dy * dy;
+}
+
+uint32_t geofence_query(float east_m, float north_m, float* distance_m, int32_t* nearest_id) {
+    *distance_m = -1.0f;
+    *nearest_id = -1;
+    if (geofence_state.grid_width == 0) return 0;
+
+    float cell_size = geofence_state.cell_size_m;
+    float fx = (east_m - grid_min_x) / cell_size;
+    float fy = (north_m - grid_min_y) / cell_size;
+    if (fx < 0.0f || fy < 0.0f || fx >= geofence_state.grid_width || fy >= geofence_state.grid_height) {
+        return 0;
+    }
+    int32_t gw = (int32_t)geofence_state.grid_width;
+    int32_t gh = (int32_t)geofence_state.grid_height;
+    int32_t cx = (int32_t)fx;
+    int32_t cy = (int32_t)fy;
+
+    // Polygons span several cells; stamp each one so it is tested once
+    static uint32_t polygon_stamp[GEOFENCE_MAX_POLYGONS];
+    static uint32_t stamp;
+    if (++stamp == 0) {
+        memset(polygon_stamp, 0, sizeof(polygon_stamp));
+        stamp = 1;
+    }
+
+    // Containing polygons are all indexed in the position's own cell, so the
+    // mask is final after ring 0. The nearest edge may lie further out: walk
+    // the rings of cells around it until no unvisited cell can be closer.
+    float margin = fminf(fminf(fx - cx, cx + 1 - fx), fminf(fy - cy, cy + 1 - fy)) * cell_size;
+    int32_t last_ring = cx;
+    if (cy > last_ring) last_ring = cy;
+    if (gw - 1 - cx > last_ring) last_ring = gw - 1 - cx;
+    if (gh - 1 - cy > last_ring) last_ring = gh - 1 - cy;
+
+    uint32_t mask = 0;
+    float best_sq = INFINITY;
+    for (int32_t ring = 0; ring <= last_ring; ring++) {
+        if (ring > 0) {
+            float reach = margin + (ring - 1) * cell_size;
+            if (reach * reach >= best_sq) break;
+        }
+        for (int32_t y = cy - ring; y <= cy + ring; y++) {
+            if (y < 0 || y >= gh) continue;
+            // Inner rows only contribute the ring's two edge columns
+            int32_t step = (y == cy - ring || y == cy + ring) ? 1 : 2 * ring;
+            for (int32_t x = cx - ring; x <= cx + ring; x += step) {
+                if (x < 0 || x >= gw) continue;
+                uint32_t cell = (uint32_t)(y * gw + x);
+                for (uint32_t e = cell_start[cell]; e < cell_start[cell + 1]; e++) {
+                    uint16_t p = cell_entries[e];
+                    if (polygon_stamp[p] == stamp) continue;
+                    polygon_stamp[p] = stamp;
+                    const GeofencePolygon* polygon = &polygons[p];
+                    if (ring > 0 && box_distance_sq(polygon, east_m, north_m) >= best_sq) continue;
+
+                    float nearest_sq;
+                    if (test_polygon(polygon, east_m, north_m, &nearest_sq)) {
+                        mask |= GEOFENCE_MASK(polygon->kind);
+                    }
+                    if (nearest_sq < best_sq) {
+                        best_sq = nearest_sq;
+                        *nearest_id = (int32_t)polygon->id;
+                    }
+                }
+            }
+        }
+    }
+    if (*nearest_id >= 0) {
+        *distance_m = sqrtf(best_sq);
+    }
+    return mask;
+}
+
+void geofence_update(void) {
+    if (geofence_state.polygon_count == 0) return;
+
+    TelematicsState* telem = telematics_get_state();
+    float east, north;
+    telematics_to_local(telem->gps.latitude, telem->gps.longitude, &east, &north);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t mask = geofence_query(east, north, &geofence_state.boundary_distance_m,
+                                   &geofence_state.nearest_polygon_id);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    float elapsed_us = (end.tv_sec - start.tv_sec) * 1e6f + (end.tv_nsec - start.tv_nsec) / 1e3f;
+    geofence_state.queries++;
+    geofence_state.last_query_us = elapsed_us;
+    if (elapsed_us > geofence_state.max_query_us) geofence_state.max_query_us = elapsed_us;
+
+    geofence_state.entered_mask = mask & ~geofence_state.inside_mask;
+    geofence_state.exited_mask = geofence_state.inside_mask & ~mask;
+    geofence_state.inside_mask = mask;
+
+    if (geofence_state.entered_mask || geofence_state.exited_mask) {
+        for (int k = 0; k < GEOFENCE_KIND_COUNT; k++) {
+            if (geofence_state.entered_mask & GEOFENCE_MASK(k)) printf("[GEOFENCE] Entered %s\n", kind_names[k]);
+            if (geofence_state.exited_mask & GEOFENCE_MASK(k)) printf("[GEOFENCE] Left %s\n", kind_names[k]);
+        }
+
+        // Zone event
+        CanGeofenceEvent event = {
+            .inside_mask = (uint8_t)geofence_state.inside_mask,
+            .entered_mask = (uint8_t)geofence_state.entered_mask,
+            .exited_mask = (uint8_t)geofence_state.exited_mask,
+            .boundary_distance = geofence_state.boundary_distance_m < 0.0f ? 6553.5f :
+                                 fminf(geofence_state.boundary_distance_m, 6553.4f),
+        };
+        uint8_t data[CAN_DLC_GEOFENCE_EVENT];
+        can_pack_geofence_event(data, &event);
+        canbus_send_message(CAN_ID_GEOFENCE_EVENT, data, sizeof(data));
+    }
+}
+
+void geofence_print_status(void) {
+    if (geofence_state.polygon_count == 0) return;
+    printf("\n=== GEOFENCE ===\n");
+    printf("Polygons: %u (%u vertices), grid %ux%u @ %.1f m\n",
+           geofence_state.polygon_count, geofence_state.vertex_count,
+           geofence_state.grid_width, geofence_state.grid_height, geofence_state.cell_size_m);
+    printf("Inside:");
+    if (geofence_state.inside_mask == 0) printf(" (none)");
+    for (int k = 0; k < GEOFENCE_KIND_COUNT; k++) {
+        if (geofence_state.inside_mask & GEOFENCE_MASK(k)) printf(" [%s]", kind_names[k]);
+    }
+    printf("\nNearest boundary: %.1f m (polygon %d)\n",
+           geofence_state.boundary_distance_m, geofence_state.nearest_polygon_id);
+    printf("Query time: last %.2f us, max %.2f us over %u queries\n",
+           geofence_state.last_query_us, geofence_state.max_query_us, geofence_state.queries);
+    printf("================\n\n");
+}
+
+GeofenceState* geofence_get_state(void) {
+    return &geofence_state;
+}
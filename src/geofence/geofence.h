@@ -0,0 +1,60 @@
+#ifndef GEOFENCE_H
+#define GEOFENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GEOFENCE_MAGIC          0x314F4547u   // "GEO1"
+#define GEOFENCE_MAX_POLYGONS   8192
+#define GEOFENCE_MAX_VERTICES   (256 * 1024)
+#define GEOFENCE_MAX_GRID_CELLS (256 * 256)
+#define GEOFENCE_MAX_ENTRIES    (1024 * 1024) // Polygon references across all grid cells
+
+typedef enum {
+    GEOFENCE_FIELD_BOUNDARY = 0,
+    GEOFENCE_HEADLAND,
+    GEOFENCE_WATERWAY,
+    GEOFENCE_NO_SPRAY,
+    GEOFENCE_EXCLUSION,
+    GEOFENCE_KIND_COUNT
+} GeofenceKind;
+
+#define GEOFENCE_MASK(kind) (1u << (kind))
+
+// Binary polygon set (little-endian):
+//   u32 magic | u32 polygon count
+//   per polygon: u32 id | u8 kind | u8 pad[3] | u32 vertex count
+//                then vertex count x (i32 lat 1e-7 deg, i32 lon 1e-7 deg)
+// Vertices are converted to the telematics field frame on load.
+
+// Geofence engine - polygons indexed by a uniform grid; each update tests
+// the GPS position against the polygons in its grid cell, and widens the
+// search ring by ring only as far as the nearest boundary needs
+typedef struct {
+    uint32_t polygon_count;
+    uint32_t vertex_count;
+    uint32_t grid_width;
+    uint32_t grid_height;
+    float cell_size_m;
+    uint32_t inside_mask;        // Kinds of every polygon containing the position
+    uint32_t entered_mask;       // Kinds entered/exited on the last update
+    uint32_t exited_mask;
+    float boundary_distance_m;   // Nearest polygon edge, -1 outside the indexed area
+    int32_t nearest_polygon_id;  // -1 when no candidate
+    uint32_t queries;
+    float last_query_us;
+    float max_query_us;
+} GeofenceState;
+
+// Dependencies: Telematics (GPS, field frame), CANBus (zone events 0x250),
+// Coverage (field area from the boundary polygons)
+void geofence_init(void);
+bool geofence_load(const char* path);
+bool geofence_add_polygon(uint32_t id, GeofenceKind kind, const float* east_m, const float* north_m, uint32_t count);
+void geofence_build_index(void);
+uint32_t geofence_query(float east_m, float north_m, float* distance_m, int32_t* nearest_id);
+void geofence_update(void);
+void geofence_print_status(void);
+GeofenceState* geofence_get_state(void);
+
+#endif // GEOFENCE_H
@@ -0,0 +1,512 @@
+#include "guidance.h"
+#include "../telematics/telematics.h"
+#include "../canbus/canbus.h"
+#include "can_messages.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#define PERIOD_NS (1000000000L / GUIDANCE_RATE_HZ)
+
+static GuidanceState guidance_state = {0};
+
+// The worker computes under this lock; fixes, path changes and status
+// reads from the main loop take it too
+static pthread_mutex_t guidance_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t worker;
+
+// Latest GPS fix, dead-reckoned forward by the worker
+static struct {
+    float east, north;
+    float heading_deg;
+    float speed_mps;
+    struct timespec time;
+    float age_s;                 // Simulated time since the fix, lockstep runs
+} fix;
+
+// Reference path: A-B line and pivot use the first one/two points
+static float vertex_x[GUIDANCE_MAX_VERTICES];
+static float vertex_y[GUIDANCE_MAX_VERTICES];
+static float pivot_radius;
+
+// Curve segments in a uniform grid, CSR layout: cell i lists
+// cell_entries[cell_start[i] .. cell_start[i+1]); segment s joins vertices s and s+1
+static uint32_t cell_start[GUIDANCE_MAX_GRID_CELLS + 1];
+static uint32_t cell_entries[GUIDANCE_MAX_ENTRIES];
+static float grid_min_x, grid_min_y;
+
+static const char* mode_names[] = { "Off", "A-B line", "Curve", "Pivot" };
+
+static float elapsed_us(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1e6f + (end->tv_nsec - start->tv_nsec) / 1e3f;
+}
+
+static float wrap_degrees(float angle) {
+    while (angle > 180.0f) angle -= 360.0f;
+    while (angle <= -180.0f) angle += 360.0f;
+    return angle;
+}
+
+void guidance_init(void) {
+    printf("[GUIDANCE] Initializing guidance module\n");
+    pthread_mutex_lock(&guidance_lock);
+    memset(&guidance_state, 0, sizeof(guidance_state));
+    pthread_mutex_unlock(&guidance_lock);
+}
+
+void guidance_set_ab_line(float a_east, float a_north, float b_east, float b_north) {
+    pthread_mutex_lock(&guidance_lock);
+    vertex_x[0] = a_east;
+    vertex_y[0] = a_north;
+    vertex_x[1] = b_east;
+    vertex_y[1] = b_north;
+    guidance_state.vertex_count = 2;
+    guidance_state.mode = GUIDANCE_AB_LINE;
+    guidance_state.pass_number = 0;
+    pthread_mutex_unlock(&guidance_lock);
+
+    float bearing = atan2f(b_east - a_east, b_north - a_north) * 180.0f / (float)M_PI;
+    printf("[GUIDANCE] A-B line set, bearing %.1f°\n", bearing < 0.0f ? bearing + 360.0f : bearing);
+}
+
+void guidance_set_pivot(float center_east, float center_north, float first_radius_m) {
+    pthread_mutex_lock(&guidance_lock);
+    vertex_x[0] = center_east;
+    vertex_y[0] = center_north;
+    pivot_radius = first_radius_m;
+    guidance_state.vertex_count = 1;
+    guidance_state.mode = GUIDANCE_PIVOT;
+    guidance_state.pass_number = 0;
+    pthread_mutex_unlock(&guidance_lock);
+    printf("[GUIDANCE] Pivot set, first circle %.1f m\n", first_radius_m);
+}
+
+static void segment_cells(uint32_t s, float cell_size, uint32_t* x0, uint32_t* y0, uint32_t* x1, uint32_t* y1) {
+    *x0 = (uint32_t)((fminf(vertex_x[s], vertex_x[s + 1]) - grid_min_x) / cell_size);
+    *y0 = (uint32_t)((fminf(vertex_y[s], vertex_y[s + 1]) - grid_min_y) / cell_size);
+    *x1 = (uint32_t)((fmaxf(vertex_x[s], vertex_x[s + 1]) - grid_min_x) / cell_size);
+    *y1 = (uint32_t)((fmaxf(vertex_y[s], vertex_y[s + 1]) - grid_min_y) / cell_size);
+    if (*x1 >= guidance_state.grid_width) *x1 = guidance_state.grid_width - 1;
+    if (*y1 >= guidance_state.grid_height) *y1 = guidance_state.grid_height - 1;
+}
+
+// Grid over the curve's bounding box, sized for a couple of cells per segment
+static void build_index(uint32_t segments) {
+    float min_x = vertex_x[0], min_y = vertex_y[0], max_x = vertex_x[0], max_y = vertex_y[0];
+    for (uint32_t i = 1; i <= segments; i++) {
+        min_x = fminf(min_x, vertex_x[i]);
+        min_y = fminf(min_y, vertex_y[i]);
+        max_x = fmaxf(max_x, vertex_x[i]);
+        max_y = fmaxf(max_y, vertex_y[i]);
+    }
+    float width = fmaxf(max_x - min_x, 1.0f);
+    float height = fmaxf(max_y - min_y, 1.0f);
+    grid_min_x = min_x;
+    grid_min_y = min_y;
+
+    uint32_t target = segments * 2 < GUIDANCE_MAX_GRID_CELLS ? segments * 2 : GUIDANCE_MAX_GRID_CELLS;
+    float cell_size = fmaxf(sqrtf(width * height / (float)target), 0.5f);
+    for (;;) {
+        uint32_t gw = (uint32_t)(width / cell_size) + 1;
+        uint32_t gh = (uint32_t)(height / cell_size) + 1;
+        if ((uint64_t)gw * gh > GUIDANCE_MAX_GRID_CELLS) {
+            cell_size *= 1.25f;
+            continue;
+        }
+        guidance_state.grid_width = gw;
+        guidance_state.grid_height = gh;
+
+        // Count pass
+        uint32_t cells = gw * gh;
+        memset(cell_start, 0, (cells + 1) * sizeof(cell_start[0]));
+        uint64_t entries = 0;
+        for (uint32_t s = 0; s < segments; s++) {
+            uint32_t x0, y0, x1, y1;
+            segment_cells(s, cell_size, &x0, &y0, &x1, &y1);
+            for (uint32_t y = y0; y <= y1; y++) {
+                for (uint32_t x = x0; x <= x1; x++) {
+                    cell_start[y * gw + x + 1]++;
+                }
+            }
+            entries += (uint64_t)(x1 - x0 + 1) * (y1 - y0 + 1);
+        }
+        if (entries > GUIDANCE_MAX_ENTRIES) {
+            cell_size *= 1.25f;
+            continue;
+        }
+
+        // Prefix sums, then fill pass
+        for (uint32_t c = 0; c < cells; c++) {
+            cell_start[c + 1] += cell_start[c];
+        }
+        static uint32_t fill[GUIDANCE_MAX_GRID_CELLS];
+        memcpy(fill, cell_start, cells * sizeof(fill[0]));
+        for (uint32_t s = 0; s < segments; s++) {
+            uint32_t x0, y0, x1, y1;
+            segment_cells(s, cell_size, &x0, &y0, &x1, &y1);
+            for (uint32_t y = y0; y <= y1; y++) {
+                for (uint32_t x = x0; x <= x1; x++) {
+                    cell_entries[fill[y * gw + x]++] = s;
+                }
+            }
+        }
+        guidance_state.cell_size_m = cell_size;
+        printf("[GUIDANCE] Indexed %u curve segments in a %ux%u grid of %.1f m cells, %llu entries\n",
+               segments, gw, gh, cell_size, (unsigned long long)entries);
+        return;
+    }
+}
+
+bool guidance_set_curve(const float* east_m, const float* north_m, uint32_t count) {
+    if (count < 2 || count > GUIDANCE_MAX_VERTICES) {
+        printf("[GUIDANCE] Curve needs 2 to %d vertices, got %u\n", GUIDANCE_MAX_VERTICES, count);
+        return false;
+    }
+    pthread_mutex_lock(&guidance_lock);
+    memcpy(vertex_x, east_m, count * sizeof(float));
+    memcpy(vertex_y, north_m, count * sizeof(float));
+    guidance_state.vertex_count = count;
+    guidance_state.nearest_segment = 0;
+    guidance_state.pass_number = 0;
+    guidance_state.mode = GUIDANCE_CURVE;
+    build_index(count - 1);
+    pthread_mutex_unlock(&guidance_lock);
+    return true;
+}
+
+bool guidance_load(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("[GUIDANCE] Cannot open %s\n", path);
+        return false;
+    }
+
+    static float east[GUIDANCE_MAX_VERTICES];
+    static float north[GUIDANCE_MAX_VERTICES];
+    uint32_t count = 0;
+    bool curve = false, ok = false;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char keyword[16];
+        double a_lat, a_lon, b_lat, b_lon, radius = 0.0;
+        if (line[0] == '#' || sscanf(line, "%15s", keyword) != 1) continue;
+
+        if (curve) {
+            if (sscanf(line, "%lf %lf", &a_lat, &a_lon) == 2 && count < GUIDANCE_MAX_VERTICES) {
+                telematics_to_local(a_lat, a_lon, &east[count], &north[count]);
+                count++;
+            }
+        } else if (strcasecmp(keyword, "AB") == 0 &&
+                   sscanf(line, "%*s %lf %lf %lf %lf", &a_lat, &a_lon, &b_lat, &b_lon) == 4) {
+            float ax, ay, bx, by;
+            telematics_to_local(a_lat, a_lon, &ax, &ay);
+            telematics_to_local(b_lat, b_lon, &bx, &by);
+            guidance_set_ab_line(ax, ay, bx, by);
+            ok = true;
+            break;
+        } else if (strcasecmp(keyword, "PIVOT") == 0 &&
+                   sscanf(line, "%*s %lf %lf %lf", &a_lat, &a_lon, &radius) >= 2) {
+            float cx, cy;
+            telematics_to_local(a_lat, a_lon, &cx, &cy);
+            guidance_set_pivot(cx, cy, (float)radius);
+            ok = true;
+            break;
+        } else if (strcasecmp(keyword, "CURVE") == 0) {
+            curve = true;
+        }
+    }
+    fclose(file);
+
+    if (curve) {
+        ok = guidance_set_curve(east, north, count);
+        if (ok) printf("[GUIDANCE] Loaded %u-vertex curve from %s\n", count, path);
+    } else if (!ok) {
+        printf("[GUIDANCE] %s has no usable guidance path\n", path);
+    }
+    return ok;
+}
+
+void guidance_set_swath_width(float width_m) {
+    pthread_mutex_lock(&guidance_lock);
+    guidance_state.swath_width_m = width_m;
+    pthread_mutex_unlock(&guidance_lock);
+}
+
+void guidance_set_fix(float east_m, float north_m, float heading_deg, float speed_kmh) {
+    pthread_mutex_lock(&guidance_lock);
+    fix.east = east_m;
+    fix.north = north_m;
+    fix.heading_deg = heading_deg;
+    fix.speed_mps = speed_kmh / 3.6f;
+    clock_gettime(CLOCK_MONOTONIC, &fix.time);
+    fix.age_s = 0.0f;
+    guidance_state.valid = true;
+    pthread_mutex_unlock(&guidance_lock);
+}
+
+// Squared distance from (px, py) to segment s, with the projection parameter
+static inline float segment_distance_sq(uint32_t s, float px, float py, float* t_out) {
+    float ex = vertex_x[s + 1] - vertex_x[s];
+    float ey = vertex_y[s + 1] - vertex_y[s];
+    float dx = px - vertex_x[s];
+    float dy = py - vertex_y[s];
+    float length_sq = ex * ex + ey * ey;
+    float t = length_sq > 0.0f ? (dx * ex + dy * ey) / length_sq : 0.0f;
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    *t_out = t;
+    dx -= t * ex;
+    dy -= t * ey;
+    return dx * dx + dy * dy;
+}
+
+// Nearest curve segment: seeded with the previous answer and its neighbours,
+// then grid rings outward until no unvisited cell can hold anything closer
+static uint32_t nearest_segment(float px, float py) {
+    uint32_t segments = guidance_state.vertex_count - 1;
+    uint32_t best = guidance_state.nearest_segment < segments ? guidance_state.nearest_segment : 0;
+    float t;
+    float best_sq = segment_distance_sq(best, px, py, &t);
+    for (int k = -2; k <= 2; k++) {
+        int64_t s = (int64_t)guidance_state.nearest_segment + k;
+        if (s < 0 || s >= segments) continue;
+        float d_sq = segment_distance_sq((uint32_t)s, px, py, &t);
+        if (d_sq < best_sq) {
+            best_sq = d_sq;
+            best = (uint32_t)s;
+        }
+    }
+
+    int32_t gw = (int32_t)guidance_state.grid_width, gh = (int32_t)guidance_state.grid_height;
+    float cell = guidance_state.cell_size_m;
+    int32_t cx = (int32_t)floorf((px - grid_min_x) / cell);
+    int32_t cy = (int32_t)floorf((py - grid_min_y) / cell);
+    cx = cx < 0 ? 0 : (cx >= gw ? gw - 1 : cx);
+    cy = cy < 0 ? 0 : (cy >= gh ? gh - 1 : cy);
+    int32_t max_ring = gw > gh ? gw : gh;
+
+    for (int32_t r = 0; r <= max_ring; r++) {
+        float reach = (r - 1) * cell;
+        if (r > 0 && reach > 0.0f && reach * reach >= best_sq) break;
+        for (int32_t y = cy - r; y <= cy + r; y++) {
+            if (y < 0 || y >= gh) continue;
+            bool edge_row = (y == cy - r || y == cy + r);
+            for (int32_t x = cx - r; x <= cx + r; x += edge_row ? 1 : 2 * r) {
+                if (x >= 0 && x < gw) {
+                    uint32_t c = (uint32_t)(y * gw + x);
+                    for (uint32_t e = cell_start[c]; e < cell_start[c + 1]; e++) {
+                        float d_sq = segment_distance_sq(cell_entries[e], px, py, &t);
+                        if (d_sq < best_sq) {
+                            best_sq = d_sq;
+                            best = cell_entries[e];
+                        }
+                    }
+                }
+                if (r == 0) break;   // Single centre cell
+            }
+        }
+    }
+    return best;
+}
+
+// One guidance cycle; the fix is dead-reckoned by wall-clock or simulated age
+static void guidance_step(bool simulated) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock(&guidance_lock);
+    GuidanceMode mode = guidance_state.mode;
+    if (mode == GUIDANCE_OFF || !guidance_state.valid) {
+        pthread_mutex_unlock(&guidance_lock);
+        return;
+    }
+
+    // Dead-reckon from the last fix to now
+    float age = simulated ? fix.age_s : elapsed_us(&fix.time, &start) / 1e6f;
+    if (age > GUIDANCE_MAX_EXTRAPOLATE_S) age = GUIDANCE_MAX_EXTRAPOLATE_S;
+    float heading = fix.heading_deg * (float)M_PI / 180.0f;
+    float px = fix.east + sinf(heading) * fix.speed_mps * age;
+    float py = fix.north + cosf(heading) * fix.speed_mps * age;
+    float swath = guidance_state.swath_width_m;
+
+    // Closest point (qx, qy) and direction (dx, dy) on the reference path
+    float qx, qy, dx, dy;
+    if (mode == GUIDANCE_AB_LINE) {
+        dx = vertex_x[1] - vertex_x[0];
+        dy = vertex_y[1] - vertex_y[0];
+        float length = fmaxf(sqrtf(dx * dx + dy * dy), 1e-3f);
+        dx /= length;
+        dy /= length;
+        float along = (px - vertex_x[0]) * dx + (py - vertex_y[0]) * dy;
+        qx = vertex_x[0] + dx * along;
+        qy = vertex_y[0] + dy * along;
+    } else if (mode == GUIDANCE_PIVOT) {
+        float rx = px - vertex_x[0], ry = py - vertex_y[0];
+        float radius = fmaxf(sqrtf(rx * rx + ry * ry), 1e-3f);
+        rx /= radius;
+        ry /= radius;
+        qx = vertex_x[0] + rx * pivot_radius;
+        qy = vertex_y[0] + ry * pivot_radius;
+        dx = -ry;                // Counter-clockwise, so passes count outward
+        dy = rx;
+    } else {
+        // Search from the position shifted back onto the reference curve by
+        // the current pass offset, so the rings stay small on far passes
+        float shift = guidance_state.pass_number * swath;
+        uint32_t s = guidance_state.nearest_segment;
+        float sx = vertex_x[s + 1] - vertex_x[s], sy = vertex_y[s + 1] - vertex_y[s];
+        float length = fmaxf(sqrtf(sx * sx + sy * sy), 1e-6f);
+        s = nearest_segment(px - shift * sy / length, py + shift * sx / length);
+
+        float t;
+        segment_distance_sq(s, px, py, &t);
+        dx = vertex_x[s + 1] - vertex_x[s];
+        dy = vertex_y[s + 1] - vertex_y[s];
+        qx = vertex_x[s] + t * dx;
+        qy = vertex_y[s] + t * dy;
+        length = fmaxf(sqrtf(dx * dx + dy * dy), 1e-6f);
+        dx /= length;
+        dy /= length;
+        guidance_state.nearest_segment = s;
+    }
+
+    // Offset to the right of the reference direction, then to the nearest pass
+    float offset = (px - qx) * dy - (py - qy) * dx;
+    int32_t pass = swath > 0.0f ? (int32_t)lroundf(offset / swath) : 0;
+    float cross_track = offset - pass * swath;
+    float heading_error = wrap_degrees(fix.heading_deg - atan2f(dx, dy) * 180.0f / (float)M_PI);
+
+    // Driving the pass the other way round
+    if (fabsf(heading_error) > 90.0f) {
+        cross_track = -cross_track;
+        heading_error = wrap_degrees(heading_error - 180.0f);
+    }
+
+    guidance_state.pass_number = pass;
+    guidance_state.cross_track_m = cross_track;
+    guidance_state.heading_error_deg = heading_error;
+    bool publish = (++guidance_state.cycles % GUIDANCE_PUBLISH_DIVIDER) == 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    guidance_state.last_cycle_us = elapsed_us(&start, &end);
+    if (guidance_state.last_cycle_us > guidance_state.max_cycle_us) {
+        guidance_state.max_cycle_us = guidance_state.last_cycle_us;
+    }
+    pthread_mutex_unlock(&guidance_lock);
+
+    if (publish) {
+        CanGuidanceStatus status = {
+            .cross_track = cross_track,
+            .heading_error = heading_error,
+            .pass = (int16_t)pass,
+            .mode = (uint8_t)mode,
+        };
+        uint8_t data[CAN_DLC_GUIDANCE_STATUS];
+        can_pack_guidance_status(data, &status);
+        canbus_send_message(CAN_ID_GUIDANCE_STATUS, data, sizeof(data));
+    }
+}
+
+void guidance_update(void) {
+    guidance_step(false);
+}
+
+void guidance_run_for(float seconds) {
+    long ticks = lroundf(seconds * GUIDANCE_RATE_HZ);
+    for (long i = 0; i < ticks; i++) {
+        guidance_step(true);
+        pthread_mutex_lock(&guidance_lock);
+        fix.age_s += 1.0f / GUIDANCE_RATE_HZ;
+        pthread_mutex_unlock(&guidance_lock);
+    }
+}
+
+static void* guidance_thread(void* arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (;;) {
+        next.tv_nsec += PERIOD_NS;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        pthread_mutex_lock(&guidance_lock);
+        bool running = guidance_state.running;
+        pthread_mutex_unlock(&guidance_lock);
+        if (!running) break;
+
+        // Missed a whole period: count it and restart the schedule from now
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (elapsed_us(&next, &now) > PERIOD_NS / 1000.0f) {
+            pthread_mutex_lock(&guidance_lock);
+            guidance_state.overruns++;
+            pthread_mutex_unlock(&guidance_lock);
+            next = now;
+        }
+
+        guidance_update();
+    }
+    return NULL;
+}
+
+bool guidance_start(void) {
+    pthread_mutex_lock(&guidance_lock);
+    bool already = guidance_state.running;
+    guidance_state.running = true;
+    pthread_mutex_unlock(&guidance_lock);
+    if (already) return true;
+
+    if (pthread_create(&worker, NULL, guidance_thread, NULL) != 0) {
+        printf("[GUIDANCE] Cannot start the guidance worker\n");
+        pthread_mutex_lock(&guidance_lock);
+        guidance_state.running = false;
+        pthread_mutex_unlock(&guidance_lock);
+        return false;
+    }
+    printf("[GUIDANCE] %s guidance running at %d Hz\n", mode_names[guidance_state.mode], GUIDANCE_RATE_HZ);
+    return true;
+}
+
+void guidance_stop(void) {
+    pthread_mutex_lock(&guidance_lock);
+    bool was_running = guidance_state.running;
+    guidance_state.running = false;
+    pthread_mutex_unlock(&guidance_lock);
+    if (was_running) {
+        pthread_join(worker, NULL);
+    }
+}
+
+void guidance_print_status(void) {
+    GuidanceState s;
+    guidance_get(&s);
+
+    printf("\n=== GUIDANCE ===\n");
+    printf("Mode: %s", mode_names[s.mode]);
+    if (s.mode == GUIDANCE_CURVE) {
+        printf(" (%u vertices, %ux%u grid @ %.1f m)", s.vertex_count, s.grid_width, s.grid_height, s.cell_size_m);
+    }
+    printf(", swath %.1f m\n", s.swath_width_m);
+    if (s.valid) {
+        printf("Pass %d: cross-track %+.2f m, heading error %+.1f°\n",
+               s.pass_number, s.cross_track_m, s.heading_error_deg);
+    } else {
+        printf("Waiting for GPS fix\n");
+    }
+    printf("Cycles: %u at %d Hz, %u overruns, compute last %.2f us / max %.2f us\n",
+           s.cycles, GUIDANCE_RATE_HZ, s.overruns, s.last_cycle_us, s.max_cycle_us);
+    printf("================\n\n");
+}
+
+void guidance_get(GuidanceState* out) {
+    pthread_mutex_lock(&guidance_lock);
+    *out = guidance_state;
+    pthread_mutex_unlock(&guidance_lock);
+}
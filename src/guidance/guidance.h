@@ -0,0 +1,65 @@
+#ifndef GUIDANCE_H
+#define GUIDANCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GUIDANCE_RATE_HZ          50
+#define GUIDANCE_PUBLISH_DIVIDER  5             // CAN 0x260 at 10 Hz
+#define GUIDANCE_MAX_VERTICES     (64 * 1024)
+#define GUIDANCE_MAX_GRID_CELLS   (256 * 256)
+#define GUIDANCE_MAX_ENTRIES      (256 * 1024)  // Segment references across all grid cells
+#define GUIDANCE_MAX_EXTRAPOLATE_S 2.0f         // Dead-reckon at most this long past a fix
+
+typedef enum {
+    GUIDANCE_OFF,
+    GUIDANCE_AB_LINE,
+    GUIDANCE_CURVE,
+    GUIDANCE_PIVOT
+} GuidanceMode;
+
+// Guidance path file (text, one record per line, '#' comments):
+//   AB <lat> <lon> <lat> <lon>          straight A-B line
+//   PIVOT <lat> <lon> [first radius m]  concentric circles around a pivot
+//   CURVE                               followed by one "<lat> <lon>" line per vertex
+// Parallel passes are spaced at the implement working width.
+
+// Guidance - a 50 Hz worker dead-reckons from the latest GPS fix and
+// computes cross-track and heading error to the nearest parallel pass.
+// Signs are relative to the direction of travel: positive cross-track
+// error = right of the pass, positive heading error = turned clockwise.
+typedef struct {
+    GuidanceMode mode;
+    bool running;
+    bool valid;                  // A fix has been received
+    float swath_width_m;
+    uint32_t vertex_count;
+    uint32_t grid_width;
+    uint32_t grid_height;
+    float cell_size_m;
+    int32_t pass_number;         // Parallel pass (0 = reference path, + = right of it)
+    float cross_track_m;
+    float heading_error_deg;
+    uint32_t nearest_segment;    // Curve mode
+    uint32_t cycles;
+    uint32_t overruns;           // Cycles that started a full period late
+    float last_cycle_us;
+    float max_cycle_us;
+} GuidanceState;
+
+// Dependencies: Telematics (GPS fix, field frame), CANBus (guidance 0x260)
+void guidance_init(void);
+void guidance_set_ab_line(float a_east, float a_north, float b_east, float b_north);
+bool guidance_set_curve(const float* east_m, const float* north_m, uint32_t count);
+void guidance_set_pivot(float center_east, float center_north, float first_radius_m);
+bool guidance_load(const char* path);
+void guidance_set_swath_width(float width_m);
+void guidance_set_fix(float east_m, float north_m, float heading_deg, float speed_kmh);
+void guidance_update(void);
+void guidance_run_for(float seconds);    // Synchronous cycles on simulated time, for lockstep runs
+bool guidance_start(void);
+void guidance_stop(void);
+void guidance_print_status(void);
+void guidance_get(GuidanceState* out);    // Snapshot under the lock the worker writes with
+
+#endif // GUIDANCE_H
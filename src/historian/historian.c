@@ -0,0 +1,537 @@
+#include "historian.h"
+#include "../engine/engine_control.h"
+#include "../transmission/transmission.h"
+#include "../hydraulics/hydraulics.h"
+#include "../pto/pto.h"
+#include "../telematics/telematics.h"
+#include "../implement/implement.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define COLUMN_ALIGN      64     // Bytes; every column starts on a cache line
+#define ROW_QUANTUM       16     // Capacities are a multiple of this, keeping columns aligned
+#define REDUCE_BLOCK      1024   // Float partial sums are folded into double this often
+
+typedef float v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+typedef uint32_t v4u __attribute__((vector_size(16)));
+
+// Unaligned vector load; compiles to a single movups/ld1
+static inline v4f load4(const float* p) {
+    v4f v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline v4u load4u(const uint32_t* p) {
+    v4u v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Lane-wise select on a comparison mask; the compiler emits minps/maxps
+static inline v4f min4(v4f a, v4f b) {
+    v4i lt = a < b;
+    return (v4f)((lt & (v4i)a) | (~lt & (v4i)b));
+}
+
+static inline v4f max4(v4f a, v4f b) {
+    v4i gt = a > b;
+    return (v4f)((gt & (v4i)a) | (~gt & (v4i)b));
+}
+
+// One tier: a ring of rows stored column by column. The raw tier has a
+// single value column per signal that min, max and mean all point at, and
+// no count column (every row is one sample).
+typedef struct {
+    uint32_t capacity;
+    uint32_t head;                        // Next row to write
+    uint32_t rows;
+    uint64_t rows_written;
+    uint64_t span_ms;                     // Bucket width, 0 for the raw tier
+    size_t bytes;
+    uint64_t* time_ms;                    // Row start time
+    uint32_t* count;                      // Raw samples behind each row
+    float* min[HIST_SIGNAL_COUNT];
+    float* max[HIST_SIGNAL_COUNT];
+    float* mean[HIST_SIGNAL_COUNT];
+
+    // Bucket being filled from the tier below
+    bool open;
+    uint64_t bucket_ms;
+    uint32_t bucket_count;
+    float acc_min[HIST_SIGNAL_COUNT];
+    float acc_max[HIST_SIGNAL_COUNT];
+    double acc_sum[HIST_SIGNAL_COUNT];
+} Ring;
+
+// Partial result of a reduction over one or two ring segments
+typedef struct {
+    float min;
+    float max;
+    double sum;
+    double weight;
+} Reduction;
+
+// Share of the budget per tier, in percent
+static const uint32_t tier_share[HIST_TIER_COUNT] = { 50, 30, 15, 5 };
+static const uint64_t tier_span_ms[HIST_TIER_COUNT] = { 0, 1000, 60000, 3600000 };
+static const char* const tier_names[HIST_TIER_COUNT] = { "raw", "1 s", "1 min", "1 h" };
+
+#define HISTORIAN_SIGNAL_NAME(name, label, unit) label,
+#define HISTORIAN_SIGNAL_UNIT(name, label, unit) unit,
+static const char* const signal_names[HIST_SIGNAL_COUNT] = { HISTORIAN_SIGNALS(HISTORIAN_SIGNAL_NAME) };
+static const char* const signal_units[HIST_SIGNAL_COUNT] = { HISTORIAN_SIGNALS(HISTORIAN_SIGNAL_UNIT) };
+
+static Ring rings[HIST_TIER_COUNT];
+static void* store = NULL;
+static size_t store_bytes = 0;
+static uint64_t last_time_ms = 0;
+static uint64_t samples_recorded = 0;
+static struct timespec epoch;
+
+static size_t row_bytes(HistorianTier tier) {
+    if (tier == HIST_TIER_RAW) {
+        return sizeof(uint64_t) + HIST_SIGNAL_COUNT * sizeof(float);
+    }
+    return sizeof(uint64_t) + sizeof(uint32_t) + 3 * HIST_SIGNAL_COUNT * sizeof(float);
+}
+
+static float* take_floats(uint8_t** cursor, uint32_t capacity) {
+    float* column = (float*)*cursor;
+    *cursor += (size_t)capacity * sizeof(float);
+    return column;
+}
+
+bool historian_init(size_t budget_bytes) {
+    historian_shutdown();
+    if (budget_bytes < HISTORIAN_MIN_BUDGET) {
+        printf("[HISTORIAN] Budget of %zu bytes is below the %u byte minimum\n",
+               budget_bytes, HISTORIAN_MIN_BUDGET);
+        return false;
+    }
+
+    // Size every tier from its share, rounded down so columns stay aligned
+    size_t total = 0;
+    for (int t = 0; t < HIST_TIER_COUNT; t++) {
+        Ring* ring = &rings[t];
+        memset(ring, 0, sizeof(*ring));
+        size_t share = budget_bytes / 100 * tier_share[t];
+        ring->capacity = (uint32_t)(share / row_bytes(t) / ROW_QUANTUM * ROW_QUANTUM);
+        ring->span_ms = tier_span_ms[t];
+        ring->bytes = ring->capacity * row_bytes(t);
+        total += ring->bytes;
+    }
+
+    store = aligned_alloc(COLUMN_ALIGN, total);
+    if (store == NULL) {
+        printf("[HISTORIAN] Could not allocate %zu bytes\n", total);
+        return false;
+    }
+    memset(store, 0, total);
+    store_bytes = total;
+
+    // Carve the columns: time columns first (8-byte elements), then floats
+    uint8_t* cursor = store;
+    for (int t = 0; t < HIST_TIER_COUNT; t++) {
+        Ring* ring = &rings[t];
+        ring->time_ms = (uint64_t*)cursor;
+        cursor += (size_t)ring->capacity * sizeof(uint64_t);
+        if (t != HIST_TIER_RAW) {
+            ring->count = (uint32_t*)cursor;
+            cursor += (size_t)ring->capacity * sizeof(uint32_t);
+        }
+        for (int s = 0; s < HIST_SIGNAL_COUNT; s++) {
+            ring->min[s] = take_floats(&cursor, ring->capacity);
+            if (t == HIST_TIER_RAW) {
+                ring->max[s] = ring->min[s];
+                ring->mean[s] = ring->min[s];
+            } else {
+                ring->max[s] = take_floats(&cursor, ring->capacity);
+                ring->mean[s] = take_floats(&cursor, ring->capacity);
+            }
+        }
+    }
+
+    last_time_ms = 0;
+    samples_recorded = 0;
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+    printf("[HISTORIAN] %d signals in %.1f MB: %u raw, %u x 1 s, %u x 1 min, %u x 1 h rows\n",
+           HIST_SIGNAL_COUNT, store_bytes / (1024.0 * 1024.0), rings[HIST_TIER_RAW].capacity,
+           rings[HIST_TIER_SECOND].capacity, rings[HIST_TIER_MINUTE].capacity,
+           rings[HIST_TIER_HOUR].capacity);
+    return true;
+}
+
+void historian_shutdown(void) {
+    free(store);
+    store = NULL;
+    store_bytes = 0;
+    memset(rings, 0, sizeof(rings));
+}
+
+bool historian_is_enabled(void) {
+    return store != NULL;
+}
+
+uint64_t historian_now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed_ns = (int64_t)(now.tv_sec - epoch.tv_sec) * 1000000000 +
+                         (now.tv_nsec - epoch.tv_nsec);
+    return (uint64_t)(elapsed_ns / 1000000);
+}
+
+// Claim the next row, overwriting the oldest once the ring is full
+static uint32_t ring_push(Ring* ring, uint64_t time_ms) {
+    uint32_t row = ring->head;
+    ring->time_ms[row] = time_ms;
+    ring->head = row + 1 == ring->capacity ? 0 : row + 1;
+    if (ring->rows < ring->capacity) ring->rows++;
+    ring->rows_written++;
+    return row;
+}
+
+static void roll_up(HistorianTier tier, uint64_t time_ms, const float* mins, const float* maxs,
+                    const float* means, uint32_t count);
+
+// Write the finished bucket as a row and pass it on to the next tier
+static void close_bucket(HistorianTier tier) {
+    Ring* ring = &rings[tier];
+    float means[HIST_SIGNAL_COUNT];
+    uint32_t row = ring_push(ring, ring->bucket_ms);
+    ring->count[row] = ring->bucket_count;
+    for (int s = 0; s < HIST_SIGNAL_COUNT; s++) {
+        means[s] = (float)(ring->acc_sum[s] / ring->bucket_count);
+        ring->min[s][row] = ring->acc_min[s];
+        ring->max[s][row] = ring->acc_max[s];
+        ring->mean[s][row] = means[s];
+    }
+    ring->open = false;
+    if (tier + 1 < HIST_TIER_COUNT) {
+        roll_up(tier + 1, ring->bucket_ms, ring->acc_min, ring->acc_max, means, ring->bucket_count);
+    }
+}
+
+// Fold a row of the tier below (or a raw sample, count 1) into the bucket
+static void roll_up(HistorianTier tier, uint64_t time_ms, const float* mins, const float* maxs,
+                    const float* means, uint32_t count) {
+    Ring* ring = &rings[tier];
+    uint64_t bucket = time_ms - time_ms % ring->span_ms;
+    if (ring->open && bucket != ring->bucket_ms) {
+        close_bucket(tier);
+    }
+    if (!ring->open) {
+        ring->open = true;
+        ring->bucket_ms = bucket;
+        ring->bucket_count = count;
+        for (int s = 0; s < HIST_SIGNAL_COUNT; s++) {
+            ring->acc_min[s] = mins[s];
+            ring->acc_max[s] = maxs[s];
+            ring->acc_sum[s] = (double)means[s] * count;
+        }
+        return;
+    }
+    ring->bucket_count += count;
+    for (int s = 0; s < HIST_SIGNAL_COUNT; s++) {
+        ring->acc_min[s] = fminf(ring->acc_min[s], mins[s]);
+        ring->acc_max[s] = fmaxf(ring->acc_max[s], maxs[s]);
+        ring->acc_sum[s] += (double)means[s] * count;
+    }
+}
+
+void historian_record(uint64_t time_ms, const float values[HIST_SIGNAL_COUNT]) {
+    if (store == NULL) return;
+    if (time_ms < last_time_ms) time_ms = last_time_ms;
+    last_time_ms = time_ms;
+
+    Ring* raw = &rings[HIST_TIER_RAW];
+    uint32_t row = ring_push(raw, time_ms);
+    for (int s = 0; s < HIST_SIGNAL_COUNT; s++) {
+        raw->min[s][row] = values[s];
+    }
+    samples_recorded++;
+    roll_up(HIST_TIER_SECOND, time_ms, values, values, values, 1);
+}
+
+void historian_sample(void) {
+    if (store == NULL) return;
+    EngineState* engine = engine_get_state();
+    TransmissionState* trans = transmission_get_state();
+    HydraulicsState* hyd = hydraulics_get_state();
+    PTOState* pto = pto_get_state();
+    TelematicsState* telem = telematics_get_state();
+    ImplementState* impl = implement_get_state();
+
+    float values[HIST_SIGNAL_COUNT];
+    values[HIST_SIG_ENGINE_RPM]    = engine->current_rpm;
+    values[HIST_SIG_ENGINE_TARGET] = engine->target_rpm;
+    values[HIST_SIG_ENGINE_LOAD]   = real_to_float(engine->load_percent);
+    values[HIST_SIG_ENGINE_TORQUE] = real_to_float(engine->torque_nm);
+    values[HIST_SIG_FUEL_RATE]     = real_to_float(engine->fuel_rate);
+    values[HIST_SIG_COOLANT_TEMP]  = real_to_float(engine->coolant_temp);
+    values[HIST_SIG_OIL_PRESSURE]  = real_to_float(engine->oil_pressure);
+    values[HIST_SIG_TRANS_OUTPUT]  = real_to_float(trans->output_speed);
+    values[HIST_SIG_TRANS_TEMP]    = real_to_float(trans->transmission_temp);
+    values[HIST_SIG_HYD_PRESSURE]  = real_to_float(hyd->system_pressure);
+    values[HIST_SIG_HYD_FLOW]      = real_to_float(hyd->flow_rate);
+    values[HIST_SIG_HYD_OIL_TEMP]  = real_to_float(hyd->oil_temp);
+    values[HIST_SIG_PTO_RPM]       = pto->current_rpm;
+    values[HIST_SIG_PTO_LOAD]      = real_to_float(pto->load_percent);
+    values[HIST_SIG_PTO_TORQUE]    = real_to_float(pto->torque_nm);
+    values[HIST_SIG_GROUND_SPEED]  = telem->gps.speed_kmh;
+    values[HIST_SIG_IMPL_DEPTH]    = real_to_float(impl->working_depth_cm);
+    values[HIST_SIG_IMPL_PRESSURE] = real_to_float(impl->pressure_bar);
+    historian_record(historian_now_ms(), values);
+}
+
+// Logical row i counts from the oldest row held
+static uint64_t row_time(const Ring* ring, uint32_t first, uint32_t i) {
+    uint32_t row = first + i;
+    return ring->time_ms[row >= ring->capacity ? row - ring->capacity : row];
+}
+
+// Rows starting in [from_ms, to_ms], as a logical start and count
+static bool find_rows(const Ring* ring, uint64_t from_ms, uint64_t to_ms,
+                      uint32_t* start, uint32_t* count) {
+    if (ring->rows == 0 || from_ms > to_ms) return false;
+    uint32_t oldest = ring->head >= ring->rows ? ring->head - ring->rows
+                                               : ring->head + ring->capacity - ring->rows;
+    uint32_t low = 0, high = ring->rows;
+    while (low < high) {   // First row at or after from_ms
+        uint32_t mid = low + (high - low) / 2;
+        if (row_time(ring, oldest, mid) < from_ms) low = mid + 1; else high = mid;
+    }
+    uint32_t begin = low;
+    high = ring->rows;
+    while (low < high) {   // First row after to_ms
+        uint32_t mid = low + (high - low) / 2;
+        if (row_time(ring, oldest, mid) <= to_ms) low = mid + 1; else high = mid;
+    }
+    if (low == begin) return false;
+    *start = oldest + begin >= ring->capacity ? oldest + begin - ring->capacity : oldest + begin;
+    *count = low - begin;
+    return true;
+}
+
+// Min, max and sum of plain samples, eight lanes per step
+static void reduce_values(const float* values, uint32_t n, Reduction* r) {
+    uint32_t i = 0;
+    if (n >= 8) {
+        v4f lo0 = load4(values), lo1 = load4(values + 4);
+        v4f hi0 = lo0, hi1 = lo1;
+        while (n - i >= 8) {
+            uint32_t end = n - i > REDUCE_BLOCK ? i + REDUCE_BLOCK : n;
+            v4f sum0 = {0}, sum1 = {0};
+            for (; i + 8 <= end; i += 8) {
+                v4f a = load4(values + i), b = load4(values + i + 4);
+                lo0 = min4(lo0, a);
+                lo1 = min4(lo1, b);
+                hi0 = max4(hi0, a);
+                hi1 = max4(hi1, b);
+                sum0 += a;
+                sum1 += b;
+            }
+            v4f sum = sum0 + sum1;
+            r->sum += (double)sum[0] + sum[1] + sum[2] + sum[3];
+        }
+        v4f lo = min4(lo0, lo1), hi = max4(hi0, hi1);
+        for (int k = 0; k < 4; k++) {
+            r->min = fminf(r->min, lo[k]);
+            r->max = fmaxf(r->max, hi[k]);
+        }
+        r->weight += i;
+    }
+    for (; i < n; i++) {
+        r->min = fminf(r->min, values[i]);
+        r->max = fmaxf(r->max, values[i]);
+        r->sum += values[i];
+        r->weight += 1.0;
+    }
+}
+
+// Rollup rows: min of mins, max of maxes, count-weighted sum of means.
+// Counts are summed as integers so the sample total stays exact.
+static void reduce_rollup(const float* mins, const float* maxs, const float* means,
+                          const uint32_t* counts, uint32_t n, Reduction* r) {
+    uint32_t i = 0;
+    if (n >= 4) {
+        v4f lo = load4(mins), hi = load4(maxs);
+        while (n - i >= 4) {
+            uint32_t end = n - i > REDUCE_BLOCK ? i + REDUCE_BLOCK : n;
+            v4f sum = {0};
+            v4u weight = {0};
+            for (; i + 4 <= end; i += 4) {
+                v4u c = load4u(counts + i);
+                lo = min4(lo, load4(mins + i));
+                hi = max4(hi, load4(maxs + i));
+                sum += load4(means + i) * __builtin_convertvector(c, v4f);
+                weight += c;
+            }
+            r->sum += (double)sum[0] + sum[1] + sum[2] + sum[3];
+            r->weight += (double)weight[0] + (double)weight[1] + (double)weight[2] + (double)weight[3];
+        }
+        for (int k = 0; k < 4; k++) {
+            r->min = fminf(r->min, lo[k]);
+            r->max = fmaxf(r->max, hi[k]);
+        }
+    }
+    for (; i < n; i++) {
+        r->min = fminf(r->min, mins[i]);
+        r->max = fmaxf(r->max, maxs[i]);
+        r->sum += (double)means[i] * counts[i];
+        r->weight += counts[i];
+    }
+}
+
+static void reduce_scalar(const Ring* ring, HistorianSignal signal, uint32_t row, uint32_t n,
+                          Reduction* r) {
+    for (uint32_t i = 0; i < n; i++, row++) {
+        double count = ring->count != NULL ? (double)ring->count[row] : 1.0;
+        r->min = fminf(r->min, ring->min[signal][row]);
+        r->max = fmaxf(r->max, ring->max[signal][row]);
+        r->sum += (double)ring->mean[signal][row] * count;
+        r->weight += count;
+    }
+}
+
+static bool query(HistorianSignal signal, HistorianTier tier, uint64_t from_ms, uint64_t to_ms,
+                  HistorianSummary* summary, bool vector) {
+    if (store == NULL || (unsigned)signal >= HIST_SIGNAL_COUNT || (unsigned)tier >= HIST_TIER_COUNT) {
+        return false;
+    }
+    const Ring* ring = &rings[tier];
+    uint32_t start, count;
+    if (!find_rows(ring, from_ms, to_ms, &start, &count)) return false;
+
+    // The rows wrap at most once: [start, capacity) then [0, rest)
+    uint32_t first_part = count < ring->capacity - start ? count : ring->capacity - start;
+    uint32_t segments[2][2] = { { start, first_part }, { 0, count - first_part } };
+    Reduction r = { INFINITY, -INFINITY, 0.0, 0.0 };
+    for (int k = 0; k < 2; k++) {
+        uint32_t row = segments[k][0], n = segments[k][1];
+        if (n == 0) continue;
+        if (!vector) {
+            reduce_scalar(ring, signal, row, n, &r);
+        } else if (tier == HIST_TIER_RAW) {
+            reduce_values(ring->min[signal] + row, n, &r);
+        } else {
+            reduce_rollup(ring->min[signal] + row, ring->max[signal] + row,
+                          ring->mean[signal] + row, ring->count + row, n, &r);
+        }
+    }
+
+    uint32_t last = count - first_part > 0 ? count - first_part - 1 : start + count - 1;
+    summary->min = r.min;
+    summary->max = r.max;
+    summary->mean = (float)(r.sum / r.weight);
+    summary->rows = count;
+    summary->samples = (uint32_t)r.weight;
+    summary->first_ms = ring->time_ms[start];
+    summary->last_ms = ring->time_ms[last];
+    summary->tier = tier;
+    return true;
+}
+
+bool historian_query_tier(HistorianSignal signal, HistorianTier tier, uint64_t from_ms,
+                          uint64_t to_ms, HistorianSummary* summary) {
+    return query(signal, tier, from_ms, to_ms, summary, true);
+}
+
+bool historian_query_scalar(HistorianSignal signal, HistorianTier tier, uint64_t from_ms,
+                            uint64_t to_ms, HistorianSummary* summary) {
+    return query(signal, tier, from_ms, to_ms, summary, false);
+}
+
+bool historian_query(HistorianSignal signal, uint64_t from_ms, uint64_t to_ms,
+                     HistorianSummary* summary) {
+    // Finest tier reaching back to from_ms; otherwise the one reaching furthest
+    HistorianTier best = HIST_TIER_RAW;
+    uint64_t best_oldest = UINT64_MAX;
+    for (int t = 0; t < HIST_TIER_COUNT; t++) {
+        HistorianTierStats stats;
+        historian_get_tier_stats(t, &stats);
+        if (stats.rows == 0) continue;
+        if (stats.oldest_ms <= from_ms) {
+            best = t;
+            break;
+        }
+        if (stats.oldest_ms < best_oldest) {
+            best_oldest = stats.oldest_ms;
+            best = t;
+        }
+    }
+    return historian_query_tier(signal, best, from_ms, to_ms, summary);
+}
+
+const char* historian_signal_name(HistorianSignal signal) {
+    return (unsigned)signal < HIST_SIGNAL_COUNT ? signal_names[signal] : "unknown";
+}
+
+const char* historian_signal_unit(HistorianSignal signal) {
+    return (unsigned)signal < HIST_SIGNAL_COUNT ? signal_units[signal] : "";
+}
+
+const char* historian_tier_name(HistorianTier tier) {
+    return (unsigned)tier < HIST_TIER_COUNT ? tier_names[tier] : "unknown";
+}
+
+void historian_get_tier_stats(HistorianTier tier, HistorianTierStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if ((unsigned)tier >= HIST_TIER_COUNT) return;
+    const Ring* ring = &rings[tier];
+    stats->capacity = ring->capacity;
+    stats->rows = ring->rows;
+    stats->rows_written = ring->rows_written;
+    stats->bytes = ring->bytes;
+    if (ring->rows > 0) {
+        uint32_t oldest = ring->head >= ring->rows ? ring->head - ring->rows
+                                                   : ring->head + ring->capacity - ring->rows;
+        uint32_t newest = ring->head == 0 ? ring->capacity - 1 : ring->head - 1;
+        stats->oldest_ms = ring->time_ms[oldest];
+        stats->newest_ms = ring->time_ms[newest];
+    }
+}
+
+bool historian_get_store(const void** data, size_t* bytes) {
+    *data = store;
+    *bytes = store_bytes;
+    return store != NULL;
+}
+
+void historian_print_status(void) {
+    printf("\n=== Signal Historian ===\n");
+    if (store == NULL) {
+        printf("Historian disabled\n");
+        printf("========================\n");
+        return;
+    }
+    printf("Samples: %llu of %d signals, %.1f MB\n", (unsigned long long)samples_recorded,
+           HIST_SIGNAL_COUNT, store_bytes / (1024.0 * 1024.0));
+    for (int t = 0; t < HIST_TIER_COUNT; t++) {
+        HistorianTierStats stats;
+        historian_get_tier_stats(t, &stats);
+        printf("%-6s %7u / %7u rows  %8.1f s held  (%.1f MB)\n", tier_names[t], stats.rows,
+               stats.capacity, (stats.newest_ms - stats.oldest_ms) / 1000.0,
+               stats.bytes / (1024.0 * 1024.0));
+    }
+
+    // Last minute of a few headline signals
+    static const HistorianSignal headline[] = {
+        HIST_SIG_ENGINE_RPM, HIST_SIG_COOLANT_TEMP, HIST_SIG_HYD_PRESSURE, HIST_SIG_IMPL_DEPTH
+    };
+    uint64_t now = last_time_ms;
+    uint64_t from = now > 60000 ? now - 60000 : 0;
+    for (size_t i = 0; i < sizeof(headline) / sizeof(headline[0]); i++) {
+        HistorianSummary summary;
+        if (historian_query(headline[i], from, now, &summary)) {
+            printf("%-14s last 60 s: min %.1f  mean %.1f  max %.1f %s (%u rows, %s)\n",
+                   signal_names[headline[i]], summary.min, summary.mean, summary.max,
+                   signal_units[headline[i]], summary.rows, tier_names[summary.tier]);
+        }
+    }
+    printf("========================\n");
+}
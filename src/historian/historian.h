@@ -0,0 +1,109 @@
+#ifndef HISTORIAN_H
+#define HISTORIAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HISTORIAN_DEFAULT_BUDGET  (8u * 1024u * 1024u)   // Bytes for all tiers together
+#define HISTORIAN_MIN_BUDGET      (256u * 1024u)
+
+// Signals recorded every cycle - one float column per signal in every tier.
+// X(name, label, unit)
+#define HISTORIAN_SIGNALS(X) \
+    X(ENGINE_RPM,       "engine_rpm",       "rpm")  \
+    X(ENGINE_TARGET,    "engine_target",    "rpm")  \
+    X(ENGINE_LOAD,      "engine_load",      "%")    \
+    X(ENGINE_TORQUE,    "engine_torque",    "Nm")   \
+    X(FUEL_RATE,        "fuel_rate",        "L/hr") \
+    X(COOLANT_TEMP,     "coolant_temp",     "C")    \
+    X(OIL_PRESSURE,     "oil_pressure",     "PSI")  \
+    X(TRANS_OUTPUT,     "trans_output",     "rpm")  \
+    X(TRANS_TEMP,       "trans_temp",       "C")    \
+    X(HYD_PRESSURE,     "hyd_pressure",     "PSI")  \
+    X(HYD_FLOW,         "hyd_flow",         "GPM")  \
+    X(HYD_OIL_TEMP,     "hyd_oil_temp",     "C")    \
+    X(PTO_RPM,          "pto_rpm",          "rpm")  \
+    X(PTO_LOAD,         "pto_load",         "%")    \
+    X(PTO_TORQUE,       "pto_torque",       "Nm")   \
+    X(GROUND_SPEED,     "ground_speed",     "km/h") \
+    X(IMPL_DEPTH,       "impl_depth",       "cm")   \
+    X(IMPL_PRESSURE,    "impl_pressure",    "bar")
+
+#define HISTORIAN_SIGNAL_ENUM(name, label, unit) HIST_SIG_##name,
+typedef enum {
+    HISTORIAN_SIGNALS(HISTORIAN_SIGNAL_ENUM)
+    HIST_SIGNAL_COUNT
+} HistorianSignal;
+#undef HISTORIAN_SIGNAL_ENUM
+
+// Raw samples at the recording rate, then min/max/mean rollups. Each tier
+// is a ring of its own, so the coarse tiers reach much further back.
+typedef enum {
+    HIST_TIER_RAW = 0,
+    HIST_TIER_SECOND,
+    HIST_TIER_MINUTE,
+    HIST_TIER_HOUR,
+    HIST_TIER_COUNT
+} HistorianTier;
+
+// Result of a range query
+typedef struct {
+    float min;
+    float max;
+    float mean;               // Weighted by the raw samples behind each row
+    uint32_t rows;            // Tier rows reduced
+    uint32_t samples;         // Raw samples behind those rows
+    uint64_t first_ms;        // Start time of the first and last row used
+    uint64_t last_ms;
+    HistorianTier tier;
+} HistorianSummary;
+
+typedef struct {
+    uint32_t capacity;        // Rows the tier holds
+    uint32_t rows;            // Rows held now (<= capacity)
+    uint64_t rows_written;    // Rows ever written, overwritten ones included
+    uint64_t oldest_ms;
+    uint64_t newest_ms;
+    size_t bytes;
+} HistorianTierStats;
+
+// Dependencies: Engine, Transmission, Hydraulics, PTO, Telematics and
+// Implement (state read by historian_sample)
+// The whole store is one allocation carved up at init; nothing allocates
+// afterwards. Returns false if the budget is too small or unavailable.
+bool historian_init(size_t budget_bytes);
+void historian_shutdown(void);
+bool historian_is_enabled(void);
+
+// Record one sample of every signal. Times are ms and must not go backwards.
+void historian_record(uint64_t time_ms, const float values[HIST_SIGNAL_COUNT]);
+
+// Read every module's state and record it at the current monotonic time
+void historian_sample(void);
+uint64_t historian_now_ms(void);   // ms since historian_init
+
+// Min/max/mean of a signal over rows starting in [from_ms, to_ms] of one
+// tier. Only closed rollup rows count; the bucket still filling is not
+// visible until it closes. Returns false if no row falls in the range.
+bool historian_query_tier(HistorianSignal signal, HistorianTier tier, uint64_t from_ms,
+                          uint64_t to_ms, HistorianSummary* summary);
+
+// As above, on the finest tier that still holds from_ms
+bool historian_query(HistorianSignal signal, uint64_t from_ms, uint64_t to_ms,
+                     HistorianSummary* summary);
+
+// Same reduction with plain scalar loops, to check the vector path against
+bool historian_query_scalar(HistorianSignal signal, HistorianTier tier, uint64_t from_ms,
+                            uint64_t to_ms, HistorianSummary* summary);
+
+const char* historian_signal_name(HistorianSignal signal);
+const char* historian_signal_unit(HistorianSignal signal);
+const char* historian_tier_name(HistorianTier tier);
+void historian_get_tier_stats(HistorianTier tier, HistorianTierStats* stats);
+
+// The whole column store, for upload to a service tool
+bool historian_get_store(const void** data, size_t* bytes);
+void historian_print_status(void);
+
+#endif // HISTORIAN_H
@@ -0,0 +1,94 @@
+#include "flow_sharing.h"
+#include <string.h>
+
+static const char* consumer_names[HYD_CONSUMER_COUNT] = {
+    "Steering", "PTO clutch", "Hitch", "SCV 1", "SCV 2", "SCV 3", "SCV 4"
+};
+
+// Steering has the priority valve, the PTO clutch must not slip, the hitch
+// comes next and the remotes share what is left. Levels ascend in
+// HydConsumer order, which the solver relies on.
+static const uint8_t default_priority[HYD_CONSUMER_COUNT] = { 0, 1, 2, 3, 3, 3, 3 };
+
+void flow_sharing_init(FlowSharing* fs) {
+    memset(fs, 0, sizeof(*fs));
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        fs->consumer[i].priority = default_priority[i];
+        fs->consumer[i].share = REAL(1);
+    }
+}
+
+void flow_sharing_set_demand(FlowSharing* fs, HydConsumer consumer, real_t demand_gpm, real_t load_psi) {
+    if (consumer >= HYD_CONSUMER_COUNT) return;
+    HydConsumerFlow* c = &fs->consumer[consumer];
+    demand_gpm = real_max(demand_gpm, REAL(0));
+    load_psi = real_max(load_psi, REAL(0));
+    if (demand_gpm != c->demand_gpm || load_psi != c->load_psi) {
+        c->demand_gpm = demand_gpm;
+        c->load_psi = load_psi;
+        fs->demand_generation++;
+    }
+}
+
+void flow_sharing_solve(FlowSharing* fs, real_t displacement_gpm, real_t max_psi, real_t power_hp) {
+    // Consumers whose load the pump cannot reach stall; the rest set the
+    // load-sense pressure
+    real_t max_load = REAL(0);
+    fs->demand_gpm = REAL(0);
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        HydConsumerFlow* c = &fs->consumer[i];
+        c->stalled = c->demand_gpm > REAL(0) && c->load_psi > max_psi;
+        if (c->demand_gpm > REAL(0) && !c->stalled) {
+            max_load = real_max(max_load, c->load_psi);
+            fs->demand_gpm = real_add(fs->demand_gpm, c->demand_gpm);
+        }
+    }
+    fs->pump_psi = real_min(real_add(max_load, REAL(HYD_MARGIN_PSI)), max_psi);
+
+    // hp = GPM x PSI / 1714, worked in hundreds of PSI to stay in Q16.16 range
+    fs->displacement_gpm = real_max(displacement_gpm, REAL(0));
+    fs->power_limit_gpm = fs->displacement_gpm;
+    real_t hundreds_psi = real_div(fs->pump_psi, REAL(100));
+    if (hundreds_psi > REAL(0)) {
+        fs->power_limit_gpm = real_div(real_mul(power_hp, REAL(17.14)), hundreds_psi);
+    }
+    fs->capacity_gpm = real_min(fs->displacement_gpm, fs->power_limit_gpm);
+    fs->saturated = fs->demand_gpm > fs->capacity_gpm;
+
+    // Serve each priority level from what the levels above left over
+    real_t remaining = fs->capacity_gpm;
+    fs->delivered_gpm = REAL(0);
+    fs->starved_mask = 0;
+    int first = 0;
+    while (first < HYD_CONSUMER_COUNT) {
+        int end = first;
+        real_t level_demand = REAL(0);
+        while (end < HYD_CONSUMER_COUNT && fs->consumer[end].priority == fs->consumer[first].priority) {
+            if (!fs->consumer[end].stalled) {
+                level_demand = real_add(level_demand, fs->consumer[end].demand_gpm);
+            }
+            end++;
+        }
+
+        real_t share = remaining > REAL(0) ? REAL(1) : REAL(0);
+        if (level_demand > remaining) {
+            share = real_div(remaining, level_demand);
+        }
+        for (int i = first; i < end; i++) {
+            HydConsumerFlow* c = &fs->consumer[i];
+            c->share = c->stalled ? REAL(0) : share;
+            c->allocated_gpm = real_mul(c->demand_gpm, c->share);
+            c->starved = c->demand_gpm > REAL(0) && c->share < REAL(HYD_STARVED_SHARE);
+            if (c->starved) {
+                fs->starved_mask |= (uint8_t)(1u << i);
+            }
+            remaining = real_max(real_sub(remaining, c->allocated_gpm), REAL(0));
+            fs->delivered_gpm = real_add(fs->delivered_gpm, c->allocated_gpm);
+        }
+        first = end;
+    }
+}
+
+const char* flow_sharing_consumer_name(HydConsumer consumer) {
+    return consumer < HYD_CONSUMER_COUNT ? consumer_names[consumer] : "Unknown";
+}
@@ -0,0 +1,61 @@
+#ifndef FLOW_SHARING_H
+#define FLOW_SHARING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../common/fixed.h"
+
+// Consumers in priority order; the priority valve feeds steering first
+typedef enum {
+    HYD_CONSUMER_STEERING = 0,
+    HYD_CONSUMER_PTO_CLUTCH,
+    HYD_CONSUMER_HITCH,
+    HYD_CONSUMER_SCV1,
+    HYD_CONSUMER_SCV2,
+    HYD_CONSUMER_SCV3,
+    HYD_CONSUMER_SCV4,
+    HYD_CONSUMER_COUNT
+} HydConsumer;
+
+#define HYD_SCV_COUNT       4
+#define HYD_MARGIN_PSI      200     // Load-sense margin above the highest load
+#define HYD_STARVED_SHARE   0.98    // Below this share of its demand a consumer is starved
+
+typedef struct {
+    uint8_t priority;          // 0 is served first; equal priorities share proportionally
+    real_t demand_gpm;
+    real_t load_psi;           // Pressure the consumer needs to move
+    real_t allocated_gpm;
+    real_t share;              // Fraction of commanded flow delivered (flow-sharing valves)
+    bool stalled;              // Load above what the pump can make
+    bool starved;              // Demand not met
+} HydConsumerFlow;
+
+// Load-sensing pump with flow-sharing valve sections: the pump makes the
+// highest served load plus a margin, limited by its speed (displacement)
+// and input power. Priority levels are served in turn; when a level asks
+// for more than is left, every section at that level gets the same share
+// of its commanded flow. Fixed size, one pass per level, no allocation.
+typedef struct {
+    HydConsumerFlow consumer[HYD_CONSUMER_COUNT];
+    real_t displacement_gpm;   // Pump flow at the current speed
+    real_t power_limit_gpm;    // Flow the input power allows at pump_psi
+    real_t capacity_gpm;       // min of the two
+    real_t pump_psi;           // Load-sensed outlet pressure
+    real_t demand_gpm;
+    real_t delivered_gpm;
+    uint8_t starved_mask;      // Bit per HydConsumer
+    bool saturated;            // Demand exceeded capacity
+    uint32_t demand_generation;  // Bumped when a posted demand changes
+} FlowSharing;
+
+void flow_sharing_init(FlowSharing* fs);
+void flow_sharing_set_demand(FlowSharing* fs, HydConsumer consumer, real_t demand_gpm, real_t load_psi);
+
+// One allocation pass; max_psi is the relief pressure at the current
+// pump speed and power_hp the pump input limit
+void flow_sharing_solve(FlowSharing* fs, real_t displacement_gpm, real_t max_psi, real_t power_hp);
+
+const char* flow_sharing_consumer_name(HydConsumer consumer);
+
+#endif // FLOW_SHARING_H
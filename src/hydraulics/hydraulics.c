@@ -1,49 +1,140 @@
 #include "hydraulics.h"
 #include "../engine/engine_control.h"
 #include "../canbus/canbus.h"
+#include "can_messages.h"
 #include "../diagnostics/diagnostics.h"
+#include "../sensors/sensors.h"
+#include "../common/change.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
 
 static HydraulicsState hydraulics_state = {0};
 
+#define PUMP_POWER_LIMIT_HP   15      // Pump input power the engine gives hydraulics
+#define RELIEF_PSI            3000    // Pump compensator setting, reached at any running speed
+#define STEERING_GPM          1.5     // Orbitrol flow while the engine runs
+#define STEERING_PSI          800
+#define CRANKING_RPM          600     // Below this the pump is not expected to keep up
+
+static uint8_t reported_starved_mask;  // Consumers already reported as starved
+static ChangeTracker update_tracker;
+
 void hydraulics_init(void) {
     printf("[HYDRAULICS] Initializing hydraulics control module\n");
-    hydraulics_state.system_pressure = 0.0;
-    hydraulics_state.flow_rate = 0.0;
-    hydraulics_state.reservoir_level = 85.0;
-    hydraulics_state.oil_temp = 20.0;
+    hydraulics_state.system_pressure = REAL(0);
+    hydraulics_state.flow_rate = REAL(0);
+    hydraulics_state.reservoir_level = REAL(85);
+    hydraulics_state.oil_temp = REAL(20);
     hydraulics_state.pto_speed = 0;
     hydraulics_state.pto_engaged = false;
     hydraulics_state.implement_raised = false;
     hydraulics_state.status = STATUS_OK;
+    flow_sharing_init(&hydraulics_state.flow);
+    reported_starved_mask = 0;
+    change_tracker_init(&update_tracker, "Hydraulics");
+    CHECKPOINT_VAR("hydraulics", hydraulics_state);
+    CHECKPOINT_VAR("hydraulics", reported_starved_mask);
+    CHECKPOINT_VAR_FROM("hydraulics", update_tracker, seen);
+}
+
+// Shares the pump between the posted demands and reports consumers that
+// newly go short once the engine is past cranking. Returns whether any
+// share moved.
+static bool allocate_flow(const EngineState* engine) {
+    bool running = engine->engine_running;
+    FlowSharing* flow = &hydraulics_state.flow;
+    real_t previous_share[HYD_CONSUMER_COUNT];
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        previous_share[i] = flow->consumer[i].share;
+    }
+    flow_sharing_set_demand(flow, HYD_CONSUMER_STEERING,
+                            running ? REAL(STEERING_GPM) : REAL(0), REAL(STEERING_PSI));
+    flow_sharing_solve(flow, hydraulics_state.flow_rate, running ? REAL(RELIEF_PSI) : REAL(0),
+                       REAL(PUMP_POWER_LIMIT_HP));
+    bool shares_moved = false;
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        shares_moved |= flow->consumer[i].share != previous_share[i];
+    }
+
+    uint8_t starved = engine->current_rpm >= CRANKING_RPM ? flow->starved_mask : 0;
+    uint8_t newly_starved = starved & (uint8_t)~reported_starved_mask;
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        if (newly_starved & (1u << i)) {
+            const HydConsumerFlow* c = &flow->consumer[i];
+            printf("[HYDRAULICS] %s starved: %.1f of %.1f GPM%s\n", flow_sharing_consumer_name((HydConsumer)i),
+                   real_to_float(c->allocated_gpm), real_to_float(c->demand_gpm),
+                   c->stalled ? " (load above pump pressure)" : "");
+        }
+    }
+    if (newly_starved) {
+        diagnostics_report_fault(FAULT_HYDRAULIC_FLOW_STARVED);
+    }
+    reported_starved_mask = starved;
+
+    // Share of commanded flow per consumer (%) and the starved mask
+    float percent[HYD_CONSUMER_COUNT];
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        percent[i] = real_to_float(flow->consumer[i].share) * 100.0f;
+    }
+    CanHydraulicFlowShare shares = {
+        .steering_share = percent[HYD_CONSUMER_STEERING],
+        .pto_clutch_share = percent[HYD_CONSUMER_PTO_CLUTCH],
+        .hitch_share = percent[HYD_CONSUMER_HITCH],
+        .scv1_share = percent[HYD_CONSUMER_SCV1],
+        .scv2_share = percent[HYD_CONSUMER_SCV2],
+        .scv3_share = percent[HYD_CONSUMER_SCV3],
+        .scv4_share = percent[HYD_CONSUMER_SCV4],
+        .starved_mask = (uint8_t)flow->starved_mask,
+    };
+    uint8_t data[CAN_DLC_HYDRAULIC_FLOW_SHARE];
+    can_pack_hydraulic_flow_share(data, &shares);
+    canbus_send_message(CAN_ID_HYDRAULIC_FLOW_SHARE, data, sizeof(data));
+    return shares_moved;
 }
 
 void hydraulics_update(void) {
     // Get engine state to determine pump speed
     EngineState* engine = engine_get_state();
+    hydraulics_state.oil_temp = sensors_read(SENSOR_HYD_OIL_TEMP);
+    hydraulics_state.reservoir_level = sensors_read(SENSOR_HYD_RESERVOIR);
 
-    if (engine->engine_running) {
-        // Hydraulic pump driven by engine
-        float pump_speed_factor = engine->current_rpm / 2600.0;
-        hydraulics_state.system_pressure = pump_speed_factor * 3000.0; // Max 3000 PSI
-        hydraulics_state.flow_rate = pump_speed_factor * 25.0; // Max 25 GPM
-
-        // Oil heats up with use
-        if (hydraulics_state.pto_engaged || hydraulics_state.implement_raised) {
-            hydraulics_state.oil_temp += 0.3;
+    // Pump output follows engine speed and the allocation follows the
+    // posted demands; with neither moved, last cycle's results stand
+    const uint32_t inputs[] = { engine->generation, hydraulics_state.flow.demand_generation };
+    if (change_tracker_update(&update_tracker, inputs, 2)) {
+        real_t previous_pressure = hydraulics_state.system_pressure;
+        real_t previous_flow = hydraulics_state.flow_rate;
+        if (engine->engine_running) {
+            // Hydraulic pump driven by engine
+            real_t pump_speed_factor = real_div(real_from_int(engine->current_rpm), REAL(2600));
+            hydraulics_state.system_pressure = real_mul(pump_speed_factor, REAL(3000)); // Max 3000 PSI
+            hydraulics_state.flow_rate = real_mul(pump_speed_factor, REAL(25)); // Max 25 GPM
+        } else {
+            hydraulics_state.system_pressure = REAL(0);
+            hydraulics_state.flow_rate = REAL(0);
         }
-    } else {
-        hydraulics_state.system_pressure = 0.0;
-        hydraulics_state.flow_rate = 0.0;
-    }
 
-    // Send hydraulics data to CAN bus
-    canbus_send_message(0x200, (uint8_t*)&hydraulics_state.system_pressure, 4);
+        // Send hydraulics data to CAN bus
+        CanHydraulicStatus status = {
+            .system_pressure = real_to_float(hydraulics_state.system_pressure),
+            .flow_rate = real_to_float(hydraulics_state.flow_rate),
+            .oil_temp = real_to_float(hydraulics_state.oil_temp),
+            .reservoir_level = real_to_float(hydraulics_state.reservoir_level),
+        };
+        uint8_t data[CAN_DLC_HYDRAULIC_STATUS];
+        can_pack_hydraulic_status(data, &status);
+        canbus_send_message(CAN_ID_HYDRAULIC_STATUS, data, sizeof(data));
+
+        bool shares_moved = allocate_flow(engine);
+        change_publish(&hydraulics_state.generation, shares_moved ||
+                       hydraulics_state.system_pressure != previous_pressure ||
+                       hydraulics_state.flow_rate != previous_flow);
+    }
 
     // Check for fault conditions
     SystemStatus health = hydraulics_check_health();
     if (health != STATUS_OK) {
-        diagnostics_report_fault(SPN_HYDRAULIC_PRESSURE, FMI_DATA_BELOW_NORMAL, "Hydraulics", "Hydraulic system pressure below normal operating range");
+        diagnostics_report_fault(FAULT_HYDRAULIC_PRESSURE_LOW);
     }
 }
 
@@ -70,16 +161,44 @@ void hydraulics_disengage_pto(void) {
     hydraulics_state.pto_speed = 0;
 }
 
+void hydraulics_set_demand(HydConsumer consumer, real_t demand_gpm, real_t load_psi) {
+    flow_sharing_set_demand(&hydraulics_state.flow, consumer, demand_gpm, load_psi);
+}
+
+real_t hydraulics_get_share(HydConsumer consumer) {
+    if (consumer >= HYD_CONSUMER_COUNT) return REAL(0);
+    return hydraulics_state.flow.consumer[consumer].share;
+}
+
+void hydraulics_print_status(void) {
+    const FlowSharing* flow = &hydraulics_state.flow;
+    printf("\n=== Hydraulic Flow Sharing ===\n");
+    printf("Pump: %.0f PSI, capacity %.1f GPM (displacement %.1f, power limit %.1f)%s\n",
+           real_to_float(flow->pump_psi), real_to_float(flow->capacity_gpm),
+           real_to_float(flow->displacement_gpm), real_to_float(flow->power_limit_gpm),
+           flow->saturated ? " - saturated" : "");
+    printf("Demand %.1f GPM, delivered %.1f GPM\n",
+           real_to_float(flow->demand_gpm), real_to_float(flow->delivered_gpm));
+    printf("%-11s %4s %8s %8s %8s %6s\n", "Consumer", "Prio", "Demand", "Given", "Load PSI", "Share");
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        const HydConsumerFlow* c = &flow->consumer[i];
+        printf("%-11s %4d %8.1f %8.1f %8.0f %5.0f%%%s\n", flow_sharing_consumer_name((HydConsumer)i),
+               c->priority, real_to_float(c->demand_gpm), real_to_float(c->allocated_gpm),
+               real_to_float(c->load_psi), real_to_float(c->share) * 100.0f,
+               c->stalled ? "  STALLED" : c->starved ? "  STARVED" : "");
+    }
+}
+
 HydraulicsState* hydraulics_get_state(void) {
     return &hydraulics_state;
 }
 
 SystemStatus hydraulics_check_health(void) {
-    if (hydraulics_state.reservoir_level < 20.0) {
+    if (hydraulics_state.reservoir_level < REAL(20)) {
         hydraulics_state.status = STATUS_CRITICAL;
         return STATUS_CRITICAL;
     }
-    if (hydraulics_state.oil_temp > 90.0) {
+    if (hydraulics_state.oil_temp > REAL(90)) {
         hydraulics_state.status = STATUS_WARNING;
         return STATUS_WARNING;
     }
@@ -2,26 +2,36 @@
 #define HYDRAULICS_H
 
 #include "../common/types.h"
+#include "../common/fixed.h"
+#include "flow_sharing.h"
 
 // Hydraulics control module - manages implements, loaders, PTO
 typedef struct {
-    float system_pressure;    // PSI
-    float flow_rate;          // GPM
-    float reservoir_level;    // Percentage
-    float oil_temp;           // Celsius
+    real_t system_pressure;    // PSI
+    real_t flow_rate;          // GPM
+    real_t reservoir_level;    // Percentage
+    real_t oil_temp;           // Celsius
     uint8_t pto_speed;        // RPM percentage
     bool pto_engaged;
     bool implement_raised;
     SystemStatus status;
+    FlowSharing flow;          // Per-consumer allocation from the last update
+    uint32_t generation;       // Bumped when pressure, pump flow or a share changes
 } HydraulicsState;
 
-// Dependencies: Engine (needs RPM for pump speed), CANBus (send hydraulic data)
+// Dependencies: Engine (needs RPM for pump speed), CANBus (send hydraulic data),
+// Sensors (oil temperature, reservoir level)
 void hydraulics_init(void);
 void hydraulics_update(void);
 void hydraulics_raise_implement(void);
 void hydraulics_lower_implement(void);
 void hydraulics_engage_pto(uint8_t speed_percent);
 void hydraulics_disengage_pto(void);
+// Consumers post their demand; the next update allocates pump flow and
+// hydraulics_get_share() returns the fraction of it they were given
+void hydraulics_set_demand(HydConsumer consumer, real_t demand_gpm, real_t load_psi);
+real_t hydraulics_get_share(HydConsumer consumer);
+void hydraulics_print_status(void);
 HydraulicsState* hydraulics_get_state(void);
 SystemStatus hydraulics_check_health(void);
 
@@ -1,99 +1,150 @@
 #include "implement.h"
+#include "section_control.h"
+#include "profile_db.h"
 #include "../hydraulics/hydraulics.h"
 #include "../pto/pto.h"
 #include "../canbus/canbus.h"
+#include "can_messages.h"
 #include "../diagnostics/diagnostics.h"
+#include "../geofence/geofence.h"
+#include "../prescription/prescription.h"
+#include "../guidance/guidance.h"
+#include "../control/control_loops.h"
+#include "../common/rng.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
-#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 static ImplementState impl_state = {
     .type = IMPLEMENT_NONE,
     .status = IMPLEMENT_IDLE,
-    .working_depth_cm = 0.0,
-    .target_depth_cm = 10.0,
-    .working_width_m = 0.0,
-    .pressure_bar = 0.0,
-    .flow_lpm = 0.0,
+    .working_depth_cm = REAL(0),
+    .target_depth_cm = REAL(10),
+    .working_width_m = REAL(0),
+    .pressure_bar = REAL(0),
+    .flow_lpm = REAL(0),
     .auto_depth_control = true,
     .rows_or_sections = 0,
-    .coverage_rate_ha_hr = 0.0
+    .coverage_rate_ha_hr = REAL(0)
 };
 
-static const char* implement_type_names[] = {
-    "None",
-    "Planter",
-    "Sprayer",
-    "Baler",
-    "Cultivator",
-    "Mower"
-};
+// Seed meter and boom pressure response time; prescription rates are
+// looked up this far ahead of the implement
+#define PLANTER_RATE_DELAY_S 1.5f
+#define SPRAYER_RATE_DELAY_S 0.8f
+
+static Rng implement_rng;
+
+// Hitch valve flow at full opening and the pressure to lift or lower
+#define HITCH_VALVE_GPM     10.0
+#define HITCH_LIFT_PSI      1200
+#define HITCH_LOWER_PSI     300
+
+// Hitch setpoint for the depth loop; depth is 0 (raised) unless working.
+// Auto depth control adds the draft loop for tillage implements.
+static void command_hitch(void) {
+    bool working = impl_state.type != IMPLEMENT_NONE && impl_state.status == IMPLEMENT_WORKING;
+    bool draft = impl_state.auto_depth_control && (impl_state.profile.flags & PROFILE_DRAFT_CONTROL);
+    control_set_hitch(working, impl_state.target_depth_cm, impl_state.working_width_m,
+                      draft, hydraulics_get_state()->system_pressure);
+}
+
+// Post the hitch valve and the profile's remote valve demands to the
+// hydraulic flow allocation and hand the hitch its share back to the depth loop
+static void command_hydraulics(const ControlState* control) {
+    real_t valve = control != NULL ? control->valve_percent : REAL(0);
+    hydraulics_set_demand(HYD_CONSUMER_HITCH,
+                          real_mul(REAL(HITCH_VALVE_GPM), real_div(real_abs(valve), REAL(100))),
+                          valve < REAL(0) ? REAL(HITCH_LIFT_PSI) : REAL(HITCH_LOWER_PSI));
+    control_set_hitch_flow_share(hydraulics_get_share(HYD_CONSUMER_HITCH));
+
+    bool working = impl_state.type != IMPLEMENT_NONE && impl_state.status == IMPLEMENT_WORKING;
+    for (int i = 0; i < HYD_SCV_COUNT && i < PROFILE_REMOTE_COUNT; i++) {
+        hydraulics_set_demand((HydConsumer)(HYD_CONSUMER_SCV1 + i),
+                              working ? real_from_float(impl_state.profile.remote_gpm[i]) : REAL(0),
+                              real_from_float(impl_state.profile.remote_psi[i]));
+    }
+}
+
+static void send_hitch(bool lowered) {
+    CanImplementHitch hitch = {
+        .lowered = lowered,
+        .target_depth = lowered ? real_to_float(impl_state.target_depth_cm) : 0.0f,
+    };
+    uint8_t data[CAN_DLC_IMPLEMENT_HITCH];
+    can_pack_implement_hitch(data, &hitch);
+    canbus_send_message(CAN_ID_IMPLEMENT_HITCH, data, sizeof(data));
+}
 
 void implement_init(void) {
     printf("[IMPLEMENT] Initializing implement control module\n");
     impl_state.type = IMPLEMENT_NONE;
     impl_state.status = IMPLEMENT_IDLE;
-    impl_state.working_depth_cm = 0.0;
+    impl_state.working_depth_cm = REAL(0);
+    rng_seed(&implement_rng, rng_get_seed(), MODULE_IMPLEMENT);
+    profile_db_init();
+    section_control_init();
+    CHECKPOINT_VAR("implement", impl_state);
+    CHECKPOINT_VAR("implement", implement_rng);
 }
 
 void implement_attach(ImplementType type) {
-    impl_state.type = type;
+    implement_attach_profile((uint32_t)type);
+}
+
+bool implement_attach_profile(uint32_t profile_id) {
+    ImplementProfile profile;
+    if (!profile_db_find(profile_id, &profile)) {
+        printf("[IMPLEMENT] Unknown implement profile 0x%08X\n", profile_id);
+        return false;
+    }
+    impl_state.profile = profile;
+    impl_state.type = (ImplementType)profile.type;
     impl_state.status = IMPLEMENT_RAISED;
 
-    printf("[IMPLEMENT] Attaching %s\n", implement_type_names[type]);
-
-    // Configure implement-specific parameters
-    switch (type) {
-        case IMPLEMENT_PLANTER:
-            impl_state.working_width_m = 12.0;  // 12-meter planter
-            impl_state.rows_or_sections = 24;    // 24 rows
-            impl_state.target_depth_cm = 5.0;    // 5 cm seed depth
-            printf("[IMPLEMENT] 24-row planter configured (12m width)\n");
-            break;
-
-        case IMPLEMENT_SPRAYER:
-            impl_state.working_width_m = 18.0;   // 18-meter boom
-            impl_state.rows_or_sections = 36;    // 36 nozzle sections
-            impl_state.target_depth_cm = 0.0;    // No depth for sprayer
-            printf("[IMPLEMENT] Boom sprayer configured (18m width, 36 sections)\n");
-            break;
-
-        case IMPLEMENT_BALER:
-            impl_state.working_width_m = 2.3;    // 2.3-meter pickup width
-            impl_state.rows_or_sections = 1;
-            impl_state.target_depth_cm = 0.0;
-            printf("[IMPLEMENT] Round baler configured (2.3m pickup)\n");
-            break;
-
-        case IMPLEMENT_CULTIVATOR:
-            impl_state.working_width_m = 9.0;    // 9-meter cultivator
-            impl_state.rows_or_sections = 45;    // 45 shanks
-            impl_state.target_depth_cm = 15.0;   // 15 cm working depth
-            printf("[IMPLEMENT] Field cultivator configured (9m width, 45 shanks)\n");
-            break;
-
-        case IMPLEMENT_MOWER:
-            impl_state.working_width_m = 7.5;    // 7.5-meter mower
-            impl_state.rows_or_sections = 3;     // 3 sections
-            impl_state.target_depth_cm = 8.0;    // 8 cm cutting height
-            printf("[IMPLEMENT] Mower conditioner configured (7.5m width)\n");
-            break;
-
-        default:
-            break;
+    printf("[IMPLEMENT] Attaching %s (profile 0x%08X)\n", profile.name, profile.id);
+
+    impl_state.working_width_m = real_from_float(profile.width_m);
+    impl_state.rows_or_sections = profile.rows_or_sections;
+    impl_state.target_depth_cm = real_from_float(profile.target_depth_cm);
+    impl_state.base_rate = profile.base_rate;
+    printf("[IMPLEMENT] %.1fm width, %d rows/sections, %.0f cm target depth\n",
+           profile.width_m, profile.rows_or_sections, profile.target_depth_cm);
+
+    // Planter row clutches and sprayer boom sections switch individually
+    impl_state.section_control = (profile.flags & PROFILE_SECTION_CONTROL) != 0;
+    impl_state.section_mask = SECTION_ALL(impl_state.rows_or_sections);
+    if (impl_state.section_control) {
+        section_control_configure((uint8_t)impl_state.rows_or_sections, real_to_float(impl_state.working_width_m));
     }
+    impl_state.target_rate = impl_state.base_rate;
+    impl_state.prescription_active = false;
+    guidance_set_swath_width(real_to_float(impl_state.working_width_m));
 
-    // Send CAN message
-    uint8_t data[8] = {0x01, (uint8_t)type, (uint8_t)impl_state.rows_or_sections, 0, 0, 0, 0, 0};
-    canbus_send_message(0x240, data, 8);
+    // Send CAN message: type, rows, profile ID
+    CanImplementAttach attach = {
+        .attached = 1,
+        .implement_type = (uint8_t)impl_state.type,
+        .rows = (uint8_t)impl_state.rows_or_sections,
+        .profile_id = profile.id,
+    };
+    uint8_t data[CAN_DLC_IMPLEMENT_ATTACH];
+    can_pack_implement_attach(data, &attach);
+    canbus_send_on(CAN_BUS_IMPLEMENT, CAN_ID_IMPLEMENT_ATTACH, data, sizeof(data));
+    return true;
 }
 
 void implement_detach(void) {
-    printf("[IMPLEMENT] Detaching %s\n", implement_type_names[impl_state.type]);
+    printf("[IMPLEMENT] Detaching %s\n", impl_state.type != IMPLEMENT_NONE ? impl_state.profile.name : "nothing");
     impl_state.type = IMPLEMENT_NONE;
+    memset(&impl_state.profile, 0, sizeof(impl_state.profile));
     impl_state.status = IMPLEMENT_IDLE;
-    impl_state.working_depth_cm = 0.0;
-    impl_state.working_width_m = 0.0;
+    impl_state.working_depth_cm = REAL(0);
+    impl_state.working_width_m = REAL(0);
+    command_hitch();
+    command_hydraulics(NULL);
+    guidance_set_swath_width(0.0f);
 }
 
 void implement_lower(void) {
@@ -103,19 +154,17 @@ void implement_lower(void) {
     }
 
     HydraulicsState* hyd = hydraulics_get_state();
-    if (hyd->system_pressure < 100.0) {
+    if (hyd->system_pressure < REAL(100)) {
         printf("[IMPLEMENT] Cannot lower - insufficient hydraulic pressure\n");
-        diagnostics_report_fault(SPN_IMPLEMENT_POSITION, FMI_MECHANICAL_FAULT, "Implement", "Implement lowering failed - hydraulic pressure insufficient");
+        diagnostics_report_fault(FAULT_IMPLEMENT_LOWER_FAILED);
         return;
     }
 
-    printf("[IMPLEMENT] Lowering %s to working position\n", implement_type_names[impl_state.type]);
+    printf("[IMPLEMENT] Lowering %s to working position\n", impl_state.profile.name);
     impl_state.status = IMPLEMENT_WORKING;
-    impl_state.working_depth_cm = impl_state.target_depth_cm;
+    command_hitch();    // The depth loop brings it down to the target
 
-    // Send CAN message
-    uint8_t data[8] = {0x01, (uint8_t)impl_state.working_depth_cm, 0, 0, 0, 0, 0, 0};
-    canbus_send_message(0x241, data, 8);
+    send_hitch(true);
 }
 
 void implement_raise(void) {
@@ -123,21 +172,21 @@ void implement_raise(void) {
         return;
     }
 
-    printf("[IMPLEMENT] Raising %s\n", implement_type_names[impl_state.type]);
+    printf("[IMPLEMENT] Raising %s\n", impl_state.profile.name);
     impl_state.status = IMPLEMENT_RAISED;
-    impl_state.working_depth_cm = 0.0;
+    command_hitch();
 
-    // Send CAN message
-    uint8_t data[8] = {0x00, 0, 0, 0, 0, 0, 0, 0};
-    canbus_send_message(0x241, data, 8);
+    send_hitch(false);
 }
 
 void implement_set_depth(float depth_cm) {
-    impl_state.target_depth_cm = depth_cm;
+    impl_state.target_depth_cm = real_from_float(depth_cm);
+    command_hitch();
     printf("[IMPLEMENT] Target depth set to %.1f cm\n", depth_cm);
 }
 
 void implement_update(void) {
+    profile_db_poll();
     if (impl_state.type == IMPLEMENT_NONE) {
         return;
     }
@@ -145,47 +194,87 @@ void implement_update(void) {
     HydraulicsState* hyd = hydraulics_get_state();
     PTOState* pto = pto_get_state();
 
+    // Hitch position comes from the depth loop
+    ControlState control;
+    control_get_state(&control);
+    impl_state.working_depth_cm = control.depth_cm;
+    command_hitch();
+    command_hydraulics(&control);
+
     if (impl_state.status == IMPLEMENT_WORKING) {
-        // Monitor hydraulic pressure and flow
-        impl_state.pressure_bar = hyd->system_pressure;
-        impl_state.flow_lpm = 80.0 + (rand() % 40); // 80-120 lpm
+        // Lift out of zones that must not be worked
+        uint32_t keep_out = GEOFENCE_MASK(GEOFENCE_WATERWAY) | GEOFENCE_MASK(GEOFENCE_EXCLUSION);
+        if (impl_state.type == IMPLEMENT_SPRAYER) {
+            keep_out |= GEOFENCE_MASK(GEOFENCE_NO_SPRAY);
+        }
+        if (geofence_get_state()->inside_mask & keep_out) {
+            printf("[IMPLEMENT] Inside geofence keep-out zone\n");
+            implement_raise();
+            return;
+        }
 
-        // Auto depth control simulation
-        if (impl_state.auto_depth_control && impl_state.target_depth_cm > 0) {
-            float depth_error = impl_state.target_depth_cm - impl_state.working_depth_cm;
-            if (fabs(depth_error) > 0.5) {
-                impl_state.working_depth_cm += depth_error * 0.1; // Gradual adjustment
+        // Shut off sections over ground that is already covered
+        if (impl_state.section_control) {
+            uint64_t mask = section_control_update();
+            if (mask != impl_state.section_mask) {
+                CanSectionState sections = { .section_mask = mask };
+                uint8_t data[CAN_DLC_SECTION_STATE];
+                can_pack_section_state(data, &sections);
+                canbus_send_on(CAN_BUS_IMPLEMENT, CAN_ID_SECTION_STATE, data, sizeof(data));
             }
+            impl_state.section_mask = mask;
         }
 
+        // Variable-rate application from the prescription map
+        if (impl_state.base_rate > 0.0f) {
+            float delay = impl_state.type == IMPLEMENT_PLANTER ? PLANTER_RATE_DELAY_S : SPRAYER_RATE_DELAY_S;
+            float rate;
+            bool active = prescription_rate_ahead(delay, &rate);
+            if (!active) rate = impl_state.base_rate;
+            if (active != impl_state.prescription_active ||
+                fabsf(rate - impl_state.target_rate) > impl_state.target_rate * 0.005f) {
+                CanApplicationRate message = { .rate = rate, .prescription_active = active };
+                uint8_t data[CAN_DLC_APPLICATION_RATE];
+                can_pack_application_rate(data, &message);
+                canbus_send_on(CAN_BUS_IMPLEMENT, CAN_ID_APPLICATION_RATE, data, sizeof(data));
+            }
+            impl_state.target_rate = rate;
+            impl_state.prescription_active = active;
+        }
+
+        // Monitor hydraulic pressure and flow
+        impl_state.pressure_bar = hyd->system_pressure;
+        impl_state.flow_lpm = real_from_int(80 + (int32_t)rng_below(&implement_rng, 40)); // 80-120 lpm
+
         // Calculate coverage rate (simplified)
         // Coverage = width (m) × speed (km/h) × 0.1 (to get ha/hr)
         // Assuming average speed of 10 km/h
-        impl_state.coverage_rate_ha_hr = impl_state.working_width_m * 10.0 * 0.1;
+        impl_state.coverage_rate_ha_hr = real_mul(impl_state.working_width_m, REAL(10.0 * 0.1));
 
         // Check for implement errors
-        if (impl_state.pressure_bar < 80.0) {
-            diagnostics_report_fault(SPN_IMPLEMENT_PRESSURE, FMI_DATA_BELOW_NORMAL, "Implement", "Implement hydraulic pressure below normal operating range");
+        if (impl_state.pressure_bar < REAL(80)) {
+            diagnostics_report_fault(FAULT_IMPLEMENT_PRESSURE_LOW);
             impl_state.status = IMPLEMENT_ERROR;
         }
 
         // Check PTO engagement for implements that need it
-        if (impl_state.type == IMPLEMENT_BALER || impl_state.type == IMPLEMENT_MOWER) {
+        if (impl_state.profile.flags & PROFILE_NEEDS_PTO) {
             if (pto->status != PTO_ENGAGED) {
-                diagnostics_report_fault(SPN_PTO_ENGAGEMENT, FMI_MECHANICAL_FAULT, "Implement", "PTO not engaged - required for implement operation");
+                diagnostics_report_fault(FAULT_IMPLEMENT_PTO_REQUIRED);
             }
         }
 
         // Send telemetry via CAN
-        uint8_t data[8] = {
-            (uint8_t)impl_state.status,
-            (uint8_t)impl_state.working_depth_cm,
-            (uint8_t)impl_state.pressure_bar,
-            (uint8_t)impl_state.flow_lpm,
-            (uint8_t)(impl_state.coverage_rate_ha_hr * 10),
-            0, 0, 0
+        CanImplementStatus status = {
+            .status = (uint8_t)impl_state.status,
+            .working_depth = real_to_float(impl_state.working_depth_cm),
+            .pressure = real_to_float(impl_state.pressure_bar),
+            .flow = real_to_float(impl_state.flow_lpm),
+            .coverage_rate = real_to_float(impl_state.coverage_rate_ha_hr),
         };
-        canbus_send_message(0x242, data, 8);
+        uint8_t data[CAN_DLC_IMPLEMENT_STATUS];
+        can_pack_implement_status(data, &status);
+        canbus_send_on(CAN_BUS_IMPLEMENT, CAN_ID_IMPLEMENT_STATUS, data, sizeof(data));
     }
 }
 
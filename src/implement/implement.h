@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "../common/fixed.h"
+#include "profile_db.h"
 
 // Types of implements that can be attached
 typedef enum {
@@ -24,19 +26,26 @@ typedef enum {
 typedef struct {
     ImplementType type;
     ImplementStatus status;
-    float working_depth_cm;      // Current working depth
-    float target_depth_cm;       // Target working depth
-    float working_width_m;       // Width of implement
-    float pressure_bar;          // Hydraulic pressure
-    float flow_lpm;              // Hydraulic flow (liters per minute)
+    real_t working_depth_cm;      // Current working depth
+    real_t target_depth_cm;       // Target working depth
+    real_t working_width_m;       // Width of implement
+    real_t pressure_bar;          // Hydraulic pressure
+    real_t flow_lpm;              // Hydraulic flow (liters per minute)
     bool auto_depth_control;     // Automatic depth adjustment
     int rows_or_sections;        // Number of rows (planter) or sections (sprayer)
-    float coverage_rate_ha_hr;   // Coverage rate in hectares per hour
+    real_t coverage_rate_ha_hr;   // Coverage rate in hectares per hour
+    bool section_control;        // Automatic per-section/row shut-off
+    uint64_t section_mask;       // Bit i = section/row i on, from the left end
+    float base_rate;             // Fixed application rate (seeds/ha or L/ha), 0 if none
+    float target_rate;           // Commanded rate, from the prescription when in a zone
+    bool prescription_active;    // target_rate came from the prescription map
+    ImplementProfile profile;    // Configuration of the attached implement
 } ImplementState;
 
 // Implement control functions
 void implement_init(void);
-void implement_attach(ImplementType type);
+void implement_attach(ImplementType type);          // Stock profile for the type
+bool implement_attach_profile(uint32_t profile_id);  // Database profile, stock as fallback
 void implement_detach(void);
 void implement_lower(void);
 void implement_raise(void);
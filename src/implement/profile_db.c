@@ -0,0 +1,214 @@
+#include "profile_db.h"
+#include "implement.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAX_SLOT_BITS 28
+
+// Built-in configurations, used when no database supplies the ID
+static const ImplementProfile stock_profiles[] = {
+    { IMPLEMENT_PLANTER, IMPLEMENT_PLANTER, PROFILE_SECTION_CONTROL, 24, 12.0f, 5.0f, 84000.0f,
+      { 9.0f, 1.0f }, { 1400.0f, 1200.0f }, "seeds/ha", "24-row planter" },          // Vacuum fan, down-force
+    { IMPLEMENT_SPRAYER, IMPLEMENT_SPRAYER, PROFILE_SECTION_CONTROL, 36, 18.0f, 0.0f, 150.0f,
+      { 7.0f }, { 1300.0f }, "L/ha", "Boom sprayer" },                               // Spray pump motor
+    { IMPLEMENT_BALER, IMPLEMENT_BALER, PROFILE_NEEDS_PTO, 1, 2.3f, 0.0f, 0.0f,
+      { 0.0f }, { 0.0f }, "", "Round baler" },
+    { IMPLEMENT_CULTIVATOR, IMPLEMENT_CULTIVATOR, PROFILE_DRAFT_CONTROL, 45, 9.0f, 15.0f, 0.0f,
+      { 0.0f }, { 0.0f }, "", "Field cultivator" },
+    { IMPLEMENT_MOWER, IMPLEMENT_MOWER, PROFILE_NEEDS_PTO, 3, 7.5f, 8.0f, 0.0f,
+      { 0.0f }, { 0.0f }, "", "Mower conditioner" },
+};
+#define STOCK_PROFILE_COUNT (sizeof(stock_profiles) / sizeof(stock_profiles[0]))
+
+static ProfileDbState db_state = {0};
+static const uint8_t* map_base = NULL;
+static const ProfileDbSlot* index_slots = NULL;
+static const ImplementProfile* records = NULL;
+static uint32_t slot_bits = 0;
+static struct timespec db_mtime;
+static ino_t db_inode;
+
+static float elapsed_us(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1e6f + (end->tv_nsec - start->tv_nsec) / 1e3f;
+}
+
+void profile_db_init(void) {
+    printf("[IMPLEMENT] Initializing implement profile database (%zu stock profiles)\n", STOCK_PROFILE_COUNT);
+    profile_db_close();
+    memset(&db_state, 0, sizeof(db_state));
+}
+
+// Maps and checks a database file without touching the current one
+static const uint8_t* map_database(const char* path, size_t* size_out, struct stat* st) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("[IMPLEMENT] Cannot open profile database %s\n", path);
+        return NULL;
+    }
+    if (fstat(fd, st) < 0 || (size_t)st->st_size < PROFILE_DB_HEADER_BYTES) {
+        printf("[IMPLEMENT] %s is not a profile database\n", path);
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st->st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("[IMPLEMENT] Cannot map %s\n", path);
+        return NULL;
+    }
+    madvise(map, size, MADV_RANDOM);  // Lookups hit one slot and one record
+
+    const ProfileDbHeader* header = (const ProfileDbHeader*)map;
+    uint64_t slots = header->slot_bits <= MAX_SLOT_BITS ? (uint64_t)1 << header->slot_bits : 0;
+    bool valid = header->magic == PROFILE_DB_MAGIC && header->version == PROFILE_DB_VERSION &&
+                 header->record_bytes == sizeof(ImplementProfile) && slots > 0 &&
+                 header->count < slots &&
+                 header->index_offset % sizeof(uint32_t) == 0 &&
+                 header->records_offset % sizeof(uint32_t) == 0 &&
+                 header->index_offset + slots * sizeof(ProfileDbSlot) <= size &&
+                 header->records_offset + (uint64_t)header->count * sizeof(ImplementProfile) <= size;
+    if (!valid) {
+        printf("[IMPLEMENT] %s is not a profile database\n", path);
+        munmap(map, size);
+        return NULL;
+    }
+    *size_out = size;
+    return (const uint8_t*)map;
+}
+
+bool profile_db_open(const char* path) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Remember the path even on failure, so a file that appears later is picked up
+    db_state.path = path;
+    size_t size = 0;
+    struct stat st;
+    const uint8_t* map = map_database(path, &size, &st);
+    if (map == NULL) {
+        if (db_state.loaded) {
+            printf("[IMPLEMENT] Keeping the %u profiles already loaded\n", db_state.count);
+        }
+        return false;
+    }
+
+    // Profiles are copied out on lookup, so the old mapping can go at once
+    bool reload = db_state.loaded;
+    if (map_base != NULL) {
+        munmap((void*)map_base, db_state.mapped_bytes);
+    }
+    const ProfileDbHeader* header = (const ProfileDbHeader*)map;
+    map_base = map;
+    index_slots = (const ProfileDbSlot*)(map + header->index_offset);
+    records = (const ImplementProfile*)(map + header->records_offset);
+    slot_bits = header->slot_bits;
+
+    db_state.loaded = true;
+    db_state.mapped_bytes = size;
+    db_state.count = header->count;
+    db_state.slots = 1u << slot_bits;
+    db_state.max_probes = 0;
+    if (reload) db_state.reloads++;
+    db_mtime = st.st_mtim;
+    db_inode = st.st_ino;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    db_state.load_us = elapsed_us(&start, &end);
+    printf("[IMPLEMENT] %s %u implement profiles from %s in %.0f us\n",
+           reload ? "Reloaded" : "Mapped", db_state.count, path, db_state.load_us);
+    return true;
+}
+
+void profile_db_close(void) {
+    if (map_base != NULL) {
+        munmap((void*)map_base, db_state.mapped_bytes);
+    }
+    map_base = NULL;
+    index_slots = NULL;
+    records = NULL;
+    slot_bits = 0;
+    db_state.loaded = false;
+    db_state.mapped_bytes = 0;
+    db_state.count = 0;
+    db_state.slots = 0;
+}
+
+// The build tool replaces the file with a rename, so a new inode or mtime
+// means a new database; the old mapping stays valid until it is swapped
+void profile_db_poll(void) {
+    struct stat st;
+    if (db_state.path == NULL || stat(db_state.path, &st) != 0) return;
+    if (st.st_ino == db_inode && st.st_mtim.tv_sec == db_mtime.tv_sec &&
+        st.st_mtim.tv_nsec == db_mtime.tv_nsec) {
+        return;
+    }
+    if (!profile_db_open(db_state.path)) {
+        // Do not retry a bad file every cycle
+        db_mtime = st.st_mtim;
+        db_inode = st.st_ino;
+    }
+}
+
+static bool valid_profile(const ImplementProfile* profile) {
+    return profile->type > IMPLEMENT_NONE && profile->type <= IMPLEMENT_MOWER &&
+           profile->width_m >= 0.0f && profile->rows_or_sections <= 64;
+}
+
+static bool find_mapped(uint32_t id, ImplementProfile* out) {
+    uint32_t mask = db_state.slots - 1;
+    uint32_t slot = profile_db_slot(id, slot_bits);
+    for (uint32_t probes = 1; probes <= db_state.slots; probes++, slot = (slot + 1) & mask) {
+        const ProfileDbSlot* entry = &index_slots[slot];
+        if (entry->record == PROFILE_NO_RECORD) return false;
+        if (entry->id != id) continue;
+
+        if (probes > db_state.max_probes) db_state.max_probes = probes;
+        if (entry->record >= db_state.count || records[entry->record].id != id ||
+            !valid_profile(&records[entry->record])) {
+            return false;
+        }
+        *out = records[entry->record];
+        out->name[PROFILE_NAME_LEN - 1] = '\0';
+        out->rate_units[PROFILE_UNITS_LEN - 1] = '\0';
+        return true;
+    }
+    return false;
+}
+
+bool profile_db_find(uint32_t id, ImplementProfile* out) {
+    db_state.lookups++;
+    if (db_state.loaded && find_mapped(id, out)) {
+        return true;
+    }
+    for (size_t i = 0; i < STOCK_PROFILE_COUNT; i++) {
+        if (stock_profiles[i].id == id) {
+            *out = stock_profiles[i];
+            return true;
+        }
+    }
+    db_state.misses++;
+    return false;
+}
+
+void profile_db_print_status(void) {
+    printf("\n=== Implement Profiles ===\n");
+    if (!db_state.loaded) {
+        printf("Database: none (%zu stock profiles)\n", STOCK_PROFILE_COUNT);
+    } else {
+        printf("Database: %s, %u profiles in %u slots (%.0f KB mapped)\n", db_state.path,
+               db_state.count, db_state.slots, db_state.mapped_bytes / 1024.0);
+        printf("Mapped in %.0f us, %u reloads, longest probe %u\n",
+               db_state.load_us, db_state.reloads, db_state.max_probes);
+    }
+    printf("Lookups: %u (%u unknown IDs)\n", db_state.lookups, db_state.misses);
+}
+
+ProfileDbState* profile_db_get_state(void) {
+    return &db_state;
+}
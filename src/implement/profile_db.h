@@ -0,0 +1,87 @@
+#ifndef PROFILE_DB_H
+#define PROFILE_DB_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PROFILE_DB_MAGIC        0x31445049u   // "IPD1"
+#define PROFILE_DB_VERSION      1
+#define PROFILE_DB_HEADER_BYTES 64
+#define PROFILE_REMOTE_COUNT    4             // Remote valves a profile can load
+#define PROFILE_NAME_LEN        40
+#define PROFILE_UNITS_LEN       12
+#define PROFILE_NO_RECORD       0xFFFFFFFFu   // Empty index slot
+
+// Profile flags
+#define PROFILE_SECTION_CONTROL 0x01          // Rows or boom sections switch individually
+#define PROFILE_NEEDS_PTO       0x02          // Working without the PTO is a fault
+#define PROFILE_DRAFT_CONTROL   0x04          // Tillage: auto depth holds draft
+
+// One implement configuration, stored as-is in the database
+typedef struct {
+    uint32_t id;                 // Implement ID, e.g. from the ISOBUS name
+    uint8_t type;                // ImplementType
+    uint8_t flags;
+    uint16_t rows_or_sections;
+    float width_m;
+    float target_depth_cm;
+    float base_rate;             // Fixed application rate, 0 if none
+    float remote_gpm[PROFILE_REMOTE_COUNT];   // SCV loads while working
+    float remote_psi[PROFILE_REMOTE_COUNT];
+    char rate_units[PROFILE_UNITS_LEN];
+    char name[PROFILE_NAME_LEN];
+} ImplementProfile;
+
+// Database file (little-endian), written by tools/implement_db from a text source:
+//   ProfileDbHeader, padded to PROFILE_DB_HEADER_BYTES
+//   index: ProfileDbSlot[1 << slot_bits], open addressing by ID hash with
+//       linear probing, at least half empty
+//   records: ImplementProfile[count]
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_bytes;       // sizeof(ImplementProfile)
+    uint32_t count;
+    uint32_t slot_bits;
+    uint32_t index_offset;
+    uint32_t records_offset;
+} ProfileDbHeader;
+
+typedef struct {
+    uint32_t id;
+    uint32_t record;             // Record number, PROFILE_NO_RECORD when empty
+} ProfileDbSlot;
+
+static inline uint32_t profile_db_slot(uint32_t id, uint32_t slot_bits) {
+    return slot_bits == 0 ? 0 : (id * 0x9E3779B1u) >> (32 - slot_bits);
+}
+
+// Implement profile database - the file stays memory-mapped, so opening
+// costs the same for five profiles or fifty thousand and a lookup touches
+// one index line and one record. Stock profiles for the five implement
+// types use their ImplementType numbers as IDs; a database entry with the
+// same ID replaces them.
+typedef struct {
+    bool loaded;
+    const char* path;
+    size_t mapped_bytes;
+    uint32_t count;
+    uint32_t slots;
+    uint32_t reloads;
+    uint32_t lookups;
+    uint32_t misses;             // IDs in neither the database nor the stock set
+    uint32_t max_probes;
+    float load_us;
+} ProfileDbState;
+
+// Dependencies: none
+void profile_db_init(void);
+bool profile_db_open(const char* path);
+void profile_db_close(void);
+void profile_db_poll(void);     // Remaps the file when it has been replaced
+bool profile_db_find(uint32_t id, ImplementProfile* out);
+void profile_db_print_status(void);
+ProfileDbState* profile_db_get_state(void);
+
+#endif // PROFILE_DB_H
@@ -0,0 +1,98 @@
+#include "section_control.h"
+#include "../telematics/telematics.h"
+#include "../coverage/coverage.h"
+#include "../common/checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define SECTION_POINTS (SECTION_MAX * SECTION_SAMPLES)
+
+_Static_assert(SECTION_SAMPLES == 4, "covered test packs one section's samples into a uint32_t");
+
+static SectionControlState section_state = {0};
+
+// Lateral offset of every footprint sample from the boom centre (positive = right)
+static float sample_offset[SECTION_POINTS];
+
+void section_control_init(void) {
+    memset(&section_state, 0, sizeof(section_state));
+    CHECKPOINT_VAR("sections", section_state);
+    CHECKPOINT_VAR("sections", sample_offset);
+}
+
+void section_control_configure(uint8_t section_count, float working_width_m) {
+    if (section_count > SECTION_MAX) section_count = SECTION_MAX;
+    section_state.section_count = section_count;
+    section_state.section_width_m = section_count > 0 ? working_width_m / section_count : 0.0f;
+    section_state.active_mask = SECTION_ALL(section_count);
+    section_state.covered_mask = 0;
+
+    for (int s = 0; s < section_count; s++) {
+        for (int k = 0; k < SECTION_SAMPLES; k++) {
+            sample_offset[s * SECTION_SAMPLES + k] = -working_width_m * 0.5f +
+                section_state.section_width_m * (s + (k + 0.5f) / SECTION_SAMPLES);
+        }
+    }
+    printf("[SECTIONS] Section control: %d sections of %.2f m\n",
+           section_count, section_state.section_width_m);
+}
+
+uint64_t section_control_update(void) {
+    int points = section_state.section_count * SECTION_SAMPLES;
+    if (points == 0) return 0;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    TelematicsState* telem = telematics_get_state();
+    float east, north;
+    telematics_to_local(telem->gps.latitude, telem->gps.longitude, &east, &north);
+
+    // Heading is clockwise from north: forward = (sin, cos), right = (cos, -sin)
+    float heading = telem->gps.heading_deg * (float)M_PI / 180.0f;
+    float forward_x = sinf(heading), forward_y = cosf(heading);
+    float right_x = forward_y, right_y = -forward_x;
+
+    // Test where the boom will be once the valves have switched
+    float lookahead = telem->gps.speed_kmh / 3.6f * SECTION_LOOKAHEAD_S;
+    if (lookahead < SECTION_MIN_LOOKAHEAD_M) lookahead = SECTION_MIN_LOOKAHEAD_M;
+    float boom_x = east + forward_x * lookahead;
+    float boom_y = north + forward_y * lookahead;
+
+    // Project all footprint samples at once (vectorizable), then batch-look
+    // them up in the coverage map
+    float sample_x[SECTION_POINTS];
+    float sample_y[SECTION_POINTS];
+    uint8_t counts[SECTION_POINTS];
+    for (int i = 0; i < points; i++) {
+        sample_x[i] = boom_x + right_x * sample_offset[i];
+        sample_y[i] = boom_y + right_y * sample_offset[i];
+    }
+    coverage_pass_counts(sample_x, sample_y, counts, points);
+
+    // A section is covered when none of its SECTION_SAMPLES counts is zero;
+    // the four counts are tested together with a has-zero-byte check
+    uint64_t covered = 0;
+    for (int s = 0; s < section_state.section_count; s++) {
+        uint32_t packed;
+        memcpy(&packed, &counts[s * SECTION_SAMPLES], sizeof(packed));
+        uint32_t has_zero = (packed - 0x01010101u) & ~packed & 0x80808080u;
+        covered |= (uint64_t)(has_zero == 0) << s;
+    }
+
+    uint64_t active = SECTION_ALL(section_state.section_count) & ~covered;
+    section_state.switch_events += (uint32_t)__builtin_popcountll(active ^ section_state.active_mask);
+    section_state.covered_mask = covered;
+    section_state.active_mask = active;
+    section_state.updates++;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    section_state.last_update_us = (end.tv_sec - start.tv_sec) * 1e6f + (end.tv_nsec - start.tv_nsec) / 1e3f;
+    return active;
+}
+
+SectionControlState* section_control_get_state(void) {
+    return &section_state;
+}
@@ -0,0 +1,33 @@
+#ifndef SECTION_CONTROL_H
+#define SECTION_CONTROL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SECTION_MAX              64
+#define SECTION_SAMPLES          4       // Footprint samples across each section
+#define SECTION_LOOKAHEAD_S      0.3f    // Valve/clutch switching delay
+#define SECTION_MIN_LOOKAHEAD_M  0.5f    // Always test ground ahead of the current pass
+
+#define SECTION_ALL(count) ((count) >= 64 ? ~0ull : ((1ull << (count)) - 1))
+
+// Automatic section control - each cycle projects every section's footprint
+// ahead of the boom and switches off sections over already-covered ground.
+// Bit i of a mask is section i, counted from the left end of the boom.
+typedef struct {
+    uint8_t section_count;
+    float section_width_m;
+    uint64_t active_mask;
+    uint64_t covered_mask;       // Sections whose footprint is fully covered
+    uint32_t switch_events;      // Section on/off transitions
+    uint32_t updates;
+    float last_update_us;
+} SectionControlState;
+
+// Dependencies: Telematics (GPS, heading), Coverage (already-covered ground)
+void section_control_init(void);
+void section_control_configure(uint8_t section_count, float working_width_m);
+uint64_t section_control_update(void);
+SectionControlState* section_control_get_state(void);
+
+#endif // SECTION_CONTROL_H
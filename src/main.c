@@ -1,14 +1,36 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include "engine/engine_control.h"
 #include "hydraulics/hydraulics.h"
 #include "transmission/transmission.h"
 #include "diagnostics/diagnostics.h"
+#include "diagnostics/uds.h"
 #include "canbus/canbus.h"
+#include "canbus/gateway.h"
 #include "pto/pto.h"
+#include "pto/pto_analysis.h"
 #include "telematics/telematics.h"
+#include "telematics/telemetry.h"
+#include "telematics/spool.h"
+#include "telematics/track.h"
 #include "implement/implement.h"
+#include "coverage/coverage.h"
+#include "geofence/geofence.h"
+#include "prescription/prescription.h"
+#include "guidance/guidance.h"
+#include "historian/historian.h"
+#include "thermal/thermal.h"
+#include "sensors/sensors.h"
+#include "control/control_loops.h"
+#include "common/rng.h"
+#include "common/change.h"
+#include "common/budget.h"
+#include "common/checkpoint.h"
+
+#define DEMO_STEP_S  1.0   // Demo loops update once per second
+#define RUN_STEP_S   2.0   // Continuous mode update period
 
 // Main ECU control loop - coordinates all subsystems
 void print_system_status(void) {
@@ -27,22 +49,38 @@ void print_system_status(void) {
            engine->current_rpm, engine->target_rpm,
            engine->status == STATUS_OK ? "OK" : "WARNING");
     printf("║   Fuel Rate: %.1f L/hr    Coolant: %.1f°C             ║\n",
-           engine->fuel_rate, engine->coolant_temp);
+           real_to_float(engine->fuel_rate), real_to_float(engine->coolant_temp));
+    printf("║   Load: %5.1f%%  Torque: %4.0f Nm  Cal: %-12s     ║\n",
+           real_to_float(engine->load_percent), real_to_float(engine->torque_nm),
+           engine_calibration_name());
+    SensorData supply;
+    sensors_get_supply(&supply);
+    printf("║   Battery: %4.1f V  Alternator: %4.0f A  ECU: %3.0f°C        ║\n",
+           supply.voltage, supply.current, supply.temperature);
     printf("║                                                           ║\n");
     printf("║ TRANSMISSION:                                             ║\n");
     printf("║   Gear: %d    Output Speed: %.0f RPM                     ║\n",
-           transmission->current_gear, transmission->output_speed);
+           transmission->current_gear, real_to_float(transmission->output_speed));
     printf("║   Temp: %.1f°C    Clutch: %s                         ║\n",
-           transmission->transmission_temp,
+           real_to_float(transmission->transmission_temp),
            transmission->clutch_engaged ? "Engaged " : "Released");
     printf("║                                                           ║\n");
     printf("║ HYDRAULICS:                                               ║\n");
     printf("║   Pressure: %.0f PSI    Flow: %.1f GPM                  ║\n",
-           hydraulics->system_pressure, hydraulics->flow_rate);
+           real_to_float(hydraulics->system_pressure), real_to_float(hydraulics->flow_rate));
     printf("║   PTO: %s at %d%%    Implement: %s              ║\n",
            hydraulics->pto_engaged ? "Engaged " : "Disabled",
            hydraulics->pto_speed,
            hydraulics->implement_raised ? "Raised " : "Lowered");
+    const char* starved = "none";
+    for (int i = 0; i < HYD_CONSUMER_COUNT; i++) {
+        if (hydraulics->flow.starved_mask & (1u << i)) {
+            starved = flow_sharing_consumer_name((HydConsumer)i);
+            break;
+        }
+    }
+    printf("║   Flow: %4.1f of %4.1f GPM demanded   Starved: %-10s ║\n",
+           real_to_float(hydraulics->flow.delivered_gpm), real_to_float(hydraulics->flow.demand_gpm), starved);
     printf("║                                                           ║\n");
     printf("║ PTO SYSTEM:                                               ║\n");
     printf("║   Status: %-12s  RPM: %4d / %4d               ║\n",
@@ -50,7 +88,13 @@ void print_system_status(void) {
            pto->status == PTO_ENGAGING ? "Engaging" : "Disengaged",
            pto->current_rpm, pto->target_speed);
     printf("║   Load: %.1f%%    Torque: %.0f Nm                      ║\n",
-           pto->load_percent, pto->torque_nm);
+           real_to_float(pto->load_percent), real_to_float(pto->torque_nm));
+    PtoAnalysisState analysis;
+    pto_analysis_get(&analysis);
+    if (analysis.spectrum_valid) {
+        printf("║   Peak: %4.0f Nm  Crest: %4.2f  Line: %5.1f Nm @ %4.1f Hz    ║\n",
+               analysis.peak_nm, analysis.crest_factor, analysis.dominant_nm, analysis.dominant_hz);
+    }
     printf("║                                                           ║\n");
     printf("║ GPS/TELEMATICS:                                           ║\n");
     printf("║   Position: %.4f, %.4f                     ║\n",
@@ -62,28 +106,86 @@ void print_system_status(void) {
            telematics->connectivity.signal_strength);
     printf("║   Field Coverage: %.1f%%                                 ║\n",
            telematics->field_coverage_percent);
+    GuidanceState guidance;
+    guidance_get(&guidance);
+    if (guidance.valid) {
+        printf("║   Guidance: pass %3d  XTE %+6.2f m  Hdg err %+6.1f°    ║\n",
+               guidance.pass_number, guidance.cross_track_m, guidance.heading_error_deg);
+    }
     printf("║                                                           ║\n");
     printf("║ IMPLEMENT CONTROL:                                        ║\n");
     if (implement->type != IMPLEMENT_NONE) {
-        printf("║   Type: %-14s  Status: %-12s       ║\n",
-               implement->type == IMPLEMENT_PLANTER ? "Planter" :
-               implement->type == IMPLEMENT_SPRAYER ? "Sprayer" :
-               implement->type == IMPLEMENT_BALER ? "Baler" :
-               implement->type == IMPLEMENT_CULTIVATOR ? "Cultivator" :
-               implement->type == IMPLEMENT_MOWER ? "Mower" : "Unknown",
+        printf("║   Type: %-18.18s  Status: %-12s   ║\n",
+               implement->profile.name,
                implement->status == IMPLEMENT_WORKING ? "Working" :
                implement->status == IMPLEMENT_RAISED ? "Raised" : "Idle");
         printf("║   Working Depth: %.1f cm    Width: %.1f m              ║\n",
-               implement->working_depth_cm, implement->working_width_m);
+               real_to_float(implement->working_depth_cm), real_to_float(implement->working_width_m));
         printf("║   Coverage Rate: %.1f ha/hr                            ║\n",
-               implement->coverage_rate_ha_hr);
+               real_to_float(implement->coverage_rate_ha_hr));
+        if (implement->section_control) {
+            printf("║   Sections On: %2d / %2d                                 ║\n",
+                   __builtin_popcountll(implement->section_mask), implement->rows_or_sections);
+        }
+        if (implement->base_rate > 0.0f) {
+            printf("║   Rate: %9.1f %-8s  Source: %-12s       ║\n",
+                   implement->target_rate,
+                   implement->profile.rate_units,
+                   implement->prescription_active ? "Prescription" : "Fixed");
+        }
     } else {
         printf("║   No implement attached                                   ║\n");
     }
     printf("╚════════════════════════════════════════════════════════════╝\n\n");
 }
 
-void run_demo_sequence(void) {
+static real_t cycle_step_s = REAL(DEMO_STEP_S);
+static bool lockstep = false;
+
+static void sensors_task(void) {
+    sensors_update(cycle_step_s);
+}
+
+static void thermal_task(void) {
+    thermal_update(cycle_step_s);
+}
+
+// Control executive, PTO torque analysis and guidance run on their own
+// wall-clock threads; with --lockstep they are stepped here on simulated
+// time instead, so a seed replays exactly
+static void workers_task(void) {
+    if (!lockstep) return;
+    float step_s = real_to_float(cycle_step_s);
+    control_run_for(step_s);
+    pto_analysis_run_for(step_s);
+    guidance_run_for(step_s);
+}
+
+// One main cycle, in update order. Budgets are per-run limits in us; the
+// whole cycle has to fit the --cycle-deadline-us deadline. The demo prints
+// the dashboard at fixed points itself, so its cycle leaves the last task out.
+static BudgetTask cycle_tasks[] = {
+    { .name = "sensors",      .run = sensors_task,        .budget_us = 1000, .task_class = BUDGET_CRITICAL },
+    { .name = "engine",       .run = engine_update,       .budget_us = 200,  .task_class = BUDGET_CRITICAL },
+    { .name = "transmission", .run = transmission_update, .budget_us = 100,  .task_class = BUDGET_CRITICAL },
+    { .name = "hydraulics",   .run = hydraulics_update,   .budget_us = 200,  .task_class = BUDGET_CRITICAL },
+    { .name = "pto",          .run = pto_update,          .budget_us = 100,  .task_class = BUDGET_CRITICAL },
+    { .name = "thermal",      .run = thermal_task,        .budget_us = 100,  .task_class = BUDGET_CRITICAL },
+    { .name = "telematics",   .run = telematics_update,   .budget_us = 2000, .task_class = BUDGET_DEFERRABLE },
+    { .name = "implement",    .run = implement_update,    .budget_us = 200,  .task_class = BUDGET_CRITICAL },
+    { .name = "workers",      .run = workers_task,        .budget_us = 5000, .task_class = BUDGET_CRITICAL },
+    { .name = "diagnostics",  .run = diagnostics_update,  .budget_us = 200,  .task_class = BUDGET_CRITICAL },
+    { .name = "historian",    .run = historian_sample,    .budget_us = 50,   .task_class = BUDGET_SHEDDABLE },
+    { .name = "canbus",       .run = canbus_update,       .budget_us = 500,  .task_class = BUDGET_CRITICAL },
+    { .name = "uds",          .run = uds_update,          .budget_us = 500,  .task_class = BUDGET_DEFERRABLE },
+    { .name = "dashboard",    .run = print_system_status, .budget_us = 2000, .task_class = BUDGET_SHEDDABLE,
+      .period_cycles = 3 },
+};
+#define CYCLE_TASK_COUNT ((int)(sizeof(cycle_tasks) / sizeof(cycle_tasks[0])))
+
+static BudgetCycle main_cycle;
+
+void run_demo_sequence(uint32_t implement_profile) {
     printf("\n🚜 Starting Tractor ECU Demo Sequence...\n\n");
 
     // Start engine
@@ -93,14 +195,7 @@ void run_demo_sequence(void) {
 
     // Let engine warm up
     for (int i = 0; i < 3; i++) {
-        engine_update();
-        transmission_update();
-        hydraulics_update();
-        pto_update();
-        telematics_update();
-        implement_update();
-        diagnostics_update();
-        canbus_update();
+        budget_run_cycle(&main_cycle);
         sleep(1);
     }
 
@@ -115,22 +210,17 @@ void run_demo_sequence(void) {
     engine_set_throttle(50);
 
     for (int i = 0; i < 5; i++) {
-        engine_update();
-        transmission_update();
-        hydraulics_update();
-        pto_update();
-        telematics_update();
-        implement_update();
-        diagnostics_update();
-        canbus_update();
+        budget_run_cycle(&main_cycle);
         sleep(1);
     }
 
     print_system_status();
 
     // Attach and configure implement
-    printf("\n>>> Attaching 24-row planter...\n");
-    implement_attach(IMPLEMENT_PLANTER);
+    printf("\n>>> Attaching implement profile %u...\n", implement_profile);
+    if (!implement_attach_profile(implement_profile)) {
+        implement_attach(IMPLEMENT_PLANTER);
+    }
     sleep(1);
 
     // Engage PTO
@@ -140,14 +230,7 @@ void run_demo_sequence(void) {
     sleep(1);
 
     for (int i = 0; i < 4; i++) {
-        engine_update();
-        transmission_update();
-        hydraulics_update();
-        pto_update();
-        telematics_update();
-        implement_update();
-        diagnostics_update();
-        canbus_update();
+        budget_run_cycle(&main_cycle);
         sleep(1);
     }
 
@@ -157,14 +240,7 @@ void run_demo_sequence(void) {
     hydraulics_raise_implement();
 
     for (int i = 0; i < 5; i++) {
-        engine_update();
-        transmission_update();
-        hydraulics_update();
-        pto_update();
-        telematics_update();
-        implement_update();
-        diagnostics_update();
-        canbus_update();
+        budget_run_cycle(&main_cycle);
         sleep(1);
     }
 
@@ -176,8 +252,24 @@ void run_demo_sequence(void) {
     sleep(1);
 
     // Print diagnostics
+    hydraulics_print_status();
+    profile_db_print_status();
+    coverage_print_status();
+    geofence_print_status();
+    prescription_print_status();
+    guidance_print_status();
+    pto_analysis_print_status();
+    sensors_print_status();
+    control_print_status();
+    track_print_stats();
+    historian_print_status();
     diagnostics_print_status();
+    uds_print_status();
     canbus_print_stats();
+    gateway_print_status();
+    change_print_status();
+    budget_print_status(&main_cycle);
+    checkpoint_print_status();
 
     printf("\n✅ Demo sequence complete!\n");
 }
@@ -188,50 +280,174 @@ int main(int argc, char* argv[]) {
     printf("║              Agricultural Equipment Control System           ║\n");
     printf("╚══════════════════════════════════════════════════════════════╝\n\n");
 
+    // Parse command line options
+    bool demo_mode = false;
+    const char* coverage_map = COVERAGE_DEFAULT_FILE;
+    const char* geofence_file = NULL;
+    const char* prescription_file = NULL;
+    const char* guidance_file = NULL;
+    const char* implement_db = NULL;
+    uint32_t implement_profile = IMPLEMENT_PLANTER;
+    size_t history_budget = HISTORIAN_DEFAULT_BUDGET;
+    uint32_t cycle_deadline_us = BUDGET_DEFAULT_DEADLINE_US;
+    const char* checkpoint_file = NULL;
+    const char* restore_file = NULL;
+    const char* sensor_replay = NULL;
+    const char* sensor_record = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--demo") == 0) {
+            demo_mode = true;
+        } else if (strcmp(argv[i], "--lockstep") == 0) {
+            lockstep = true;
+        } else if (strcmp(argv[i], "--coverage-map") == 0 && i + 1 < argc) {
+            coverage_map = argv[++i];
+        } else if (strcmp(argv[i], "--geofence") == 0 && i + 1 < argc) {
+            geofence_file = argv[++i];
+        } else if (strcmp(argv[i], "--prescription") == 0 && i + 1 < argc) {
+            prescription_file = argv[++i];
+        } else if (strcmp(argv[i], "--guidance") == 0 && i + 1 < argc) {
+            guidance_file = argv[++i];
+        } else if (strcmp(argv[i], "--implement-db") == 0 && i + 1 < argc) {
+            implement_db = argv[++i];
+        } else if (strcmp(argv[i], "--implement") == 0 && i + 1 < argc) {
+            implement_profile = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--calibration") == 0 && i + 1 < argc) {
+            engine_set_calibration_file(argv[++i]);
+        } else if (strcmp(argv[i], "--history-mb") == 0 && i + 1 < argc) {
+            history_budget = (size_t)strtoul(argv[++i], NULL, 10) * 1024u * 1024u;
+        } else if (strcmp(argv[i], "--cycle-deadline-us") == 0 && i + 1 < argc) {
+            cycle_deadline_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_file = argv[++i];
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            restore_file = argv[++i];
+        } else if (strcmp(argv[i], "--sensor-replay") == 0 && i + 1 < argc) {
+            sensor_replay = argv[++i];
+        } else if (strcmp(argv[i], "--sensor-record") == 0 && i + 1 < argc) {
+            sensor_record = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rng_set_seed(strtoull(argv[++i], NULL, 0));
+        } else if (strcmp(argv[i], "--spool-dir") == 0 && i + 1 < argc) {
+            telemetry_set_spool_dir(argv[++i]);
+        } else if (strcmp(argv[i], "--drain-rate") == 0 && i + 1 < argc) {
+            spool_set_drain_rate((uint32_t)strtoul(argv[++i], NULL, 10));
+        } else if (strcmp(argv[i], "--uplink") == 0 && i + 1 < argc) {
+            if (!telemetry_parse_endpoint(argv[++i])) {
+                printf("Invalid --uplink endpoint '%s' (expected host:port[/path])\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+
     // Initialize all subsystems
-    printf("Initializing subsystems...\n");
+    printf("Initializing subsystems (simulation seed %llu)...\n", (unsigned long long)rng_get_seed());
     canbus_init();          // Core communication layer
+    gateway_init();         // Tractor <-> implement bus routing
     diagnostics_init();     // Fault tracking
     engine_init();          // Engine control
     transmission_init();    // Transmission control
     hydraulics_init();      // Hydraulics control
     pto_init();             // PTO control
+    thermal_init();         // Coolant and oil temperatures
+    sensors_init();         // Analogue inputs and their filters
+    if (sensor_replay != NULL) {
+        sensors_replay_open(sensor_replay);
+    }
+    if (sensor_record != NULL) {
+        sensors_record_open(sensor_record);
+    }
+    control_init();         // Depth, draft and PTO speed loops
     telematics_init();      // GPS and cloud connectivity
     implement_init();       // Implement control
+    if (implement_db != NULL) {
+        profile_db_open(implement_db);
+    }
+    coverage_init(coverage_map);  // Field coverage map
+    geofence_init();        // Field boundaries and zones
+    if (geofence_file != NULL) {
+        geofence_load(geofence_file);
+    }
+    prescription_init();    // Variable-rate application maps
+    if (prescription_file != NULL) {
+        prescription_load(prescription_file);
+    }
+    guidance_init();        // A-B line / curve / pivot guidance
+    if (guidance_file == NULL || !guidance_load(guidance_file)) {
+        guidance_set_ab_line(0.0f, 0.0f, 100.0f, 0.0f);  // East through the field origin
+    }
+    if (history_budget > 0) {
+        historian_init(history_budget);  // Signal history and rollups
+    }
+    uds_init(0, 0);         // Service tool diagnostics over ISO-TP
+    uds_add_region(UDS_REGION_FAULTS, diagnostics_get_state()->faults,
+                   sizeof(diagnostics_get_state()->faults), "fault history");
+    const void* history_store;
+    size_t history_bytes;
+    if (historian_get_store(&history_store, &history_bytes)) {
+        uds_add_region(UDS_REGION_HISTORY, history_store, (uint32_t)history_bytes, "signal history");
+    }
+    // Lockstep: the cycle only has to fit its simulated period, so no task
+    // is ever shed for timing reasons
+    if (lockstep) {
+        cycle_deadline_us = (uint32_t)((demo_mode ? DEMO_STEP_S : RUN_STEP_S) * 1e6);
+    }
+    budget_cycle_init(&main_cycle, "main", cycle_tasks,
+                      demo_mode ? CYCLE_TASK_COUNT - 1 : CYCLE_TASK_COUNT, cycle_deadline_us);
+
+    // Warm start: overwrite the fresh state before the workers run
+    bool warm_start = false;
+    if (restore_file != NULL && checkpoint_open(restore_file)) {
+        warm_start = checkpoint_restore();
+        CheckpointState* checkpoint = checkpoint_get_state();
+        printf("[CHECKPOINT] Restored %s: %d sections in %.1f us (seed %llu)\n", restore_file,
+               checkpoint->section_count, checkpoint->restore_us,
+               (unsigned long long)checkpoint->image_seed);
+    }
+    if (lockstep) {
+        printf("Lockstep run: control, PTO analysis and guidance step with the cycle\n");
+    } else {
+        guidance_start();
+        pto_analysis_start();   // 1 kHz torque sampling and spectrum
+        control_start();        // 100 Hz control executive
+    }
 
     printf("\n✓ All subsystems initialized\n");
 
     // Run demo or interactive mode
-    if (argc > 1 && strcmp(argv[1], "--demo") == 0) {
-        run_demo_sequence();
+    if (demo_mode) {
+        run_demo_sequence(implement_profile);
     } else {
         printf("\nStarting main control loop (press Ctrl+C to stop)...\n");
         printf("Tip: Run with --demo flag to see automated demo\n\n");
 
-        engine_start();
-        transmission_shift_gear(GEAR_NEUTRAL);
+        if (!warm_start) {
+            engine_start();
+            transmission_shift_gear(GEAR_NEUTRAL);
+        }
+        cycle_step_s = REAL(RUN_STEP_S);
 
         // Main control loop
         for (int cycle = 0; cycle < 10; cycle++) {
-            engine_update();
-            transmission_update();
-            hydraulics_update();
-            pto_update();
-            telematics_update();
-            implement_update();
-            diagnostics_update();
-            canbus_update();
-
-            if (cycle % 3 == 0) {
-                print_system_status();
-            }
+            budget_run_cycle(&main_cycle);  // Dashboard every third cycle
 
             sleep(2);
         }
     }
 
     printf("\n🛑 Shutting down ECU controller...\n");
+    guidance_stop();
+    pto_analysis_stop();
+    control_stop();
+    if (checkpoint_file != NULL && checkpoint_save(checkpoint_file)) {
+        printf("[CHECKPOINT] Saved %s (%zu bytes of state in %.0f us)\n", checkpoint_file,
+               checkpoint_get_state()->state_bytes, checkpoint_get_state()->save_us);
+    }
     engine_stop();
+    telemetry_shutdown();   // Persist unsent telemetry
+    coverage_sync();        // Flush the field coverage map
+    track_save(TRACK_DEFAULT_FILE);  // Store the day's GPS track
+    historian_shutdown();
+    sensors_record_close();  // Finish the raw sample recording
 
     return 0;
 }
@@ -0,0 +1,256 @@
+#include "prescription.h"
+#include "../telematics/telematics.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Tile prefetch distance, as a multiple of the look-ahead distance
+#define PREFETCH_FACTOR 2.0f
+
+typedef struct {
+    uint32_t tile;               // Tile index, PRESCRIPTION_NO_TILE when the entry is free
+    uint32_t last_used;
+    const uint16_t* cells;
+} CachedTile;
+
+static PrescriptionState rx_state = {0};
+static const uint8_t* map_base = NULL;
+static const uint32_t* directory = NULL;
+static const uint8_t* slots = NULL;
+static uint32_t slot_capacity = 0;     // Slots actually present in the file
+
+static CachedTile cache[PRESCRIPTION_CACHE_TILES];
+static int mru_entry = -1;
+static uint32_t cache_clock = 0;
+
+static void reset_cache(void) {
+    for (int i = 0; i < PRESCRIPTION_CACHE_TILES; i++) {
+        cache[i].tile = PRESCRIPTION_NO_TILE;
+        cache[i].last_used = 0;
+        cache[i].cells = NULL;
+    }
+    mru_entry = -1;
+    cache_clock = 0;
+    rx_state.resident_tiles = 0;
+}
+
+static float elapsed_us(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1e6f + (end->tv_nsec - start->tv_nsec) / 1e3f;
+}
+
+void prescription_init(void) {
+    printf("[PRESCRIPTION] Initializing variable-rate prescription maps\n");
+    memset(&rx_state, 0, sizeof(rx_state));
+    reset_cache();
+}
+
+bool prescription_load(const char* path) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    prescription_unload();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("[PRESCRIPTION] Cannot open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < PRESCRIPTION_HEADER_BYTES) {
+        printf("[PRESCRIPTION] %s is not a prescription map\n", path);
+        close(fd);
+        return false;
+    }
+
+    // Map the whole raster; nothing is read until a tile is touched
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("[PRESCRIPTION] Cannot map %s\n", path);
+        return false;
+    }
+    madvise(map, size, MADV_RANDOM);  // Tiles are touched by position, not in file order
+
+    const PrescriptionHeader* header = (const PrescriptionHeader*)map;
+    size_t tiles = (size_t)header->tiles_x * header->tiles_y;
+    size_t slots_offset = (PRESCRIPTION_HEADER_BYTES + tiles * sizeof(uint32_t) + 4095) & ~(size_t)4095;
+    if (header->magic != PRESCRIPTION_MAGIC || header->version != PRESCRIPTION_VERSION ||
+        header->cell_size_m <= 0.0f || tiles == 0 || slots_offset > size) {
+        printf("[PRESCRIPTION] %s is not a prescription map\n", path);
+        munmap(map, size);
+        return false;
+    }
+
+    map_base = (const uint8_t*)map;
+    directory = (const uint32_t*)(map_base + PRESCRIPTION_HEADER_BYTES);
+    slots = map_base + slots_offset;
+    slot_capacity = (uint32_t)((size - slots_offset) / PRESCRIPTION_TILE_BYTES);
+
+    rx_state.header = header;
+    rx_state.mapped_bytes = size;
+    rx_state.tile_count = 0;
+    for (size_t t = 0; t < tiles; t++) {
+        if (directory[t] < slot_capacity) rx_state.tile_count++;
+    }
+    telematics_to_local(header->origin_lat, header->origin_lon,
+                        &rx_state.origin_east_m, &rx_state.origin_north_m);
+    rx_state.loaded = true;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    rx_state.load_ms = elapsed_us(&start, &end) / 1000.0f;
+
+    float tile_m = PRESCRIPTION_TILE_CELLS * header->cell_size_m;
+    printf("[PRESCRIPTION] Loaded %.*s map %s: %ux%u tiles (%.1f x %.1f km, %u with data) in %.2f ms\n",
+           (int)sizeof(header->product), header->product, path, header->tiles_x, header->tiles_y,
+           header->tiles_x * tile_m / 1000.0f, header->tiles_y * tile_m / 1000.0f,
+           rx_state.tile_count, rx_state.load_ms);
+    return true;
+}
+
+void prescription_unload(void) {
+    if (map_base != NULL) {
+        munmap((void*)map_base, rx_state.mapped_bytes);
+    }
+    map_base = NULL;
+    directory = NULL;
+    slots = NULL;
+    slot_capacity = 0;
+    rx_state.loaded = false;
+    rx_state.header = NULL;
+    rx_state.mapped_bytes = 0;
+    reset_cache();
+}
+
+// Tile cells through the LRU cache; NULL for tiles without data. Evicted
+// tiles are dropped from memory so the resident set stays within the budget.
+static const uint16_t* cached_tile(uint32_t tile) {
+    if (mru_entry >= 0 && cache[mru_entry].tile == tile) {
+        rx_state.cache_hits++;
+        cache[mru_entry].last_used = ++cache_clock;
+        return cache[mru_entry].cells;
+    }
+
+    int victim = 0;
+    for (int i = 0; i < PRESCRIPTION_CACHE_TILES; i++) {
+        if (cache[i].tile == tile) {
+            rx_state.cache_hits++;
+            cache[i].last_used = ++cache_clock;
+            mru_entry = i;
+            return cache[i].cells;
+        }
+        if (cache[i].last_used < cache[victim].last_used) victim = i;
+    }
+
+    uint32_t slot = directory[tile];
+    if (slot >= slot_capacity) return NULL;
+
+    rx_state.cache_misses++;
+    if (cache[victim].tile != PRESCRIPTION_NO_TILE) {
+        madvise((void*)cache[victim].cells, PRESCRIPTION_TILE_BYTES, MADV_DONTNEED);
+        rx_state.evictions++;
+    } else {
+        rx_state.resident_tiles++;
+    }
+    cache[victim].tile = tile;
+    cache[victim].cells = (const uint16_t*)(slots + (size_t)slot * PRESCRIPTION_TILE_BYTES);
+    cache[victim].last_used = ++cache_clock;
+    mru_entry = victim;
+    return cache[victim].cells;
+}
+
+// Tile index under a field-frame position, or PRESCRIPTION_NO_TILE off the raster
+static uint32_t locate(float east_m, float north_m, uint32_t* cell) {
+    const PrescriptionHeader* header = rx_state.header;
+    float fx = (east_m - rx_state.origin_east_m) / header->cell_size_m;
+    float fy = (north_m - rx_state.origin_north_m) / header->cell_size_m;
+    if (fx < 0.0f || fy < 0.0f) return PRESCRIPTION_NO_TILE;
+
+    uint32_t cx = (uint32_t)fx, cy = (uint32_t)fy;
+    uint32_t tx = cx >> PRESCRIPTION_TILE_SHIFT, ty = cy >> PRESCRIPTION_TILE_SHIFT;
+    if (tx >= header->tiles_x || ty >= header->tiles_y) return PRESCRIPTION_NO_TILE;
+
+    *cell = ((cy & (PRESCRIPTION_TILE_CELLS - 1)) << PRESCRIPTION_TILE_SHIFT) |
+            (cx & (PRESCRIPTION_TILE_CELLS - 1));
+    return ty * header->tiles_x + tx;
+}
+
+bool prescription_rate_at(float east_m, float north_m, float* rate) {
+    if (!rx_state.loaded) return false;
+    rx_state.lookups++;
+
+    uint32_t cell;
+    uint32_t tile = locate(east_m, north_m, &cell);
+    if (tile == PRESCRIPTION_NO_TILE) return false;
+    const uint16_t* cells = cached_tile(tile);
+    if (cells == NULL || cells[cell] == PRESCRIPTION_NO_DATA) return false;
+
+    *rate = cells[cell] * rx_state.header->rate_scale;
+    return true;
+}
+
+bool prescription_rate_ahead(float lookahead_s, float* rate) {
+    if (!rx_state.loaded) return false;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    TelematicsState* telem = telematics_get_state();
+    float east, north;
+    telematics_to_local(telem->gps.latitude, telem->gps.longitude, &east, &north);
+
+    // Rate for the ground the implement will be over once the actuator responds
+    float heading = telem->gps.heading_deg * (float)M_PI / 180.0f;
+    float forward_x = sinf(heading), forward_y = cosf(heading);
+    float distance = telem->gps.speed_kmh / 3.6f * lookahead_s;
+    bool in_zone = prescription_rate_at(east + forward_x * distance, north + forward_y * distance, rate);
+
+    // Start paging in the tile beyond that so crossing a tile edge never stalls
+    uint32_t cell;
+    float ahead = distance * PREFETCH_FACTOR;
+    uint32_t next = locate(east + forward_x * ahead, north + forward_y * ahead, &cell);
+    if (next != PRESCRIPTION_NO_TILE && directory[next] < slot_capacity) {
+        madvise((void*)(slots + (size_t)directory[next] * PRESCRIPTION_TILE_BYTES),
+                PRESCRIPTION_TILE_BYTES, MADV_WILLNEED);
+    }
+
+    rx_state.last_in_zone = in_zone;
+    if (in_zone) rx_state.last_rate = *rate;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    rx_state.last_lookup_us = elapsed_us(&start, &end);
+    return in_zone;
+}
+
+void prescription_print_status(void) {
+    printf("\n=== PRESCRIPTION MAP ===\n");
+    if (!rx_state.loaded) {
+        printf("No prescription loaded - fixed application rates\n");
+        printf("========================\n\n");
+        return;
+    }
+    const PrescriptionHeader* header = rx_state.header;
+    printf("Product: %.*s (%.*s)\n", (int)sizeof(header->product), header->product,
+           (int)sizeof(header->units), header->units);
+    printf("Raster: %ux%u tiles, %u with data, %.1f MB mapped (loaded in %.2f ms)\n",
+           header->tiles_x, header->tiles_y, rx_state.tile_count,
+           rx_state.mapped_bytes / (1024.0 * 1024.0), rx_state.load_ms);
+    printf("Tile cache: %u/%d resident, %u hits, %u misses, %u evictions\n",
+           rx_state.resident_tiles, PRESCRIPTION_CACHE_TILES,
+           rx_state.cache_hits, rx_state.cache_misses, rx_state.evictions);
+    if (rx_state.last_in_zone) {
+        printf("Current rate: %.1f %.*s (%u lookups, last %.1f us)\n", rx_state.last_rate,
+               (int)sizeof(header->units), header->units, rx_state.lookups, rx_state.last_lookup_us);
+    } else {
+        printf("Current rate: outside prescription zones (%u lookups)\n", rx_state.lookups);
+    }
+    printf("========================\n\n");
+}
+
+PrescriptionState* prescription_get_state(void) {
+    return &rx_state;
+}
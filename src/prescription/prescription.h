@@ -0,0 +1,67 @@
+#ifndef PRESCRIPTION_H
+#define PRESCRIPTION_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PRESCRIPTION_MAGIC         0x314D5852u   // "RXM1"
+#define PRESCRIPTION_VERSION       1
+#define PRESCRIPTION_TILE_SHIFT    6             // 64 x 64 cells per tile
+#define PRESCRIPTION_TILE_CELLS    (1 << PRESCRIPTION_TILE_SHIFT)
+#define PRESCRIPTION_TILE_BYTES    (PRESCRIPTION_TILE_CELLS * PRESCRIPTION_TILE_CELLS * 2)
+#define PRESCRIPTION_HEADER_BYTES  4096
+#define PRESCRIPTION_NO_TILE       0xFFFFFFFFu   // Directory entry for a tile with no data
+#define PRESCRIPTION_NO_DATA       0xFFFF        // Cell value outside every zone
+#define PRESCRIPTION_CACHE_TILES   16            // Resident tile budget (128 KB)
+
+// Raster file (little-endian):
+//   PrescriptionHeader, padded to PRESCRIPTION_HEADER_BYTES
+//   u32 tile directory[tiles_y][tiles_x] - tile slot or PRESCRIPTION_NO_TILE,
+//       padded to a 4096-byte boundary
+//   tile slots, PRESCRIPTION_TILE_BYTES each: u16 cells, row-major, south row first
+// A cell's rate is raw * rate_scale in the header's units.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    double origin_lat;           // South-west corner of the raster
+    double origin_lon;
+    float cell_size_m;
+    float rate_scale;
+    char product[24];            // e.g. "Corn seed", "Glyphosate"
+    char units[16];              // e.g. "seeds/ha", "L/ha"
+} PrescriptionHeader;
+
+// Variable-rate prescription map - the raster stays memory-mapped; only the
+// tiles the tractor is working near are kept resident, in an LRU cache
+typedef struct {
+    bool loaded;
+    const PrescriptionHeader* header;  // Points into the mapping
+    size_t mapped_bytes;
+    uint32_t tile_count;         // Tiles with data
+    float origin_east_m;         // Raster corner in the telematics field frame
+    float origin_north_m;
+    float last_rate;             // Last rate returned by the look-ahead query
+    bool last_in_zone;
+    uint32_t lookups;
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t evictions;
+    uint32_t resident_tiles;
+    float load_ms;
+    float last_lookup_us;
+} PrescriptionState;
+
+// Dependencies: Telematics (GPS, field frame)
+void prescription_init(void);
+bool prescription_load(const char* path);
+void prescription_unload(void);
+bool prescription_rate_at(float east_m, float north_m, float* rate);
+bool prescription_rate_ahead(float lookahead_s, float* rate);
+void prescription_print_status(void);
+PrescriptionState* prescription_get_state(void);
+
+#endif // PRESCRIPTION_H
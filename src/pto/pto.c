@@ -1,26 +1,66 @@
 #include "pto.h"
+#include "pto_analysis.h"
+#include "../control/control_loops.h"
 #include "../engine/engine_control.h"
+#include "../hydraulics/hydraulics.h"
 #include "../canbus/canbus.h"
+#include "can_messages.h"
 #include "../diagnostics/diagnostics.h"
+#include "../geofence/geofence.h"
+#include "../common/rng.h"
+#include "../common/change.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
-#include <stdlib.h>
 #include <math.h>
 
 static PTOState pto_state = {
     .status = PTO_DISENGAGED,
     .target_speed = PTO_SPEED_540,
     .current_rpm = 0,
-    .load_percent = 0.0,
-    .torque_nm = 0.0,
+    .load_percent = REAL(0),
+    .torque_nm = REAL(0),
     .overload_detected = false,
-    .slip_percent = 0.0
+    .slip_percent = REAL(0)
 };
 
+// Clutch pack fill flow while engaging, then lube and holding flow
+#define CLUTCH_FILL_GPM     3.0
+#define CLUTCH_HOLD_GPM     0.5
+#define CLUTCH_PSI          250
+
+static Rng pto_rng;
+static uint32_t analysis_sequence;  // Last torque analysis block acted on
+static ChangeTracker update_tracker;
+static uint32_t command_generation; // Engage and disengage commands
+static uint32_t turning_cycles;     // Counts while the shaft turns, an input that always moves
+
+static void command_changed(void) {
+    command_generation++;
+    change_publish(&pto_state.generation, true);
+}
+
 void pto_init(void) {
     printf("[PTO] Initializing PTO module\n");
     pto_state.status = PTO_DISENGAGED;
     pto_state.current_rpm = 0;
-    pto_state.load_percent = 0.0;
+    pto_state.load_percent = REAL(0);
+    rng_seed(&pto_rng, rng_get_seed(), MODULE_PTO);
+    analysis_sequence = 0;
+    change_tracker_init(&update_tracker, "PTO");
+    CHECKPOINT_VAR("pto", pto_state);
+    CHECKPOINT_VAR("pto", pto_rng);
+    CHECKPOINT_VAR("pto", analysis_sequence);
+    CHECKPOINT_VAR_FROM("pto", update_tracker, seen);
+    CHECKPOINT_VAR("pto", command_generation);
+    CHECKPOINT_VAR("pto", turning_cycles);
+    pto_analysis_init();
+}
+
+static void send_command(bool engage, uint16_t speed) {
+    CanPtoCommand command = { .engage = engage, .target_speed = speed };
+    uint8_t data[CAN_DLC_PTO_COMMAND];
+    can_pack_pto_command(data, &command);
+    canbus_send_message(CAN_ID_PTO_COMMAND, data, sizeof(data));
 }
 
 void pto_engage(PTOSpeed speed) {
@@ -28,71 +68,120 @@ void pto_engage(PTOSpeed speed) {
 
     if (engine->current_rpm < 800) {
         printf("[PTO] Cannot engage - engine RPM too low\n");
-        diagnostics_report_fault(SPN_PTO_ENGAGEMENT, FMI_MECHANICAL_FAULT, "PTO", "PTO engagement failed - engine RPM below minimum threshold");
+        diagnostics_report_fault(FAULT_PTO_ENGAGE_RPM_LOW);
         return;
     }
 
     pto_state.status = PTO_ENGAGING;
     pto_state.target_speed = speed;
+    command_changed();
     printf("[PTO] Engaging PTO at %d RPM target\n", speed);
 
-    // Send CAN message
-    uint8_t data[8] = {0x01, (uint8_t)(speed >> 8), (uint8_t)(speed & 0xFF), 0, 0, 0, 0, 0};
-    canbus_send_message(0x220, data, 8);
+    send_command(true, (uint16_t)speed);
 }
 
 void pto_disengage(void) {
     printf("[PTO] Disengaging PTO\n");
     pto_state.status = PTO_DISENGAGED;
     pto_state.current_rpm = 0;
+    command_changed();
 
-    // Send CAN message
-    uint8_t data[8] = {0x00, 0, 0, 0, 0, 0, 0, 0};
-    canbus_send_message(0x220, data, 8);
+    send_command(false, 0);
 }
 
 void pto_update(void) {
     EngineState* engine = engine_get_state();
 
+    // Spin-up and implement load move a turning shaft every cycle; an idle
+    // PTO only needs a pass when the engine, its clutch oil or a command changed
+    if (pto_state.status == PTO_ENGAGING || pto_state.status == PTO_ENGAGED) {
+        turning_cycles++;
+    }
+    const uint32_t inputs[] = { engine->generation, hydraulics_get_state()->generation,
+                                command_generation, turning_cycles };
+    if (!change_tracker_update(&update_tracker, inputs, 4)) {
+        return;
+    }
+    PTOStatus previous_status = pto_state.status;
+    int previous_rpm = pto_state.current_rpm;
+    real_t previous_torque = pto_state.torque_nm;
+
     if (pto_state.status == PTO_ENGAGING) {
         // Simulate PTO spin-up
         if (pto_state.current_rpm < pto_state.target_speed) {
-            pto_state.current_rpm += 50; // Gradual engagement
-            pto_state.slip_percent = ((float)(pto_state.target_speed - pto_state.current_rpm) /
-                                     pto_state.target_speed) * 100.0;
+            // Gradual engagement, slower when the clutch is short of oil
+            pto_state.current_rpm += real_to_int(real_mul(REAL(50), hydraulics_get_share(HYD_CONSUMER_PTO_CLUTCH)));
+            pto_state.slip_percent = real_mul(real_div(real_from_int(pto_state.target_speed - pto_state.current_rpm),
+                                                       real_from_int(pto_state.target_speed)), REAL(100));
         } else {
             pto_state.status = PTO_ENGAGED;
-            pto_state.slip_percent = 0.0;
+            pto_state.slip_percent = REAL(0);
             printf("[PTO] PTO fully engaged at %d RPM\n", pto_state.current_rpm);
         }
     }
 
+    real_t clutch_gpm = pto_state.status == PTO_ENGAGING ? REAL(CLUTCH_FILL_GPM) :
+                        pto_state.status == PTO_ENGAGED ? REAL(CLUTCH_HOLD_GPM) : REAL(0);
+    hydraulics_set_demand(HYD_CONSUMER_PTO_CLUTCH, clutch_gpm, REAL(CLUTCH_PSI));
+
+    if (pto_state.status == PTO_ENGAGED &&
+        (geofence_get_state()->exited_mask & GEOFENCE_MASK(GEOFENCE_FIELD_BOUNDARY))) {
+        printf("[PTO] Left field boundary\n");
+        pto_disengage();
+    }
+
     if (pto_state.status == PTO_ENGAGED) {
         // PTO speed should track engine RPM ratio
-        float engine_ratio = (float)engine->current_rpm / 2100.0; // 2100 is nominal engine RPM
-        pto_state.current_rpm = (int)(pto_state.target_speed * engine_ratio);
+        real_t engine_ratio = real_div(real_from_int(engine->current_rpm), REAL(2100)); // 2100 is nominal engine RPM
+        pto_state.current_rpm = real_to_int(real_mul(real_from_int(pto_state.target_speed), engine_ratio));
 
         // Simulate load based on implement work
-        pto_state.load_percent = 45.0 + (rand() % 30); // 45-75% load
-        pto_state.torque_nm = (pto_state.load_percent / 100.0) * 850.0; // Max 850 Nm
+        pto_state.load_percent = real_from_int(45 + (int32_t)rng_below(&pto_rng, 30)); // 45-75% load
+        pto_state.torque_nm = real_mul(real_div(pto_state.load_percent, REAL(100)), REAL(850)); // Max 850 Nm
+
+        pto_analysis_set_operating_point(true, pto_state.current_rpm, real_to_float(pto_state.torque_nm));
+        control_set_pto_speed(true, pto_state.target_speed, pto_state.current_rpm);
 
         // Check for overload
-        if (pto_state.load_percent > 90.0) {
+        if (pto_state.load_percent > REAL(90)) {
             pto_state.overload_detected = true;
-            diagnostics_report_fault(SPN_PTO_SHAFT_SPEED, FMI_DATA_ABOVE_NORMAL, "PTO", "PTO overload detected - shaft load exceeds maximum rating");
+            diagnostics_report_fault(FAULT_PTO_OVERLOAD);
             pto_state.status = PTO_ERROR;
         }
 
-        // Send telemetry via CAN
-        uint8_t data[8] = {
-            (uint8_t)(pto_state.current_rpm >> 8),
-            (uint8_t)(pto_state.current_rpm & 0xFF),
-            (uint8_t)pto_state.load_percent,
-            (uint8_t)(pto_state.torque_nm / 10),
-            0, 0, 0, 0
+        // Shock and vibration come from the 1 kHz torque analysis; act on
+        // each published block once, and on each peak since the last check
+        PtoAnalysisState analysis;
+        pto_analysis_take(&analysis);
+        if (analysis.valid && analysis.sequence != analysis_sequence) {
+            analysis_sequence = analysis.sequence;
+            if (analysis.unchecked_peak_nm > PTO_SHEAR_BOLT_NM) {
+                pto_state.overload_detected = true;
+                diagnostics_report_fault(FAULT_PTO_SHOCK_LOAD);
+                pto_state.status = PTO_ERROR;
+            }
+            if (analysis.spectrum_valid && analysis.dominant_nm > PTO_VIBRATION_LIMIT_NM) {
+                diagnostics_report_fault(FAULT_PTO_DRIVELINE_VIBRATION);
+            }
+        }
+
+        // Send telemetry via CAN with the last analysis block's peak and crest factor
+        CanPtoStatus status = {
+            .shaft_speed = (uint16_t)pto_state.current_rpm,
+            .load = real_to_float(pto_state.load_percent),
+            .torque = real_to_float(pto_state.torque_nm),
+            .block_peak = analysis.valid ? analysis.peak_nm : 0.0f,
+            .crest_factor = analysis.valid ? analysis.crest_factor : 0.0f,
         };
-        canbus_send_message(0x221, data, 8);
+        uint8_t data[CAN_DLC_PTO_STATUS];
+        can_pack_pto_status(data, &status);
+        canbus_send_message(CAN_ID_PTO_STATUS, data, sizeof(data));
+    } else {
+        pto_analysis_set_operating_point(false, 0, 0.0f);
+        control_set_pto_speed(false, 0, 0);
     }
+    change_publish(&pto_state.generation, pto_state.status != previous_status ||
+                   pto_state.current_rpm != previous_rpm || pto_state.torque_nm != previous_torque);
 }
 
 PTOState* pto_get_state(void) {
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "../common/fixed.h"
 
 // PTO standard speeds for agricultural equipment
 typedef enum {
@@ -21,10 +22,11 @@ typedef struct {
     PTOStatus status;
     PTOSpeed target_speed;
     int current_rpm;
-    float load_percent;      // Load on PTO (0-100%)
-    float torque_nm;         // Torque in Newton-meters
+    real_t load_percent;      // Load on PTO (0-100%)
+    real_t torque_nm;         // Torque in Newton-meters
     bool overload_detected;
-    float slip_percent;      // Clutch slip
+    real_t slip_percent;      // Clutch slip
+    uint32_t generation;      // Bumped when status, shaft speed or torque changes
 } PTOState;
 
 // PTO control functions
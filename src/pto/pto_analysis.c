@@ -0,0 +1,389 @@
+#include "pto_analysis.h"
+#include "../common/fft.h"
+#include "../common/rng.h"
+#include "../common/checkpoint.h"
+#include "../common/types.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#define SAMPLE_PERIOD_NS   (1000000000L / PTO_SAMPLE_RATE_HZ)
+#define ANALYSIS_PERIOD_NS (1000000000L / (PTO_SAMPLE_RATE_HZ / PTO_STATS_BLOCK))
+#define RING_MASK          (PTO_RING_SAMPLES - 1)
+#define SAMPLER_RNG_STREAM (MODULE_COUNT + MODULE_PTO)
+
+// Simulated torque sensor: load plus shaft-order ripple and rock strikes
+#define LOAD_LAG           0.003f  // Per-sample first-order lag (~0.3 s)
+#define FIRST_ORDER_SHARE  0.03f   // Residual unbalance
+#define SECOND_ORDER_SHARE 0.05f   // U-joint working angle
+#define NOISE_NM           15.0f
+#define SHOCK_ONE_IN       20000   // Per sample: one strike every ~20 s
+#define SHOCK_MIN_NM       300.0f
+#define SHOCK_SPAN_NM      600.0f
+#define SHOCK_DECAY        0.9f    // Per sample, dies out in ~30 ms
+
+static PtoAnalysisState analysis_state = {0};
+
+// Snapshot, counters and the running flag; held only for copies
+static pthread_mutex_t analysis_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t sampler_thread;
+static pthread_t analysis_thread;
+
+static pthread_mutex_t operating_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct {
+    bool engaged;
+    float shaft_hz;
+    float torque_nm;
+} operating_point;
+
+// Single-producer single-consumer ring: the sampler owns ring_head, the
+// analysis thread owns ring_tail
+static float ring[PTO_RING_SAMPLES];
+static uint32_t ring_head;
+static uint32_t ring_tail;
+static uint32_t ring_dropped;
+static uint32_t sampler_overruns;
+
+// Sampler-only state: the shaft model
+static struct {
+    Rng rng;
+    float load_nm;
+    float shaft_phase;
+    float shock_nm;
+} sampler;
+
+// Analysis-only state: the FFT window and the running block statistics
+static struct {
+    float history[PTO_FFT_SIZE];
+    uint32_t history_pos;
+    uint32_t history_fill;
+    bool in_shock;
+    uint32_t block_count, blocks, shocks;
+    float block_sum, block_sum_sq, block_peak;
+} analyser;
+
+// Analysis scratch, rebuilt by init
+static FftPlan fft_plan;
+static float hann[PTO_FFT_SIZE];
+static float fft_re[PTO_FFT_SIZE];
+static float fft_im[PTO_FFT_SIZE];
+
+static float elapsed_us(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1e6f + (end->tv_nsec - start->tv_nsec) / 1e3f;
+}
+
+static void advance(struct timespec* next, long period_ns) {
+    next->tv_nsec += period_ns;
+    if (next->tv_nsec >= 1000000000L) {
+        next->tv_nsec -= 1000000000L;
+        next->tv_sec++;
+    }
+}
+
+static bool is_running(void) {
+    pthread_mutex_lock(&analysis_lock);
+    bool running = analysis_state.running;
+    pthread_mutex_unlock(&analysis_lock);
+    return running;
+}
+
+void pto_analysis_init(void) {
+    printf("[PTO] Initializing torque analysis (%d Hz, %d-point FFT)\n", PTO_SAMPLE_RATE_HZ, PTO_FFT_SIZE);
+    memset(&analysis_state, 0, sizeof(analysis_state));
+    memset(&operating_point, 0, sizeof(operating_point));
+    ring_head = ring_tail = 0;
+    ring_dropped = sampler_overruns = 0;
+    memset(&sampler, 0, sizeof(sampler));
+    memset(&analyser, 0, sizeof(analyser));
+    rng_seed(&sampler.rng, rng_get_seed(), SAMPLER_RNG_STREAM);
+
+    // Shaft model and analysis window; the sample ring restarts empty
+    CHECKPOINT_VAR("pto_analysis", analysis_state);
+    CHECKPOINT_VAR("pto_analysis", operating_point);
+    CHECKPOINT_VAR("pto_analysis", sampler);
+    CHECKPOINT_VAR("pto_analysis", analyser);
+
+    if (fft_plan.size != PTO_FFT_SIZE && !fft_plan_init(&fft_plan, PTO_FFT_SIZE)) {
+        printf("[PTO] Cannot allocate the FFT plan\n");
+    }
+    for (int i = 0; i < PTO_FFT_SIZE; i++) {
+        hann[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / PTO_FFT_SIZE);
+    }
+}
+
+void pto_analysis_set_operating_point(bool engaged, int shaft_rpm, float torque_nm) {
+    pthread_mutex_lock(&operating_lock);
+    operating_point.engaged = engaged;
+    operating_point.shaft_hz = engaged ? shaft_rpm / 60.0f : 0.0f;
+    operating_point.torque_nm = engaged ? torque_nm : 0.0f;
+    pthread_mutex_unlock(&operating_lock);
+}
+
+// One reading of the (simulated) strain-gauge torque sensor
+static float read_torque_sensor(void) {
+    pthread_mutex_lock(&operating_lock);
+    bool engaged = operating_point.engaged;
+    float shaft_hz = operating_point.shaft_hz;
+    float target_nm = operating_point.torque_nm;
+    pthread_mutex_unlock(&operating_lock);
+
+    sampler.load_nm += (target_nm - sampler.load_nm) * LOAD_LAG;
+    if (!engaged) {
+        sampler.shock_nm = 0.0f;
+        return sampler.load_nm;
+    }
+
+    sampler.shaft_phase += 2.0f * (float)M_PI * shaft_hz / PTO_SAMPLE_RATE_HZ;
+    if (sampler.shaft_phase > 2.0f * (float)M_PI) sampler.shaft_phase -= 2.0f * (float)M_PI;
+
+    if (rng_below(&sampler.rng, SHOCK_ONE_IN) == 0) {
+        sampler.shock_nm += SHOCK_MIN_NM + SHOCK_SPAN_NM * (float)rng_uniform(&sampler.rng);
+    }
+    sampler.shock_nm *= SHOCK_DECAY;
+
+    // Sum of two uniforms: triangular noise, cheap and bounded
+    float noise = NOISE_NM * (float)(rng_uniform(&sampler.rng) + rng_uniform(&sampler.rng) - 1.0);
+    float ripple = FIRST_ORDER_SHARE * sinf(sampler.shaft_phase) + SECOND_ORDER_SHARE * sinf(2.0f * sampler.shaft_phase);
+    return sampler.load_nm * (1.0f + ripple) + sampler.shock_nm + noise;
+}
+
+// Sampler side: one reading into the ring, dropped if the ring is full
+static void sample_torque(void) {
+    float torque = read_torque_sensor();
+    uint32_t head = ring_head;
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    if (head - tail == PTO_RING_SAMPLES) {
+        __atomic_fetch_add(&ring_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    ring[head & RING_MASK] = torque;
+    __atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void* sampler_main(void* arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (uint32_t tick = 0;; tick++) {
+        advance(&next, SAMPLE_PERIOD_NS);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        // Checked every 10 ms rather than every sample
+        if (tick % 10 == 0 && !is_running()) break;
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (elapsed_us(&next, &now) > SAMPLE_PERIOD_NS / 1000.0f) {
+            __atomic_fetch_add(&sampler_overruns, 1, __ATOMIC_RELAXED);
+            next = now;
+        }
+
+        sample_torque();
+    }
+    return NULL;
+}
+
+// Hann-windowed spectrum of the last PTO_FFT_SIZE samples
+static void analyse_spectrum(float shaft_hz) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    float mean = 0.0f;
+    for (int i = 0; i < PTO_FFT_SIZE; i++) mean += analyser.history[i];
+    mean /= PTO_FFT_SIZE;
+
+    // Unroll the circular history oldest-first under the window
+    for (int i = 0; i < PTO_FFT_SIZE; i++) {
+        fft_re[i] = (analyser.history[(analyser.history_pos + i) % PTO_FFT_SIZE] - mean) * hann[i];
+        fft_im[i] = 0.0f;
+    }
+    fft_forward(&fft_plan, fft_re, fft_im);
+
+    int first_bin = (int)ceilf(PTO_MIN_LINE_HZ * PTO_FFT_SIZE / PTO_SAMPLE_RATE_HZ);
+    int best_bin = first_bin;
+    float best_power = 0.0f;
+    for (int k = first_bin; k < PTO_FFT_SIZE / 2; k++) {
+        float power = fft_re[k] * fft_re[k] + fft_im[k] * fft_im[k];
+        if (power > best_power) {
+            best_power = power;
+            best_bin = k;
+        }
+    }
+    // Single-sided amplitude; the Hann window halves the coherent gain
+    float amplitude = 4.0f * sqrtf(best_power) / PTO_FFT_SIZE;
+    float line_hz = (float)best_bin * PTO_SAMPLE_RATE_HZ / PTO_FFT_SIZE;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    float fft_us = elapsed_us(&start, &end);
+
+    pthread_mutex_lock(&analysis_lock);
+    analysis_state.spectrum_valid = true;
+    analysis_state.dominant_hz = line_hz;
+    analysis_state.dominant_nm = amplitude;
+    analysis_state.dominant_order = shaft_hz > 0.0f ? line_hz / shaft_hz : 0.0f;
+    analysis_state.spectra++;
+    analysis_state.last_fft_us = fft_us;
+    if (fft_us > analysis_state.max_fft_us) analysis_state.max_fft_us = fft_us;
+    pthread_mutex_unlock(&analysis_lock);
+}
+
+// Analysis side: everything the sampler has queued, block by block
+static void analyse_queued(void) {
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring_tail;
+    for (; tail != head; tail++) {
+        float torque = ring[tail & RING_MASK];
+        analyser.history[analyser.history_pos] = torque;
+        analyser.history_pos = (analyser.history_pos + 1) % PTO_FFT_SIZE;
+        if (analyser.history_fill < PTO_FFT_SIZE) analyser.history_fill++;
+
+        float magnitude = fabsf(torque);
+        analyser.block_sum += torque;
+        analyser.block_sum_sq += torque * torque;
+        if (magnitude > analyser.block_peak) analyser.block_peak = magnitude;
+
+        // Hysteresis so one strike counts once
+        if (!analyser.in_shock && magnitude > PTO_SHOCK_NM) {
+            analyser.in_shock = true;
+            analyser.shocks++;
+        } else if (analyser.in_shock && magnitude < 0.8f * PTO_SHOCK_NM) {
+            analyser.in_shock = false;
+        }
+        if (++analyser.block_count < PTO_STATS_BLOCK) continue;
+
+        float rms = sqrtf(analyser.block_sum_sq / PTO_STATS_BLOCK);
+        pthread_mutex_lock(&operating_lock);
+        bool engaged = operating_point.engaged;
+        float shaft_hz = operating_point.shaft_hz;
+        pthread_mutex_unlock(&operating_lock);
+
+        pthread_mutex_lock(&analysis_lock);
+        analysis_state.valid = true;
+        analysis_state.sequence++;
+        analysis_state.shaft_hz = shaft_hz;
+        analysis_state.mean_nm = analyser.block_sum / PTO_STATS_BLOCK;
+        analysis_state.rms_nm = rms;
+        analysis_state.peak_nm = analyser.block_peak;
+        analysis_state.crest_factor = rms > 1.0f ? analyser.block_peak / rms : 0.0f;
+        analysis_state.shock_count = analyser.shocks;
+        if (analyser.block_peak > analysis_state.max_peak_nm) analysis_state.max_peak_nm = analyser.block_peak;
+        if (analyser.block_peak > analysis_state.unchecked_peak_nm) analysis_state.unchecked_peak_nm = analyser.block_peak;
+        if (!engaged) analysis_state.spectrum_valid = false;
+        pthread_mutex_unlock(&analysis_lock);
+
+        analyser.block_count = 0;
+        analyser.block_sum = analyser.block_sum_sq = analyser.block_peak = 0.0f;
+        if (++analyser.blocks % PTO_FFT_DIVIDER == 0 && engaged &&
+            analyser.history_fill == PTO_FFT_SIZE && fft_plan.size == PTO_FFT_SIZE) {
+            analyse_spectrum(shaft_hz);
+        }
+    }
+    __atomic_store_n(&ring_tail, tail, __ATOMIC_RELEASE);
+}
+
+static void* analysis_main(void* arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (;;) {
+        advance(&next, ANALYSIS_PERIOD_NS);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        if (!is_running()) break;
+        analyse_queued();
+    }
+    return NULL;
+}
+
+// Lockstep: the same sampling and analysis on simulated time, on the
+// caller's thread, with the analysis keeping pace block by block
+void pto_analysis_run_for(float seconds) {
+    long samples = lroundf(seconds * PTO_SAMPLE_RATE_HZ);
+    for (long i = 0; i < samples; i++) {
+        sample_torque();
+        if ((i + 1) % PTO_STATS_BLOCK == 0) analyse_queued();
+    }
+    analyse_queued();
+}
+
+bool pto_analysis_start(void) {
+    pthread_mutex_lock(&analysis_lock);
+    bool already = analysis_state.running;
+    analysis_state.running = true;
+    pthread_mutex_unlock(&analysis_lock);
+    if (already) return true;
+
+    if (pthread_create(&sampler_thread, NULL, sampler_main, NULL) != 0) {
+        printf("[PTO] Cannot start the torque sampler\n");
+        pthread_mutex_lock(&analysis_lock);
+        analysis_state.running = false;
+        pthread_mutex_unlock(&analysis_lock);
+        return false;
+    }
+    if (pthread_create(&analysis_thread, NULL, analysis_main, NULL) != 0) {
+        printf("[PTO] Cannot start the torque analysis worker\n");
+        pthread_mutex_lock(&analysis_lock);
+        analysis_state.running = false;
+        pthread_mutex_unlock(&analysis_lock);
+        pthread_join(sampler_thread, NULL);
+        return false;
+    }
+    printf("[PTO] Torque sampling at %d Hz, spectrum every %d ms\n",
+           PTO_SAMPLE_RATE_HZ, PTO_FFT_DIVIDER * PTO_STATS_BLOCK * 1000 / PTO_SAMPLE_RATE_HZ);
+    return true;
+}
+
+void pto_analysis_stop(void) {
+    pthread_mutex_lock(&analysis_lock);
+    bool was_running = analysis_state.running;
+    analysis_state.running = false;
+    pthread_mutex_unlock(&analysis_lock);
+    if (was_running) {
+        pthread_join(sampler_thread, NULL);
+        pthread_join(analysis_thread, NULL);
+    }
+}
+
+static void snapshot(PtoAnalysisState* out, bool take) {
+    pthread_mutex_lock(&analysis_lock);
+    *out = analysis_state;
+    if (take) analysis_state.unchecked_peak_nm = 0.0f;
+    pthread_mutex_unlock(&analysis_lock);
+    out->samples = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    out->dropped = __atomic_load_n(&ring_dropped, __ATOMIC_RELAXED);
+    out->overruns = __atomic_load_n(&sampler_overruns, __ATOMIC_RELAXED);
+}
+
+void pto_analysis_get(PtoAnalysisState* out) {
+    snapshot(out, false);
+}
+
+void pto_analysis_take(PtoAnalysisState* out) {
+    snapshot(out, true);
+}
+
+void pto_analysis_print_status(void) {
+    PtoAnalysisState s;
+    pto_analysis_get(&s);
+
+    printf("\n=== PTO TORQUE ANALYSIS ===\n");
+    if (!s.valid) {
+        printf("No torque samples analysed\n");
+    } else {
+        printf("Last block: mean %.0f Nm, RMS %.0f Nm, peak %.0f Nm, crest factor %.2f\n",
+               s.mean_nm, s.rms_nm, s.peak_nm, s.crest_factor);
+        printf("Max peak %.0f Nm (shear bolt %.0f Nm), %u shock loads above %.0f Nm\n",
+               s.max_peak_nm, PTO_SHEAR_BOLT_NM, s.shock_count, PTO_SHOCK_NM);
+        if (s.spectrum_valid) {
+            printf("Dominant line: %.1f Hz, %.1f Nm (order %.1f of %.1f Hz shaft)\n",
+                   s.dominant_hz, s.dominant_nm, s.dominant_order, s.shaft_hz);
+        }
+    }
+    printf("Samples: %llu at %d Hz, %u dropped, %u overruns\n",
+           (unsigned long long)s.samples, PTO_SAMPLE_RATE_HZ, s.dropped, s.overruns);
+    printf("Spectra: %u, FFT last %.1f us / max %.1f us\n", s.spectra, s.last_fft_us, s.max_fft_us);
+    printf("===========================\n\n");
+}
@@ -0,0 +1,58 @@
+#ifndef PTO_ANALYSIS_H
+#define PTO_ANALYSIS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PTO_SAMPLE_RATE_HZ      1000
+#define PTO_RING_SAMPLES        4096    // Power of two; ~4 s of slack for the analysis thread
+#define PTO_STATS_BLOCK         100     // Samples per statistics block (10 Hz)
+#define PTO_FFT_SIZE            1024    // ~1 s window, ~1 Hz resolution
+#define PTO_FFT_DIVIDER         5       // One spectrum every 5 blocks
+#define PTO_MIN_LINE_HZ         2.0f    // Lines below this are load changes, not vibration
+#define PTO_SHOCK_NM            1000.0f // A sample above this starts a shock event
+#define PTO_SHEAR_BOLT_NM       1700.0f // Shear bolt rating at the PTO stub
+#define PTO_VIBRATION_LIMIT_NM  120.0f  // Largest acceptable spectral line amplitude
+
+// PTO torque analysis - a sampler thread reads shaft torque at 1 kHz into a
+// lock-free ring; an analysis thread drains it into block statistics and a
+// windowed spectrum. The control loop only reads the published snapshot, so
+// a slow analysis never delays it (the sampler drops samples instead).
+typedef struct {
+    bool running;
+    bool valid;                 // At least one block has been analysed
+    uint32_t sequence;          // Incremented for every published block
+    float shaft_hz;             // From the operating point
+    float mean_nm;              // Last block
+    float rms_nm;
+    float peak_nm;
+    float crest_factor;         // peak / RMS
+    float max_peak_nm;          // Since start
+    float unchecked_peak_nm;    // Largest block peak since the last pto_analysis_take
+    uint32_t shock_count;
+    bool spectrum_valid;
+    float dominant_hz;          // Largest line above PTO_MIN_LINE_HZ
+    float dominant_nm;          // Its amplitude
+    float dominant_order;       // Multiple of shaft speed (2 = U-joint working angle)
+    uint64_t samples;
+    uint32_t dropped;           // Ring full - the analysis thread fell behind
+    uint32_t overruns;          // Sampler missed a whole period
+    uint32_t spectra;
+    float last_fft_us;
+    float max_fft_us;
+} PtoAnalysisState;
+
+// Dependencies: none at runtime; PTO feeds the operating point and reads
+// the snapshot back for its shock and vibration faults
+void pto_analysis_init(void);
+bool pto_analysis_start(void);
+void pto_analysis_stop(void);
+void pto_analysis_run_for(float seconds);   // Sample and analyse synchronously, for lockstep runs
+void pto_analysis_set_operating_point(bool engaged, int shaft_rpm, float torque_nm);
+void pto_analysis_get(PtoAnalysisState* out);
+// Snapshot for the PTO fault checks; restarts unchecked_peak_nm so every
+// shock is judged once against the shear-bolt rating
+void pto_analysis_take(PtoAnalysisState* out);
+void pto_analysis_print_status(void);
+
+#endif // PTO_ANALYSIS_H
@@ -0,0 +1,561 @@
+#include "sensors.h"
+#include "../engine/engine_control.h"
+#include "../hydraulics/hydraulics.h"
+#include "../thermal/thermal.h"
+#include "../diagnostics/diagnostics.h"
+#include "../common/rng.h"
+#include "../common/checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define LANES              ((SENSOR_CHANNEL_COUNT + 3) & ~3)   // Scan row, padded to whole vectors
+#define GROUPS             (LANES / 4)
+#define SCAN_BUFFER        (SENSOR_MAX_BLOCK * SENSOR_OVERSAMPLE)
+#define COUNTS_PER_VOLT    (SENSOR_ADC_MAX / 5.0f)
+#define SHORTED_COUNTS     (0.25f * COUNTS_PER_VOLT)
+#define OPEN_COUNTS        (4.75f * COUNTS_PER_VOLT)
+#define MIN_STUCK_SAMPLES  16      // Shorter blocks say nothing about a frozen input
+#define SENSOR_RNG_STREAM  (MODULE_COUNT + MODULE_DIAGNOSTICS)
+
+// Simulated front end: triangular noise of a few LSB on every conversion,
+// and a rare ignition spike on one channel
+#define SPIKE_ONE_IN       8192    // Per scan, background
+#define INJECTED_ONE_IN    64      // Per scan and channel with SENSOR_FAULT_SPIKES
+#define SPIKE_MIN_COUNTS   400
+#define SHORTED_CODE       12
+#define OPEN_CODE          4088
+
+_Static_assert(SENSOR_MEDIAN_TAPS == 5, "the median network is written for five taps");
+_Static_assert(SENSOR_CHANNEL_COUNT <= 32, "spike hits are a 32-bit channel mask");
+
+typedef float v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+typedef uint32_t v4u __attribute__((vector_size(16)));
+typedef uint16_t v4h __attribute__((vector_size(8)));
+
+static inline v4u load4h(const uint16_t* p) {
+    v4h v;
+    memcpy(&v, p, sizeof(v));
+    return __builtin_convertvector(v, v4u);
+}
+
+static inline v4f min4(v4f a, v4f b) {
+    v4i lt = a < b;
+    return (v4f)((lt & (v4i)a) | (~lt & (v4i)b));
+}
+
+static inline v4f max4(v4f a, v4f b) {
+    v4i gt = a > b;
+    return (v4f)((gt & (v4i)a) | (~gt & (v4i)b));
+}
+
+// Median of five without sorting: the median of e and the two middle
+// values of the pairs (a, b) and (c, d)
+static inline v4f median5(v4f a, v4f b, v4f c, v4f d, v4f e) {
+    v4f f = max4(min4(a, b), min4(c, d));
+    v4f g = min4(max4(a, b), max4(c, d));
+    return max4(min4(e, f), min4(max4(e, f), g));
+}
+
+typedef struct {
+    const char* label;
+    const char* unit;
+    float low;                  // At 0.5 V
+    float high;                 // At 4.5 V
+    uint16_t tau_ms;
+    FaultId fault_low;
+    FaultId fault_high;
+    FaultId fault_stuck;
+} ChannelDefinition;
+
+#define SENSOR_CHANNEL_DEFINITION(name, label, unit, low, high, tau_ms) \
+    [SENSOR_##name] = { label, unit, low, high, tau_ms, \
+                        FAULT_SENSOR_##name##_LOW, FAULT_SENSOR_##name##_HIGH, FAULT_SENSOR_##name##_STUCK },
+static const ChannelDefinition definitions[SENSOR_CHANNEL_COUNT] = {
+    SENSOR_CHANNELS(SENSOR_CHANNEL_DEFINITION)
+};
+#undef SENSOR_CHANNEL_DEFINITION
+
+static SensorState sensor_state = {0};
+
+// Filter state, one lane per channel
+static struct {
+    v4f taps[SENSOR_MEDIAN_TAPS][GROUPS];
+    v4f iir[GROUPS];
+    uint32_t tap;
+    bool primed;
+    float pending_samples;      // Fraction of a sample carried to the next cycle
+} filter;
+
+// Per-lane constants from the channel table
+static v4f alpha[GROUPS];       // IIR coefficient at the sample rate
+static v4f gain[GROUPS];        // Engineering units per count
+static v4f offset[GROUPS];
+
+// Simulated ADC, or the position in the replay file
+static struct {
+    uint8_t injected[SENSOR_CHANNEL_COUNT];   // SensorFault
+    uint16_t stuck_code[SENSOR_CHANNEL_COUNT];
+    uint64_t replay_scan;
+} source;
+static Rng sensor_rng;
+
+// Raw conversions buffered by the scan since the last cycle
+static uint16_t scans[SCAN_BUFFER][LANES];
+
+static const uint16_t* replay_codes = NULL;
+static size_t replay_bytes = 0;
+static uint64_t replay_scans = 0;
+static FILE* record_file = NULL;
+static uint64_t recorded_scans = 0;
+
+static double elapsed_us(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e6 + (end.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+void sensors_init(void) {
+    printf("[SENSORS] Initializing %d analogue inputs (%d Hz, %dx oversampling)\n",
+           SENSOR_CHANNEL_COUNT, SENSOR_SAMPLE_RATE_HZ, SENSOR_OVERSAMPLE);
+    memset(&sensor_state, 0, sizeof(sensor_state));
+    memset(&filter, 0, sizeof(filter));
+    memset(&source, 0, sizeof(source));
+    rng_seed(&sensor_rng, rng_get_seed(), SENSOR_RNG_STREAM);
+
+    float lane_alpha[LANES] = {0}, lane_gain[LANES] = {0}, lane_offset[LANES] = {0};
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        const ChannelDefinition* def = &definitions[ch];
+        // exp(-T/tau) to first order; tau is always many samples long
+        lane_alpha[ch] = 1000.0f / (SENSOR_SAMPLE_RATE_HZ * (float)def->tau_ms + 1000.0f);
+        lane_gain[ch] = (def->high - def->low) / (4.0f * COUNTS_PER_VOLT);
+        lane_offset[ch] = def->low - 0.5f * COUNTS_PER_VOLT * lane_gain[ch];
+        sensor_state.channels[ch].valid = true;
+    }
+    memcpy(alpha, lane_alpha, sizeof(alpha));
+    memcpy(gain, lane_gain, sizeof(gain));
+    memcpy(offset, lane_offset, sizeof(offset));
+
+    // The replay mapping and the recording are reopened from their files
+    CHECKPOINT_VAR("sensors", sensor_state);
+    CHECKPOINT_VAR("sensors", filter);
+    CHECKPOINT_VAR("sensors", source);
+    CHECKPOINT_VAR("sensors", sensor_rng);
+}
+
+// What each input would read right now, in volts at the ADC pin
+static void plant_volts(float* volts) {
+    const ThermalState* thermal = thermal_get_state();
+    const EngineState* engine = engine_get_state();
+    const HydraulicsState* hydraulics = hydraulics_get_state();
+    bool running = engine->engine_running;
+    float speed = running ? engine->current_rpm / 2200.0f : 0.0f;
+    float ambient = real_to_float(thermal->ambient_c);
+    float coolant = real_to_float(thermal->temp_c[THERMAL_COOLANT]);
+
+    float values[SENSOR_CHANNEL_COUNT];
+    values[SENSOR_COOLANT_TEMP] = coolant;
+    values[SENSOR_OIL_PRESSURE] = running ? 30.0f + 25.0f * (speed < 1.0f ? speed : 1.0f) : 0.0f;
+    values[SENSOR_TRANS_OIL_TEMP] = real_to_float(thermal->temp_c[THERMAL_TRANSMISSION_OIL]);
+    values[SENSOR_HYD_OIL_TEMP] = real_to_float(thermal->temp_c[THERMAL_HYDRAULIC_OIL]);
+    values[SENSOR_HYD_RESERVOIR] = hydraulics->implement_raised ? 81.0f : 85.0f;   // Oil out in the hitch rams
+    values[SENSOR_BATTERY_VOLTAGE] = running && engine->current_rpm >= 600 ? 14.1f : 12.6f;
+    values[SENSOR_ALTERNATOR_CURRENT] = running ? 18.0f + 0.2f * real_to_float(engine->load_percent) : -8.0f;
+    values[SENSOR_ECU_TEMP] = ambient + 12.0f + 0.15f * (coolant - ambient);
+
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        const ChannelDefinition* def = &definitions[ch];
+        volts[ch] = 0.5f + 4.0f * (values[ch] - def->low) / (def->high - def->low);
+    }
+}
+
+static void simulate_scans(uint32_t count) {
+    float volts[SENSOR_CHANNEL_COUNT];
+    plant_volts(volts);
+    int base[SENSOR_CHANNEL_COUNT];
+    uint32_t spiky = 0;
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        float code = volts[ch] * COUNTS_PER_VOLT + 0.5f;
+        base[ch] = code < 0.0f ? 0 : code > SENSOR_ADC_MAX ? SENSOR_ADC_MAX : (int)code;
+        switch ((SensorFault)source.injected[ch]) {
+            case SENSOR_FAULT_SHORTED: base[ch] = SHORTED_CODE; break;
+            case SENSOR_FAULT_OPEN:    base[ch] = OPEN_CODE; break;
+            case SENSOR_FAULT_SPIKES:  spiky |= 1u << ch; break;
+            default:                   break;
+        }
+    }
+
+    for (uint32_t s = 0; s < count; s++) {
+        uint16_t* row = scans[s];
+        uint64_t noise = 0;
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+            // Two nibbles per conversion: -3 to +3 LSB, zero mean; the division
+            // truncates toward zero, so nibble sums -3 to +3 all give 0
+            if (ch % 8 == 0) noise = rng_next(&sensor_rng);
+            int code = base[ch] + ((int)(noise & 0xF) + (int)((noise >> 4) & 0xF) - 15) / 4;
+            noise >>= 8;
+            row[ch] = (uint16_t)(code < 0 ? 0 : code > SENSOR_ADC_MAX ? SENSOR_ADC_MAX : code);
+        }
+
+        // Bits 0-12 background spike, 13-20 its channel, 21-30 amplitude, 31 sign
+        uint64_t r = rng_next(&sensor_rng);
+        uint32_t hits = (r & (SPIKE_ONE_IN - 1)) == 0 ? 1u << ((r >> 13) & 0xFF) % SENSOR_CHANNEL_COUNT : 0;
+        if (spiky != 0) {
+            // Six bits per channel
+            uint64_t draw = rng_next(&sensor_rng);
+            for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+                if ((spiky >> ch) & 1u && ((draw >> (6 * (ch % 10))) & (INJECTED_ONE_IN - 1)) == 0) {
+                    hits |= 1u << ch;
+                }
+            }
+        }
+        for (int ch = 0; hits != 0; ch++, hits >>= 1) {
+            if ((hits & 1u) == 0) continue;
+            int amplitude = SPIKE_MIN_COUNTS + (int)((r >> 21) & 0x3FF);
+            int code = row[ch] + ((r >> 31) & 1 ? amplitude : -amplitude);
+            row[ch] = (uint16_t)(code < 0 ? 0 : code > SENSOR_ADC_MAX ? SENSOR_ADC_MAX : code);
+        }
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+            if (source.injected[ch] == SENSOR_FAULT_STUCK) row[ch] = source.stuck_code[ch];
+        }
+    }
+}
+
+static void replay_scan_rows(uint32_t count) {
+    for (uint32_t s = 0; s < count; s++) {
+        const uint16_t* codes = replay_codes + (source.replay_scan % replay_scans) * SENSOR_CHANNEL_COUNT;
+        memcpy(scans[s], codes, SENSOR_CHANNEL_COUNT * sizeof(uint16_t));
+        source.replay_scan++;
+    }
+}
+
+static void record_scan_rows(uint32_t count) {
+    for (uint32_t s = 0; s < count; s++) {
+        if (fwrite(scans[s], sizeof(uint16_t), SENSOR_CHANNEL_COUNT, record_file) != SENSOR_CHANNEL_COUNT) {
+            printf("[SENSORS] Recording stopped - write failed\n");
+            sensors_record_close();
+            return;
+        }
+    }
+    recorded_scans += count;
+}
+
+// Per-channel results of one block, taken out of the vector lanes
+typedef struct {
+    int32_t shorted[LANES];     // Samples below SHORTED_COUNTS (as -1 per sample)
+    int32_t open[LANES];
+    int32_t spikes[LANES];
+    float lowest[LANES];
+    float highest[LANES];
+    float median[LANES];        // Last median output
+    float value[LANES];         // Scaled IIR output
+} BlockResult;
+
+// Oversample, range check, median and IIR filter a block for all channels
+// at once, four lanes per vector
+static void filter_block(uint32_t samples, BlockResult* result) {
+    if (!filter.primed) {
+        for (int g = 0; g < GROUPS; g++) {
+            v4u sum = {0};
+            for (int o = 0; o < SENSOR_OVERSAMPLE; o++) sum += load4h(&scans[o][g * 4]);
+            v4f first = __builtin_convertvector(sum, v4f) * (1.0f / SENSOR_OVERSAMPLE);
+            for (int t = 0; t < SENSOR_MEDIAN_TAPS; t++) filter.taps[t][g] = first;
+            filter.iir[g] = first;
+        }
+        filter.primed = true;
+    }
+
+    v4i shorted[GROUPS] = {{0}}, open[GROUPS] = {{0}}, spikes[GROUPS] = {{0}};
+    v4f lowest[GROUPS], highest[GROUPS], median[GROUPS];
+    for (int g = 0; g < GROUPS; g++) {
+        lowest[g] = (v4f){0} + (float)SENSOR_ADC_MAX;
+        highest[g] = (v4f){0};
+        median[g] = filter.iir[g];
+    }
+    const v4f shorted_at = (v4f){0} + SHORTED_COUNTS;
+    const v4f open_at = (v4f){0} + OPEN_COUNTS;
+    const v4f spike_at = (v4f){0} + SENSOR_SPIKE_COUNTS;
+
+    uint32_t tap = filter.tap;
+    for (uint32_t i = 0; i < samples; i++) {
+        const uint16_t (*rows)[LANES] = &scans[i * SENSOR_OVERSAMPLE];
+        for (int g = 0; g < GROUPS; g++) {
+            v4u sum = load4h(&rows[0][g * 4]);
+            for (int o = 1; o < SENSOR_OVERSAMPLE; o++) sum += load4h(&rows[o][g * 4]);
+            v4f x = __builtin_convertvector(sum, v4f) * (1.0f / SENSOR_OVERSAMPLE);
+
+            shorted[g] += x < shorted_at;      // -1 per lane that is true
+            open[g] += x > open_at;
+            lowest[g] = min4(lowest[g], x);
+            highest[g] = max4(highest[g], x);
+
+            filter.taps[tap][g] = x;
+            v4f m = median5(filter.taps[0][g], filter.taps[1][g], filter.taps[2][g],
+                            filter.taps[3][g], filter.taps[4][g]);
+            spikes[g] += max4(x - m, m - x) > spike_at;
+            filter.iir[g] += alpha[g] * (m - filter.iir[g]);
+            median[g] = m;
+        }
+        tap = tap + 1 == SENSOR_MEDIAN_TAPS ? 0 : tap + 1;
+    }
+    filter.tap = tap;
+
+    v4f value[GROUPS];
+    for (int g = 0; g < GROUPS; g++) {
+        shorted[g] = -shorted[g];
+        open[g] = -open[g];
+        spikes[g] = -spikes[g];
+        value[g] = filter.iir[g] * gain[g] + offset[g];
+    }
+    memcpy(result->shorted, shorted, sizeof(result->shorted));
+    memcpy(result->open, open, sizeof(result->open));
+    memcpy(result->spikes, spikes, sizeof(result->spikes));
+    memcpy(result->lowest, lowest, sizeof(result->lowest));
+    memcpy(result->highest, highest, sizeof(result->highest));
+    memcpy(result->median, median, sizeof(result->median));
+    memcpy(result->value, value, sizeof(result->value));
+}
+
+static void set_iir_lane(int channel, float counts) {
+    float lanes[LANES];
+    memcpy(lanes, filter.iir, sizeof(lanes));
+    lanes[channel] = counts;
+    memcpy(filter.iir, lanes, sizeof(lanes));
+}
+
+static FaultId fault_id(int channel, SensorFault fault) {
+    const ChannelDefinition* def = &definitions[channel];
+    return fault == SENSOR_FAULT_SHORTED ? def->fault_low :
+           fault == SENSOR_FAULT_OPEN ? def->fault_high : def->fault_stuck;
+}
+
+static const char* fault_name(SensorFault fault) {
+    switch (fault) {
+        case SENSOR_FAULT_SHORTED: return "shorted to ground";
+        case SENSOR_FAULT_OPEN:    return "open circuit";
+        case SENSOR_FAULT_STUCK:   return "frozen";
+        case SENSOR_FAULT_SPIKES:  return "noisy";
+        default:                   return "ok";
+    }
+}
+
+// Debounce the circuit checks and publish the channels that passed them
+static void evaluate(uint32_t samples, const BlockResult* result) {
+    float block_ms = samples * 1000.0f / SENSOR_SAMPLE_RATE_HZ;
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        SensorChannelState* channel = &sensor_state.channels[ch];
+        const ChannelDefinition* def = &definitions[ch];
+        bool shorted = (uint32_t)result->shorted[ch] * 2 > samples;
+        bool open = (uint32_t)result->open[ch] * 2 > samples;
+        bool frozen = samples >= MIN_STUCK_SAMPLES && result->highest[ch] == result->lowest[ch];
+        channel->out_of_range_ms = shorted || open ? channel->out_of_range_ms + block_ms : 0.0f;
+        channel->stuck_ms = frozen ? channel->stuck_ms + block_ms : 0.0f;
+        channel->spikes += (uint32_t)result->spikes[ch];
+
+        SensorFault fault = SENSOR_FAULT_NONE;
+        if (channel->out_of_range_ms >= SENSOR_RANGE_DEBOUNCE_MS) {
+            fault = shorted ? SENSOR_FAULT_SHORTED : SENSOR_FAULT_OPEN;
+        } else if (channel->stuck_ms >= SENSOR_STUCK_MS) {
+            fault = SENSOR_FAULT_STUCK;
+        } else if (channel->fault != SENSOR_FAULT_NONE && (shorted || open || frozen)) {
+            fault = channel->fault;     // Still bad, timer restarted by a short good spell
+        }
+
+        if (fault != channel->fault) {
+            if (channel->fault != SENSOR_FAULT_NONE) {
+                uint32_t spn;
+                uint8_t fmi;
+                if (diagnostics_fault_code(fault_id(ch, channel->fault), &spn, &fmi)) {
+                    diagnostics_clear_fault(spn, fmi);
+                }
+            }
+            if (fault != SENSOR_FAULT_NONE) {
+                printf("[SENSORS] %s input %s - holding %.1f %s\n", def->label, fault_name(fault),
+                       real_to_float(channel->value), def->unit);
+                diagnostics_report_fault(fault_id(ch, fault));
+                channel->faults++;
+            } else {
+                printf("[SENSORS] %s input recovered\n", def->label);
+                set_iir_lane(ch, result->median[ch]);   // Do not ramp in from the bad readings
+            }
+            channel->fault = fault;
+        }
+        channel->valid = fault == SENSOR_FAULT_NONE;
+
+        // A block mostly out of range is never published, even before the
+        // fault is confirmed
+        if (channel->valid && !shorted && !open) {
+            channel->value = real_from_float(result->value[ch]);
+            float lanes[LANES];
+            memcpy(lanes, filter.iir, sizeof(lanes));
+            channel->filtered_counts = lanes[ch];
+        }
+    }
+}
+
+void sensors_update(real_t dt_s) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    filter.pending_samples += real_to_float(dt_s) * SENSOR_SAMPLE_RATE_HZ;
+    uint32_t samples = (uint32_t)filter.pending_samples;
+    filter.pending_samples -= (float)samples;
+    if (samples == 0) return;
+    if (samples > SENSOR_MAX_BLOCK) {
+        sensor_state.overruns += samples - SENSOR_MAX_BLOCK;
+        samples = SENSOR_MAX_BLOCK;
+    }
+
+    uint32_t count = samples * SENSOR_OVERSAMPLE;
+    if (replay_codes != NULL) {
+        replay_scan_rows(count);
+    } else {
+        simulate_scans(count);
+    }
+    if (record_file != NULL) {
+        record_scan_rows(count);
+    }
+
+    BlockResult result;
+    filter_block(samples, &result);
+    evaluate(samples, &result);
+
+    sensor_state.samples += samples;
+    sensor_state.cycles++;
+    sensor_state.last_us = (float)elapsed_us(&start);
+    if (sensor_state.last_us > sensor_state.max_us) sensor_state.max_us = sensor_state.last_us;
+}
+
+real_t sensors_read(SensorChannel channel) {
+    return (unsigned)channel < SENSOR_CHANNEL_COUNT ? sensor_state.channels[channel].value : REAL(0);
+}
+
+bool sensors_valid(SensorChannel channel) {
+    return (unsigned)channel < SENSOR_CHANNEL_COUNT && sensor_state.channels[channel].valid;
+}
+
+void sensors_get_supply(SensorData* out) {
+    out->voltage = real_to_float(sensor_state.channels[SENSOR_BATTERY_VOLTAGE].value);
+    out->current = real_to_float(sensor_state.channels[SENSOR_ALTERNATOR_CURRENT].value);
+    out->temperature = real_to_float(sensor_state.channels[SENSOR_ECU_TEMP].value);
+}
+
+const char* sensors_channel_name(SensorChannel channel) {
+    return (unsigned)channel < SENSOR_CHANNEL_COUNT ? definitions[channel].label : "unknown";
+}
+
+void sensors_inject_fault(SensorChannel channel, SensorFault fault) {
+    if ((unsigned)channel >= SENSOR_CHANNEL_COUNT) return;
+    if (fault == SENSOR_FAULT_STUCK) {
+        // Freeze on whatever the converter would read now
+        float volts[SENSOR_CHANNEL_COUNT];
+        plant_volts(volts);
+        float code = volts[channel] * COUNTS_PER_VOLT + 0.5f;
+        source.stuck_code[channel] = (uint16_t)(code < 0.0f ? 0 : code > SENSOR_ADC_MAX ? SENSOR_ADC_MAX : code);
+    }
+    source.injected[channel] = (uint8_t)fault;
+}
+
+bool sensors_replay_open(const char* path) {
+    sensors_replay_close();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("[SENSORS] Cannot open replay file %s\n", path);
+        return false;
+    }
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(SensorReplayHeader)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("[SENSORS] Cannot map replay file %s\n", path);
+        return false;
+    }
+
+    const SensorReplayHeader* header = map;
+    size_t row_bytes = SENSOR_CHANNEL_COUNT * sizeof(uint16_t);
+    if (header->magic != SENSOR_REPLAY_MAGIC || header->version != SENSOR_REPLAY_VERSION ||
+        header->channel_count != SENSOR_CHANNEL_COUNT || header->sample_rate_hz != SENSOR_SAMPLE_RATE_HZ ||
+        header->oversample != SENSOR_OVERSAMPLE || header->scans == 0 ||
+        header->scans > ((size_t)st.st_size - sizeof(SensorReplayHeader)) / row_bytes) {
+        printf("[SENSORS] %s is not a replay of this input set\n", path);
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+    replay_codes = (const uint16_t*)((const uint8_t*)map + sizeof(SensorReplayHeader));
+    replay_bytes = (size_t)st.st_size;
+    replay_scans = header->scans;
+    source.replay_scan = 0;
+    sensor_state.replaying = true;
+    printf("[SENSORS] Replaying %s: %.1f s of raw samples\n", path,
+           (double)replay_scans / SENSOR_OVERSAMPLE / SENSOR_SAMPLE_RATE_HZ);
+    return true;
+}
+
+void sensors_replay_close(void) {
+    if (replay_codes != NULL) {
+        munmap((void*)((const uint8_t*)replay_codes - sizeof(SensorReplayHeader)), replay_bytes);
+    }
+    replay_codes = NULL;
+    replay_scans = 0;
+    sensor_state.replaying = false;
+}
+
+bool sensors_record_open(const char* path) {
+    sensors_record_close();
+    record_file = fopen(path, "wb");
+    if (record_file == NULL) {
+        printf("[SENSORS] Cannot create recording %s\n", path);
+        return false;
+    }
+    SensorReplayHeader header = { SENSOR_REPLAY_MAGIC, SENSOR_REPLAY_VERSION, SENSOR_CHANNEL_COUNT,
+                            SENSOR_SAMPLE_RATE_HZ, SENSOR_OVERSAMPLE, 0 };
+    fwrite(&header, sizeof(header), 1, record_file);
+    recorded_scans = 0;
+    return true;
+}
+
+// The scan count goes into the header last, so a recording cut short
+// by a reset reads as empty rather than as a partial row
+void sensors_record_close(void) {
+    if (record_file == NULL) return;
+    FILE* file = record_file;
+    record_file = NULL;
+    SensorReplayHeader header = { SENSOR_REPLAY_MAGIC, SENSOR_REPLAY_VERSION, SENSOR_CHANNEL_COUNT,
+                            SENSOR_SAMPLE_RATE_HZ, SENSOR_OVERSAMPLE, recorded_scans };
+    bool ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    if (fclose(file) != 0 || !ok) {
+        printf("[SENSORS] Recording could not be finished\n");
+    }
+}
+
+void sensors_print_status(void) {
+    printf("\n=== Sensor Inputs ===\n");
+    printf("Source: %s, %llu samples per input in %u cycles", sensor_state.replaying ? "replay" : "simulated ADC",
+           (unsigned long long)sensor_state.samples, sensor_state.cycles);
+    if (sensor_state.overruns > 0) printf(", %u lost to late cycles", sensor_state.overruns);
+    printf("\n");
+    printf("%-30s %10s %-4s %8s %7s %s\n", "Input", "Value", "", "Counts", "Spikes", "Status");
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        const SensorChannelState* channel = &sensor_state.channels[ch];
+        printf("%-30s %10.1f %-4s %8.1f %7u %s%s\n", definitions[ch].label, real_to_float(channel->value),
+               definitions[ch].unit, channel->filtered_counts, channel->spikes,
+               fault_name(channel->fault), channel->valid ? "" : " (last good value held)");
+    }
+    if (sensor_state.cycles > 0) {
+        printf("Filtering: %.1f us last cycle, %.1f us max\n", sensor_state.last_us, sensor_state.max_us);
+    }
+    printf("=====================\n");
+}
+
+SensorState* sensors_get_state(void) {
+    return &sensor_state;
+}
@@ -0,0 +1,108 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "../common/types.h"
+#include "../common/fixed.h"
+
+#define SENSOR_SAMPLE_RATE_HZ   1000    // Filtered samples per channel
+#define SENSOR_OVERSAMPLE       4       // ADC conversions averaged into one sample
+#define SENSOR_ADC_MAX          4095    // 12-bit converter, 5 V reference
+#define SENSOR_MAX_BLOCK        2048    // Samples buffered between two cycles (~2 s)
+#define SENSOR_MEDIAN_TAPS      5       // Spike rejection window
+#define SENSOR_SPIKE_COUNTS     40.0f   // Sample this far from the median counts as a spike
+#define SENSOR_RANGE_DEBOUNCE_MS 200    // Out of range this long before a circuit fault
+#define SENSOR_STUCK_MS         1000    // Frozen this long before a stuck fault
+#define SENSOR_REPLAY_MAGIC     0x31575253u   // "SRW1"
+#define SENSOR_REPLAY_VERSION   1
+
+// Analogue inputs, in ADC scan order:
+//   X(name, label, unit, value at 0.5 V, value at 4.5 V, filter time constant ms)
+// Inputs are ratiometric 0.5-4.5 V; below 0.25 V the circuit is shorted to
+// ground, above 4.75 V it is open or shorted to the supply. The three
+// circuit faults per input are in DIAGNOSTIC_FAULT_TABLE.
+#define SENSOR_CHANNELS(X) \
+    X(COOLANT_TEMP,       "coolant_temp",       "C",    -40.0f,  150.0f, 500) \
+    X(OIL_PRESSURE,       "oil_pressure",       "PSI",    0.0f,  100.0f,  50) \
+    X(TRANS_OIL_TEMP,     "trans_oil_temp",     "C",    -40.0f,  150.0f, 500) \
+    X(HYD_OIL_TEMP,       "hyd_oil_temp",       "C",    -40.0f,  150.0f, 500) \
+    X(HYD_RESERVOIR,      "hyd_reservoir",      "%",      0.0f,  100.0f, 2000) \
+    X(BATTERY_VOLTAGE,    "battery_voltage",    "V",      0.0f,   32.0f, 100) \
+    X(ALTERNATOR_CURRENT, "alternator_current", "A",    -50.0f,  150.0f, 100) \
+    X(ECU_TEMP,           "ecu_temp",           "C",    -40.0f,  125.0f, 1000)
+
+#define SENSOR_CHANNEL_ID(name, label, unit, low, high, tau_ms) SENSOR_##name,
+typedef enum {
+    SENSOR_CHANNELS(SENSOR_CHANNEL_ID)
+    SENSOR_CHANNEL_COUNT
+} SensorChannel;
+#undef SENSOR_CHANNEL_ID
+
+typedef enum {
+    SENSOR_FAULT_NONE = 0,
+    SENSOR_FAULT_SHORTED,       // Reads near 0 V
+    SENSOR_FAULT_OPEN,          // Reads near 5 V
+    SENSOR_FAULT_STUCK,         // Converter returns the same code every scan
+    SENSOR_FAULT_SPIKES         // Ignition noise: one scan in 64 hits the input
+} SensorFault;
+
+typedef struct {
+    real_t value;               // Published, in engineering units
+    float filtered_counts;      // IIR output, ADC counts
+    bool valid;                 // false while a circuit fault holds the last good value
+    SensorFault fault;          // Active circuit fault
+    float out_of_range_ms;      // Debounce timers
+    float stuck_ms;
+    uint32_t spikes;            // Samples the median filter replaced
+    uint32_t faults;            // Circuit faults raised
+} SensorChannelState;
+
+// Replay file (little-endian): this header, then `scans` rows of
+// channel_count uint16 ADC codes in scan order, SENSOR_OVERSAMPLE rows
+// per filtered sample
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t channel_count;
+    uint32_t sample_rate_hz;
+    uint32_t oversample;
+    uint64_t scans;
+} SensorReplayHeader;
+
+typedef struct {
+    SensorChannelState channels[SENSOR_CHANNEL_COUNT];
+    uint64_t samples;           // Per channel, since init
+    uint32_t cycles;
+    uint32_t overruns;          // Samples lost because a cycle came late
+    bool replaying;             // Raw samples come from a replay file
+    float last_us;              // Acquisition and filtering, last cycle
+    float max_us;
+} SensorState;
+
+// Sensor inputs - each cycle the samples the ADC scan has buffered since
+// the last one (simulated from the plant models or read from a replay
+// file) are oversampled, median and IIR filtered and scaled for all
+// channels at once, then published. Modules read the published values;
+// an input with a circuit fault keeps its last good value.
+//
+// Dependencies: Thermal, Engine and Hydraulics (plant values the simulated
+// ADC converts), Diagnostics (circuit faults)
+void sensors_init(void);
+void sensors_update(real_t dt_s);
+real_t sensors_read(SensorChannel channel);
+bool sensors_valid(SensorChannel channel);
+void sensors_get_supply(SensorData* out);   // Battery, alternator, ECU board
+const char* sensors_channel_name(SensorChannel channel);
+
+// Replay file: raw conversions in scan order, looped at its end
+bool sensors_replay_open(const char* path);
+void sensors_replay_close(void);
+bool sensors_record_open(const char* path);
+void sensors_record_close(void);
+
+// Simulated ADC only - for checks and bench runs
+void sensors_inject_fault(SensorChannel channel, SensorFault fault);
+
+void sensors_print_status(void);
+SensorState* sensors_get_state(void);
+
+#endif // SENSORS_H
@@ -0,0 +1,338 @@
+#include "spool.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define SPOOL_HEADER_BYTES 8
+
+static SpoolState spool_state = {
+    .head_fd = -1,
+    .tail_fd = -1,
+    .drain_rate = SPOOL_DEFAULT_DRAIN_RATE
+};
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint32_t checksum(const uint8_t* data, size_t length) {
+    uint32_t hash = 2166136261u;   // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void put_u32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void segment_path(uint32_t segment, char* path, size_t size) {
+    snprintf(path, size, "%s/seg_%08u.tlm", spool_state.directory, segment);
+}
+
+static int open_tail_segment(void) {
+    char path[192];
+    segment_path(spool_state.tail_segment, path, sizeof(path));
+    spool_state.tail_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    spool_state.tail_bytes = 0;
+    return spool_state.tail_fd;
+}
+
+// Count framed records from an offset so dropped data is accounted for
+static uint32_t count_records(int fd, off_t offset) {
+    uint8_t header[SPOOL_HEADER_BYTES];
+    uint32_t count = 0;
+    while (pread(fd, header, sizeof(header), offset) == (ssize_t)sizeof(header)) {
+        uint32_t length = get_u32(header);
+        if (length == 0 || length > SPOOL_MAX_RECORD) break;
+        offset += SPOOL_HEADER_BYTES + length;
+        count++;
+    }
+    return count;
+}
+
+// Delete the head segment; records past the read offset, not yet drained,
+// are counted as dropped
+static void remove_head_segment(bool drained) {
+    char path[192];
+    segment_path(spool_state.head_segment, path, sizeof(path));
+
+    if (spool_state.head_fd < 0) {
+        spool_state.head_fd = open(path, O_RDONLY);
+    }
+    if (spool_state.head_fd >= 0) {
+        struct stat st;
+        if (fstat(spool_state.head_fd, &st) == 0) {
+            spool_state.stats.bytes_on_disk -= (uint64_t)st.st_size;
+        }
+        if (!drained) {
+            uint32_t total = count_records(spool_state.head_fd, spool_state.head_offset);
+            spool_state.stats.records_dropped += total;
+        }
+        close(spool_state.head_fd);
+    }
+    unlink(path);
+
+    spool_state.head_fd = -1;
+    spool_state.head_offset = 0;
+    spool_state.head_segment++;
+}
+
+bool spool_init(const char* directory) {
+    printf("[SPOOL] Initializing store-and-forward spool in %s/\n", directory);
+
+    if (spool_state.tail_fd >= 0) close(spool_state.tail_fd);
+    if (spool_state.head_fd >= 0) close(spool_state.head_fd);
+    snprintf(spool_state.directory, sizeof(spool_state.directory), "%s", directory);
+    spool_state.head_fd = -1;
+    spool_state.tail_fd = -1;
+    spool_state.head_offset = 0;
+    spool_state.buffered_bytes = 0;
+    spool_state.buffered_records = 0;
+    spool_state.peeked_length = 0;
+    memset(&spool_state.stats, 0, sizeof(spool_state.stats));
+
+    if (mkdir(directory, 0755) < 0 && errno != EEXIST) {
+        printf("[SPOOL] Cannot create %s: %s\n", directory, strerror(errno));
+        return false;
+    }
+
+    // Recover segments left by a previous run
+    uint32_t oldest = UINT32_MAX;
+    uint32_t newest = 0;
+    uint32_t found = 0;
+    DIR* dir = opendir(directory);
+    if (dir != NULL) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            uint32_t segment;
+            char suffix[8];
+            if (sscanf(entry->d_name, "seg_%8u.%3s", &segment, suffix) == 2 && strcmp(suffix, "tlm") == 0) {
+                char path[192];
+                struct stat st;
+                segment_path(segment, path, sizeof(path));
+                if (stat(path, &st) == 0) {
+                    spool_state.stats.bytes_on_disk += (uint64_t)st.st_size;
+                }
+                if (segment < oldest) oldest = segment;
+                if (segment > newest) newest = segment;
+                found++;
+            }
+        }
+        closedir(dir);
+    }
+
+    // Always append to a fresh segment so a torn record from a crash never
+    // sits in front of new data
+    if (found > 0) {
+        spool_state.head_segment = oldest;
+        spool_state.tail_segment = newest + 1;
+        printf("[SPOOL] Recovered %u segment(s), %llu bytes pending\n",
+               found, (unsigned long long)spool_state.stats.bytes_on_disk);
+    } else {
+        spool_state.head_segment = 0;
+        spool_state.tail_segment = 0;
+    }
+
+    if (open_tail_segment() < 0) {
+        printf("[SPOOL] Cannot open segment: %s\n", strerror(errno));
+        return false;
+    }
+
+    spool_state.last_sync_us = monotonic_us();
+    spool_state.last_drain_us = spool_state.last_sync_us;
+    spool_state.drain_tokens = 0;
+    return true;
+}
+
+void spool_sync(void) {
+    if (spool_state.buffered_bytes == 0 || spool_state.tail_fd < 0) {
+        return;
+    }
+
+    const uint8_t* p = spool_state.buffer;
+    size_t remaining = spool_state.buffered_bytes;
+    while (remaining > 0) {
+        ssize_t n = write(spool_state.tail_fd, p, remaining);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            printf("[SPOOL] Write failed: %s - %u record(s) lost\n",
+                   strerror(errno), spool_state.buffered_records);
+            spool_state.stats.records_dropped += spool_state.buffered_records;
+            spool_state.tail_bytes -= (uint32_t)remaining;
+            break;
+        }
+        p += n;
+        remaining -= (size_t)n;
+        spool_state.stats.bytes_on_disk += (uint64_t)n;
+    }
+    fsync(spool_state.tail_fd);
+
+    spool_state.stats.fsyncs++;
+    spool_state.buffered_bytes = 0;
+    spool_state.buffered_records = 0;
+    spool_state.last_sync_us = monotonic_us();
+}
+
+static void roll_tail_segment(void) {
+    spool_sync();
+    close(spool_state.tail_fd);
+    spool_state.tail_segment++;
+    open_tail_segment();
+
+    // Enforce the disk cap by dropping the oldest data
+    while (spool_state.tail_segment - spool_state.head_segment + 1 > SPOOL_MAX_SEGMENTS) {
+        printf("[SPOOL] Disk cap reached - dropping segment %u\n", spool_state.head_segment);
+        remove_head_segment(false);
+    }
+}
+
+bool spool_append(const uint8_t* data, size_t length) {
+    if (length == 0 || length > SPOOL_MAX_RECORD || spool_state.tail_fd < 0) {
+        return false;
+    }
+
+    uint32_t framed = SPOOL_HEADER_BYTES + (uint32_t)length;
+    if (spool_state.tail_bytes > 0 && spool_state.tail_bytes + framed > SPOOL_SEGMENT_BYTES) {
+        roll_tail_segment();
+    }
+    if (spool_state.buffered_bytes + framed > SPOOL_BUFFER_BYTES) {
+        spool_sync();
+    }
+
+    uint8_t* out = &spool_state.buffer[spool_state.buffered_bytes];
+    put_u32(out, (uint32_t)length);
+    put_u32(out + 4, checksum(data, length));
+    memcpy(out + SPOOL_HEADER_BYTES, data, length);
+
+    spool_state.buffered_bytes += framed;
+    spool_state.buffered_records++;
+    spool_state.tail_bytes += framed;
+    spool_state.stats.records_spooled++;
+
+    if (spool_state.buffered_records >= SPOOL_FSYNC_RECORDS) {
+        spool_sync();
+    }
+    return true;
+}
+
+bool spool_is_empty(void) {
+    return spool_state.head_segment == spool_state.tail_segment &&
+           spool_state.head_offset >= spool_state.tail_bytes;
+}
+
+bool spool_peek(uint8_t* out, size_t capacity, size_t* length) {
+    spool_state.peeked_length = 0;
+    if (spool_is_empty()) {
+        return false;
+    }
+
+    // Refill the drain budget
+    uint64_t now = monotonic_us();
+    uint64_t burst = spool_state.drain_rate > SPOOL_BUFFER_BYTES ? spool_state.drain_rate : SPOOL_BUFFER_BYTES;
+    spool_state.drain_tokens += (now - spool_state.last_drain_us) * spool_state.drain_rate / 1000000u;
+    if (spool_state.drain_tokens > burst) spool_state.drain_tokens = burst;
+    spool_state.last_drain_us = now;
+
+    if (spool_state.head_segment == spool_state.tail_segment) {
+        spool_sync();
+    }
+
+    for (;;) {
+        if (spool_state.head_fd < 0) {
+            char path[192];
+            segment_path(spool_state.head_segment, path, sizeof(path));
+            spool_state.head_fd = open(path, O_RDONLY);
+            if (spool_state.head_fd < 0) {
+                if (spool_state.head_segment == spool_state.tail_segment) return false;
+                spool_state.head_segment++;   // Missing segment - skip it
+                continue;
+            }
+        }
+
+        uint8_t header[SPOOL_HEADER_BYTES];
+        ssize_t n = pread(spool_state.head_fd, header, sizeof(header), spool_state.head_offset);
+        uint32_t record_length = n == (ssize_t)sizeof(header) ? get_u32(header) : 0;
+        bool valid = record_length > 0 && record_length <= SPOOL_MAX_RECORD && record_length <= capacity;
+
+        if (valid) {
+            if (spool_state.drain_tokens < SPOOL_HEADER_BYTES + record_length) {
+                return false;   // Rate limited - try again next cycle
+            }
+            n = pread(spool_state.head_fd, out, record_length, spool_state.head_offset + SPOOL_HEADER_BYTES);
+            valid = n == (ssize_t)record_length && checksum(out, record_length) == get_u32(header + 4);
+            if (valid) {
+                *length = record_length;
+                spool_state.peeked_length = record_length;
+                return true;
+            }
+        }
+
+        if (spool_state.head_segment == spool_state.tail_segment) {
+            return false;
+        }
+        // End of segment, or a torn/corrupt record from a crash: move on
+        if (n != 0) {
+            spool_state.stats.records_dropped++;
+        }
+        remove_head_segment(true);
+    }
+}
+
+void spool_pop(void) {
+    if (spool_state.peeked_length == 0) {
+        return;
+    }
+    uint32_t framed = SPOOL_HEADER_BYTES + spool_state.peeked_length;
+    spool_state.head_offset += framed;
+    spool_state.drain_tokens -= framed;
+    spool_state.stats.records_drained++;
+    spool_state.peeked_length = 0;
+
+    // Fully drained - start a fresh segment so the spool does not grow forever
+    if (spool_is_empty() && spool_state.buffered_bytes == 0) {
+        spool_state.tail_segment++;
+        remove_head_segment(true);
+        close(spool_state.tail_fd);
+        open_tail_segment();
+    }
+}
+
+void spool_update(void) {
+    if (spool_state.buffered_records > 0 &&
+        monotonic_us() - spool_state.last_sync_us >= SPOOL_FSYNC_MS * 1000u) {
+        spool_sync();
+    }
+}
+
+void spool_set_drain_rate(uint32_t bytes_per_second) {
+    spool_state.drain_rate = bytes_per_second > 0 ? bytes_per_second : SPOOL_DEFAULT_DRAIN_RATE;
+}
+
+void spool_print_stats(void) {
+    printf("Spool: %u spooled, %u drained, %u dropped, %u fsyncs\n",
+           spool_state.stats.records_spooled, spool_state.stats.records_drained,
+           spool_state.stats.records_dropped, spool_state.stats.fsyncs);
+    printf("Spool: segments %u-%u, %llu bytes on disk, drain rate %u B/s\n",
+           spool_state.head_segment, spool_state.tail_segment,
+           (unsigned long long)spool_state.stats.bytes_on_disk, spool_state.drain_rate);
+}
+
+SpoolState* spool_get_state(void) {
+    return &spool_state;
+}
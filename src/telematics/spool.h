@@ -0,0 +1,61 @@
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SPOOL_DEFAULT_DIR        "spool"
+#define SPOOL_SEGMENT_BYTES      (256 * 1024)   // Roll to a new segment file past this size
+#define SPOOL_MAX_SEGMENTS       64             // Disk cap: 16 MB, oldest segment dropped beyond it
+#define SPOOL_BUFFER_BYTES       (16 * 1024)    // RAM cap: appends buffered before write + fsync
+#define SPOOL_MAX_RECORD         (SPOOL_BUFFER_BYTES - 8)
+#define SPOOL_FSYNC_RECORDS      8              // fsync after this many buffered records...
+#define SPOOL_FSYNC_MS           1000           // ...or once this much time has passed
+#define SPOOL_DEFAULT_DRAIN_RATE (32 * 1024)    // Bytes per second replayed when the link returns
+
+typedef struct {
+    uint32_t records_spooled;
+    uint32_t records_drained;
+    uint32_t records_dropped;    // Lost to the disk cap or to a torn segment tail
+    uint32_t fsyncs;
+    uint64_t bytes_on_disk;
+} SpoolStats;
+
+// Store-and-forward spool - append-only segment files "seg_NNNNNNNN.tlm",
+// each record framed as u32 length | u32 FNV-1a checksum | payload.
+// Records are drained oldest-first; a fully drained segment is deleted.
+// Delivery is at-least-once: a partially drained segment is replayed from
+// its start after a restart.
+typedef struct {
+    char directory[128];
+    uint32_t head_segment;       // Oldest segment (read side)
+    uint32_t tail_segment;       // Newest segment (append side)
+    uint32_t tail_bytes;         // Bytes in the tail segment, including buffered
+    int head_fd;
+    uint32_t head_offset;
+    int tail_fd;
+    uint8_t buffer[SPOOL_BUFFER_BYTES];
+    uint32_t buffered_bytes;
+    uint32_t buffered_records;
+    uint64_t last_sync_us;
+    uint32_t drain_rate;         // Bytes per second
+    uint64_t drain_tokens;
+    uint64_t last_drain_us;
+    uint32_t peeked_length;      // Size of the record returned by the last peek
+    SpoolStats stats;
+} SpoolState;
+
+// Dependencies: none (POSIX file I/O only)
+bool spool_init(const char* directory);
+bool spool_append(const uint8_t* data, size_t length);
+bool spool_peek(uint8_t* out, size_t capacity, size_t* length);
+void spool_pop(void);
+void spool_sync(void);
+void spool_update(void);
+void spool_set_drain_rate(uint32_t bytes_per_second);
+bool spool_is_empty(void);
+void spool_print_stats(void);
+SpoolState* spool_get_state(void);
+
+#endif // SPOOL_H
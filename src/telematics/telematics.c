@@ -1,10 +1,19 @@
 #include "telematics.h"
+#include "telemetry.h"
+#include "track.h"
+#include "spool.h"
 #include "../canbus/canbus.h"
+#include "can_messages.h"
 #include "../diagnostics/diagnostics.h"
+#include "../coverage/coverage.h"
+#include "../geofence/geofence.h"
+#include "../guidance/guidance.h"
+#include "../common/rng.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 
 static TelematicsState telem_state = {
     .gps = {
@@ -29,10 +38,14 @@ static TelematicsState telem_state = {
 };
 
 static int update_counter = 0;
+static Rng telematics_rng;
+static double meters_per_deg_lat = 111132.92;
+static double meters_per_deg_lon = 111320.0;
 
 void telematics_init(void) {
     printf("[TELEMATICS] Initializing GPS/Telematics module\n");
     printf("[TELEMATICS] Acquiring GPS signal...\n");
+    rng_seed(&telematics_rng, rng_get_seed(), MODULE_TELEMATICS);
 
     // Simulate GPS acquisition
     telem_state.gps.satellites = 8;
@@ -41,6 +54,8 @@ void telematics_init(void) {
     printf("[TELEMATICS] GPS fix acquired - %d satellites\n", telem_state.gps.satellites);
     printf("[TELEMATICS] Position: %.4f, %.4f\n",
            telem_state.gps.latitude, telem_state.gps.longitude);
+    telematics_set_field_origin(telem_state.gps.latitude, telem_state.gps.longitude);
+    track_init(TRACK_EPSILON_M);
 
     // Simulate cloud connection
     telem_state.connectivity.cloud_connected = true;
@@ -48,6 +63,15 @@ void telematics_init(void) {
     printf("[TELEMATICS] Connected to cloud via %s (signal: %.0f%%)\n",
            telem_state.connectivity.connection_type,
            telem_state.connectivity.signal_strength);
+
+    telemetry_init();
+
+    // The spool and uplink keep their own files
+    CHECKPOINT_VAR("telematics", telem_state);
+    CHECKPOINT_VAR("telematics", update_counter);
+    CHECKPOINT_VAR("telematics", telematics_rng);
+    CHECKPOINT_VAR("telematics", meters_per_deg_lat);
+    CHECKPOINT_VAR("telematics", meters_per_deg_lon);
 }
 
 void telematics_update(void) {
@@ -56,26 +80,39 @@ void telematics_update(void) {
     // Update GPS position (simulate movement)
     if (telem_state.gps.gps_fix) {
         // Simulate tractor moving in a field pattern
-        telem_state.gps.latitude += 0.00001 * (rand() % 3 - 1);
-        telem_state.gps.longitude += 0.00001 * (rand() % 3 - 1);
-        telem_state.gps.speed_kmh = 8.0 + (rand() % 30) / 10.0; // 8-11 km/h
-        telem_state.gps.heading_deg = 90.0 + (rand() % 20 - 10); // Generally east
-
-        // Update field coverage (increases over time)
-        if (telem_state.field_coverage_percent < 100.0) {
-            telem_state.field_coverage_percent += 0.5;
-        }
+        telem_state.gps.latitude += 0.00001 * ((int)rng_below(&telematics_rng, 3) - 1);
+        telem_state.gps.longitude += 0.00001 * ((int)rng_below(&telematics_rng, 3) - 1);
+        telem_state.gps.speed_kmh = 8.0 + rng_below(&telematics_rng, 30) / 10.0; // 8-11 km/h
+        telem_state.gps.heading_deg = 90.0 + ((int)rng_below(&telematics_rng, 20) - 10); // Generally east
+
+        // Keep the full path - the recorder compresses it online
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        track_record(telem_state.gps.latitude, telem_state.gps.longitude,
+                     (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000));
+
+        // Sweep the implement swath into the coverage map
+        coverage_update();
+        telem_state.field_coverage_percent = coverage_get_state()->coverage_percent;
+
+        // Zone membership for implement/PTO reactions
+        geofence_update();
+
+        // Hand the fix to the 50 Hz guidance worker
+        float east, north;
+        telematics_to_local(telem_state.gps.latitude, telem_state.gps.longitude, &east, &north);
+        guidance_set_fix(east, north, telem_state.gps.heading_deg, telem_state.gps.speed_kmh);
     }
 
     // Update work hours
     telem_state.work_hours += 0.1 / 3600.0; // Increment by update interval
 
     // Simulate connectivity fluctuations
-    telem_state.connectivity.signal_strength = 75.0 + (rand() % 20);
+    telem_state.connectivity.signal_strength = 75.0 + rng_below(&telematics_rng, 20);
 
     // Check for connectivity issues
     if (telem_state.connectivity.signal_strength < 30.0) {
-        diagnostics_report_fault(SPN_CELLULAR_SIGNAL, FMI_DATA_BELOW_NORMAL, "Telematics", "Cellular signal strength below minimum threshold");
+        diagnostics_report_fault(FAULT_CELLULAR_SIGNAL_LOW);
         telem_state.connectivity.cloud_connected = false;
     } else {
         telem_state.connectivity.cloud_connected = true;
@@ -83,29 +120,64 @@ void telematics_update(void) {
 
     // Send GPS data via CAN bus
     if (update_counter % 10 == 0) {
-        uint8_t data[8] = {
-            (uint8_t)(telem_state.gps.latitude * 10000),
-            (uint8_t)(telem_state.gps.longitude * 10000),
-            (uint8_t)telem_state.gps.speed_kmh,
-            (uint8_t)telem_state.gps.heading_deg,
-            telem_state.gps.satellites,
-            (uint8_t)telem_state.connectivity.signal_strength,
-            0, 0
+        CanGpsPosition position = {
+            .latitude = telem_state.gps.latitude,
+            .longitude = telem_state.gps.longitude,
+        };
+        CanGpsStatus status = {
+            .speed = telem_state.gps.speed_kmh,
+            .heading = telem_state.gps.heading_deg,
+            .satellites = (uint8_t)telem_state.gps.satellites,
+            .signal_strength = telem_state.connectivity.signal_strength,
         };
-        canbus_send_message(0x230, data, 8);
+        uint8_t data[CAN_DLC_GPS_POSITION];
+        can_pack_gps_position(data, &position);
+        canbus_send_message(CAN_ID_GPS_POSITION, data, sizeof(data));
+        uint8_t status_data[CAN_DLC_GPS_STATUS];
+        can_pack_gps_status(status_data, &status);
+        canbus_send_message(CAN_ID_GPS_STATUS, status_data, sizeof(status_data));
     }
+
+    // Sample every module into the upload batch, then replay any spooled
+    // batches if the link is up
+    telemetry_sample();
+    telemetry_drain();
 }
 
 void telematics_send_status_update(void) {
     printf("[TELEMATICS] Sending status update to cloud...\n");
-    telem_state.connectivity.data_sent_kb += 5; // 5 KB update
+    telemetry_drain();
+    bool queued = telemetry_flush();
+
+    TelemetryStats* stats = &telemetry_get_state()->stats;
+    telem_state.connectivity.data_sent_kb = (int)(stats->bytes_sent / 1024);
+
+    if (queued) {
+        telem_state.connectivity.data_received_kb += 1;
+        printf("[TELEMATICS] Cloud sync queued (↑%llu bytes acknowledged, %.1f bytes/sample)\n",
+               (unsigned long long)stats->bytes_sent, stats->bytes_per_sample);
+    } else if (!spool_is_empty()) {
+        printf("[TELEMATICS] Cloud sync deferred - data spooled until the link returns\n");
+    } else {
+        printf("[TELEMATICS] Cloud sync failed\n");
+    }
+    telemetry_print_stats();
+}
 
-    // Simulate receiving acknowledgment
-    telem_state.connectivity.data_received_kb += 1;
+void telematics_set_field_origin(double latitude, double longitude) {
+    telem_state.field_origin_lat = latitude;
+    telem_state.field_origin_lon = longitude;
+    telematics_meters_per_degree(latitude, &meters_per_deg_lat, &meters_per_deg_lon);
+}
+
+void telematics_to_local(double latitude, double longitude, float* east_m, float* north_m) {
+    *east_m = (float)((longitude - telem_state.field_origin_lon) * meters_per_deg_lon);
+    *north_m = (float)((latitude - telem_state.field_origin_lat) * meters_per_deg_lat);
+}
 
-    printf("[TELEMATICS] Cloud sync complete (↑%d KB ↓%d KB)\n",
-           telem_state.connectivity.data_sent_kb,
-           telem_state.connectivity.data_received_kb);
+void telematics_from_local(float east_m, float north_m, double* latitude, double* longitude) {
+    *latitude = telem_state.field_origin_lat + north_m / meters_per_deg_lat;
+    *longitude = telem_state.field_origin_lon + east_m / meters_per_deg_lon;
 }
 
 TelematicsState* telematics_get_state(void) {
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <math.h>
 
 typedef struct {
     double latitude;
@@ -28,12 +29,29 @@ typedef struct {
     float field_coverage_percent;  // How much of field has been covered
     float work_hours;              // Operating hours today
     bool remote_command_pending;
+    double field_origin_lat;       // Origin of the local east/north field frame
+    double field_origin_lon;
 } TelematicsState;
 
+// Local field frame: metres east/north of the field origin. Equirectangular
+// with the WGS84 metres per degree at the origin latitude, so distances are
+// true at the origin; away from it the east scale drifts with northing by
+// tan(latitude) per radian, about 0.3 m per km east at 2 km north at 42 deg.
+// Every field module shares the frame, so it is self-consistent, but it is
+// not a survey projection.
+static inline void telematics_meters_per_degree(double latitude, double* per_lat, double* per_lon) {
+    double phi = latitude * M_PI / 180.0;
+    *per_lat = 111132.92 - 559.82 * cos(2.0 * phi) + 1.175 * cos(4.0 * phi) - 0.0023 * cos(6.0 * phi);
+    *per_lon = 111412.84 * cos(phi) - 93.5 * cos(3.0 * phi) + 0.118 * cos(5.0 * phi);
+}
+
 // Telematics functions
 void telematics_init(void);
 void telematics_update(void);
 void telematics_send_status_update(void);
+void telematics_set_field_origin(double latitude, double longitude);
+void telematics_to_local(double latitude, double longitude, float* east_m, float* north_m);
+void telematics_from_local(float east_m, float north_m, double* latitude, double* longitude);
 TelematicsState* telematics_get_state(void);
 
 #endif // TELEMATICS_H
@@ -0,0 +1,476 @@
+#include "telemetry.h"
+#include "telematics.h"
+#include "spool.h"
+#include "../engine/engine_control.h"
+#include "../transmission/transmission.h"
+#include "../hydraulics/hydraulics.h"
+#include "../pto/pto.h"
+#include "../implement/implement.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+static TelemetryState telemetry_state = {0};
+static uint64_t init_time_us = 0;
+
+// Upload worker: the cycle hands it one finished record at a time and
+// collects the result on a later cycle, so only the worker ever waits on
+// DNS, connect or the server. The cycle touches the record only while the
+// slot is not QUEUED.
+typedef enum {
+    UPLINK_IDLE = 0,
+    UPLINK_QUEUED,          // Handed to the worker
+    UPLINK_DONE,            // Result ready for the cycle
+    UPLINK_HELD             // Direct batch that failed behind newer spooled ones; sent first
+} UplinkSlot;
+
+static pthread_mutex_t uplink_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t uplink_wake = PTHREAD_COND_INITIALIZER;
+static pthread_t uplink_thread;
+static bool uplink_running;
+static uint64_t retry_at_us;     // No upload starts before this after a failure
+static struct {
+    UplinkSlot slot;
+    bool from_spool;
+    bool sent;
+    uint16_t samples;
+    size_t length;              // Compressed bytes after the u16 sample count
+    uint64_t batch_start_us;
+    uint64_t upload_us;
+    uint64_t finished_us;
+    uint32_t spool_segment;     // Spool head the record was peeked from
+    uint32_t spool_offset;
+    uint8_t record[SPOOL_MAX_RECORD];
+} uplink;
+
+_Static_assert(2 + TELEMETRY_MAX_COMPRESSED <= SPOOL_MAX_RECORD, "a batch record must fit the upload slot");
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint64_t cpu_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void uplink_start(void);
+static void uplink_stop(void);
+
+void telemetry_init(void) {
+    printf("[TELEMETRY] Initializing telemetry upload pipeline\n");
+    uplink_stop();
+    memset(&telemetry_state.batch, 0, sizeof(telemetry_state.batch));
+    memset(&telemetry_state.stats, 0, sizeof(telemetry_state.stats));
+    if (telemetry_state.endpoint.port == 0) {
+        telemetry_set_endpoint(TELEMETRY_DEFAULT_HOST, TELEMETRY_DEFAULT_PORT, TELEMETRY_DEFAULT_PATH);
+    }
+    spool_init(telemetry_state.spool_dir[0] ? telemetry_state.spool_dir : SPOOL_DEFAULT_DIR);
+    init_time_us = monotonic_us();
+    uplink_start();
+}
+
+void telemetry_set_endpoint(const char* host, uint16_t port, const char* path) {
+    snprintf(telemetry_state.endpoint.host, sizeof(telemetry_state.endpoint.host), "%s", host);
+    snprintf(telemetry_state.endpoint.path, sizeof(telemetry_state.endpoint.path), "%s", path);
+    telemetry_state.endpoint.port = port;
+    printf("[TELEMETRY] Upload endpoint: http://%s:%u%s\n", host, port, path);
+}
+
+void telemetry_set_spool_dir(const char* directory) {
+    snprintf(telemetry_state.spool_dir, sizeof(telemetry_state.spool_dir), "%s", directory);
+}
+
+bool telemetry_parse_endpoint(const char* spec) {
+    char host[64];
+    unsigned port = 0;
+    const char* colon = strrchr(spec, ':');
+    if (colon == NULL || colon == spec || (size_t)(colon - spec) >= sizeof(host)) {
+        return false;
+    }
+    memcpy(host, spec, (size_t)(colon - spec));
+    host[colon - spec] = '\0';
+
+    int consumed = 0;
+    if (sscanf(colon + 1, "%u%n", &port, &consumed) != 1 || port == 0 || port > 65535) {
+        return false;
+    }
+    const char* path = colon + 1 + consumed;
+    telemetry_set_endpoint(host, (uint16_t)port, *path == '/' ? path : TELEMETRY_DEFAULT_PATH);
+    return true;
+}
+
+void telemetry_sample(void) {
+    TelemetryBatch* batch = &telemetry_state.batch;
+    EngineState* engine = engine_get_state();
+    TransmissionState* trans = transmission_get_state();
+    HydraulicsState* hyd = hydraulics_get_state();
+    PTOState* pto = pto_get_state();
+    TelematicsState* telem = telematics_get_state();
+    ImplementState* impl = implement_get_state();
+
+    uint64_t now = monotonic_us();
+    int i = batch->sample_count;
+    if (i == 0) {
+        telemetry_state.batch_start_us = now;
+    }
+
+    batch->columns[TLM_CH_TIMESTAMP_MS][i] = (int32_t)((now - init_time_us) / 1000u);
+    batch->columns[TLM_CH_ENGINE_RPM][i]   = engine->current_rpm;
+    batch->columns[TLM_CH_COOLANT_TEMP][i] = (int32_t)(real_to_float(engine->coolant_temp) * 10.0f);
+    batch->columns[TLM_CH_FUEL_RATE][i]    = (int32_t)(real_to_float(engine->fuel_rate) * 10.0f);
+    batch->columns[TLM_CH_TRANS_GEAR][i]   = trans->current_gear;
+    batch->columns[TLM_CH_TRANS_OUTPUT][i] = (int32_t)real_to_float(trans->output_speed);
+    batch->columns[TLM_CH_TRANS_TEMP][i]   = (int32_t)(real_to_float(trans->transmission_temp) * 10.0f);
+    batch->columns[TLM_CH_HYD_PRESSURE][i] = (int32_t)real_to_float(hyd->system_pressure);
+    batch->columns[TLM_CH_HYD_OIL_TEMP][i] = (int32_t)(real_to_float(hyd->oil_temp) * 10.0f);
+    batch->columns[TLM_CH_PTO_RPM][i]      = pto->current_rpm;
+    batch->columns[TLM_CH_PTO_LOAD][i]     = (int32_t)(real_to_float(pto->load_percent) * 10.0f);
+    batch->columns[TLM_CH_LATITUDE][i]     = (int32_t)(telem->gps.latitude * 1e7);
+    batch->columns[TLM_CH_LONGITUDE][i]    = (int32_t)(telem->gps.longitude * 1e7);
+    batch->columns[TLM_CH_SPEED][i]        = (int32_t)(telem->gps.speed_kmh * 10.0f);
+    batch->columns[TLM_CH_HEADING][i]      = (int32_t)(telem->gps.heading_deg * 10.0f);
+    batch->columns[TLM_CH_IMPL_STATUS][i]  = impl->status;
+    batch->columns[TLM_CH_IMPL_DEPTH][i]   = (int32_t)(real_to_float(impl->working_depth_cm) * 10.0f);
+    batch->sample_count++;
+
+    if (batch->sample_count == TELEMETRY_BATCH_SAMPLES) {
+        telemetry_flush();
+    }
+}
+
+// Connect with a timeout so an unreachable endpoint cannot hold up the upload worker
+static int connect_endpoint(const TelemetryEndpoint* endpoint) {
+    char port[8];
+    snprintf(port, sizeof(port), "%u", endpoint->port);
+
+    struct addrinfo hints = {0};
+    struct addrinfo* result = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(endpoint->host, port, &hints, &result) != 0) {
+        return -1;
+    }
+
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(result);
+        return -1;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int rc = connect(fd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+
+    if (rc < 0 && errno == EINPROGRESS) {
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (poll(&pfd, 1, TELEMETRY_TIMEOUT_MS) == 1 &&
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0) {
+            rc = 0;
+        }
+    }
+    if (rc < 0) {
+        close(fd);
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, flags);
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = TELEMETRY_TIMEOUT_MS * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static bool send_all(int fd, const void* data, size_t length) {
+    const uint8_t* p = data;
+    while (length > 0) {
+        ssize_t n = send(fd, p, length, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool http_post(const TelemetryEndpoint* endpoint, const uint8_t* body, size_t length) {
+    int fd = connect_endpoint(endpoint);
+    if (fd < 0) return false;
+
+    char header[256];
+    int header_len = snprintf(header, sizeof(header),
+        "POST %s HTTP/1.1\r\n"
+        "Host: %s:%u\r\n"
+        "Content-Type: application/x-tractor-telemetry\r\n"
+        "Content-Encoding: x-zero-run\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n\r\n",
+        endpoint->path, endpoint->host, endpoint->port, length);
+
+    bool ok = header_len > 0 && (size_t)header_len < sizeof(header) &&
+              send_all(fd, header, (size_t)header_len) &&
+              send_all(fd, body, length);
+
+    if (ok) {
+        // Only the status line matters: "HTTP/1.x 2xx"
+        char response[64] = {0};
+        ssize_t n = recv(fd, response, sizeof(response) - 1, 0);
+        ok = n >= 12 && strncmp(response, "HTTP/1.", 7) == 0 && response[9] == '2';
+    }
+
+    close(fd);
+    return ok;
+}
+
+static void record_sent(uint16_t samples, size_t length) {
+    TelemetryStats* stats = &telemetry_state.stats;
+    stats->batches_sent++;
+    stats->samples_sent += samples;
+    stats->raw_bytes += (uint64_t)samples * TELEMETRY_CHANNEL_COUNT * sizeof(int32_t);
+    stats->bytes_sent += length;
+    stats->bytes_per_sample = (float)stats->bytes_sent / (float)stats->samples_sent;
+}
+
+static void* uplink_main(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&uplink_lock);
+    for (;;) {
+        while (uplink_running && uplink.slot != UPLINK_QUEUED) {
+            pthread_cond_wait(&uplink_wake, &uplink_lock);
+        }
+        // A record queued before the stop is still sent
+        if (uplink.slot != UPLINK_QUEUED) break;
+        TelemetryEndpoint endpoint = telemetry_state.endpoint;
+        pthread_mutex_unlock(&uplink_lock);
+
+        uint64_t start = monotonic_us();
+        bool sent = http_post(&endpoint, uplink.record + 2, uplink.length);
+        uint64_t end = monotonic_us();
+
+        pthread_mutex_lock(&uplink_lock);
+        uplink.sent = sent;
+        uplink.upload_us = end - start;
+        uplink.finished_us = end;
+        uplink.slot = UPLINK_DONE;
+    }
+    pthread_mutex_unlock(&uplink_lock);
+    return NULL;
+}
+
+static void uplink_start(void) {
+    uplink.slot = UPLINK_IDLE;
+    uplink_running = true;
+    if (pthread_create(&uplink_thread, NULL, uplink_main, NULL) != 0) {
+        printf("[TELEMETRY] Cannot start the upload worker - batches will be spooled\n");
+        uplink_running = false;
+    }
+}
+
+static void uplink_stop(void) {
+    pthread_mutex_lock(&uplink_lock);
+    bool was_running = uplink_running;
+    uplink_running = false;
+    pthread_cond_signal(&uplink_wake);
+    pthread_mutex_unlock(&uplink_lock);
+    if (was_running) {
+        pthread_join(uplink_thread, NULL);
+    }
+}
+
+static UplinkSlot uplink_slot(void) {
+    pthread_mutex_lock(&uplink_lock);
+    UplinkSlot slot = uplink.slot;
+    pthread_mutex_unlock(&uplink_lock);
+    return slot;
+}
+
+static void uplink_set_slot(UplinkSlot slot) {
+    pthread_mutex_lock(&uplink_lock);
+    uplink.slot = slot;
+    if (slot == UPLINK_QUEUED) {
+        pthread_cond_signal(&uplink_wake);
+    }
+    pthread_mutex_unlock(&uplink_lock);
+}
+
+static bool uplink_ready(void) {
+    return uplink_running && uplink_slot() == UPLINK_IDLE &&
+           (telemetry_state.stats.backoff_ms == 0 || monotonic_us() >= retry_at_us);
+}
+
+static bool spool_record(const uint8_t* record, size_t length, uint16_t samples) {
+    if (!spool_append(record, length)) {
+        return false;
+    }
+    telemetry_state.stats.batches_spooled++;
+    printf("[TELEMETRY] Upload deferred - spooled %u samples to disk\n", samples);
+    return true;
+}
+
+// Take the result of a finished upload; cycle side only
+static void uplink_collect(void) {
+    if (uplink_slot() != UPLINK_DONE) {
+        return;
+    }
+    TelemetryStats* stats = &telemetry_state.stats;
+    stats->last_upload_us = (uint32_t)uplink.upload_us;
+
+    // Exponential backoff: the drain and direct sends both wait it out
+    if (uplink.sent) {
+        stats->backoff_ms = 0;
+    } else {
+        stats->upload_failures++;
+        stats->backoff_ms = stats->backoff_ms == 0 ? TELEMETRY_BACKOFF_MIN_MS : stats->backoff_ms * 2;
+        if (stats->backoff_ms > TELEMETRY_BACKOFF_MAX_MS) stats->backoff_ms = TELEMETRY_BACKOFF_MAX_MS;
+        retry_at_us = uplink.finished_us + (uint64_t)stats->backoff_ms * 1000u;
+    }
+
+    if (uplink.sent) {
+        // The disk cap may have dropped the segment while the upload ran
+        const SpoolState* spool = spool_get_state();
+        if (uplink.from_spool && spool->head_segment == uplink.spool_segment &&
+            spool->head_offset == uplink.spool_offset) {
+            spool_pop();
+        }
+        if (!uplink.from_spool) {
+            stats->last_latency_us = (uint32_t)(uplink.finished_us - uplink.batch_start_us);
+        }
+        record_sent(uplink.samples, uplink.length);
+        uplink_set_slot(UPLINK_IDLE);
+    } else if (uplink.from_spool) {
+        uplink_set_slot(UPLINK_IDLE);   // Still at the spool head
+    } else if (spool_is_empty() && spool_record(uplink.record, uplink.length + 2, uplink.samples)) {
+        uplink_set_slot(UPLINK_IDLE);
+    } else {
+        // Newer batches were spooled while this one was in flight
+        uplink_set_slot(UPLINK_HELD);
+    }
+}
+
+bool telemetry_flush(void) {
+    TelemetryBatch* batch = &telemetry_state.batch;
+    TelemetryStats* stats = &telemetry_state.stats;
+    if (batch->sample_count == 0) {
+        return true;
+    }
+    uplink_collect();
+
+    // Records are u16 sample count + compressed batch, the same layout the spool stores
+    static uint8_t encoded[TELEMETRY_MAX_ENCODED];
+    static uint8_t record[2 + TELEMETRY_MAX_COMPRESSED];
+    uint16_t samples = batch->sample_count;
+
+    uint64_t cpu_start = cpu_time_us();
+    size_t encoded_len = telemetry_encode_batch(batch, encoded, sizeof(encoded));
+    size_t compressed_len = telemetry_compress(encoded, encoded_len, record + 2, sizeof(record) - 2);
+    stats->last_cpu_us = (uint32_t)(cpu_time_us() - cpu_start);
+    record[0] = (uint8_t)samples;
+    record[1] = (uint8_t)(samples >> 8);
+
+    // New data queues behind anything already spooled or in flight so
+    // uploads stay in order
+    bool queued = false;
+    bool connected = telematics_get_state()->connectivity.cloud_connected;
+    if (compressed_len > 0 && connected && spool_is_empty() && uplink_ready()) {
+        memcpy(uplink.record, record, compressed_len + 2);
+        uplink.length = compressed_len;
+        uplink.samples = samples;
+        uplink.from_spool = false;
+        uplink.batch_start_us = telemetry_state.batch_start_us;
+        uplink_set_slot(UPLINK_QUEUED);
+        queued = true;
+    } else if (compressed_len == 0 || !spool_record(record, compressed_len + 2, samples)) {
+        stats->batches_failed++;
+        printf("[TELEMETRY] Upload to %s:%u failed - dropped %u samples\n",
+               telemetry_state.endpoint.host, telemetry_state.endpoint.port, samples);
+    }
+
+    batch->sample_count = 0;
+    return queued;
+}
+
+void telemetry_drain(void) {
+    spool_update();
+    uplink_collect();
+    if (!telematics_get_state()->connectivity.cloud_connected || !uplink_running) {
+        return;
+    }
+
+    // One record in flight at a time: a held batch first, then the spool
+    // oldest-first; the spool enforces the drain rate
+    if (telemetry_state.stats.backoff_ms > 0 && monotonic_us() < retry_at_us) {
+        return;
+    }
+    UplinkSlot slot = uplink_slot();
+    if (slot == UPLINK_HELD) {
+        uplink_set_slot(UPLINK_QUEUED);
+        return;
+    }
+    size_t length;
+    while (slot == UPLINK_IDLE && spool_peek(uplink.record, sizeof(uplink.record), &length)) {
+        if (length <= 2) {
+            spool_pop();
+            continue;
+        }
+        const SpoolState* spool = spool_get_state();
+        uplink.samples = (uint16_t)(uplink.record[0] | (uplink.record[1] << 8));
+        uplink.length = length - 2;
+        uplink.from_spool = true;
+        uplink.spool_segment = spool->head_segment;
+        uplink.spool_offset = spool->head_offset;
+        uplink_set_slot(UPLINK_QUEUED);
+        return;
+    }
+}
+
+void telemetry_shutdown(void) {
+    telemetry_flush();
+    uplink_stop();   // Waits for the upload in flight
+    uplink_collect();
+    if (uplink.slot == UPLINK_HELD) {
+        spool_record(uplink.record, uplink.length + 2, uplink.samples);
+        uplink.slot = UPLINK_IDLE;
+    }
+    spool_sync();
+}
+
+void telemetry_print_stats(void) {
+    TelemetryStats* stats = &telemetry_state.stats;
+    printf("\n=== TELEMETRY UPLINK ===\n");
+    printf("Endpoint: http://%s:%u%s\n", telemetry_state.endpoint.host,
+           telemetry_state.endpoint.port, telemetry_state.endpoint.path);
+    printf("Batches sent/spooled/failed: %u / %u / %u\n",
+           stats->batches_sent, stats->batches_spooled, stats->batches_failed);
+    printf("Samples sent: %u\n", stats->samples_sent);
+    if (stats->bytes_sent > 0) {
+        printf("Bytes per sample: %.2f (%d channels, %.1fx vs raw)\n",
+               stats->bytes_per_sample, TELEMETRY_CHANNEL_COUNT,
+               (double)stats->raw_bytes / (double)stats->bytes_sent);
+    }
+    printf("Last batch: latency %u us, upload %u us, encode CPU %u us\n",
+           stats->last_latency_us, stats->last_upload_us, stats->last_cpu_us);
+    if (stats->upload_failures > 0) {
+        printf("Failed uploads: %u, current backoff %u ms\n", stats->upload_failures, stats->backoff_ms);
+    }
+    if (uplink_slot() == UPLINK_QUEUED) {
+        printf("Upload worker: %u samples in flight\n", uplink.samples);
+    }
+    spool_print_stats();
+    printf("========================\n\n");
+}
+
+TelemetryState* telemetry_get_state(void) {
+    return &telemetry_state;
+}
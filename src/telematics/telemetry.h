@@ -0,0 +1,59 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "telemetry_codec.h"
+
+#define TELEMETRY_DEFAULT_HOST "127.0.0.1"
+#define TELEMETRY_DEFAULT_PORT 8080
+#define TELEMETRY_DEFAULT_PATH "/telemetry"
+#define TELEMETRY_TIMEOUT_MS   250
+#define TELEMETRY_BACKOFF_MIN_MS 500     // Wait after a failed upload, doubled per failure...
+#define TELEMETRY_BACKOFF_MAX_MS 30000   // ...up to this
+
+typedef struct {
+    char host[64];
+    uint16_t port;
+    char path[64];
+} TelemetryEndpoint;
+
+typedef struct {
+    uint32_t batches_sent;
+    uint32_t batches_spooled;    // Deferred to the store-and-forward spool
+    uint32_t batches_failed;
+    uint32_t upload_failures;    // POSTs that got no 2xx answer
+    uint32_t backoff_ms;         // Wait before the next attempt, 0 after a success
+    uint32_t samples_sent;
+    uint64_t raw_bytes;          // Size as plain int32 columns
+    uint64_t bytes_sent;         // Compressed payload bytes acknowledged
+    float bytes_per_sample;      // All channels of one sample, on the wire
+    uint32_t last_latency_us;    // First sample of batch -> server acknowledgment
+    uint32_t last_cpu_us;        // CPU time to encode + compress the batch
+    uint32_t last_upload_us;     // Wall time of the HTTP exchange, on the worker
+} TelemetryStats;
+
+// Telemetry upload pipeline - samples all modules into columnar batches,
+// delta/varint encodes and compresses them, and POSTs them over HTTP from
+// an upload worker thread. The cycle never waits on the network: it hands
+// the worker one record at a time and collects the result a cycle later.
+typedef struct {
+    TelemetryBatch batch;
+    uint64_t batch_start_us;
+    TelemetryEndpoint endpoint;
+    TelemetryStats stats;
+    char spool_dir[128];
+} TelemetryState;
+
+// Dependencies: all modules (sampled), Telematics (cloud connectivity),
+// Spool (batches that cannot be sent are stored on disk and drained later)
+void telemetry_init(void);
+void telemetry_set_endpoint(const char* host, uint16_t port, const char* path);
+bool telemetry_parse_endpoint(const char* spec);   // "host:port[/path]"
+void telemetry_set_spool_dir(const char* directory);
+void telemetry_sample(void);
+bool telemetry_flush(void);      // true if the batch went to the upload worker
+void telemetry_drain(void);
+void telemetry_shutdown(void);
+void telemetry_print_stats(void);
+TelemetryState* telemetry_get_state(void);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,129 @@
+#include "telemetry_codec.h"
+
+static inline uint32_t zigzag_encode(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t zigzag_decode(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static inline size_t put_varint(uint8_t* out, uint32_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool get_varint(const uint8_t* in, size_t length, size_t* pos, uint32_t* value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= length) return false;
+        uint8_t byte = in[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t telemetry_encode_batch(const TelemetryBatch* batch, uint8_t* out, size_t capacity) {
+    if (batch->sample_count > TELEMETRY_BATCH_SAMPLES) return 0;
+    // Every value fits in 5 varint bytes, so checking the worst case up front
+    // keeps the inner loop free of bounds checks
+    if (capacity < 8 + (size_t)TELEMETRY_CHANNEL_COUNT * batch->sample_count * 5) return 0;
+
+    uint32_t magic = TELEMETRY_MAGIC;
+    out[0] = (uint8_t)magic;
+    out[1] = (uint8_t)(magic >> 8);
+    out[2] = (uint8_t)(magic >> 16);
+    out[3] = (uint8_t)(magic >> 24);
+    out[4] = TELEMETRY_VERSION;
+    out[5] = TELEMETRY_CHANNEL_COUNT;
+    out[6] = (uint8_t)batch->sample_count;
+    out[7] = (uint8_t)(batch->sample_count >> 8);
+
+    size_t pos = 8;
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        const int32_t* column = batch->columns[ch];
+        int32_t previous = 0;
+        for (int i = 0; i < batch->sample_count; i++) {
+            int32_t delta = (int32_t)((uint32_t)column[i] - (uint32_t)previous);
+            pos += put_varint(&out[pos], zigzag_encode(delta));
+            previous = column[i];
+        }
+    }
+    return pos;
+}
+
+bool telemetry_decode_batch(const uint8_t* in, size_t length, TelemetryBatch* batch) {
+    if (length < 8) return false;
+
+    uint32_t magic = (uint32_t)in[0] | ((uint32_t)in[1] << 8) |
+                     ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    uint16_t samples = (uint16_t)(in[6] | (in[7] << 8));
+    if (magic != TELEMETRY_MAGIC || in[4] != TELEMETRY_VERSION ||
+        in[5] != TELEMETRY_CHANNEL_COUNT || samples == 0 || samples > TELEMETRY_BATCH_SAMPLES) {
+        return false;
+    }
+
+    size_t pos = 8;
+    for (int ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ch++) {
+        int32_t previous = 0;
+        for (int i = 0; i < samples; i++) {
+            uint32_t raw;
+            if (!get_varint(in, length, &pos, &raw)) return false;
+            previous = (int32_t)((uint32_t)previous + (uint32_t)zigzag_decode(raw));
+            batch->columns[ch][i] = previous;
+        }
+    }
+    batch->sample_count = samples;
+    return pos == length;
+}
+
+size_t telemetry_compress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+    size_t pos = 0;
+    size_t i = 0;
+    while (i < length) {
+        if (in[i] != 0) {
+            if (pos >= capacity) return 0;
+            out[pos++] = in[i++];
+            continue;
+        }
+        // Steady signals encode as runs of zero deltas
+        size_t run = 1;
+        while (i + run < length && in[i + run] == 0 && run < 255) {
+            run++;
+        }
+        if (pos + 2 > capacity) return 0;
+        out[pos++] = 0;
+        out[pos++] = (uint8_t)run;
+        i += run;
+    }
+    return pos;
+}
+
+size_t telemetry_decompress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+    size_t pos = 0;
+    size_t i = 0;
+    while (i < length) {
+        if (in[i] != 0) {
+            if (pos >= capacity) return 0;
+            out[pos++] = in[i++];
+            continue;
+        }
+        if (i + 1 >= length) return 0;
+        size_t run = in[i + 1];
+        if (run == 0 || pos + run > capacity) return 0;
+        for (size_t k = 0; k < run; k++) {
+            out[pos++] = 0;
+        }
+        i += 2;
+    }
+    return pos;
+}
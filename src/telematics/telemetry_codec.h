@@ -0,0 +1,56 @@
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TELEMETRY_BATCH_SAMPLES 64
+#define TELEMETRY_MAGIC         0x314D4C54u   // "TLM1" little-endian
+#define TELEMETRY_VERSION       1
+
+// Signals sampled into each batch - one column per channel.
+// Values are fixed-point integers so deltas stay small.
+typedef enum {
+    TLM_CH_TIMESTAMP_MS = 0,   // ms since telemetry_init
+    TLM_CH_ENGINE_RPM,         // RPM
+    TLM_CH_COOLANT_TEMP,       // 0.1 °C
+    TLM_CH_FUEL_RATE,          // 0.1 L/hr
+    TLM_CH_TRANS_GEAR,         // GearPosition
+    TLM_CH_TRANS_OUTPUT,       // RPM
+    TLM_CH_TRANS_TEMP,         // 0.1 °C
+    TLM_CH_HYD_PRESSURE,       // PSI
+    TLM_CH_HYD_OIL_TEMP,       // 0.1 °C
+    TLM_CH_PTO_RPM,            // RPM
+    TLM_CH_PTO_LOAD,           // 0.1 %
+    TLM_CH_LATITUDE,           // 1e-7 deg
+    TLM_CH_LONGITUDE,          // 1e-7 deg
+    TLM_CH_SPEED,              // 0.1 km/h
+    TLM_CH_HEADING,            // 0.1 deg
+    TLM_CH_IMPL_STATUS,        // ImplementStatus
+    TLM_CH_IMPL_DEPTH,         // 0.1 cm
+    TELEMETRY_CHANNEL_COUNT
+} TelemetryChannel;
+
+// Columnar batch of samples
+typedef struct {
+    int32_t columns[TELEMETRY_CHANNEL_COUNT][TELEMETRY_BATCH_SAMPLES];
+    uint16_t sample_count;
+} TelemetryBatch;
+
+// Worst case: 8-byte header + 5 varint bytes per value
+#define TELEMETRY_MAX_ENCODED  (8 + TELEMETRY_CHANNEL_COUNT * TELEMETRY_BATCH_SAMPLES * 5)
+// Zero-run packing expands a lone zero byte to two bytes
+#define TELEMETRY_MAX_COMPRESSED (TELEMETRY_MAX_ENCODED * 2)
+
+// Wire format (all little-endian):
+//   u32 magic | u8 version | u8 channel count | u16 sample count (1-batch size)
+//   then per column: zigzag varint of the first value, then zigzag varint deltas
+// The encoded frame is then zero-run packed: each 0x00 byte is followed by
+// the length of the zero run (1-255), other bytes are copied through.
+size_t telemetry_encode_batch(const TelemetryBatch* batch, uint8_t* out, size_t capacity);
+bool telemetry_decode_batch(const uint8_t* in, size_t length, TelemetryBatch* batch);
+size_t telemetry_compress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity);
+size_t telemetry_decompress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity);
+
+#endif // TELEMETRY_CODEC_H
@@ -0,0 +1,188 @@
+#include "track.h"
+#include "telematics.h"
+#include "../common/checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+static TrackState track_state = { .epsilon_m = TRACK_EPSILON_M };
+
+static inline uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static inline uint8_t* put_varint(uint8_t* out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+void track_init(float epsilon_m) {
+    printf("[TRACK] Initializing GPS track recorder (error bound %.2f m)\n", epsilon_m);
+    track_state.bytes = 0;
+    track_state.window_count = 0;
+    track_state.has_anchor = false;
+    track_state.epsilon_m = epsilon_m;
+    track_state.points_recorded = 0;
+    track_state.vertices = 0;
+    track_state.full = false;
+    CHECKPOINT_VAR("track", track_state);
+}
+
+// Vertices are deltas from the previous vertex; the first is a delta from zero
+static void emit_vertex(const TrackPoint* point) {
+    if (track_state.bytes + 15 > TRACK_BUFFER_BYTES) {
+        if (!track_state.full) {
+            printf("[TRACK] Track buffer full - recording stopped\n");
+            track_state.full = true;
+        }
+        return;
+    }
+
+    TrackPoint previous = {0};
+    if (track_state.has_anchor) {
+        previous = track_state.anchor;
+    }
+    uint8_t* out = &track_state.data[track_state.bytes];
+    out = put_varint(out, zigzag(point->lat_e7 - previous.lat_e7));
+    out = put_varint(out, zigzag(point->lon_e7 - previous.lon_e7));
+    out = put_varint(out, point->time_ms - previous.time_ms);
+    track_state.bytes = (uint32_t)(out - track_state.data);
+    track_state.vertices++;
+
+    track_state.anchor = *point;
+    track_state.has_anchor = true;
+}
+
+// Distance in metres from p to segment a-b
+static float segment_distance(const TrackPoint* a, const TrackPoint* b, const TrackPoint* p) {
+    float bx = (b->lon_e7 - a->lon_e7) * track_state.meters_per_lon_e7;
+    float by = (b->lat_e7 - a->lat_e7) * track_state.meters_per_lat_e7;
+    float px = (p->lon_e7 - a->lon_e7) * track_state.meters_per_lon_e7;
+    float py = (p->lat_e7 - a->lat_e7) * track_state.meters_per_lat_e7;
+
+    float length_sq = bx * bx + by * by;
+    float t = length_sq > 0.0f ? (px * bx + py * by) / length_sq : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    float dx = px - t * bx;
+    float dy = py - t * by;
+    return sqrtf(dx * dx + dy * dy);
+}
+
+void track_record(double latitude, double longitude, uint32_t time_ms) {
+    if (track_state.full) return;
+
+    TrackPoint point = {
+        .lat_e7 = (int32_t)lround(latitude * 1e7),
+        .lon_e7 = (int32_t)lround(longitude * 1e7),
+        .time_ms = time_ms
+    };
+    track_state.points_recorded++;
+
+    if (!track_state.has_anchor) {
+        double per_lat, per_lon;
+        telematics_meters_per_degree(latitude, &per_lat, &per_lon);
+        track_state.meters_per_lat_e7 = (float)(per_lat / 1e7);
+        track_state.meters_per_lon_e7 = (float)(per_lon / 1e7);
+        emit_vertex(&point);
+        return;
+    }
+
+    // Opening window: extend the segment anchor -> point while every
+    // buffered fix stays within the error bound
+    bool fits = track_state.window_count < TRACK_WINDOW;
+    for (int i = 0; fits && i < track_state.window_count; i++) {
+        fits = segment_distance(&track_state.anchor, &point, &track_state.window[i]) <= track_state.epsilon_m;
+    }
+
+    if (!fits) {
+        // The previous fix closes the segment and anchors the next one
+        emit_vertex(&track_state.window[track_state.window_count - 1]);
+        track_state.window_count = 0;
+    }
+    track_state.window[track_state.window_count++] = point;
+}
+
+void track_finish(void) {
+    if (track_state.window_count > 0) {
+        emit_vertex(&track_state.window[track_state.window_count - 1]);
+        track_state.window_count = 0;
+    }
+}
+
+size_t track_decode(const uint8_t* data, size_t length, TrackPoint* out, size_t capacity) {
+    TrackPoint current = {0};
+    size_t count = 0;
+    size_t pos = 0;
+
+    while (pos < length && count < capacity) {
+        uint32_t fields[3];
+        for (int f = 0; f < 3; f++) {
+            uint32_t value = 0;
+            int shift = 0;
+            uint8_t byte;
+            do {
+                if (pos >= length || shift > 28) return count;
+                byte = data[pos++];
+                value |= (uint32_t)(byte & 0x7F) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            fields[f] = value;
+        }
+        current.lat_e7 += unzigzag(fields[0]);
+        current.lon_e7 += unzigzag(fields[1]);
+        current.time_ms += fields[2];
+        out[count++] = current;
+    }
+    return count;
+}
+
+bool track_save(const char* path) {
+    track_finish();
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("[TRACK] Cannot write %s\n", path);
+        return false;
+    }
+    uint32_t header[4] = { TRACK_MAGIC, track_state.points_recorded, track_state.vertices, track_state.bytes };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(track_state.data, 1, track_state.bytes, file) == track_state.bytes;
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+void track_print_stats(void) {
+    // Time a full decode of the stored track
+    static TrackPoint decoded[TRACK_BUFFER_BYTES / 3];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t count = track_decode(track_state.data, track_state.bytes, decoded,
+                                sizeof(decoded) / sizeof(decoded[0]));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double decode_us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+
+    uint32_t raw_bytes = track_state.points_recorded * (uint32_t)sizeof(TrackPoint);
+    printf("\n=== GPS TRACK ===\n");
+    printf("Fixes recorded: %u, vertices kept: %u (+%u pending)\n",
+           track_state.points_recorded, track_state.vertices, track_state.window_count);
+    printf("Storage: %u bytes vs %u raw (%.1fx), error bound %.2f m\n",
+           track_state.bytes, raw_bytes,
+           track_state.bytes > 0 ? (double)raw_bytes / track_state.bytes : 0.0,
+           track_state.epsilon_m);
+    printf("Full decode: %zu vertices in %.1f us\n", count, decode_us);
+    printf("=================\n\n");
+}
+
+TrackState* track_get_state(void) {
+    return &track_state;
+}
@@ -0,0 +1,49 @@
+#ifndef TRACK_H
+#define TRACK_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACK_DEFAULT_FILE  "field_track.trk"
+#define TRACK_MAGIC         0x314B5254u   // "TRK1"
+#define TRACK_EPSILON_M     0.10f         // Max deviation of a dropped fix from the kept path
+#define TRACK_WINDOW        128           // Fixes held while a segment is still open
+#define TRACK_BUFFER_BYTES  (1024 * 1024) // Encoded vertex storage
+
+// One fix in fixed point: 1e-7 degree (~1.1 cm) and milliseconds
+typedef struct {
+    int32_t lat_e7;
+    int32_t lon_e7;
+    uint32_t time_ms;
+} TrackPoint;
+
+// GPS track recorder - every fix is fed through an opening-window line
+// simplifier; only vertices needed to keep all fixes within TRACK_EPSILON_M
+// are stored, as zigzag-varint deltas of lat, lon and time. Dropped fixes
+// are reconstructed by interpolating between vertices.
+typedef struct {
+    uint8_t data[TRACK_BUFFER_BYTES];
+    uint32_t bytes;
+    TrackPoint window[TRACK_WINDOW];   // Fixes after the anchor, last one is the candidate vertex
+    uint16_t window_count;
+    TrackPoint anchor;                 // Last emitted vertex
+    bool has_anchor;
+    float meters_per_lon_e7;
+    float meters_per_lat_e7;
+    float epsilon_m;
+    uint32_t points_recorded;
+    uint32_t vertices;
+    bool full;
+} TrackState;
+
+// Dependencies: none - fed by Telematics
+void track_init(float epsilon_m);
+void track_record(double latitude, double longitude, uint32_t time_ms);
+void track_finish(void);
+size_t track_decode(const uint8_t* data, size_t length, TrackPoint* out, size_t capacity);
+bool track_save(const char* path);
+void track_print_stats(void);
+TrackState* track_get_state(void);
+
+#endif // TRACK_H
@@ -0,0 +1,166 @@
+#include "thermal.h"
+#include "../engine/engine_control.h"
+#include "../transmission/transmission.h"
+#include "../hydraulics/hydraulics.h"
+#include "../pto/pto.h"
+#include "../common/checkpoint.h"
+#include <stdio.h>
+
+// Heat capacities (kJ/K): fluid plus the metal it soaks into
+#define COOLANT_CAPACITY       REAL(95)
+#define TRANSMISSION_CAPACITY  REAL(110)
+#define HYDRAULIC_CAPACITY     REAL(75)
+
+// Conductances (kW/K). Cooler airflow scales with the belt-driven fan.
+#define RADIATOR_KW_K          2.2     // Fan at rated speed, thermostat fully open
+#define STILL_AIR_KW_K         0.05    // Engine block and radiator with the fan stopped
+#define TRANS_TO_COOLANT_KW_K  0.25    // Oil-to-coolant heat exchanger
+#define TRANS_CASE_KW_K        0.08
+#define HYD_COOLER_KW_K        0.35
+#define HYD_CASE_KW_K          0.05
+#define HYD_TO_TRANS_KW_K      0.05    // Shared rear housing wall
+
+#define THERMOSTAT_OPEN_C      82.0
+#define THERMOSTAT_FULL_C      92.0
+#define THERMOSTAT_BYPASS      0.05    // Minimum flow through the radiator
+
+// Heat sources
+#define FAN_RATED_RPM          2200
+#define FUEL_KW_PER_LPH        9.88    // Diesel LHV x density
+#define COOLANT_SHARE          0.28    // Share of fuel energy into the water jacket
+#define NM_RPM_PER_KW          9549.3
+#define PSI_GPM_PER_KW         2298.5
+#define GEARBOX_LOSS           0.04    // Share of driveline power lost in the gearbox
+#define PTO_LOSS               0.03
+#define CHURNING_KW            REAL(0.5)
+#define PUMP_LOSS_WORKING      0.25    // Relief and valve losses with circuits in use
+#define PUMP_LOSS_STANDBY      0.08
+
+static ThermalState thermal_state = {0};
+static real_t pending_s;    // Elapsed time not yet integrated
+
+void thermal_init(void) {
+    printf("[THERMAL] Initializing thermal model\n");
+    thermal_state.ambient_c = real_from_float(THERMAL_AMBIENT_C);
+    for (int i = 0; i < THERMAL_NODE_COUNT; i++) {
+        thermal_state.temp_c[i] = thermal_state.ambient_c;
+        thermal_state.heat_in_kw[i] = REAL(0);
+        thermal_state.rejected_kw[i] = REAL(0);
+    }
+    pending_s = REAL(0);
+    thermal_state.thermostat_open = REAL(THERMOSTAT_BYPASS);
+    CHECKPOINT_VAR("thermal", thermal_state);
+    CHECKPOINT_VAR("thermal", pending_s);
+}
+
+void thermal_set_ambient(float ambient_c) {
+    thermal_state.ambient_c = real_from_float(ambient_c);
+}
+
+ThermalState* thermal_get_state(void) {
+    return &thermal_state;
+}
+
+// Heat input per node from the current operating point; returns fan speed 0-1
+static real_t update_heat_sources(void) {
+    EngineState* engine = engine_get_state();
+    real_t* heat = thermal_state.heat_in_kw;
+    for (int i = 0; i < THERMAL_NODE_COUNT; i++) {
+        heat[i] = REAL(0);
+    }
+    if (!engine->engine_running) {
+        return REAL(0);
+    }
+
+    heat[THERMAL_COOLANT] = real_mul(engine->fuel_rate, REAL(FUEL_KW_PER_LPH * COOLANT_SHARE));
+
+    // Power = torque x speed; the speed is scaled first to stay in Q16.16 range
+    TransmissionState* transmission = transmission_get_state();
+    heat[THERMAL_TRANSMISSION_OIL] = CHURNING_KW;
+    if (transmission->clutch_engaged && transmission->current_gear > GEAR_NEUTRAL) {
+        real_t crank_kw = real_mul(engine->torque_nm,
+                                   real_div(real_from_int(engine->current_rpm), REAL(NM_RPM_PER_KW)));
+        heat[THERMAL_TRANSMISSION_OIL] = real_add(heat[THERMAL_TRANSMISSION_OIL],
+                                                  real_mul(crank_kw, REAL(GEARBOX_LOSS)));
+    }
+    PTOState* pto = pto_get_state();
+    if (pto->status == PTO_ENGAGED) {
+        real_t pto_kw = real_mul(pto->torque_nm,
+                                 real_div(real_from_int(pto->current_rpm), REAL(NM_RPM_PER_KW)));
+        heat[THERMAL_TRANSMISSION_OIL] = real_add(heat[THERMAL_TRANSMISSION_OIL],
+                                                  real_mul(pto_kw, REAL(PTO_LOSS)));
+    }
+
+    HydraulicsState* hydraulics = hydraulics_get_state();
+    real_t pump_kw = real_mul(hydraulics->system_pressure,
+                              real_div(hydraulics->flow_rate, REAL(PSI_GPM_PER_KW)));
+    bool working = hydraulics->pto_engaged || hydraulics->implement_raised;
+    heat[THERMAL_HYDRAULIC_OIL] = real_mul(pump_kw, working ? REAL(PUMP_LOSS_WORKING) : REAL(PUMP_LOSS_STANDBY));
+
+    return real_min(real_div(real_from_int(engine->current_rpm), REAL(FAN_RATED_RPM)), REAL(1));
+}
+
+// Backward Euler for one node with its neighbours at their latest values:
+//   C (T' - T) / h = Q + sum G_k (T_k - T')
+// weighted_sum is sum G_k T_k over neighbours and ambient. Stable for any h.
+// Solved for the increment, which keeps its precision at 1 kHz step sizes.
+static void node_step(ThermalNode node, real_t capacity, real_t h, real_t heat,
+                      real_t conductance, real_t weighted_sum) {
+    real_t temp = thermal_state.temp_c[node];
+    real_t net_kw = real_sub(real_add(heat, weighted_sum), real_mul(conductance, temp));
+    real_t increment = real_div(real_mul(h, net_kw), real_add(capacity, real_mul(h, conductance)));
+    thermal_state.temp_c[node] = real_add(temp, increment);
+}
+
+// One Gauss-Seidel sweep over the network
+static void integrate(real_t h, real_t fan) {
+    real_t* temp = thermal_state.temp_c;
+    const real_t* heat = thermal_state.heat_in_kw;
+    real_t ambient = thermal_state.ambient_c;
+
+    // Thermostat ramps the radiator in between its opening and full-open temperatures
+    real_t opening = real_div(real_sub(temp[THERMAL_COOLANT], REAL(THERMOSTAT_OPEN_C)),
+                              REAL(THERMOSTAT_FULL_C - THERMOSTAT_OPEN_C));
+    thermal_state.thermostat_open = real_min(real_max(opening, REAL(THERMOSTAT_BYPASS)), REAL(1));
+
+    real_t radiator = real_add(REAL(STILL_AIR_KW_K),
+                               real_mul(REAL(RADIATOR_KW_K), real_mul(fan, thermal_state.thermostat_open)));
+    real_t hyd_cooler = real_add(REAL(HYD_CASE_KW_K), real_mul(REAL(HYD_COOLER_KW_K), fan));
+    real_t ambient_g[THERMAL_NODE_COUNT] = { radiator, REAL(TRANS_CASE_KW_K), hyd_cooler };
+
+    node_step(THERMAL_COOLANT, COOLANT_CAPACITY, h, heat[THERMAL_COOLANT],
+        real_add(radiator, REAL(TRANS_TO_COOLANT_KW_K)),
+        real_add(real_mul(radiator, ambient), real_mul(REAL(TRANS_TO_COOLANT_KW_K), temp[THERMAL_TRANSMISSION_OIL])));
+
+    node_step(THERMAL_TRANSMISSION_OIL, TRANSMISSION_CAPACITY, h,
+        heat[THERMAL_TRANSMISSION_OIL],
+        REAL(TRANS_CASE_KW_K + TRANS_TO_COOLANT_KW_K + HYD_TO_TRANS_KW_K),
+        real_add(real_add(real_mul(REAL(TRANS_CASE_KW_K), ambient),
+                          real_mul(REAL(TRANS_TO_COOLANT_KW_K), temp[THERMAL_COOLANT])),
+                 real_mul(REAL(HYD_TO_TRANS_KW_K), temp[THERMAL_HYDRAULIC_OIL])));
+
+    node_step(THERMAL_HYDRAULIC_OIL, HYDRAULIC_CAPACITY, h,
+        heat[THERMAL_HYDRAULIC_OIL],
+        real_add(hyd_cooler, REAL(HYD_TO_TRANS_KW_K)),
+        real_add(real_mul(hyd_cooler, ambient), real_mul(REAL(HYD_TO_TRANS_KW_K), temp[THERMAL_TRANSMISSION_OIL])));
+
+    for (int i = 0; i < THERMAL_NODE_COUNT; i++) {
+        thermal_state.rejected_kw[i] = real_mul(ambient_g[i], real_sub(temp[i], ambient));
+    }
+}
+
+// Advances the network by dt seconds of simulated time. Results depend on
+// elapsed time, not on how often this is called: short updates accumulate
+// until THERMAL_MIN_STEP_S has passed, because per-call increments at 1 kHz
+// would fall below the resolution of the temperatures.
+void thermal_update(real_t dt_s) {
+    pending_s = real_add(pending_s, dt_s);
+    if (pending_s < REAL(THERMAL_MIN_STEP_S)) return;
+
+    real_t fan = update_heat_sources();
+    while (pending_s >= REAL(THERMAL_MIN_STEP_S)) {
+        real_t h = real_min(pending_s, REAL(THERMAL_MAX_STEP_S));
+        integrate(h, fan);
+        pending_s = real_sub(pending_s, h);
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include "../common/types.h"
+#include "../common/fixed.h"
+
+#define THERMAL_AMBIENT_C     20.0f
+#define THERMAL_MIN_STEP_S    0.1    // Shorter updates are accumulated
+#define THERMAL_MAX_STEP_S    2.0    // Longer updates are split into substeps
+
+// Lumped thermal network: each fluid is one node with a heat capacity,
+// linked to its neighbours and to ambient through conductances
+typedef enum {
+    THERMAL_COOLANT = 0,
+    THERMAL_TRANSMISSION_OIL,
+    THERMAL_HYDRAULIC_OIL,
+    THERMAL_NODE_COUNT
+} ThermalNode;
+
+typedef struct {
+    real_t temp_c[THERMAL_NODE_COUNT];
+    real_t heat_in_kw[THERMAL_NODE_COUNT];    // Heat from load in the last update
+    real_t rejected_kw[THERMAL_NODE_COUNT];   // Heat to ambient through coolers and cases
+    real_t ambient_c;
+    real_t thermostat_open;                   // 0-1, coolant thermostat opening
+} ThermalState;
+
+// Dependencies: Engine, Transmission, Hydraulics and PTO (heat sources and
+// fan speed). Those modules read their fluid temperatures back through
+// the sensor inputs, which sample the node temperatures here.
+void thermal_init(void);
+void thermal_update(real_t dt_s);
+void thermal_set_ambient(float ambient_c);
+ThermalState* thermal_get_state(void);
+
+#endif // THERMAL_H
@@ -1,67 +1,96 @@
 #include "transmission.h"
 #include "../engine/engine_control.h"
 #include "../canbus/canbus.h"
+#include "can_messages.h"
 #include "../diagnostics/diagnostics.h"
+#include "../sensors/sensors.h"
+#include "../common/change.h"
+#include "../common/checkpoint.h"
 #include <stdio.h>
 
 static TransmissionState transmission_state = {0};
-static const float gear_ratios[] = {0.0, 0.0, 3.5, 2.2, 1.5, 1.0, -4.0};
+static const real_t gear_ratios[] = {REAL(0.0), REAL(0.0), REAL(3.5), REAL(2.2), REAL(1.5), REAL(1.0), REAL(-4.0)};
+static ChangeTracker update_tracker;
+static uint32_t command_generation;    // Gear and clutch commands
+
+static void command_changed(void) {
+    command_generation++;
+    change_publish(&transmission_state.generation, true);
+}
 
 void transmission_init(void) {
     printf("[TRANSMISSION] Initializing transmission control module\n");
     transmission_state.current_gear = GEAR_PARK;
-    transmission_state.clutch_position = 0.0;
-    transmission_state.output_speed = 0.0;
-    transmission_state.transmission_temp = 20.0;
-    transmission_state.oil_pressure = 50.0;
+    transmission_state.clutch_position = REAL(0);
+    transmission_state.output_speed = REAL(0);
+    transmission_state.transmission_temp = REAL(20);
+    transmission_state.oil_pressure = REAL(50);
     transmission_state.clutch_engaged = false;
     transmission_state.status = STATUS_OK;
+    change_tracker_init(&update_tracker, "Transmission");
+    CHECKPOINT_VAR("transmission", transmission_state);
+    CHECKPOINT_VAR_FROM("transmission", update_tracker, seen);
+    CHECKPOINT_VAR("transmission", command_generation);
 }
 
 void transmission_update(void) {
     // Get engine state
     EngineState* engine = engine_get_state();
+    transmission_state.transmission_temp = sensors_read(SENSOR_TRANS_OIL_TEMP);
 
-    if (engine->engine_running && transmission_state.clutch_engaged) {
-        // Calculate output speed based on gear ratio
-        float ratio = gear_ratios[transmission_state.current_gear];
-        if (ratio != 0.0) {
-            transmission_state.output_speed = engine->current_rpm / ratio;
+    // Output speed only moves with engine speed, gear and clutch
+    const uint32_t inputs[] = { engine->generation, command_generation };
+    if (change_tracker_update(&update_tracker, inputs, 2)) {
+        real_t previous_speed = transmission_state.output_speed;
+        if (engine->engine_running && transmission_state.clutch_engaged) {
+            // Calculate output speed based on gear ratio
+            real_t ratio = gear_ratios[transmission_state.current_gear];
+            if (ratio != REAL(0)) {
+                transmission_state.output_speed = real_div(real_from_int(engine->current_rpm), ratio);
+            } else {
+                transmission_state.output_speed = REAL(0);
+            }
         } else {
-            transmission_state.output_speed = 0.0;
+            transmission_state.output_speed = REAL(0);
         }
+        change_publish(&transmission_state.generation, transmission_state.output_speed != previous_speed);
 
-        // Temperature increases with use
-        transmission_state.transmission_temp += 0.2;
-    } else {
-        transmission_state.output_speed = 0.0;
+        // Send speed data to CAN bus
+        CanTransmissionStatus status = {
+            .output_speed = real_to_float(transmission_state.output_speed),
+            .gear = (uint8_t)transmission_state.current_gear,
+            .clutch_engaged = transmission_state.clutch_engaged,
+        };
+        uint8_t data[CAN_DLC_TRANSMISSION_STATUS];
+        can_pack_transmission_status(data, &status);
+        canbus_send_message(CAN_ID_TRANSMISSION_STATUS, data, sizeof(data));
     }
 
-    // Send speed data to CAN bus
-    canbus_send_message(0x300, (uint8_t*)&transmission_state.output_speed, 4);
-
     // Check for fault conditions
     SystemStatus health = transmission_check_health();
     if (health != STATUS_OK) {
-        diagnostics_report_fault(SPN_TRANS_OIL_TEMP, FMI_DATA_ABOVE_NORMAL, "Transmission", "Transmission oil temperature above normal operating range");
+        diagnostics_report_fault(FAULT_TRANS_OIL_TEMP_HIGH);
     }
 }
 
 void transmission_shift_gear(GearPosition gear) {
     printf("[TRANSMISSION] Shifting to gear: %d\n", gear);
     transmission_state.current_gear = gear;
+    command_changed();
 }
 
 void transmission_engage_clutch(void) {
     printf("[TRANSMISSION] Engaging clutch\n");
     transmission_state.clutch_engaged = true;
-    transmission_state.clutch_position = 100.0;
+    transmission_state.clutch_position = REAL(100);
+    command_changed();
 }
 
 void transmission_disengage_clutch(void) {
     printf("[TRANSMISSION] Disengaging clutch\n");
     transmission_state.clutch_engaged = false;
-    transmission_state.clutch_position = 0.0;
+    transmission_state.clutch_position = REAL(0);
+    command_changed();
 }
 
 TransmissionState* transmission_get_state(void) {
@@ -69,11 +98,11 @@ TransmissionState* transmission_get_state(void) {
 }
 
 SystemStatus transmission_check_health(void) {
-    if (transmission_state.transmission_temp > 120.0) {
+    if (transmission_state.transmission_temp > REAL(120)) {
         transmission_state.status = STATUS_CRITICAL;
         return STATUS_CRITICAL;
     }
-    if (transmission_state.oil_pressure < 25.0) {
+    if (transmission_state.oil_pressure < REAL(25)) {
         transmission_state.status = STATUS_WARNING;
         return STATUS_WARNING;
     }
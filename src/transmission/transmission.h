@@ -2,6 +2,7 @@
 #define TRANSMISSION_H
 
 #include "../common/types.h"
+#include "../common/fixed.h"
 
 // Transmission control module - manages gear selection, clutch, speed
 typedef enum {
@@ -16,15 +17,17 @@ typedef enum {
 
 typedef struct {
     GearPosition current_gear;
-    float clutch_position;     // 0-100%
-    float output_speed;        // RPM
-    float transmission_temp;   // Celsius
-    float oil_pressure;        // PSI
+    real_t clutch_position;     // 0-100%
+    real_t output_speed;        // RPM
+    real_t transmission_temp;   // Celsius
+    real_t oil_pressure;        // PSI
     bool clutch_engaged;
     SystemStatus status;
+    uint32_t generation;        // Bumped when output speed, gear or clutch changes
 } TransmissionState;
 
-// Dependencies: Engine (needs RPM), CANBus (send speed data), Diagnostics
+// Dependencies: Engine (needs RPM), CANBus (send speed data), Diagnostics,
+// Sensors (oil temperature)
 void transmission_init(void);
 void transmission_update(void);
 void transmission_shift_gear(GearPosition gear);
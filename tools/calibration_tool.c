@@ -0,0 +1,85 @@
+// Writes engine calibration files and benchmarks the table lookups.
+//
+// Usage: calibration_tool write <output> [stock|eco]
+//        calibration_tool bench [iterations]
+
+#include "engine/calibration.h"
+#include "common/rng.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_INPUTS     4096
+#define BENCH_RNG_STREAM 1
+
+static int write_calibration(const char* path, const char* variant) {
+    CalibrationSet set;
+    calibration_defaults(&set);
+    if (strcmp(variant, "eco") == 0) {
+        // Lower governed speeds and a 15% torque limit for light field work
+        snprintf(set.name, sizeof(set.name), "eco");
+        for (uint32_t i = 0; i < set.throttle_speed.count; i++) {
+            set.throttle_speed.values[i] = 800.0f + (set.throttle_speed.values[i] - 800.0f) * 0.8f;
+        }
+        for (uint32_t i = 0; i < set.torque_curve.count; i++) {
+            set.torque_curve.values[i] *= 0.85f;
+        }
+    } else if (strcmp(variant, "stock") != 0) {
+        fprintf(stderr, "Unknown calibration variant '%s'\n", variant);
+        return 1;
+    }
+    if (!calibration_prepare(&set) || !calibration_save(path, &set)) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return 1;
+    }
+    printf("Wrote '%s' calibration to %s\n", set.name, path);
+    return 0;
+}
+
+static int bench(long iterations) {
+    CalibrationSet set;
+    calibration_defaults(&set);
+
+    // Pseudo-random operating points so the branch predictor cannot learn them
+    static real_t rpm[BENCH_INPUTS], load[BENCH_INPUTS];
+    Rng rng;
+    rng_seed(&rng, RNG_DEFAULT_SEED, BENCH_RNG_STREAM);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        rpm[i] = real_from_float(700.0f + rng_below(&rng, 2000));
+        load[i] = real_from_float(rng_below(&rng, 1100) / 10.0f);
+    }
+
+    volatile real_t sink = REAL(0);
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        sink = real_add(sink, cal_lookup_1d(&set.torque_curve, rpm[n & (BENCH_INPUTS - 1)]));
+    }
+    double lookup_1d = (now_ns() - start) / iterations;
+
+    start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        int k = n & (BENCH_INPUTS - 1);
+        sink = real_add(sink, cal_lookup_2d(&set.fuel_map, rpm[k], load[k]));
+    }
+    double lookup_2d = (now_ns() - start) / iterations;
+    (void)sink;
+
+    printf("1D torque curve: %.1f ns/lookup\n", lookup_1d);
+    printf("2D fuel map:     %.1f ns/lookup\n", lookup_2d);
+    printf("Fuel at 1700 RPM / 60%% load: %.2f L/hr\n",
+           real_to_float(cal_lookup_2d(&set.fuel_map, REAL(1700), REAL(60))));
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "write") == 0) {
+        return write_calibration(argv[2], argc > 3 ? argv[3] : "stock");
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        long iterations = argc > 2 ? atol(argv[2]) : 10000000;
+        return bench(iterations > 0 ? iterations : 1);
+    }
+    fprintf(stderr, "Usage: %s write <output> [stock|eco]\n       %s bench [iterations]\n", argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,276 @@
+// Round-trip check and throughput benchmark for the generated CAN codecs
+// (build/generated/can_messages.h, from src/canbus/tractor.dbc).
+//
+// The check packs random frames with the generated code and compares the
+// bytes against a slow bit-by-bit reference packer driven by the signal
+// table, then unpacks and compares the values; it also checks rounding of
+// off-grid values and clamping of out-of-range and NaN inputs. The
+// benchmark times encode and decode per message type.
+//
+// Usage: can_bench [--check] [frames per message]
+
+#include "can_messages.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define BENCH_FRAMES 1024
+#define MAX_MESSAGE_BYTES 64
+
+typedef struct {
+    const char* name;
+    uint32_t id;
+    int dlc;
+    size_t size;
+    void (*pack)(uint8_t* data, const void* msg);
+    void (*unpack)(const uint8_t* data, void* msg);
+} MessageInfo;
+
+typedef struct {
+    const char* message;
+    const char* field;
+    int start;
+    int length;
+    bool big_endian;
+    bool is_signed;
+    double scale;
+    double offset;
+    double min;
+    double max;
+    bool raw;                     // Integer field, stored unscaled
+    void (*set)(void* msg, uint64_t raw, double value);
+    uint64_t (*get_raw)(const void* msg);
+    double (*get)(const void* msg);
+} SignalInfo;
+
+// Message and signal tables from the generated X-macros
+#define MESSAGE_WRAPPERS(m, S, id, dlc) \
+    typedef S m##_t; \
+    static void pack_##m(uint8_t* data, const void* msg) { can_pack_##m(data, msg); } \
+    static void unpack_##m(const uint8_t* data, void* msg) { can_unpack_##m(data, msg); }
+CAN_MESSAGES(MESSAGE_WRAPPERS)
+
+#define SIGNAL_ACCESSORS(m, f, start, length, be, sg, scale, offset, min, max) \
+    static void set_##m##_##f(void* p, uint64_t raw, double value) { \
+        m##_t* msg = p; \
+        msg->f = _Generic(msg->f, float: (float)value, double: value, default: (__typeof__(msg->f))raw); \
+    } \
+    static uint64_t get_raw_##m##_##f(const void* p) { return (uint64_t)(int64_t)((const m##_t*)p)->f; } \
+    static double get_##m##_##f(const void* p) { return (double)((const m##_t*)p)->f; }
+CAN_SIGNALS(SIGNAL_ACCESSORS)
+
+#define MESSAGE_ENTRY(m, S, id, dlc) { #m, id, dlc, sizeof(S), pack_##m, unpack_##m },
+static const MessageInfo messages[] = { CAN_MESSAGES(MESSAGE_ENTRY) };
+#define MESSAGE_COUNT (sizeof(messages) / sizeof(messages[0]))
+
+#define SIGNAL_ENTRY(m, f, start, length, be, sg, scale, offset, min, max) \
+    { #m, #f, start, length, be, sg, scale, offset, min, max, \
+      _Generic(((m##_t*)0)->f, float: false, double: false, default: true), \
+      set_##m##_##f, get_raw_##m##_##f, get_##m##_##f },
+static const SignalInfo signals[] = { CAN_SIGNALS(SIGNAL_ENTRY) };
+#define SIGNAL_COUNT (sizeof(signals) / sizeof(signals[0]))
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double uniform(double low, double high) {
+    return low + (high - low) * (double)(next_random() >> 11) / 9007199254740992.0;
+}
+
+static int64_t raw_min(const SignalInfo* s) { return llround((s->min - s->offset) / s->scale); }
+static int64_t raw_max(const SignalInfo* s) { return llround((s->max - s->offset) / s->scale); }
+
+// Random raw value in the signal's range, stored into the message
+static uint64_t set_random(const SignalInfo* s, void* msg) {
+    uint64_t raw;
+    if (s->length == 64 && !s->is_signed) {
+        raw = next_random();
+    } else {
+        int64_t low = raw_min(s);
+        uint64_t span = (uint64_t)(raw_max(s) - low) + 1;
+        raw = (uint64_t)(low + (int64_t)(next_random() % span));
+    }
+    s->set(msg, raw, (double)(int64_t)raw * s->scale + s->offset);
+    return raw;
+}
+
+// Reference packer: one bit at a time, LSB upwards for Intel signals and
+// MSB downwards (following the Motorola bit numbering) for big-endian ones
+static void reference_place(uint8_t* data, const SignalInfo* s, uint64_t raw) {
+    int position = s->start;
+    for (int i = 0; i < s->length; i++) {
+        int bit = s->big_endian ? s->length - 1 - i : i;
+        if ((raw >> bit) & 1) {
+            data[position / 8] |= (uint8_t)(1u << (position % 8));
+        }
+        if (s->big_endian) {
+            position = position % 8 == 0 ? position + 15 : position - 1;
+        } else {
+            position++;
+        }
+    }
+}
+
+static bool message_matches(const SignalInfo* s, const MessageInfo* m) {
+    return strcmp(s->message, m->name) == 0;
+}
+
+static int check_message(const MessageInfo* m, long frames) {
+    _Alignas(8) uint8_t msg[MAX_MESSAGE_BYTES], out[MAX_MESSAGE_BYTES];
+    uint64_t raws[SIGNAL_COUNT];
+    int failures = 0;
+    double worst_error = 0.0;
+
+    for (long n = 0; n < frames && failures < 10; n++) {
+        // Values on the raw grid must pack to the reference bytes exactly
+        memset(msg, 0, sizeof(msg));
+        uint8_t data[8] = {0}, expected[8] = {0};
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            if (!message_matches(&signals[i], m)) continue;
+            raws[i] = set_random(&signals[i], msg);
+            reference_place(expected, &signals[i], raws[i]);
+        }
+        m->pack(data, msg);
+        if (memcmp(data, expected, (size_t)m->dlc) != 0) {
+            printf("  %s: packed bytes differ from the reference\n", m->name);
+            failures++;
+        }
+        m->unpack(data, out);
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            const SignalInfo* s = &signals[i];
+            if (!message_matches(s, m)) continue;
+            bool ok;
+            if (s->raw) {
+                uint64_t mask = s->length == 64 ? ~0ull : (1ull << s->length) - 1;
+                ok = (s->get_raw(out) & mask) == (raws[i] & mask);
+            } else {
+                double steps = fabs(s->get(out) - s->get(msg)) / s->scale;
+                if (steps > worst_error) worst_error = steps;
+                ok = steps <= 0.5;
+            }
+            if (!ok) {
+                printf("  %s.%s: unpacked value differs\n", m->name, s->field);
+                failures++;
+            }
+        }
+
+        // Physical signals: off-grid values round to the nearest step,
+        // out-of-range values and NaN clamp to the range
+        for (size_t i = 0; i < SIGNAL_COUNT; i++) {
+            const SignalInfo* s = &signals[i];
+            if (!message_matches(s, m) || s->raw) continue;
+            double cases[4] = { uniform(s->min, s->max), s->max + uniform(1.0, 1000.0) * s->scale,
+                                s->min - uniform(1.0, 1000.0) * s->scale, NAN };
+            double expect[4] = { cases[0], s->max, s->min, s->min };
+            for (int c = 0; c < 4; c++) {
+                s->set(msg, 0, cases[c]);
+                m->pack(data, msg);
+                m->unpack(data, out);
+                double tolerance = s->scale * 0.5 * (1.0 + 1e-3) + fabs(expect[c]) * 1e-6;
+                if (!(fabs(s->get(out) - expect[c]) <= tolerance)) {
+                    printf("  %s.%s: %g came back as %g\n", m->name, s->field, cases[c], s->get(out));
+                    failures++;
+                }
+            }
+        }
+    }
+    printf("  0x%03X %-22s %s (worst on-grid error %.3g steps)\n", m->id, m->name,
+           failures == 0 ? "ok" : "FAILED", worst_error);
+    return failures;
+}
+
+// Encode and decode timing with the codecs inlined into the loops
+typedef struct {
+    double pack_ns;
+    double unpack_ns;
+} BenchResult;
+
+static volatile uint64_t bench_sink;
+
+#define BENCH_MESSAGE(m, S, id, dlc) \
+    static BenchResult bench_##m(long rounds) { \
+        static S values[BENCH_FRAMES], decoded[BENCH_FRAMES]; \
+        static uint8_t frames[BENCH_FRAMES][8]; \
+        for (int n = 0; n < BENCH_FRAMES; n++) { \
+            for (size_t i = 0; i < SIGNAL_COUNT; i++) { \
+                if (strcmp(signals[i].message, #m) == 0) set_random(&signals[i], &values[n]); \
+            } \
+        } \
+        BenchResult result; \
+        uint64_t sink = 0; \
+        double start = now_ns(); \
+        for (long r = 0; r < rounds; r++) { \
+            for (int n = 0; n < BENCH_FRAMES; n++) can_pack_##m(frames[n], &values[n]); \
+            sink += frames[r % BENCH_FRAMES][0]; \
+        } \
+        result.pack_ns = (now_ns() - start) / ((double)rounds * BENCH_FRAMES); \
+        start = now_ns(); \
+        for (long r = 0; r < rounds; r++) { \
+            for (int n = 0; n < BENCH_FRAMES; n++) can_unpack_##m(frames[n], &decoded[n]); \
+            sink += *(const uint8_t*)&decoded[r % BENCH_FRAMES]; \
+        } \
+        result.unpack_ns = (now_ns() - start) / ((double)rounds * BENCH_FRAMES); \
+        bench_sink = sink; \
+        return result; \
+    }
+
+CAN_MESSAGES(BENCH_MESSAGE)
+
+#define BENCH_ENTRY(m, S, id, dlc) bench_##m,
+static BenchResult (*const bench_functions[])(long) = { CAN_MESSAGES(BENCH_ENTRY) };
+
+int main(int argc, char* argv[]) {
+    bool check_only = false;
+    long frames = 20000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if (argv[i][0] != '-') {
+            frames = strtol(argv[i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--check] [frames per message]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        if (messages[i].size > MAX_MESSAGE_BYTES) {
+            fprintf(stderr, "%s is larger than %d bytes\n", messages[i].name, MAX_MESSAGE_BYTES);
+            return 1;
+        }
+    }
+
+    printf("Round trip: %zu messages, %zu signals, %ld frames each\n", MESSAGE_COUNT, SIGNAL_COUNT, frames);
+    int failures = 0;
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        failures += check_message(&messages[i], frames);
+    }
+    printf("Round trip %s\n", failures == 0 ? "PASSED" : "FAILED");
+    if (check_only || failures != 0) {
+        return failures == 0 ? 0 : 1;
+    }
+
+    long rounds = frames / 10 > 0 ? frames / 10 : 1;
+    printf("\nThroughput (%ld x %d frames per message):\n", rounds, BENCH_FRAMES);
+    printf("  %-28s %10s %10s\n", "Message", "Encode ns", "Decode ns");
+    double total_pack = 0.0, total_unpack = 0.0;
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        BenchResult result = bench_functions[i](rounds);
+        total_pack += result.pack_ns;
+        total_unpack += result.unpack_ns;
+        printf("  0x%03X %-22s %10.2f %10.2f\n", messages[i].id, messages[i].name,
+               result.pack_ns, result.unpack_ns);
+    }
+    printf("  %-28s %10.2f %10.2f\n", "Mean", total_pack / MESSAGE_COUNT, total_unpack / MESSAGE_COUNT);
+    return 0;
+}
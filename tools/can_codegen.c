@@ -0,0 +1,403 @@
+// Generates CAN message codecs from a DBC-style definition file: one
+// struct per message plus inline pack/unpack functions that place every
+// signal with constant shifts and masks, so the codec has no loops over
+// signals and no data-dependent branches.
+//
+// Supported DBC subset:
+//   BO_ <id> <Name>: <dlc> <sender>
+//    SG_ <Name> : <start>|<length>@<1 Intel|0 Motorola><+|-> (<scale>,<offset>) [<min>|<max>] "<unit>" <receivers>
+//   CM_ SG_ <id> <Name> "<comment>";
+// Other lines are ignored. Signals with scale 1, offset 0 and no range
+// ([0|0]) are raw integers (counters, enums, bit masks); all others are
+// physical values, clamped to their range when packed.
+//
+// Usage: can_codegen <definition.dbc> <output.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAX_MESSAGES    64
+#define MAX_SIGNALS     512
+#define NAME_LEN        64
+#define TEXT_LEN        128
+
+typedef struct {
+    uint32_t id;
+    int dlc;
+    char name[NAME_LEN];
+    char snake[NAME_LEN];
+    char upper[NAME_LEN];
+    int first_signal;
+    int signal_count;
+} Message;
+
+typedef struct {
+    char name[NAME_LEN];
+    char snake[NAME_LEN];
+    int start;
+    int length;
+    bool big_endian;
+    bool is_signed;
+    double scale;
+    double offset;
+    double min;
+    double max;
+    char unit[TEXT_LEN];
+    char comment[TEXT_LEN];
+    // Derived
+    bool raw;                  // Integer field, no scaling
+    bool wide;                 // Physical value needs double precision
+    int shift;                 // Position of the raw LSB in the LE or BE frame word
+    double raw_min;
+    double raw_max;
+} Signal;
+
+static Message messages[MAX_MESSAGES];
+static Signal signals[MAX_SIGNALS];
+static int message_count = 0;
+static int signal_count = 0;
+
+static void to_snake(const char* name, char* snake, char* upper) {
+    size_t n = 0;
+    for (size_t i = 0; name[i] != '\0' && n + 2 < NAME_LEN; i++) {
+        char c = name[i];
+        if (isupper((unsigned char)c) && i > 0 && !isupper((unsigned char)name[i - 1])) {
+            snake[n] = '_';
+            if (upper != NULL) upper[n] = '_';
+            n++;
+        }
+        snake[n] = (char)tolower((unsigned char)c);
+        if (upper != NULL) upper[n] = (char)toupper((unsigned char)c);
+        n++;
+    }
+    snake[n] = '\0';
+    if (upper != NULL) upper[n] = '\0';
+}
+
+static bool parse_message(const char* line) {
+    Message* m = &messages[message_count];
+    unsigned long id;
+    char name[NAME_LEN];
+    int dlc;
+    if (sscanf(line, " BO_ %lu %63[^: ] : %d", &id, name, &dlc) != 3) return false;
+    if (message_count == MAX_MESSAGES || dlc < 1 || dlc > 8) return false;
+    m->id = (uint32_t)id;
+    m->dlc = dlc;
+    snprintf(m->name, sizeof(m->name), "%s", name);
+    to_snake(name, m->snake, m->upper);
+    m->first_signal = signal_count;
+    m->signal_count = 0;
+    message_count++;
+    return true;
+}
+
+static bool parse_signal(const char* line) {
+    if (message_count == 0 || signal_count == MAX_SIGNALS) return false;
+    Signal* s = &signals[signal_count];
+    memset(s, 0, sizeof(*s));
+    int order;
+    char sign;
+    if (sscanf(line, " SG_ %63s : %d|%d@%d%c (%lf,%lf) [%lf|%lf] \"%127[^\"]\"",
+               s->name, &s->start, &s->length, &order, &sign,
+               &s->scale, &s->offset, &s->min, &s->max, s->unit) < 9) {
+        return false;
+    }
+    if (s->length < 1 || s->length > 64 || s->scale == 0.0 || (sign != '+' && sign != '-')) return false;
+    s->big_endian = order == 0;
+    s->is_signed = sign == '-';
+    to_snake(s->name, s->snake, NULL);
+    messages[message_count - 1].signal_count++;
+    signal_count++;
+    return true;
+}
+
+static void parse_comment(const char* line) {
+    unsigned long id;
+    char name[NAME_LEN], text[TEXT_LEN];
+    if (sscanf(line, " CM_ SG_ %lu %63s \"%127[^\"]\"", &id, name, text) != 3) return;
+    for (int m = 0; m < message_count; m++) {
+        if (messages[m].id != id) continue;
+        for (int i = 0; i < messages[m].signal_count; i++) {
+            Signal* s = &signals[messages[m].first_signal + i];
+            if (strcmp(s->name, name) == 0) snprintf(s->comment, sizeof(s->comment), "%s", text);
+        }
+    }
+}
+
+// Motorola bit numbers run MSB-first through each byte; this is the
+// position counted from the first byte's MSB
+static int motorola_linear(int bit) {
+    return (bit / 8) * 8 + (7 - bit % 8);
+}
+
+// Checks placement and overlap, and works out shifts and raw limits
+static bool resolve_message(const Message* m) {
+    uint64_t used = 0;
+    for (int i = 0; i < m->signal_count; i++) {
+        Signal* s = &signals[m->first_signal + i];
+        for (int b = 0; b < s->length; b++) {
+            int byte, bit;
+            if (s->big_endian) {
+                int linear = motorola_linear(s->start) + b;
+                byte = linear / 8;
+                bit = 7 - linear % 8;
+            } else {
+                byte = (s->start + b) / 8;
+                bit = (s->start + b) % 8;
+            }
+            if (byte >= m->dlc) {
+                fprintf(stderr, "%s.%s does not fit in %d bytes\n", m->name, s->name, m->dlc);
+                return false;
+            }
+            uint64_t mask = (uint64_t)1 << (byte * 8 + bit);
+            if (used & mask) {
+                fprintf(stderr, "%s.%s overlaps another signal\n", m->name, s->name);
+                return false;
+            }
+            used |= mask;
+        }
+
+        s->shift = s->big_endian ? 63 - (motorola_linear(s->start) + s->length - 1) : s->start;
+        s->raw = s->scale == 1.0 && s->offset == 0.0 && s->min == 0.0 && s->max == 0.0;
+        s->wide = s->length > 24;
+        double limit_min = s->is_signed ? -ldexp(1.0, s->length - 1) : 0.0;
+        double limit_max = s->is_signed ? ldexp(1.0, s->length - 1) - 1.0 : ldexp(1.0, s->length) - 1.0;
+        s->raw_min = limit_min;
+        s->raw_max = limit_max;
+        if (s->min != 0.0 || s->max != 0.0) {
+            double low = ceil((s->min - s->offset) / s->scale - 1e-9);
+            double high = floor((s->max - s->offset) / s->scale + 1e-9);
+            s->raw_min = fmax(low, limit_min);
+            s->raw_max = fmin(high, limit_max);
+        }
+    }
+    return true;
+}
+
+// Literal with a decimal point, so 10 prints as 10.0f
+static const char* literal(double value, bool wide) {
+    static char buffers[4][48];
+    static int next = 0;
+    char* out = buffers[next++ & 3];
+    snprintf(out, 40, wide ? "%.17g" : "%.9g", value);
+    if (strpbrk(out, ".eEn") == NULL) strcat(out, ".0");
+    if (!wide) strcat(out, "f");
+    return out;
+}
+
+static const char* raw_type(const Signal* s) {
+    static char type[16];
+    int bits = s->length <= 8 ? 8 : s->length <= 16 ? 16 : s->length <= 32 ? 32 : 64;
+    snprintf(type, sizeof(type), "%sint%d_t", s->is_signed ? "" : "u", bits);
+    return type;
+}
+
+static const char* field_type(const Signal* s) {
+    return s->raw ? raw_type(s) : s->wide ? "double" : "float";
+}
+
+static void emit_helpers(FILE* out) {
+    fputs("// Frame words: byte i of an Intel (little-endian) frame is bits 8i..8i+7\n"
+          "// of the LE word; byte i of a Motorola frame is bits 56-8i..63-8i of the\n"
+          "// BE word. Loops have constant trip counts and unroll.\n"
+          "static inline uint64_t can_load_le(const uint8_t* data, int dlc) {\n"
+          "    uint64_t word = 0;\n"
+          "    for (int i = 0; i < dlc; i++) word |= (uint64_t)data[i] << (8 * i);\n"
+          "    return word;\n"
+          "}\n\n"
+          "static inline uint64_t can_load_be(const uint8_t* data, int dlc) {\n"
+          "    uint64_t word = 0;\n"
+          "    for (int i = 0; i < dlc; i++) word |= (uint64_t)data[i] << (56 - 8 * i);\n"
+          "    return word;\n"
+          "}\n\n"
+          "static inline void can_store(uint8_t* data, int dlc, uint64_t le, uint64_t be) {\n"
+          "    for (int i = 0; i < dlc; i++) data[i] = (uint8_t)(le >> (8 * i)) | (uint8_t)(be >> (56 - 8 * i));\n"
+          "}\n\n"
+          "static inline int64_t can_sign_extend(uint64_t raw, int length) {\n"
+          "    return (int64_t)(raw << (64 - length)) >> (64 - length);\n"
+          "}\n\n"
+          "// Physical value to raw: scale, clamp to the signal range and round to\n"
+          "// nearest. The compares compile to min/max instructions (NaN goes to\n"
+          "// the minimum) and rounding is a truncation of a value made\n"
+          "// non-negative, so no libm calls and no branches.\n"
+          "static inline uint64_t can_raw_f(float value, float offset, float inv_scale, float raw_min, float raw_max) {\n"
+          "    float x = (value - offset) * inv_scale;\n"
+          "    x = x > raw_min ? x : raw_min;\n"
+          "    x = x < raw_max ? x : raw_max;\n"
+          "    return (uint64_t)((int64_t)(x - raw_min + 0.5f) + (int64_t)raw_min);\n"
+          "}\n\n"
+          "static inline uint64_t can_raw_d(double value, double offset, double inv_scale, double raw_min, double raw_max) {\n"
+          "    double x = (value - offset) * inv_scale;\n"
+          "    x = x > raw_min ? x : raw_min;\n"
+          "    x = x < raw_max ? x : raw_max;\n"
+          "    return (uint64_t)((int64_t)(x - raw_min + 0.5) + (int64_t)raw_min);\n"
+          "}\n\n", out);
+}
+
+static void emit_message(FILE* out, const Message* m) {
+    bool has_le = false, has_be = false;
+    for (int i = 0; i < m->signal_count; i++) {
+        if (signals[m->first_signal + i].big_endian) has_be = true; else has_le = true;
+    }
+
+    fprintf(out, "// %s (0x%03X, %d bytes)\n", m->name, m->id, m->dlc);
+    fprintf(out, "#define CAN_ID_%s 0x%03X\n", m->upper, m->id);
+    fprintf(out, "#define CAN_DLC_%s %d\n\n", m->upper, m->dlc);
+    fprintf(out, "typedef struct {\n");
+    for (int i = 0; i < m->signal_count; i++) {
+        const Signal* s = &signals[m->first_signal + i];
+        char decl[160];
+        snprintf(decl, sizeof(decl), "    %s %s;", field_type(s), s->snake);
+        char note[TEXT_LEN * 2 + 32];
+        if (s->raw) {
+            snprintf(note, sizeof(note), "%s", s->comment);
+        } else {
+            snprintf(note, sizeof(note), "%s%s%g..%g%s%s", s->unit, s->unit[0] ? ", " : "",
+                     s->raw_min * s->scale + s->offset, s->raw_max * s->scale + s->offset,
+                     s->comment[0] ? " - " : "", s->comment);
+        }
+        if (note[0] != '\0') {
+            fprintf(out, "%-36s// %s\n", decl, note);
+        } else {
+            fprintf(out, "%s\n", decl);
+        }
+    }
+    fprintf(out, "} Can%s;\n\n", m->name);
+
+    fprintf(out, "static inline void can_pack_%s(uint8_t data[CAN_DLC_%s], const Can%s* msg) {\n",
+            m->snake, m->upper, m->name);
+    fprintf(out, "    uint64_t le = 0, be = 0;\n");
+    for (int i = 0; i < m->signal_count; i++) {
+        const Signal* s = &signals[m->first_signal + i];
+        char value[256];
+        if (s->raw) {
+            snprintf(value, sizeof(value), s->is_signed ? "(uint64_t)(int64_t)msg->%s" : "(uint64_t)msg->%s", s->snake);
+        } else {
+            snprintf(value, sizeof(value), "can_raw_%c(msg->%s, %s, %s, %s, %s)", s->wide ? 'd' : 'f', s->snake,
+                     literal(s->offset, s->wide), literal(1.0 / s->scale, s->wide),
+                     literal(s->raw_min, s->wide), literal(s->raw_max, s->wide));
+        }
+        uint64_t mask = s->length == 64 ? ~(uint64_t)0 : ((uint64_t)1 << s->length) - 1;
+        fprintf(out, "    %s |= (%s & 0x%llXull) << %d;\n", s->big_endian ? "be" : "le",
+                value, (unsigned long long)mask, s->shift);
+    }
+    fprintf(out, "    can_store(data, CAN_DLC_%s, le, be);\n}\n\n", m->upper);
+
+    fprintf(out, "static inline void can_unpack_%s(const uint8_t data[CAN_DLC_%s], Can%s* msg) {\n",
+            m->snake, m->upper, m->name);
+    if (has_le) fprintf(out, "    uint64_t le = can_load_le(data, CAN_DLC_%s);\n", m->upper);
+    if (has_be) fprintf(out, "    uint64_t be = can_load_be(data, CAN_DLC_%s);\n", m->upper);
+    for (int i = 0; i < m->signal_count; i++) {
+        const Signal* s = &signals[m->first_signal + i];
+        uint64_t mask = s->length == 64 ? ~(uint64_t)0 : ((uint64_t)1 << s->length) - 1;
+        char raw[128];
+        snprintf(raw, sizeof(raw), "((%s >> %d) & 0x%llXull)", s->big_endian ? "be" : "le",
+                 s->shift, (unsigned long long)mask);
+        char value[192];
+        if (s->is_signed) {
+            snprintf(value, sizeof(value), "can_sign_extend(%s, %d)", raw, s->length);
+        } else {
+            snprintf(value, sizeof(value), "%s", raw);
+        }
+        if (s->raw) {
+            fprintf(out, "    msg->%s = (%s)%s;\n", s->snake, raw_type(s), value);
+        } else {
+            const char* type = s->wide ? "double" : "float";
+            fprintf(out, "    msg->%s = (%s)%s * %s + %s;\n", s->snake, type, value,
+                    literal(s->scale, s->wide), literal(s->offset, s->wide));
+        }
+    }
+    fprintf(out, "}\n\n");
+}
+
+static void emit_tables(FILE* out) {
+    fputs("// Tables for tools: X(message, struct, id, dlc) and\n"
+          "// X(message, field, start, length, big endian, signed, scale, offset, min, max)\n"
+          "// with min/max the physical range the packer clamps to\n", out);
+    fputs("#define CAN_MESSAGES(X) \\\n", out);
+    for (int m = 0; m < message_count; m++) {
+        fprintf(out, "    X(%s, Can%s, 0x%03X, %d)%s\n", messages[m].snake, messages[m].name,
+                messages[m].id, messages[m].dlc, m + 1 < message_count ? " \\" : "");
+    }
+    fputs("\n#define CAN_SIGNALS(X) \\\n", out);
+    int emitted = 0;
+    for (int m = 0; m < message_count; m++) {
+        for (int i = 0; i < messages[m].signal_count; i++) {
+            const Signal* s = &signals[messages[m].first_signal + i];
+            emitted++;
+            fprintf(out, "    X(%s, %s, %d, %d, %d, %d, %.17g, %.17g, %.17g, %.17g)%s\n",
+                    messages[m].snake, s->snake, s->start, s->length, s->big_endian, s->is_signed,
+                    s->scale, s->offset, s->raw_min * s->scale + s->offset, s->raw_max * s->scale + s->offset,
+                    emitted < signal_count ? " \\" : "");
+        }
+    }
+    fputs("\n", out);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <definition.dbc> <output.h>\n", argv[0]);
+        return 1;
+    }
+    FILE* in = fopen(argv[1], "r");
+    if (in == NULL) {
+        fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    char line[512];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        line_number++;
+        const char* text = line;
+        while (isspace((unsigned char)*text)) text++;
+        bool ok = true;
+        if (strncmp(text, "BO_ ", 4) == 0) {
+            ok = parse_message(text);
+        } else if (strncmp(text, "SG_ ", 4) == 0) {
+            ok = parse_signal(text);
+        } else if (strncmp(text, "CM_ SG_ ", 8) == 0) {
+            parse_comment(text);
+        }
+        if (!ok) {
+            fprintf(stderr, "%s:%d: cannot parse: %s", argv[1], line_number, line);
+            fclose(in);
+            return 1;
+        }
+    }
+    fclose(in);
+
+    for (int m = 0; m < message_count; m++) {
+        for (int n = 0; n < m; n++) {
+            if (messages[n].id == messages[m].id) {
+                fprintf(stderr, "%s: duplicate message id 0x%X\n", argv[1], messages[m].id);
+                return 1;
+            }
+        }
+        if (!resolve_message(&messages[m])) return 1;
+    }
+
+    FILE* out = fopen(argv[2], "w");
+    if (out == NULL) {
+        fprintf(stderr, "Cannot create %s\n", argv[2]);
+        return 1;
+    }
+    fprintf(out, "// Generated by tools/can_codegen from %s - do not edit\n\n", argv[1]);
+    fputs("#ifndef CAN_MESSAGES_H\n#define CAN_MESSAGES_H\n\n#include <stdint.h>\n\n", out);
+    emit_helpers(out);
+    for (int m = 0; m < message_count; m++) {
+        emit_message(out, &messages[m]);
+    }
+    emit_tables(out);
+    fputs("#endif // CAN_MESSAGES_H\n", out);
+    if (fclose(out) != 0) {
+        fprintf(stderr, "Cannot write %s\n", argv[2]);
+        return 1;
+    }
+    printf("Generated %d messages, %d signals into %s\n", message_count, signal_count, argv[2]);
+    return 0;
+}
@@ -0,0 +1,298 @@
+// Fork check and benchmark for whole-ECU checkpoints (src/common/checkpoint.c).
+//
+// Drives the control models through the first part of the control_bench
+// drive cycle (start, drive, cultivator lowered with the PTO on) and saves
+// a checkpoint there. The check confirms that a restore reproduces the
+// saved state exactly, that a run continued from a restore matches the
+// run that never stopped, that two forks with the same what-if agree step
+// for step, and that damaged or truncated images are rejected. The
+// benchmark then forks the saved state once per what-if - throttle and
+// PTO speed for the rest of the pass - compares the restore cost with
+// re-initialising and re-driving to the fork point, and ranks the
+// what-ifs by fuel per kWh of PTO work.
+//
+// Usage: checkpoint_fork [--check] [forks]
+
+#include "engine/engine_control.h"
+#include "transmission/transmission.h"
+#include "hydraulics/hydraulics.h"
+#include "pto/pto.h"
+#include "implement/implement.h"
+#include "canbus/canbus.h"
+#include "canbus/gateway.h"
+#include "diagnostics/diagnostics.h"
+#include "diagnostics/uds.h"
+#include "thermal/thermal.h"
+#include "sensors/sensors.h"
+#include "control/control_loops.h"
+#include "common/checkpoint.h"
+#include "common/rng.h"
+#include "common/fixed.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#define FORK_IMAGE       "build/fork_point.ckpt"
+#define DAMAGED_IMAGE    "build/fork_damaged.ckpt"
+#define DEFAULT_FORKS    1000
+#define CONTROL_STEP_S   0.1
+#define WARMUP_STEPS     600       // Start, drive and lower the cultivator
+#define WHAT_IF_STEPS    300       // 30 s of simulated work after the fork
+#define CHANNELS         4
+
+static const uint8_t throttles[] = { 40, 50, 60, 70, 80, 90, 100 };
+static const PTOSpeed pto_speeds[] = { PTO_SPEED_540, PTO_SPEED_1000 };
+#define THROTTLE_COUNT  (sizeof(throttles) / sizeof(throttles[0]))
+#define PTO_SPEED_COUNT (sizeof(pto_speeds) / sizeof(pto_speeds[0]))
+
+static void step(void) {
+    sensors_update(REAL(CONTROL_STEP_S));
+    engine_update();
+    transmission_update();
+    hydraulics_update();
+    pto_update();
+    thermal_update(REAL(CONTROL_STEP_S));
+    implement_update();
+    diagnostics_update();
+    canbus_update();
+    control_run_for(CONTROL_STEP_S);
+}
+
+// Cold start: initialise every module and drive to the fork point
+static void drive_to_fork_point(void) {
+    rng_set_seed(RNG_DEFAULT_SEED);
+    canbus_init();
+    gateway_init();
+    diagnostics_init();
+    engine_init();
+    transmission_init();
+    hydraulics_init();
+    pto_init();
+    thermal_init();
+    sensors_init();
+    control_init();
+    implement_init();
+    uds_init(0, 0);
+
+    engine_start();
+    for (int s = 0; s < 20; s++) step();
+    transmission_shift_gear(GEAR_DRIVE_1);
+    transmission_engage_clutch();
+    engine_set_throttle(50);
+    implement_attach(IMPLEMENT_CULTIVATOR);
+    pto_engage(PTO_SPEED_540);
+    hydraulics_engage_pto(75);
+    for (int s = 0; s < 100; s++) step();
+    implement_lower();
+    hydraulics_raise_implement();
+    for (int s = 20 + 100; s < WARMUP_STEPS; s++) step();
+}
+
+// Model outputs per step after a fork; wall-clock fields such as message
+// timestamps are left out so two forks compare exactly
+static void sample(float* row) {
+    float values[CHANNELS] = {
+        real_to_float(engine_get_state()->fuel_rate),
+        real_to_float(transmission_get_state()->output_speed),
+        (float)pto_get_state()->current_rpm,
+        real_to_float(pto_get_state()->torque_nm),
+    };
+    memcpy(row, values, sizeof(values));
+}
+
+typedef struct {
+    uint8_t throttle;
+    PTOSpeed pto_speed;
+    float fuel_l;              // Burnt over the what-if
+    float pto_kwh;             // Delivered at the PTO over the what-if
+} Outcome;
+
+static void what_if(Outcome* outcome, float* trace) {
+    engine_set_throttle(outcome->throttle);
+    if (pto_get_state()->target_speed != outcome->pto_speed) {
+        pto_disengage();
+        pto_engage(outcome->pto_speed);
+    }
+    outcome->fuel_l = 0.0f;
+    outcome->pto_kwh = 0.0f;
+    for (int s = 0; s < WHAT_IF_STEPS; s++) {
+        step();
+        float row[CHANNELS];
+        sample(row);
+        if (trace != NULL) memcpy(&trace[s * CHANNELS], row, sizeof(row));
+        outcome->fuel_l += row[0] * (float)(CONTROL_STEP_S / 3600.0);
+        float power_kw = row[3] * row[2] * (float)(2.0 * 3.14159265 / 60.0 / 1000.0);
+        outcome->pto_kwh += power_kw * (float)(CONTROL_STEP_S / 3600.0);
+    }
+}
+
+static bool write_file(const char* path, const uint8_t* data, size_t size) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return false;
+    bool ok = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = malloc(*size);
+    if (data != NULL && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+// Open a damaged copy of the image; true when it is turned away
+static bool rejected(const uint8_t* image, size_t size, size_t flip_at, uint8_t flip) {
+    uint8_t* copy = malloc(size);
+    memcpy(copy, image, size);
+    if (flip_at < size) copy[flip_at] ^= flip;
+    bool written = write_file(DAMAGED_IMAGE, copy, size);
+    free(copy);
+    quiet_begin();
+    bool opened = written && checkpoint_open(DAMAGED_IMAGE);
+    quiet_end();
+    checkpoint_close();
+    return written && !opened;
+}
+
+static void check(void) {
+    static float continued[WHAT_IF_STEPS * CHANNELS];
+    static float fork_a[WHAT_IF_STEPS * CHANNELS];
+    static float fork_b[WHAT_IF_STEPS * CHANNELS];
+
+    quiet_begin();
+    drive_to_fork_point();
+    bool saved = checkpoint_save(FORK_IMAGE);
+    uint32_t saved_digest = checkpoint_digest();
+    Outcome straight = { 80, PTO_SPEED_540, 0, 0 };
+    what_if(&straight, continued);
+    quiet_end();
+    expect("Every module's state fits the section table", !checkpoint_get_state()->table_full);
+    expect("Fork point saved", saved);
+
+    bool opened = checkpoint_open(FORK_IMAGE);
+    expect("Image mapped and matches this build", opened);
+    quiet_begin();
+    bool restored = opened && checkpoint_restore();
+    uint32_t restored_digest = checkpoint_digest();
+    Outcome a = { 80, PTO_SPEED_540, 0, 0 };
+    what_if(&a, fork_a);
+    checkpoint_restore();
+    Outcome b = { 80, PTO_SPEED_540, 0, 0 };
+    what_if(&b, fork_b);
+    quiet_end();
+    expect("Restore reproduces the saved state", restored && restored_digest == saved_digest);
+    expect("Fork matches the run that never stopped",
+           memcmp(fork_a, continued, sizeof(continued)) == 0);
+    expect("Two forks with the same what-if agree step for step",
+           memcmp(fork_a, fork_b, sizeof(fork_a)) == 0);
+    checkpoint_close();
+
+    size_t size = 0;
+    uint8_t* image = read_file(FORK_IMAGE, &size);
+    expect("Image read back", image != NULL && size > sizeof(CheckpointHeader));
+    if (image == NULL) return;
+    CheckpointHeader header;
+    memcpy(&header, image, sizeof(header));
+    expect("Flipped payload bit rejected", rejected(image, size, size - 1, 0x01));
+    expect("Truncated image rejected", rejected(image, size - CHECKPOINT_ALIGN, size, 0));
+    expect("Other format version rejected",
+           rejected(image, size, offsetof(CheckpointHeader, version), 0x80));
+    expect("Unknown section rejected",
+           rejected(image, size, sizeof(CheckpointHeader) + offsetof(CheckpointSection, name_hash), 0x01));
+    free(image);
+    unlink(DAMAGED_IMAGE);
+    printf("  %zu bytes of state in %d sections\n",
+           checkpoint_get_state()->state_bytes, checkpoint_get_state()->section_count);
+}
+
+static float fuel_per_kwh(const Outcome* outcome) {
+    return outcome->pto_kwh > 0.0f ? outcome->fuel_l / outcome->pto_kwh : 1e9f;
+}
+
+static int by_fuel_per_kwh(const void* left, const void* right) {
+    float a = fuel_per_kwh(left);
+    float b = fuel_per_kwh(right);
+    return (a > b) - (a < b);
+}
+
+static void bench(uint32_t forks) {
+    // Cold start cost: what each fork would pay without a checkpoint
+    quiet_begin();
+    double start = now_ns();
+    for (int r = 0; r < 5; r++) drive_to_fork_point();
+    double cold_us = (now_ns() - start) / 5 / 1000.0;
+    quiet_end();
+
+    if (!checkpoint_open(FORK_IMAGE)) {
+        check_failures++;
+        return;
+    }
+    Outcome* outcomes = calloc(forks, sizeof(Outcome));
+    double restore_total_us = 0.0;
+    float restore_max_us = 0.0f;
+    quiet_begin();
+    start = now_ns();
+    for (uint32_t f = 0; f < forks; f++) {
+        checkpoint_restore();
+        float us = checkpoint_get_state()->restore_us;
+        restore_total_us += us;
+        if (us > restore_max_us) restore_max_us = us;
+        outcomes[f].throttle = throttles[f % THROTTLE_COUNT];
+        outcomes[f].pto_speed = pto_speeds[(f / THROTTLE_COUNT) % PTO_SPEED_COUNT];
+        what_if(&outcomes[f], NULL);
+    }
+    double total_ms = (now_ns() - start) / 1e6;
+    quiet_end();
+    checkpoint_close();
+
+    printf("\nFork benchmark (%u forks of %d steps from step %d):\n", forks, WHAT_IF_STEPS, WARMUP_STEPS);
+    printf("  Restore:            %8.1f us avg, %8.1f us max (%zu bytes)\n",
+           restore_total_us / forks, restore_max_us, checkpoint_get_state()->state_bytes);
+    printf("  Cold init + drive:  %8.1f us (%.0fx the restore)\n", cold_us,
+           cold_us / (restore_total_us / forks));
+    printf("  All forks:          %8.1f ms, %.1f us per what-if\n", total_ms, total_ms * 1000.0 / forks);
+
+    // Every what-if is deterministic, so the grid repeats; rank the first pass
+    uint32_t distinct = forks < THROTTLE_COUNT * PTO_SPEED_COUNT ? forks : THROTTLE_COUNT * PTO_SPEED_COUNT;
+    qsort(outcomes, distinct, sizeof(Outcome), by_fuel_per_kwh);
+    printf("  %-10s %-8s %10s %10s %10s\n", "Throttle %", "PTO rpm", "Fuel L", "PTO kWh", "L/kWh");
+    for (uint32_t i = 0; i < distinct && i < 5; i++) {
+        printf("  %-10u %-8d %10.3f %10.3f %10.3f\n", outcomes[i].throttle, outcomes[i].pto_speed,
+               outcomes[i].fuel_l, outcomes[i].pto_kwh, fuel_per_kwh(&outcomes[i]));
+    }
+    free(outcomes);
+}
+
+int main(int argc, char* argv[]) {
+    bool check_only = false;
+    uint32_t forks = DEFAULT_FORKS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if (argv[i][0] != '-') {
+            forks = (uint32_t)strtoul(argv[i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--check] [forks]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (forks < 1) forks = 1;
+
+    printf("\nCheckpoint checks:\n");
+    check();
+    if (check_report("Checkpoint") && !check_only) {
+        bench(forks);
+    }
+    return check_failures == 0 ? 0 : 1;
+}
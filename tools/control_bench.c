@@ -0,0 +1,488 @@
+// Replays a scripted drive cycle through the control models with no sleeps
+// and records every model output per step. Run the float build with --trace
+// and the fixed-point build with --compare to check that Q16.16 stays within
+// FIXED_TOLERANCE_PERCENT of full scale (`make fixed-check` does both).
+// Also soaks the thermal network at several update rates and checks that
+// the temperatures do not depend on the rate.
+//
+// Usage: control_bench [--trace <file>] [--compare <file>] [iterations]
+
+#include "engine/engine_control.h"
+#include "engine/calibration.h"
+#include "transmission/transmission.h"
+#include "hydraulics/hydraulics.h"
+#include "pto/pto.h"
+#include "implement/implement.h"
+#include "canbus/canbus.h"
+#include "diagnostics/diagnostics.h"
+#include "geofence/geofence.h"
+#include "thermal/thermal.h"
+#include "sensors/sensors.h"
+#include "control/control_loops.h"
+#include "common/rng.h"
+#include "common/change.h"
+#include "common/fixed.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TRACE_MAGIC 0x31525443u   // "CTR1"
+#define CONTROL_STEP_S 0.1         // Simulated time per drive-cycle step
+
+// Thermal soak: 30 min at a working point, then 30 min after shutdown
+#define SOAK_PHASE_S      1800
+#define SOAK_SAMPLE_S     60
+#define SOAK_SAMPLES      (2 * SOAK_PHASE_S / SOAK_SAMPLE_S)
+#define SOAK_WORK_PHASES  8        // Drive-cycle phases that set up the working point
+#define SOAK_TOLERANCE_C  0.5f
+
+// Steady idle for the change-driven update timing
+#define IDLE_SETTLE_STEPS 200
+#define IDLE_STEPS        20000
+
+// Update periods; 1/1024 s is the reference and is exact in Q16.16
+static const double soak_periods_s[] = { 1.0 / 1024, 0.1, 1.0, THERMAL_MAX_STEP_S };
+#define SOAK_RATES (sizeof(soak_periods_s) / sizeof(soak_periods_s[0]))
+
+typedef struct {
+    const char* name;
+    float full_scale;
+} TraceChannel;
+
+static const TraceChannel channels[] = {
+    { "engine rpm",        3000.0f },
+    { "engine target rpm", 3000.0f },
+    { "fuel rate",         100.0f },
+    { "coolant temp",      150.0f },
+    { "engine load",       100.0f },
+    { "engine torque",     1000.0f },
+    { "output speed",      3000.0f },
+    { "trans temp",        150.0f },
+    { "hyd pressure",      3000.0f },
+    { "hyd flow",          25.0f },
+    { "hyd oil temp",      150.0f },
+    { "pto rpm",           1000.0f },
+    { "pto load",          100.0f },
+    { "pto torque",        850.0f },
+    { "pto slip",          100.0f },
+    { "implement depth",   20.0f },
+    { "implement pressure", 3000.0f },
+    { "implement flow",    120.0f },
+    { "coverage rate",     20.0f },
+    { "hitch valve",       200.0f },
+    { "draft force",       50.0f },
+};
+
+#define CHANNEL_COUNT (sizeof(channels) / sizeof(channels[0]))
+
+// One phase of the drive cycle: an operator action, then a number of steps
+typedef enum {
+    ACTION_NONE,
+    ACTION_START,
+    ACTION_DRIVE,
+    ACTION_THROTTLE,
+    ACTION_GEAR,
+    ACTION_ATTACH,
+    ACTION_PTO_ON,
+    ACTION_LOWER,
+    ACTION_RAISE,
+    ACTION_PTO_OFF,
+    ACTION_CLUTCH_OFF
+} Action;
+
+typedef struct {
+    Action action;
+    int value;
+    int steps;
+} Phase;
+
+static const Phase drive_cycle[] = {
+    { ACTION_START,      0,                   20 },
+    { ACTION_DRIVE,      GEAR_DRIVE_1,        10 },
+    { ACTION_THROTTLE,   50,                  100 },
+    { ACTION_ATTACH,     IMPLEMENT_CULTIVATOR, 10 },
+    { ACTION_PTO_ON,     PTO_SPEED_540,       100 },
+    { ACTION_LOWER,      0,                   400 },
+    { ACTION_GEAR,       GEAR_DRIVE_2,        200 },
+    { ACTION_THROTTLE,   80,                  400 },
+    { ACTION_THROTTLE,   100,                 300 },
+    { ACTION_GEAR,       GEAR_DRIVE_3,        300 },
+    { ACTION_THROTTLE,   65,                  400 },
+    { ACTION_THROTTLE,   35,                  300 },
+    { ACTION_RAISE,      0,                   100 },
+    { ACTION_PTO_OFF,    0,                   100 },
+    { ACTION_THROTTLE,   90,                  200 },
+    { ACTION_CLUTCH_OFF, 0,                   100 },
+    { ACTION_THROTTLE,   0,                   200 },
+};
+
+static void apply(const Phase* phase) {
+    switch (phase->action) {
+        case ACTION_START:      engine_start(); break;
+        case ACTION_DRIVE:      transmission_shift_gear((GearPosition)phase->value);
+                                transmission_engage_clutch(); break;
+        case ACTION_THROTTLE:   engine_set_throttle((uint8_t)phase->value); break;
+        case ACTION_GEAR:       transmission_shift_gear((GearPosition)phase->value); break;
+        case ACTION_ATTACH:     implement_attach((ImplementType)phase->value); break;
+        case ACTION_PTO_ON:     pto_engage((PTOSpeed)phase->value);
+                                hydraulics_engage_pto(75); break;
+        case ACTION_LOWER:      implement_lower();
+                                hydraulics_raise_implement(); break;
+        case ACTION_RAISE:      implement_raise();
+                                hydraulics_lower_implement(); break;
+        case ACTION_PTO_OFF:    pto_disengage();
+                                hydraulics_disengage_pto(); break;
+        case ACTION_CLUTCH_OFF: transmission_disengage_clutch(); break;
+        case ACTION_NONE:       break;
+    }
+}
+
+static void step(void) {
+    sensors_update(REAL(CONTROL_STEP_S));
+    engine_update();
+    transmission_update();
+    hydraulics_update();
+    pto_update();
+    thermal_update(REAL(CONTROL_STEP_S));
+    implement_update();
+    diagnostics_update();
+    canbus_update();
+    control_run_for(CONTROL_STEP_S);
+}
+
+static void sample(float* row) {
+    EngineState* engine = engine_get_state();
+    TransmissionState* transmission = transmission_get_state();
+    HydraulicsState* hydraulics = hydraulics_get_state();
+    PTOState* pto = pto_get_state();
+    ImplementState* implement = implement_get_state();
+    ControlState control;
+    control_get_state(&control);
+    float values[CHANNEL_COUNT] = {
+        engine->current_rpm,
+        engine->target_rpm,
+        real_to_float(engine->fuel_rate),
+        real_to_float(engine->coolant_temp),
+        real_to_float(engine->load_percent),
+        real_to_float(engine->torque_nm),
+        real_to_float(transmission->output_speed),
+        real_to_float(transmission->transmission_temp),
+        real_to_float(hydraulics->system_pressure),
+        real_to_float(hydraulics->flow_rate),
+        real_to_float(hydraulics->oil_temp),
+        (float)pto->current_rpm,
+        real_to_float(pto->load_percent),
+        real_to_float(pto->torque_nm),
+        real_to_float(pto->slip_percent),
+        real_to_float(implement->working_depth_cm),
+        real_to_float(implement->pressure_bar),
+        real_to_float(implement->flow_lpm),
+        real_to_float(implement->coverage_rate_ha_hr),
+        real_to_float(control.valve_percent),
+        real_to_float(control.draft_kn),
+    };
+    memcpy(row, values, sizeof(values));
+}
+
+// Runs the first phase_count phases of the drive cycle; trace may be NULL
+// when only timing matters
+static int run_cycle(float* trace, size_t phase_count) {
+    quiet_begin();
+    rng_set_seed(RNG_DEFAULT_SEED);
+    canbus_init();
+    diagnostics_init();
+    engine_init();
+    transmission_init();
+    hydraulics_init();
+    pto_init();
+    thermal_init();
+    sensors_init();
+    control_init();
+    implement_init();
+    geofence_init();
+
+    int steps = 0;
+    for (size_t p = 0; p < phase_count; p++) {
+        apply(&drive_cycle[p]);
+        for (int s = 0; s < drive_cycle[p].steps; s++) {
+            step();
+            if (trace != NULL) sample(&trace[(size_t)steps * CHANNEL_COUNT]);
+            steps++;
+        }
+    }
+
+    quiet_end();
+    return steps;
+}
+
+static int cycle_steps(void) {
+    int steps = 0;
+    for (size_t p = 0; p < sizeof(drive_cycle) / sizeof(drive_cycle[0]); p++) {
+        steps += drive_cycle[p].steps;
+    }
+    return steps;
+}
+
+static bool write_trace(const char* path, const float* trace, uint32_t steps) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return false;
+    uint32_t header[3] = { TRACE_MAGIC, CHANNEL_COUNT, steps };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(trace, sizeof(float) * CHANNEL_COUNT, steps, file) == steps;
+    return fclose(file) == 0 && ok;
+}
+
+// Reports the worst deviation per channel as a share of full scale
+static int compare_trace(const char* path, const float* trace, uint32_t steps) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+    uint32_t header[3];
+    float* reference = malloc(sizeof(float) * CHANNEL_COUNT * steps);
+    bool ok = reference != NULL &&
+              fread(header, sizeof(header), 1, file) == 1 &&
+              header[0] == TRACE_MAGIC && header[1] == CHANNEL_COUNT && header[2] == steps &&
+              fread(reference, sizeof(float) * CHANNEL_COUNT, steps, file) == steps;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "%s is not a matching control trace\n", path);
+        free(reference);
+        return 1;
+    }
+
+    int failures = 0;
+    printf("Channel               Max error   %% of full scale   (at step)\n");
+    for (uint32_t c = 0; c < CHANNEL_COUNT; c++) {
+        float worst = 0.0f;
+        uint32_t worst_step = 0;
+        for (uint32_t s = 0; s < steps; s++) {
+            float error = fabsf(trace[s * CHANNEL_COUNT + c] - reference[s * CHANNEL_COUNT + c]);
+            if (error > worst) {
+                worst = error;
+                worst_step = s;
+            }
+        }
+        float percent = worst / channels[c].full_scale * 100.0f;
+        bool pass = percent <= FIXED_TOLERANCE_PERCENT;
+        failures += !pass;
+        printf("%-20s %10.4f %12.4f%%       %6u  %s\n", channels[c].name, worst, percent,
+               worst_step, pass ? "" : "FAIL");
+    }
+    free(reference);
+    printf("%s: %u steps, %zu channels, tolerance %.2f%% of full scale\n",
+           failures ? "FAILED" : "PASSED", steps, CHANNEL_COUNT, FIXED_TOLERANCE_PERCENT);
+    return failures ? 1 : 0;
+}
+
+// Integrates the thermal network alone from the given engine operating
+// point, then with the engine stopped, sampling every SOAK_SAMPLE_S
+static double soak(const EngineState* working, double period_s, float* samples) {
+    EngineState* engine = engine_get_state();
+    *engine = *working;
+    thermal_init();
+    real_t dt = real_from_float((float)period_s);
+    long steps_per_sample = lround(SOAK_SAMPLE_S / period_s);
+
+    double start = now_ns();
+    for (int s = 0; s < SOAK_SAMPLES; s++) {
+        if (s == SOAK_SAMPLES / 2) {
+            engine->engine_running = false;
+            engine->current_rpm = 0;
+        }
+        for (long n = 0; n < steps_per_sample; n++) {
+            thermal_update(dt);
+        }
+        for (int k = 0; k < THERMAL_NODE_COUNT; k++) {
+            samples[s * THERMAL_NODE_COUNT + k] = real_to_float(thermal_get_state()->temp_c[k]);
+        }
+    }
+    return (now_ns() - start) / (steps_per_sample * SOAK_SAMPLES);
+}
+
+static int check_thermal_rates(void) {
+    run_cycle(NULL, SOAK_WORK_PHASES);
+    EngineState working = *engine_get_state();
+
+    static float samples[SOAK_RATES][SOAK_SAMPLES * THERMAL_NODE_COUNT];
+    double update_ns[SOAK_RATES];
+    quiet_begin();
+    for (size_t r = 0; r < SOAK_RATES; r++) {
+        update_ns[r] = soak(&working, soak_periods_s[r], samples[r]);
+    }
+    quiet_end();
+    *engine_get_state() = working;
+
+    const float* reference = samples[0];
+    int hot = (SOAK_SAMPLES / 2 - 1) * THERMAL_NODE_COUNT;
+    printf("Thermal soak: %d min working (coolant %.1f, transmission %.1f, hydraulic %.1f C), %d min off\n",
+           SOAK_PHASE_S / 60, reference[hot + THERMAL_COOLANT], reference[hot + THERMAL_TRANSMISSION_OIL],
+           reference[hot + THERMAL_HYDRAULIC_OIL], SOAK_PHASE_S / 60);
+
+    int failures = 0;
+    for (size_t r = 0; r < SOAK_RATES; r++) {
+        float worst = 0.0f;
+        for (int i = 0; i < SOAK_SAMPLES * THERMAL_NODE_COUNT; i++) {
+            worst = fmaxf(worst, fabsf(samples[r][i] - reference[i]));
+        }
+        bool pass = worst <= SOAK_TOLERANCE_C;
+        failures += !pass;
+        printf("  %7.1f Hz: max deviation %.3f C from %.0f Hz, %.0f ns/update  %s\n",
+               1.0 / soak_periods_s[r], worst, 1.0 / soak_periods_s[0], update_ns[r], pass ? "" : "FAIL");
+    }
+    return failures ? 1 : 0;
+}
+
+// Engine idling in neutral: times the engine, transmission, hydraulics and
+// PTO updates once the speed has settled
+static double bench_idle(bool tracking) {
+    change_set_enabled(tracking);
+    quiet_begin();
+    rng_set_seed(RNG_DEFAULT_SEED);
+    canbus_init();
+    diagnostics_init();
+    engine_init();
+    transmission_init();
+    hydraulics_init();
+    pto_init();
+    thermal_init();
+    sensors_init();
+    engine_start();
+    for (int s = 0; s < IDLE_SETTLE_STEPS; s++) {
+        step();
+    }
+    double start = now_ns();
+    for (int s = 0; s < IDLE_STEPS; s++) {
+        engine_update();
+        transmission_update();
+        hydraulics_update();
+        pto_update();
+        canbus_update();
+    }
+    double per_step = (now_ns() - start) / IDLE_STEPS;
+    quiet_end();
+    change_set_enabled(true);
+    return per_step;
+}
+
+// Replays the drive cycle with every update forced and checks that
+// skipping unchanged updates left every traced channel bit-identical.
+// Both runs follow an earlier run, as not every module resets all of its
+// state on init.
+static int check_change_driven(uint32_t steps, size_t phase_count, long iterations) {
+    uint32_t full_updates, skipped_updates;
+    float* trace = malloc(sizeof(float) * CHANNEL_COUNT * steps);
+    float* forced = malloc(sizeof(float) * CHANNEL_COUNT * steps);
+    if (trace == NULL || forced == NULL) return 1;
+    run_cycle(trace, phase_count);
+    change_get_totals(&full_updates, &skipped_updates);
+
+    change_set_enabled(false);
+    run_cycle(forced, phase_count);
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        run_cycle(NULL, phase_count);
+    }
+    double forced_cycle = (now_ns() - start) / iterations;
+    change_set_enabled(true);
+    start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        run_cycle(NULL, phase_count);
+    }
+    double tracked_cycle = (now_ns() - start) / iterations;
+    bool identical = memcmp(trace, forced, sizeof(float) * CHANNEL_COUNT * steps) == 0;
+    free(trace);
+    free(forced);
+
+    double idle_forced = bench_idle(false);
+    double idle_tracked = bench_idle(true);
+    printf("Change-driven updates: %u of %u module updates skipped (%.0f%%), trace %s every update forced\n",
+           skipped_updates, full_updates + skipped_updates,
+           100.0 * skipped_updates / (full_updates + skipped_updates),
+           identical ? "identical with" : "DIFFERS from");
+    printf("  Drive cycle: %.1f us tracked vs %.1f us forced\n", tracked_cycle / 1000.0, forced_cycle / 1000.0);
+    printf("  Idle step:   %.0f ns tracked vs %.0f ns forced (engine, transmission, hydraulics, PTO)\n",
+           idle_tracked, idle_forced);
+    return identical ? 0 : 1;
+}
+
+// Dependent chains, so the timing is latency rather than throughput
+static void bench_arithmetic(long iterations) {
+    real_t a = REAL(1.0001), b = REAL(0.37), x = REAL(12.5);
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        x = real_sub(real_add(real_mul(x, REAL(0.5)), REAL(1)), b);   // Settles at 1.26
+    }
+    double mul_add = (now_ns() - start) / iterations;
+
+    volatile real_t sink = x;
+    x = REAL(1000);
+    start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        x = real_add(real_div(x, a), b);   // Settles near 3700
+    }
+    double div_add = (now_ns() - start) / iterations;
+    sink = real_add(sink, x);
+    (void)sink;
+
+    printf("real_t mul+add+sub: %.2f ns\n", mul_add);
+    printf("real_t div+add:     %.2f ns\n", div_add);
+}
+
+int main(int argc, char* argv[]) {
+    const char* trace_path = NULL;
+    const char* compare_path = NULL;
+    long iterations = 200;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compare_path = argv[++i];
+        } else if (argv[i][0] != '-' && atol(argv[i]) > 0) {
+            iterations = atol(argv[i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--trace <file>] [--compare <file>] [iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+#ifdef ECU_FIXED_POINT
+    printf("Control models: Q16.16 fixed point\n");
+#else
+    printf("Control models: float\n");
+#endif
+
+    uint32_t steps = (uint32_t)cycle_steps();
+    float* trace = malloc(sizeof(float) * CHANNEL_COUNT * steps);
+    if (trace == NULL) return 1;
+    size_t phase_count = sizeof(drive_cycle) / sizeof(drive_cycle[0]);
+    run_cycle(trace, phase_count);
+
+    double start = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        run_cycle(NULL, phase_count);
+    }
+    double per_cycle = (now_ns() - start) / iterations;
+    printf("Drive cycle: %u steps, %.1f us/cycle (%.0f ns/step incl. re-init)\n",
+           steps, per_cycle / 1000.0, per_cycle / steps);
+    bench_arithmetic(iterations * 100000);
+
+    int result = check_change_driven(steps, phase_count, iterations);
+    result |= check_thermal_rates();
+    if (trace_path != NULL) {
+        if (write_trace(trace_path, trace, steps)) {
+            printf("Trace written to %s\n", trace_path);
+        } else {
+            fprintf(stderr, "Cannot write %s\n", trace_path);
+            result = 1;
+        }
+    }
+    if (compare_path != NULL) {
+        result |= compare_trace(compare_path, trace, steps);
+    }
+    free(trace);
+    return result;
+}
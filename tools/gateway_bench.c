@@ -0,0 +1,182 @@
+// Routing check and benchmark for the CAN gateway (src/canbus/gateway.c).
+//
+// The check floods the implement bus with frames on random 11-bit IDs and
+// confirms that only routed IDs reach the tractor bus, at no more than
+// their route's rate, and that a forwarded frame is not routed again. It
+// also checks the ID rewrite and payload mask of the engine speed route.
+// The benchmark reports the routing cost per frame and the forwarding
+// latency for several dispatch batch sizes (frames sent between two
+// canbus_dispatch calls, as modules do within one cycle).
+//
+// Usage: gateway_bench [--check] [frames]
+
+#include "canbus/canbus.h"
+#include "canbus/gateway.h"
+#include "can_messages.h"
+#include "common/rng.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define DEFAULT_FRAMES  200000
+#define FLOOD_BATCH     128        // Below the loopback queue depth
+
+#define BENCH_RNG_STREAM 1
+
+// Fixed seed and stream, so every run floods the same IDs and payloads
+static Rng bench_rng;
+
+// Frames arriving on one ID of the receiving bus
+typedef struct {
+    uint32_t count;
+    CANMessage last;
+} Receiver;
+
+static void count_frame(const CANMessage* message, void* context) {
+    Receiver* receiver = context;
+    receiver->count++;
+    receiver->last = *message;
+}
+
+// Drain the queues and empty the bus buffers so a flood never saturates them
+static void settle(void) {
+    canbus_dispatch(0);
+    for (int b = 0; b < CAN_BUS_COUNT; b++) {
+        canbus_get_bus_state((CanBusId)b)->message_count = 0;
+    }
+}
+
+// Subscriptions outlive the checks, so receivers are static
+static Receiver engine;
+static Receiver hitch;
+static Receiver receivers[6];
+
+static void check_rewrite(void) {
+    canbus_subscribe_on(CAN_BUS_IMPLEMENT, GATEWAY_ID_ENGINE_SPEED, count_frame, &engine);
+    uint8_t data[8] = { 0x08, 0x07, 0xC8, 0x7A, 0x82, 0x10, 0x27, 0x55 };
+    canbus_send_on(CAN_BUS_TRACTOR, CAN_ID_ENGINE_STATUS, data, sizeof(data));
+    settle();
+    static const uint8_t expected[8] = { 0x08, 0x07, 0, 0, 0, 0, 0, 0 };
+    expect("Engine speed rewritten to its implement-bus ID",
+           engine.count == 1 && engine.last.message_id == GATEWAY_ID_ENGINE_SPEED);
+    expect("Engine payload masked to the speed signal",
+           engine.count == 1 && memcmp(engine.last.data, expected, 8) == 0);
+
+    // The hitch command is forwarded once and not routed back
+    canbus_subscribe_on(CAN_BUS_IMPLEMENT, CAN_ID_IMPLEMENT_HITCH, count_frame, &hitch);
+    uint32_t implement_seen = gateway_get_state()->seen[CAN_BUS_IMPLEMENT];
+    uint8_t command[CAN_DLC_IMPLEMENT_HITCH] = { 1, 100 };
+    canbus_send_on(CAN_BUS_TRACTOR, CAN_ID_IMPLEMENT_HITCH, command, sizeof(command));
+    settle();
+    expect("Hitch command forwarded, not seen again by the gateway",
+           hitch.count == 1 && gateway_get_state()->seen[CAN_BUS_IMPLEMENT] == implement_seen);
+}
+
+static void check_flood(uint32_t frames) {
+    // Routed IDs plus the implement bus's own heavy traffic
+    static const uint32_t watched[] = {
+        CAN_ID_IMPLEMENT_STATUS, CAN_ID_IMPLEMENT_ATTACH, CAN_ID_SECTION_STATE,
+        CAN_ID_APPLICATION_RATE, 0x123, 0x7FF,
+    };
+    _Static_assert(sizeof(watched) / sizeof(watched[0]) == sizeof(receivers) / sizeof(receivers[0]),
+                   "one receiver per watched ID");
+    for (size_t i = 0; i < sizeof(watched) / sizeof(watched[0]); i++) {
+        canbus_subscribe_on(CAN_BUS_TRACTOR, watched[i], count_frame, &receivers[i]);
+    }
+
+    const GatewayState* gateway = gateway_get_state();
+    uint32_t seen_before = gateway->seen[CAN_BUS_IMPLEMENT];
+    uint32_t unrouted_before = gateway->unrouted[CAN_BUS_IMPLEMENT];
+    uint32_t routed_before = 0;
+    uint32_t status_before = gateway->routes[ROUTE_IMPLEMENT_STATUS].forwarded;
+    for (int r = 0; r < GATEWAY_ROUTE_COUNT; r++) {
+        routed_before += gateway->routes[r].forwarded + gateway->routes[r].filtered + gateway->routes[r].refused;
+    }
+
+    uint32_t on_watched[sizeof(watched) / sizeof(watched[0])] = {0};
+    double start = now_ns();
+    for (uint32_t sent = 0; sent < frames; sent++) {
+        uint32_t id = rng_below(&bench_rng, 0x800);
+        if ((sent & 7) == 0) id = watched[rng_below(&bench_rng, sizeof(watched) / sizeof(watched[0]))];
+        for (size_t i = 0; i < sizeof(watched) / sizeof(watched[0]); i++) on_watched[i] += id == watched[i];
+        uint64_t payload = rng_next(&bench_rng);
+        canbus_send_on(CAN_BUS_IMPLEMENT, id, (const uint8_t*)&payload, 8);
+        if (sent % FLOOD_BATCH == FLOOD_BATCH - 1) settle();
+    }
+    settle();
+    double elapsed_ms = (now_ns() - start) / 1e6;
+
+    uint32_t routed = 0;
+    for (int r = 0; r < GATEWAY_ROUTE_COUNT; r++) {
+        routed += gateway->routes[r].forwarded + gateway->routes[r].filtered + gateway->routes[r].refused;
+    }
+    expect("Every implement frame looked up once",
+           gateway->seen[CAN_BUS_IMPLEMENT] - seen_before == frames &&
+           (gateway->unrouted[CAN_BUS_IMPLEMENT] - unrouted_before) + (routed - routed_before) == frames);
+    expect("Section and rate commands stay on the implement bus",
+           receivers[2].count == 0 && receivers[3].count == 0 && on_watched[2] > 0 && on_watched[3] > 0);
+    expect("Unrouted IDs stay on the implement bus", receivers[4].count == 0 && receivers[5].count == 0);
+    expect("Implement attach forwarded every time", receivers[1].count == on_watched[1]);
+
+    // 500 ms minimum interval on the status route
+    uint32_t status = gateway->routes[ROUTE_IMPLEMENT_STATUS].forwarded - status_before;
+    expect("Implement status held to its route interval",
+           receivers[0].count == status && status >= 1 && status <= (uint32_t)(elapsed_ms / 500.0) + 1);
+    printf("  %u frames in %.1f ms: %u attach and %u status frames reached the tractor bus\n",
+           frames, elapsed_ms, receivers[1].count, receivers[0].count);
+}
+
+static void bench(uint32_t frames) {
+    static const int batches[] = { 1, 8, 32, 128 };
+    printf("\nRouting benchmark (%u implement-bus frames, 1 in 8 forwarded):\n", frames);
+    printf("  %-6s %12s %12s %12s %12s\n", "Batch", "ns/frame", "Route ns", "Avg lat us", "Max lat us");
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+        GatewayState* gateway = gateway_get_state();
+        memset(gateway, 0, sizeof(*gateway));
+        double start = now_ns();
+        for (uint32_t sent = 0; sent < frames; sent++) {
+            uint32_t id = (sent & 7) == 0 ? CAN_ID_IMPLEMENT_ATTACH : rng_below(&bench_rng, 0x800);
+            if (id == CAN_ID_IMPLEMENT_STATUS) id = CAN_ID_SECTION_STATE;
+            uint64_t payload = rng_next(&bench_rng);
+            canbus_send_on(CAN_BUS_IMPLEMENT, id, (const uint8_t*)&payload, 8);
+            if (sent % batches[b] == (uint32_t)batches[b] - 1) settle();
+        }
+        settle();
+        double elapsed = now_ns() - start;
+        const GatewayRouteStats* attach = &gateway->routes[ROUTE_IMPLEMENT_ATTACH];
+        printf("  %-6d %12.1f %12.1f %12.2f %12.2f\n", batches[b], elapsed / frames,
+               (double)gateway->lookup_ns / frames,
+               attach->forwarded > 0 ? attach->latency_total_ns / 1000.0 / attach->forwarded : 0.0,
+               attach->latency_max_ns / 1000.0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool check_only = false;
+    uint32_t frames = DEFAULT_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if (argv[i][0] != '-') {
+            frames = (uint32_t)strtoul(argv[i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--check] [frames]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1000) frames = 1000;
+
+    canbus_init();
+    gateway_init();
+    rng_seed(&bench_rng, RNG_DEFAULT_SEED, BENCH_RNG_STREAM);
+
+    printf("\nGateway checks:\n");
+    check_rewrite();
+    check_flood(frames);
+    if (check_report("Gateway") && !check_only) {
+        bench(frames);
+    }
+    return check_failures == 0 ? 0 : 1;
+}
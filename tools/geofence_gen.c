@@ -0,0 +1,92 @@
+// Generates a synthetic geofence polygon set in the ECU's binary format:
+// a rectangular field boundary with headland strips, plus randomly placed
+// waterways, no-spray buffers and exclusion zones.
+//
+// Usage: geofence_gen <output> [zone_count] [origin_lat origin_lon]
+
+#include "geofence/geofence.h"
+#include "telematics/telematics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define FIELD_HALF_WIDTH_M  600.0
+#define FIELD_HALF_HEIGHT_M 400.0
+#define HEADLAND_M          24.0
+#define ZONE_SIDES          16
+
+static double origin_lat = 41.6032;
+static double origin_lon = -90.5776;
+static FILE* output;
+static uint32_t next_id = 1;
+
+static void write_polygon(GeofenceKind kind, const double* east, const double* north, uint32_t count) {
+    double meters_per_deg_lat, meters_per_deg_lon;
+    telematics_meters_per_degree(origin_lat, &meters_per_deg_lat, &meters_per_deg_lon);
+    uint32_t record[3] = { next_id++, (uint32_t)kind, count };
+    fwrite(record, sizeof(record), 1, output);
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t vertex[2] = {
+            (int32_t)lround((origin_lat + north[i] / meters_per_deg_lat) * 1e7),
+            (int32_t)lround((origin_lon + east[i] / meters_per_deg_lon) * 1e7)
+        };
+        fwrite(vertex, sizeof(vertex), 1, output);
+    }
+}
+
+static void write_rectangle(GeofenceKind kind, double x0, double y0, double x1, double y1) {
+    double east[4] = { x0, x1, x1, x0 };
+    double north[4] = { y0, y0, y1, y1 };
+    write_polygon(kind, east, north, 4);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output> [zone_count] [origin_lat origin_lon]\n", argv[0]);
+        return 1;
+    }
+    uint32_t zones = argc > 2 ? (uint32_t)atoi(argv[2]) : 100;
+    if (argc > 4) {
+        origin_lat = atof(argv[3]);
+        origin_lon = atof(argv[4]);
+    }
+    output = fopen(argv[1], "wb");
+    if (output == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    uint32_t header[2] = { GEOFENCE_MAGIC, 5 + zones };
+    fwrite(header, sizeof(header), 1, output);
+
+    double w = FIELD_HALF_WIDTH_M, h = FIELD_HALF_HEIGHT_M, e = HEADLAND_M;
+    write_rectangle(GEOFENCE_FIELD_BOUNDARY, -w, -h, w, h);
+    write_rectangle(GEOFENCE_HEADLAND, -w, -h, -w + e, h);
+    write_rectangle(GEOFENCE_HEADLAND, w - e, -h, w, h);
+    write_rectangle(GEOFENCE_HEADLAND, -w + e, -h, w - e, -h + e);
+    write_rectangle(GEOFENCE_HEADLAND, -w + e, h - e, w - e, h);
+
+    // Small zones scattered inside the field, clear of the origin
+    srand(42);
+    static const GeofenceKind kinds[3] = { GEOFENCE_WATERWAY, GEOFENCE_NO_SPRAY, GEOFENCE_EXCLUSION };
+    for (uint32_t z = 0; z < zones; z++) {
+        double cx, cy;
+        do {
+            cx = (rand() / (double)RAND_MAX * 2.0 - 1.0) * (w - e - 20.0);
+            cy = (rand() / (double)RAND_MAX * 2.0 - 1.0) * (h - e - 20.0);
+        } while (fabs(cx) < 30.0 && fabs(cy) < 30.0);
+        double radius = 3.0 + rand() / (double)RAND_MAX * 7.0;
+
+        double east[ZONE_SIDES], north[ZONE_SIDES];
+        for (int i = 0; i < ZONE_SIDES; i++) {
+            double angle = 2.0 * M_PI * i / ZONE_SIDES;
+            east[i] = cx + radius * cos(angle);
+            north[i] = cy + radius * sin(angle);
+        }
+        write_polygon(kinds[z % 3], east, north, ZONE_SIDES);
+    }
+
+    fclose(output);
+    printf("Wrote %u polygons to %s\n", header[1], argv[1]);
+    return 0;
+}
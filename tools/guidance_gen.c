@@ -0,0 +1,45 @@
+// Generates a synthetic curved guidance path in the ECU's text format: a
+// meandering line across the field through the origin, densely sampled
+// the way a recorded curve from a previous pass would be.
+//
+// Usage: guidance_gen <output> [vertex_count] [origin_lat origin_lon]
+
+#include "telematics/telematics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define CURVE_LENGTH_M  1200.0
+#define MEANDER_M       40.0
+#define WAVELENGTH_M    300.0
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output> [vertex_count] [origin_lat origin_lon]\n", argv[0]);
+        return 1;
+    }
+    long count = argc > 2 ? atol(argv[2]) : 50000;
+    double origin_lat = argc > 4 ? atof(argv[3]) : 41.6032;
+    double origin_lon = argc > 4 ? atof(argv[4]) : -90.5776;
+    if (count < 2) {
+        fprintf(stderr, "vertex_count must be at least 2\n");
+        return 1;
+    }
+    FILE* output = fopen(argv[1], "w");
+    if (output == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    double meters_per_deg_lat, meters_per_deg_lon;
+    telematics_meters_per_degree(origin_lat, &meters_per_deg_lat, &meters_per_deg_lon);
+    fprintf(output, "# Synthetic guidance curve, %ld vertices\nCURVE\n", count);
+    for (long i = 0; i < count; i++) {
+        double east = -CURVE_LENGTH_M / 2.0 + CURVE_LENGTH_M * i / (count - 1);
+        double north = MEANDER_M * sin(2.0 * M_PI * east / WAVELENGTH_M);
+        fprintf(output, "%.9f %.9f\n", origin_lat + north / meters_per_deg_lat, origin_lon + east / meters_per_deg_lon);
+    }
+    fclose(output);
+    printf("Wrote %ld-vertex guidance curve to %s\n", count, argv[1]);
+    return 0;
+}
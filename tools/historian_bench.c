@@ -0,0 +1,213 @@
+// Check and benchmark for the signal historian (src/historian).
+//
+// Records a synthetic 100 Hz drive of several hours through the historian,
+// then checks the vector range reductions against the scalar ones on
+// random ranges of every tier, and checks each rollup tier against the
+// finer tier it was built from. The benchmark times recording and
+// full-tier range queries, vector against scalar.
+//
+// Usage: historian_bench [--check] [--hours N] [--budget-mb N]
+
+#include "historian/historian.h"
+#include "common/rng.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define SAMPLE_PERIOD_MS  10      // 100 Hz, the control executive rate
+#define RANDOM_QUERIES    2000
+#define RECORD_BLOCK      4096
+#define BENCH_RNG_STREAM  1
+
+// Fixed seed and stream, so every run records and queries the same data
+static Rng bench_rng;
+
+static double uniform(double low, double high) {
+    return low + (high - low) * rng_uniform(&bench_rng);
+}
+
+// Slow sweeps plus noise, with a different period and level per signal
+static void synthetic_sample(uint64_t time_ms, float* values) {
+    double t = time_ms / 1000.0;
+    for (int s = 0; s < HIST_SIGNAL_COUNT; s++) {
+        double level = 100.0 * (s + 1);
+        double period = 30.0 + 17.0 * s;
+        values[s] = (float)(level + 0.4 * level * sin(2.0 * M_PI * t / period) + uniform(-1.0, 1.0));
+    }
+}
+
+// Samples are generated a block at a time so only recording is timed
+static double record_drive(double hours) {
+    static float block[RECORD_BLOCK][HIST_SIGNAL_COUNT];
+    uint64_t samples = (uint64_t)(hours * 3600.0 * 1000.0 / SAMPLE_PERIOD_MS);
+    double elapsed = 0.0;
+    for (uint64_t n = 0; n < samples; n += RECORD_BLOCK) {
+        uint64_t count = samples - n < RECORD_BLOCK ? samples - n : RECORD_BLOCK;
+        for (uint64_t k = 0; k < count; k++) {
+            synthetic_sample((n + k) * SAMPLE_PERIOD_MS, block[k]);
+        }
+        double start = now_ns();
+        for (uint64_t k = 0; k < count; k++) {
+            historian_record((n + k) * SAMPLE_PERIOD_MS, block[k]);
+        }
+        elapsed += now_ns() - start;
+    }
+    return elapsed / (double)samples;
+}
+
+static bool close_to(float a, float b) {
+    return fabsf(a - b) <= 1e-5f * fmaxf(1.0f, fabsf(b));
+}
+
+// Vector against scalar reduction on random ranges of every tier
+static int check_vector(void) {
+    int failures = 0;
+    for (int t = 0; t < HIST_TIER_COUNT; t++) {
+        HistorianTierStats stats;
+        historian_get_tier_stats(t, &stats);
+        int checked = 0;
+        for (int q = 0; q < RANDOM_QUERIES && failures < 10; q++) {
+            HistorianSignal signal = (HistorianSignal)rng_below(&bench_rng, HIST_SIGNAL_COUNT);
+            uint64_t a = (uint64_t)uniform((double)stats.oldest_ms, (double)stats.newest_ms);
+            uint64_t b = (uint64_t)uniform((double)stats.oldest_ms, (double)stats.newest_ms);
+            uint64_t from = a < b ? a : b, to = a < b ? b : a;
+            HistorianSummary vec, ref;
+            bool found = historian_query_tier(signal, t, from, to, &vec);
+            if (found != historian_query_scalar(signal, t, from, to, &ref)) {
+                printf("  %s: vector and scalar disagree on whether rows exist\n", historian_tier_name(t));
+                failures++;
+                continue;
+            }
+            if (!found) continue;
+            checked++;
+            if (vec.min != ref.min || vec.max != ref.max || !close_to(vec.mean, ref.mean) ||
+                vec.rows != ref.rows || vec.samples != ref.samples) {
+                printf("  %s %s: vector %g/%g/%g vs scalar %g/%g/%g over %u rows\n",
+                       historian_tier_name(t), historian_signal_name(signal), vec.min, vec.mean,
+                       vec.max, ref.min, ref.mean, ref.max, ref.rows);
+                failures++;
+            }
+        }
+        printf("  %-6s %5d random ranges  %s\n", historian_tier_name(t), checked,
+               failures == 0 ? "ok" : "FAILED");
+    }
+    return failures;
+}
+
+// Each rollup row must summarize exactly the rows of the finer tier under it
+static int check_rollups(void) {
+    static const uint64_t span_ms[HIST_TIER_COUNT] = { 0, 1000, 60000, 3600000 };
+    int failures = 0;
+    for (int t = HIST_TIER_SECOND; t < HIST_TIER_COUNT; t++) {
+        HistorianTierStats coarse, fine;
+        historian_get_tier_stats(t, &coarse);
+        historian_get_tier_stats(t - 1, &fine);
+        if (coarse.rows == 0) {
+            printf("  %-6s no closed rows to compare\n", historian_tier_name(t));
+            continue;
+        }
+        // Newest closed rows whose whole bucket the finer tier still holds
+        int compared = 0;
+        for (uint64_t bucket = coarse.newest_ms; compared < 8 && bucket >= fine.oldest_ms &&
+             bucket >= coarse.oldest_ms; bucket -= span_ms[t]) {
+            uint64_t end = bucket + span_ms[t] - 1;
+            HistorianSummary row, parts;
+            if (!historian_query_scalar(HIST_SIG_ENGINE_RPM, t, bucket, bucket, &row) ||
+                !historian_query_scalar(HIST_SIG_ENGINE_RPM, t - 1, bucket, end, &parts)) {
+                break;
+            }
+            if (row.min != parts.min || row.max != parts.max || !close_to(row.mean, parts.mean) ||
+                row.samples != parts.samples) {
+                printf("  %s row at %llu ms: %g/%g/%g (%u samples) vs %g/%g/%g (%u samples)\n",
+                       historian_tier_name(t), (unsigned long long)bucket, row.min, row.mean,
+                       row.max, row.samples, parts.min, parts.mean, parts.max, parts.samples);
+                failures++;
+            }
+            compared++;
+            if (bucket < span_ms[t]) break;
+        }
+        printf("  %-6s %5d rows against the %s tier  %s\n", historian_tier_name(t), compared,
+               historian_tier_name(t - 1), failures == 0 ? "ok" : "FAILED");
+    }
+    return failures;
+}
+
+static volatile float bench_sink;
+
+static void bench_queries(void) {
+    printf("\nFull-tier range queries:\n");
+    printf("  %-6s %8s %12s %12s %8s\n", "Tier", "Rows", "Vector ns", "Scalar ns", "Speedup");
+    for (int t = 0; t < HIST_TIER_COUNT; t++) {
+        HistorianTierStats stats;
+        historian_get_tier_stats(t, &stats);
+        if (stats.rows == 0) continue;
+        int rounds = (int)(2000000u / stats.rows) + 1;
+        HistorianSummary summary;
+        float sink = 0.0f;
+        double start = now_ns();
+        for (int r = 0; r < rounds; r++) {
+            historian_query_tier(r % HIST_SIGNAL_COUNT, t, stats.oldest_ms, stats.newest_ms, &summary);
+            sink += summary.mean;
+        }
+        double vector_ns = (now_ns() - start) / rounds;
+        start = now_ns();
+        for (int r = 0; r < rounds; r++) {
+            historian_query_scalar(r % HIST_SIGNAL_COUNT, t, stats.oldest_ms, stats.newest_ms, &summary);
+            sink += summary.mean;
+        }
+        double scalar_ns = (now_ns() - start) / rounds;
+        bench_sink = sink;
+        printf("  %-6s %8u %12.0f %12.0f %7.1fx\n", historian_tier_name(t), stats.rows,
+               vector_ns, scalar_ns, scalar_ns / vector_ns);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool check_only = false;
+    double hours = 6.0;
+    unsigned long budget_mb = HISTORIAN_DEFAULT_BUDGET / (1024u * 1024u);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+            hours = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--budget-mb") == 0 && i + 1 < argc) {
+            budget_mb = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--check] [--hours N] [--budget-mb N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (hours <= 0.0) hours = 1.0;
+    rng_seed(&bench_rng, RNG_DEFAULT_SEED, BENCH_RNG_STREAM);
+
+    if (!historian_init((size_t)budget_mb * 1024u * 1024u)) {
+        return 1;
+    }
+    double record_ns = record_drive(hours);
+    printf("Recorded %.1f h at %d Hz: %.1f ns per sample of %d signals\n", hours,
+           1000 / SAMPLE_PERIOD_MS, record_ns, HIST_SIGNAL_COUNT);
+    for (int t = 0; t < HIST_TIER_COUNT; t++) {
+        HistorianTierStats stats;
+        historian_get_tier_stats(t, &stats);
+        printf("  %-6s %8u / %8u rows, %10.1f s held\n", historian_tier_name(t), stats.rows,
+               stats.capacity, (stats.newest_ms - stats.oldest_ms) / 1000.0);
+    }
+
+    printf("\nVector against scalar reductions:\n");
+    int failures = check_vector();
+    printf("Rollups against the finer tier:\n");
+    failures += check_rollups();
+    printf("Historian check %s\n", failures == 0 ? "PASSED" : "FAILED");
+    if (check_only || failures != 0) {
+        historian_shutdown();
+        return failures == 0 ? 0 : 1;
+    }
+
+    bench_queries();
+    historian_shutdown();
+    return 0;
+}
@@ -0,0 +1,301 @@
+// Compiles implement profile text sources into the ECU's memory-mapped
+// profile database, generates large synthetic sources and benchmarks
+// lookups.
+//
+// Source format - one profile per line, key=value fields, name last:
+//   id=0x00010001 type=planter width=12 rows=24 depth=5 rate=84000
+//       units=seeds/ha sections scv=9@1400 scv=1@1200 name=24-row planter
+// type is planter, sprayer, baler, cultivator or mower; the bare words
+// sections, pto and draft set the profile flags; scv=GPM@PSI loads the
+// next remote valve. '#' starts a comment.
+//
+// Usage: implement_db build <source> <output>
+//        implement_db gen <count> <source>
+//        implement_db bench <database> [lookups]
+
+#include "implement/profile_db.h"
+#include "implement/implement.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define LINE_MAX_BYTES 512
+
+static const char* type_names[] = { "none", "planter", "sprayer", "baler", "cultivator", "mower" };
+#define TYPE_COUNT (sizeof(type_names) / sizeof(type_names[0]))
+
+static bool parse_type(const char* value, uint8_t* type) {
+    for (size_t i = 1; i < TYPE_COUNT; i++) {
+        if (strcmp(value, type_names[i]) == 0) {
+            *type = (uint8_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One source line into a profile; false with a message on errors
+static bool parse_line(char* line, ImplementProfile* profile, const char** error) {
+    memset(profile, 0, sizeof(*profile));
+    bool have_id = false, have_type = false;
+    int remotes = 0;
+
+    char* cursor = line;
+    while (*cursor != '\0') {
+        while (isspace((unsigned char)*cursor)) cursor++;
+        if (*cursor == '\0') break;
+        if (strncmp(cursor, "name=", 5) == 0) {
+            char* name = cursor + 5;
+            size_t length = strlen(name);
+            while (length > 0 && isspace((unsigned char)name[length - 1])) length--;
+            if (length >= PROFILE_NAME_LEN) length = PROFILE_NAME_LEN - 1;
+            memcpy(profile->name, name, length);
+            break;
+        }
+
+        char* token = cursor;
+        while (*cursor != '\0' && !isspace((unsigned char)*cursor)) cursor++;
+        if (*cursor != '\0') *cursor++ = '\0';
+
+        char* value = strchr(token, '=');
+        if (value != NULL) *value++ = '\0';
+        if (strcmp(token, "sections") == 0) {
+            profile->flags |= PROFILE_SECTION_CONTROL;
+        } else if (strcmp(token, "pto") == 0) {
+            profile->flags |= PROFILE_NEEDS_PTO;
+        } else if (strcmp(token, "draft") == 0) {
+            profile->flags |= PROFILE_DRAFT_CONTROL;
+        } else if (value == NULL) {
+            *error = "unknown flag";
+            return false;
+        } else if (strcmp(token, "id") == 0) {
+            profile->id = (uint32_t)strtoul(value, NULL, 0);
+            have_id = true;
+        } else if (strcmp(token, "type") == 0) {
+            if (!parse_type(value, &profile->type)) {
+                *error = "unknown implement type";
+                return false;
+            }
+            have_type = true;
+        } else if (strcmp(token, "width") == 0) {
+            profile->width_m = strtof(value, NULL);
+        } else if (strcmp(token, "rows") == 0) {
+            long rows = strtol(value, NULL, 10);
+            if (rows < 1 || rows > 64) {
+                *error = "rows must be 1-64";
+                return false;
+            }
+            profile->rows_or_sections = (uint16_t)rows;
+        } else if (strcmp(token, "depth") == 0) {
+            profile->target_depth_cm = strtof(value, NULL);
+        } else if (strcmp(token, "rate") == 0) {
+            profile->base_rate = strtof(value, NULL);
+        } else if (strcmp(token, "units") == 0) {
+            snprintf(profile->rate_units, sizeof(profile->rate_units), "%s", value);
+        } else if (strcmp(token, "scv") == 0) {
+            char* at = strchr(value, '@');
+            if (remotes >= PROFILE_REMOTE_COUNT || at == NULL) {
+                *error = remotes >= PROFILE_REMOTE_COUNT ? "too many scv loads" : "scv needs GPM@PSI";
+                return false;
+            }
+            profile->remote_gpm[remotes] = strtof(value, NULL);
+            profile->remote_psi[remotes] = strtof(at + 1, NULL);
+            remotes++;
+        } else {
+            *error = "unknown field";
+            return false;
+        }
+    }
+
+    if (!have_id || !have_type || profile->name[0] == '\0') {
+        *error = "id, type and name are required";
+        return false;
+    }
+    if (profile->rows_or_sections == 0) profile->rows_or_sections = 1;
+    return true;
+}
+
+static int build(const char* source_path, const char* output_path) {
+    FILE* source = fopen(source_path, "r");
+    if (source == NULL) {
+        fprintf(stderr, "Cannot open %s\n", source_path);
+        return 1;
+    }
+
+    size_t capacity = 256, count = 0;
+    ImplementProfile* profiles = malloc(capacity * sizeof(*profiles));
+    char line[LINE_MAX_BYTES];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), source) != NULL) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char* text = line;
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0') continue;
+
+        if (count == capacity) {
+            capacity *= 2;
+            profiles = realloc(profiles, capacity * sizeof(*profiles));
+        }
+        const char* error = NULL;
+        if (!parse_line(text, &profiles[count], &error)) {
+            fprintf(stderr, "%s:%d: %s\n", source_path, line_number, error);
+            fclose(source);
+            free(profiles);
+            return 1;
+        }
+        count++;
+    }
+    fclose(source);
+
+    // Index at most half full, so probe runs stay short
+    uint32_t slot_bits = 4;
+    while (((size_t)1 << slot_bits) < count * 2) slot_bits++;
+    size_t slot_count = (size_t)1 << slot_bits;
+    ProfileDbSlot* slots = malloc(slot_count * sizeof(*slots));
+    for (size_t i = 0; i < slot_count; i++) {
+        slots[i].id = 0;
+        slots[i].record = PROFILE_NO_RECORD;
+    }
+    uint32_t longest = 0;
+    for (size_t r = 0; r < count; r++) {
+        uint32_t slot = profile_db_slot(profiles[r].id, slot_bits);
+        uint32_t probes = 1;
+        while (slots[slot].record != PROFILE_NO_RECORD) {
+            if (slots[slot].id == profiles[r].id) {
+                fprintf(stderr, "%s: duplicate profile id 0x%08X (%s)\n", source_path,
+                        profiles[r].id, profiles[r].name);
+                free(slots);
+                free(profiles);
+                return 1;
+            }
+            slot = (slot + 1) & (uint32_t)(slot_count - 1);
+            probes++;
+        }
+        slots[slot].id = profiles[r].id;
+        slots[slot].record = (uint32_t)r;
+        if (probes > longest) longest = probes;
+    }
+
+    ProfileDbHeader header = {
+        .magic = PROFILE_DB_MAGIC,
+        .version = PROFILE_DB_VERSION,
+        .record_bytes = sizeof(ImplementProfile),
+        .count = (uint32_t)count,
+        .slot_bits = slot_bits,
+        .index_offset = PROFILE_DB_HEADER_BYTES,
+        .records_offset = (uint32_t)(PROFILE_DB_HEADER_BYTES + slot_count * sizeof(ProfileDbSlot)),
+    };
+    uint8_t padded[PROFILE_DB_HEADER_BYTES] = {0};
+    memcpy(padded, &header, sizeof(header));
+
+    // Write beside the target and rename over it, so a running ECU keeps
+    // its mapping of the old file and picks the new one up whole
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", output_path);
+    FILE* output = fopen(temp_path, "wb");
+    bool ok = output != NULL &&
+              fwrite(padded, sizeof(padded), 1, output) == 1 &&
+              fwrite(slots, sizeof(*slots), slot_count, output) == slot_count &&
+              fwrite(profiles, sizeof(*profiles), count, output) == count;
+    if (output != NULL && fclose(output) != 0) ok = false;
+    ok = ok && rename(temp_path, output_path) == 0;
+    free(slots);
+    free(profiles);
+    if (!ok) {
+        fprintf(stderr, "Cannot write %s\n", output_path);
+        remove(temp_path);
+        return 1;
+    }
+    printf("Wrote %zu profiles to %s (%zu index slots, longest probe %u)\n",
+           count, output_path, slot_count, longest);
+    return 0;
+}
+
+// Synthetic fleet: model variants of each implement type with scattered IDs
+static int generate(long count, const char* path) {
+    FILE* output = fopen(path, "w");
+    if (output == NULL) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return 1;
+    }
+    fprintf(output, "# Synthetic implement profiles (%ld)\n", count);
+    uint32_t x = 2463534242u;
+    for (long i = 0; i < count; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        uint32_t id = 0x01000000u + (uint32_t)i * 7919u;   // Sparse, like manufacturer codes
+        int type = 1 + (int)(x % 5);
+        int rows = 4 + (int)((x >> 8) % 45);
+        float width = rows * (0.3f + (float)((x >> 16) % 50) / 100.0f);
+        fprintf(output, "id=0x%08X type=%s width=%.1f rows=%d", id, type_names[type], width, rows);
+        switch (type) {
+            case IMPLEMENT_PLANTER:
+                fprintf(output, " depth=%.1f rate=%u units=seeds/ha sections scv=%.1f@1400",
+                        3.0f + (float)(x % 5), 60000u + (x >> 20) % 40000u, 6.0f + (float)(x % 5));
+                break;
+            case IMPLEMENT_SPRAYER:
+                fprintf(output, " rate=%u units=L/ha sections scv=%.1f@1300",
+                        80u + (x >> 20) % 200u, 4.0f + (float)(x % 6));
+                break;
+            case IMPLEMENT_CULTIVATOR:
+                fprintf(output, " depth=%.1f draft", 8.0f + (float)(x % 12));
+                break;
+            default:
+                fprintf(output, " depth=%.1f pto", (float)(x % 10));
+                break;
+        }
+        fprintf(output, " name=%s %ld\n", type_names[type], i);
+    }
+    fclose(output);
+    printf("Wrote %ld profiles to %s\n", count, path);
+    return 0;
+}
+
+static int bench(const char* path, long lookups) {
+    double start = now_ns();
+    if (!profile_db_open(path)) return 1;
+    double open_us = (now_ns() - start) / 1e3;
+
+    ProfileDbState* state = profile_db_get_state();
+    uint32_t* ids = malloc(state->count * sizeof(*ids));
+    ImplementProfile profile;
+    uint32_t found = 0;
+    // IDs follow the gen pattern; other databases show up as misses
+    for (uint32_t i = 0; i < state->count; i++) {
+        ids[i] = 0x01000000u + i * 7919u;
+    }
+
+    uint32_t x = 88172645u;
+    start = now_ns();
+    for (long n = 0; n < lookups; n++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        found += profile_db_find(ids[x % state->count], &profile);
+    }
+    double lookup_ns = (now_ns() - start) / (double)lookups;
+    free(ids);
+
+    printf("Mapped %u profiles (%.1f MB) in %.0f us\n", state->count,
+           state->mapped_bytes / (1024.0 * 1024.0), open_us);
+    printf("%ld lookups: %.1f ns each, %u found, longest probe %u\n",
+           lookups, lookup_ns, found, state->max_probes);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && strcmp(argv[1], "build") == 0) {
+        return build(argv[2], argv[3]);
+    }
+    if (argc >= 4 && strcmp(argv[1], "gen") == 0) {
+        return generate(strtol(argv[2], NULL, 10), argv[3]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        return bench(argv[2], argc >= 4 ? strtol(argv[3], NULL, 10) : 1000000);
+    }
+    fprintf(stderr, "Usage: %s build <source> <output>\n", argv[0]);
+    fprintf(stderr, "       %s gen <count> <source>\n", argv[0]);
+    fprintf(stderr, "       %s bench <database> [lookups]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,273 @@
+// Step-response harness for the control loops. Runs each loop against its
+// plant with several tunings, no sleeps, and reports rise time (10-90 %),
+// overshoot, 2 % settling time, integrated absolute error and the final
+// error, so tunings can be compared offline before they go on a tractor.
+//
+// The depth and draft loops run against the hitch plant in the control
+// module. The PTO speed loop closes through the engine governor, so its
+// step runs the engine, hydraulics and PTO models at the 1 s main-loop
+// period with the control executive ticking in between.
+//
+// Usage: pid_step [--loop depth|draft|pto] [--kp X] [--ki X] [--kd X] [--tau X]
+//        Gains given on the command line are added as a "custom" tuning.
+
+#include "control/control_loops.h"
+#include "engine/engine_control.h"
+#include "transmission/transmission.h"
+#include "hydraulics/hydraulics.h"
+#include "pto/pto.h"
+#include "implement/implement.h"
+#include "canbus/canbus.h"
+#include "diagnostics/diagnostics.h"
+#include "geofence/geofence.h"
+#include "thermal/thermal.h"
+#include "sensors/sensors.h"
+#include "common/rng.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX_SAMPLES     4096
+#define TICK_S          (1.0f / CONTROL_RATE_HZ)
+#define MAIN_STEP_S     1.0f    // Main-loop period for the PTO step
+#define SETTLE_BAND     0.02f
+
+typedef struct {
+    float rise_s;
+    float overshoot_percent;
+    float settle_s;
+    float iae;
+    float final_error;
+} StepMetrics;
+
+typedef struct {
+    const char* name;
+    PidGains gains;
+} Tuning;
+
+typedef struct {
+    const char* name;
+    ControlLoopId loop;
+    const char* description;
+    // Fills y[] at sample_s spacing; returns the count and the step endpoints
+    int (*run)(const PidGains* gains, float* y, float* start, float* setpoint);
+    float sample_s;
+} Scenario;
+
+// Hitch from the top stop to 15 cm, 9 m implement, draft control off
+static int run_depth(const PidGains* gains, float* y, float* start, float* setpoint) {
+    control_init();
+    control_set_gains(CONTROL_LOOP_DEPTH, gains);
+    control_set_hitch(true, REAL(15), REAL(9), false, REAL(2000));
+    int count = (int)(10.0f / TICK_S);
+    for (int i = 0; i < count; i++) {
+        control_run_for(TICK_S);
+        ControlState state;
+        control_get_state(&state);
+        y[i] = real_to_float(state.depth_cm);
+    }
+    *start = 0.0f;
+    *setpoint = 15.0f;
+    return count;
+}
+
+// Target depth 10 -> 15 cm with draft control on: a draft setpoint step
+static int run_draft(const PidGains* gains, float* y, float* start, float* setpoint) {
+    control_init();
+    control_set_gains(CONTROL_LOOP_DRAFT, gains);
+    control_set_hitch(true, REAL(10), REAL(9), true, REAL(2000));
+    control_run_for(20.0f);
+    ControlState state;
+    control_get_state(&state);
+    *start = real_to_float(state.draft_setpoint_kn);
+
+    control_set_hitch(true, REAL(15), REAL(9), true, REAL(2000));
+    int count = (int)(20.0f / (CONTROL_DRAFT_DIVIDER * TICK_S));
+    for (int i = 0; i < count; i++) {
+        control_run_for(CONTROL_DRAFT_DIVIDER * TICK_S);
+        control_get_state(&state);
+        y[i] = real_to_float(state.draft_kn);
+        *setpoint = real_to_float(state.draft_setpoint_kn);
+    }
+    return count;
+}
+
+static void main_loop_step(void) {
+    sensors_update(REAL(MAIN_STEP_S));
+    engine_update();
+    transmission_update();
+    hydraulics_update();
+    pto_update();
+    thermal_update(REAL(MAIN_STEP_S));
+    control_run_for(MAIN_STEP_S);
+}
+
+// Engage the 540 PTO at half throttle: the engine sits below rated speed,
+// so the loop has to lift it
+static int run_pto(const PidGains* gains, float* y, float* start, float* setpoint) {
+    rng_set_seed(RNG_DEFAULT_SEED);
+    canbus_init();
+    diagnostics_init();
+    engine_init();
+    transmission_init();
+    hydraulics_init();
+    pto_init();
+    thermal_init();
+    sensors_init();
+    control_init();
+    implement_init();
+    geofence_init();
+    control_set_gains(CONTROL_LOOP_PTO_SPEED, gains);
+
+    engine_start();
+    engine_set_throttle(50);
+    for (int i = 0; i < 20; i++) {
+        main_loop_step();
+    }
+    pto_engage(PTO_SPEED_540);
+    PTOState* pto = pto_get_state();
+    while (pto->status == PTO_ENGAGING) {
+        main_loop_step();
+    }
+    *start = (float)pto->current_rpm;
+    *setpoint = (float)pto->target_speed;
+
+    int count = 60;
+    for (int i = 0; i < count; i++) {
+        main_loop_step();
+        y[i] = (float)pto->current_rpm;
+    }
+    return count;
+}
+
+static StepMetrics measure(const float* y, int count, float dt, float start, float setpoint) {
+    StepMetrics m = { NAN, 0.0f, NAN, 0.0f, 0.0f };
+    float span = setpoint - start;
+    float t10 = NAN, t90 = NAN;
+    int last_outside = -1;
+    for (int i = 0; i < count; i++) {
+        float progress = (y[i] - start) / span;
+        if (isnan(t10) && progress >= 0.1f) t10 = (i + 1) * dt;
+        if (isnan(t90) && progress >= 0.9f) t90 = (i + 1) * dt;
+        m.overshoot_percent = fmaxf(m.overshoot_percent, (progress - 1.0f) * 100.0f);
+        if (fabsf(y[i] - setpoint) > SETTLE_BAND * fabsf(span)) last_outside = i;
+        m.iae += fabsf(setpoint - y[i]) * dt;
+    }
+    m.rise_s = t90 - t10;
+    if (last_outside < count - 1) m.settle_s = (last_outside + 1) * dt;
+
+    int tail = count / 10 > 0 ? count / 10 : 1;
+    for (int i = count - tail; i < count; i++) {
+        m.final_error += y[i] - setpoint;
+    }
+    m.final_error /= tail;
+    return m;
+}
+
+static void print_value(float value, const char* format) {
+    if (isnan(value)) {
+        printf("%9s", "-");
+    } else {
+        printf(format, value);
+    }
+}
+
+static void run_scenario(const Scenario* scenario, const Tuning* tunings, int tuning_count) {
+    static float y[MAX_SAMPLES];
+    printf("%s\n", scenario->description);
+    printf("%-10s %8s %8s %7s %9s %9s %9s %9s %9s\n",
+           "Tuning", "kp", "ki", "kd", "rise s", "overshoot", "settle s", "IAE", "final err");
+    for (int t = 0; t < tuning_count; t++) {
+        float start = 0.0f, setpoint = 0.0f;
+        quiet_begin();
+        int count = scenario->run(&tunings[t].gains, y, &start, &setpoint);
+        quiet_end();
+        StepMetrics m = measure(y, count, scenario->sample_s, start, setpoint);
+        const PidGains* g = &tunings[t].gains;
+        printf("%-10s %8.3f %8.3f %7.3f", tunings[t].name,
+               real_to_float(g->kp), real_to_float(g->ki), real_to_float(g->kd));
+        print_value(m.rise_s, "%9.2f");
+        printf("%8.1f%%", m.overshoot_percent);
+        print_value(m.settle_s, "%9.2f");
+        printf("%9.2f %+9.3f\n", m.iae, m.final_error);
+    }
+    printf("\n");
+}
+
+static PidGains scaled(const PidGains* base, float p_scale, float i_scale) {
+    PidGains gains = *base;
+    gains.kp = real_mul(gains.kp, real_from_float(p_scale));
+    gains.ki = real_mul(gains.ki, real_from_float(i_scale));
+    return gains;
+}
+
+int main(int argc, char* argv[]) {
+    static const Scenario scenarios[] = {
+        { "depth", CONTROL_LOOP_DEPTH, "Depth loop (100 Hz): hitch 0 -> 15 cm, 2000 PSI",
+          run_depth, TICK_S },
+        { "draft", CONTROL_LOOP_DRAFT, "Draft loop (20 Hz, over the depth loop): target depth 10 -> 15 cm",
+          run_draft, CONTROL_DRAFT_DIVIDER * TICK_S },
+        { "pto", CONTROL_LOOP_PTO_SPEED, "PTO speed loop (50 Hz, through the 1 s engine governor): engage 540 at 50% throttle",
+          run_pto, MAIN_STEP_S },
+    };
+    const int scenario_count = sizeof(scenarios) / sizeof(scenarios[0]);
+
+    const char* only = NULL;
+    float custom[4] = { NAN, NAN, NAN, NAN };   // kp, ki, kd, tau
+    static const char* gain_flags[4] = { "--kp", "--ki", "--kd", "--tau" };
+    for (int i = 1; i < argc; i++) {
+        bool known = false;
+        if (strcmp(argv[i], "--loop") == 0 && i + 1 < argc) {
+            only = argv[++i];
+            known = true;
+        }
+        for (int g = 0; g < 4 && !known; g++) {
+            if (strcmp(argv[i], gain_flags[g]) == 0 && i + 1 < argc) {
+                custom[g] = strtof(argv[++i], NULL);
+                known = true;
+            }
+        }
+        if (!known) {
+            fprintf(stderr, "Usage: %s [--loop depth|draft|pto] [--kp X] [--ki X] [--kd X] [--tau X]\n", argv[0]);
+            return 1;
+        }
+    }
+    bool has_custom = !isnan(custom[0]) || !isnan(custom[1]) || !isnan(custom[2]) || !isnan(custom[3]);
+
+    int ran = 0;
+    for (int s = 0; s < scenario_count; s++) {
+        if (only != NULL && strcmp(only, scenarios[s].name) != 0) continue;
+
+        quiet_begin();
+        control_init();
+        quiet_end();
+        PidGains base;
+        control_get_gains(scenarios[s].loop, &base);
+
+        Tuning tunings[5] = {
+            { "default", base },
+            { "soft", scaled(&base, 0.5f, 0.5f) },
+            { "stiff", scaled(&base, 2.0f, 2.0f) },
+            { "P only", scaled(&base, 1.0f, 0.0f) },
+        };
+        int tuning_count = 4;
+        if (has_custom) {
+            PidGains gains = base;
+            if (!isnan(custom[0])) gains.kp = real_from_float(custom[0]);
+            if (!isnan(custom[1])) gains.ki = real_from_float(custom[1]);
+            if (!isnan(custom[2])) gains.kd = real_from_float(custom[2]);
+            if (!isnan(custom[3])) gains.derivative_tau_s = real_from_float(custom[3]);
+            tunings[tuning_count++] = (Tuning){ "custom", gains };
+        }
+
+        run_scenario(&scenarios[s], tunings, tuning_count);
+        ran++;
+    }
+    if (ran == 0) {
+        fprintf(stderr, "Unknown loop '%s' (depth, draft or pto)\n", only);
+        return 1;
+    }
+    return 0;
+}
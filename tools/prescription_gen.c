@@ -0,0 +1,126 @@
+// Generates a synthetic farm-wide prescription raster in the ECU's tiled
+// format: 1 km blocks of fields, each split into smooth management zones,
+// with unprescribed blocks left out of the file entirely.
+//
+// Usage: prescription_gen <output> [seed|spray] [extent_m] [cell_m] [centre_lat centre_lon]
+
+#include "prescription/prescription.h"
+#include "telematics/telematics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define BLOCK_M           1000.0
+#define ROAD_M            20.0
+#define PRESCRIBED_SHARE  0.7
+
+static uint16_t cells[PRESCRIPTION_TILE_CELLS * PRESCRIPTION_TILE_CELLS];
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output> [seed|spray] [extent_m] [cell_m] [centre_lat centre_lon]\n", argv[0]);
+        return 1;
+    }
+    bool spray = argc > 2 && strcmp(argv[2], "spray") == 0;
+    double extent = argc > 3 ? atof(argv[3]) : 8000.0;
+    double cell = argc > 4 ? atof(argv[4]) : 2.0;
+    double centre_lat = argc > 6 ? atof(argv[5]) : 41.6032;
+    double centre_lon = argc > 6 ? atof(argv[6]) : -90.5776;
+    if (extent <= 0.0 || cell <= 0.0) {
+        fprintf(stderr, "extent and cell size must be positive\n");
+        return 1;
+    }
+
+    // Zone rates: seeds/ha for a planter, L/ha for a sprayer
+    double base = spray ? 150.0 : 84000.0;
+    double swing = spray ? 60.0 : 12000.0;
+    float scale = spray ? 0.01f : 10.0f;
+
+    PrescriptionHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PRESCRIPTION_MAGIC;
+    header.version = PRESCRIPTION_VERSION;
+    header.tiles_x = header.tiles_y = (uint32_t)ceil(extent / cell / PRESCRIPTION_TILE_CELLS);
+    double half = header.tiles_x * PRESCRIPTION_TILE_CELLS * cell * 0.5;
+    double meters_per_deg_lat, meters_per_deg_lon;
+    telematics_meters_per_degree(centre_lat, &meters_per_deg_lat, &meters_per_deg_lon);
+    header.origin_lat = centre_lat - half / meters_per_deg_lat;
+    header.origin_lon = centre_lon - half / meters_per_deg_lon;
+    header.cell_size_m = (float)cell;
+    header.rate_scale = scale;
+    snprintf(header.product, sizeof(header.product), "%s", spray ? "Herbicide" : "Corn seed");
+    snprintf(header.units, sizeof(header.units), "%s", spray ? "L/ha" : "seeds/ha");
+
+    // Pick the prescribed blocks; the block around the centre always is
+    srand(42);
+    int blocks = (int)ceil(2.0 * half / BLOCK_M);
+    bool* prescribed = calloc((size_t)blocks * blocks, sizeof(bool));
+    for (int b = 0; b < blocks * blocks; b++) {
+        prescribed[b] = rand() / (double)RAND_MAX < PRESCRIBED_SHARE;
+    }
+    prescribed[(int)(half / BLOCK_M) * blocks + (int)(half / BLOCK_M)] = true;
+
+    // Directory: a tile gets a slot when any of its cells lies in a prescribed block
+    uint32_t tiles = header.tiles_x * header.tiles_y;
+    uint32_t* directory = malloc(tiles * sizeof(uint32_t));
+    uint32_t slot_count = 0;
+    double tile_m = PRESCRIPTION_TILE_CELLS * cell;
+    for (uint32_t ty = 0; ty < header.tiles_y; ty++) {
+        for (uint32_t tx = 0; tx < header.tiles_x; tx++) {
+            int bx0 = (int)(tx * tile_m / BLOCK_M), bx1 = (int)(((tx + 1) * tile_m - cell) / BLOCK_M);
+            int by0 = (int)(ty * tile_m / BLOCK_M), by1 = (int)(((ty + 1) * tile_m - cell) / BLOCK_M);
+            bool any = false;
+            for (int by = by0; by <= by1 && by < blocks; by++) {
+                for (int bx = bx0; bx <= bx1 && bx < blocks; bx++) {
+                    any |= prescribed[by * blocks + bx];
+                }
+            }
+            directory[ty * header.tiles_x + tx] = any ? slot_count++ : PRESCRIPTION_NO_TILE;
+        }
+    }
+
+    FILE* output = fopen(argv[1], "wb");
+    if (output == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    static uint8_t padding[4096];
+    size_t directory_bytes = tiles * sizeof(uint32_t);
+    fwrite(&header, sizeof(header), 1, output);
+    fwrite(padding, PRESCRIPTION_HEADER_BYTES - sizeof(header), 1, output);
+    fwrite(directory, directory_bytes, 1, output);
+    fwrite(padding, (4096 - directory_bytes % 4096) % 4096, 1, output);
+
+    for (uint32_t t = 0; t < tiles; t++) {
+        if (directory[t] == PRESCRIPTION_NO_TILE) continue;
+        uint32_t tx = t % header.tiles_x, ty = t / header.tiles_x;
+        for (int y = 0; y < PRESCRIPTION_TILE_CELLS; y++) {
+            for (int x = 0; x < PRESCRIPTION_TILE_CELLS; x++) {
+                double e = ((tx << PRESCRIPTION_TILE_SHIFT) + x + 0.5) * cell;
+                double n = ((ty << PRESCRIPTION_TILE_SHIFT) + y + 0.5) * cell;
+                int bx = (int)(e / BLOCK_M), by = (int)(n / BLOCK_M);
+                double in_x = fmod(e, BLOCK_M), in_y = fmod(n, BLOCK_M);
+                uint16_t value = PRESCRIPTION_NO_DATA;
+                if (bx < blocks && by < blocks && prescribed[by * blocks + bx] &&
+                    in_x >= ROAD_M && in_y >= ROAD_M) {
+                    // Smooth soil-productivity surface quantized into five zones
+                    double soil = 0.5 * sin(e / 170.0 + bx) * cos(n / 230.0 - by) + 0.5 * sin((e + n) / 410.0);
+                    double zone = fmin(floor((soil + 1.0) * 2.5), 4.0) / 2.0 - 1.0;
+                    value = (uint16_t)lround((base + swing * zone) / scale);
+                }
+                cells[(y << PRESCRIPTION_TILE_SHIFT) | x] = value;
+            }
+        }
+        fwrite(cells, sizeof(cells), 1, output);
+    }
+    fclose(output);
+
+    printf("Wrote %ux%u-tile %s prescription (%u tiles with data, %.1f MB) to %s\n",
+           header.tiles_x, header.tiles_y, header.product, slot_count,
+           (PRESCRIPTION_HEADER_BYTES + directory_bytes + (double)slot_count * PRESCRIPTION_TILE_BYTES) / (1024.0 * 1024.0),
+           argv[1]);
+    free(directory);
+    free(prescribed);
+    return 0;
+}
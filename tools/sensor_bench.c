@@ -0,0 +1,370 @@
+// Check and benchmark for the sensor input pipeline (src/sensors/sensors.c).
+//
+// The check idles the engine model on the simulated ADC and confirms that
+// the published inputs follow the plant, that ignition spikes do not reach
+// them, that shorted, open and frozen inputs raise their circuit fault
+// after the debounce time while the last good value is held, and that
+// they recover. It then records the raw conversions of a run, replays them
+// and checks that the replay publishes exactly what the live run did, and
+// that the batched filters match a plain per-channel reference on the same
+// samples. The benchmark times a whole sensors_update in replay mode
+// against the reference filters alone, for several cycle lengths.
+//
+// Usage: sensor_bench [--check] [cycles]
+
+#include "engine/engine_control.h"
+#include "transmission/transmission.h"
+#include "hydraulics/hydraulics.h"
+#include "pto/pto.h"
+#include "canbus/canbus.h"
+#include "diagnostics/diagnostics.h"
+#include "thermal/thermal.h"
+#include "sensors/sensors.h"
+#include "common/rng.h"
+#include "common/fixed.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define REPLAY_FILE     "build/sensor_replay.raw"
+#define STEP_S          0.1
+#define STEP_MS         100
+#define DEFAULT_CYCLES  2000
+#define RECORD_STEPS    300
+
+// Span and filter time constant per input, from the channel table
+#define SENSOR_SPAN(name, label, unit, low, high, tau_ms) [SENSOR_##name] = (high) - (low),
+static const float spans[SENSOR_CHANNEL_COUNT] = { SENSOR_CHANNELS(SENSOR_SPAN) };
+#undef SENSOR_SPAN
+#define SENSOR_TAU(name, label, unit, low, high, tau_ms) [SENSOR_##name] = tau_ms,
+static const int taus_ms[SENSOR_CHANNEL_COUNT] = { SENSOR_CHANNELS(SENSOR_TAU) };
+#undef SENSOR_TAU
+
+static void step(void) {
+    sensors_update(REAL(STEP_S));
+    engine_update();
+    transmission_update();
+    hydraulics_update();
+    pto_update();
+    thermal_update(REAL(STEP_S));
+    diagnostics_update();
+    canbus_update();
+}
+
+static void init_modules(void) {
+    rng_set_seed(RNG_DEFAULT_SEED);
+    canbus_init();
+    diagnostics_init();
+    engine_init();
+    transmission_init();
+    hydraulics_init();
+    pto_init();
+    thermal_init();
+    sensors_init();
+}
+
+// Engine running at a steady throttle, filters settled
+static void start_idle(void) {
+    init_modules();
+    engine_start();
+    engine_set_throttle(40);
+    for (int s = 0; s < 50; s++) step();
+}
+
+static bool fault_active(FaultId fault) {
+    const DiagnosticsState* diagnostics = diagnostics_get_state();
+    for (int i = 0; i < diagnostics->fault_count; i++) {
+        if (diagnostics->faults[i].fault_id == fault) return diagnostics->faults[i].active;
+    }
+    return false;
+}
+
+static float value(SensorChannel channel) {
+    return real_to_float(sensors_read(channel));
+}
+
+static float coolant_error(void) {
+    return fabsf(value(SENSOR_COOLANT_TEMP) - real_to_float(thermal_get_state()->temp_c[THERMAL_COOLANT]));
+}
+
+static void check_tracking(void) {
+    quiet_begin();
+    start_idle();
+    quiet_end();
+    float trans_error = fabsf(value(SENSOR_TRANS_OIL_TEMP) -
+                              real_to_float(thermal_get_state()->temp_c[THERMAL_TRANSMISSION_OIL]));
+    expect("Temperatures within 0.5 C of the thermal model", coolant_error() < 0.5f && trans_error < 0.5f);
+    expect("Battery reads the charging voltage", fabsf(value(SENSOR_BATTERY_VOLTAGE) - 14.1f) < 0.1f);
+    expect("Modules read the published inputs",
+           engine_get_state()->coolant_temp == sensors_read(SENSOR_COOLANT_TEMP) &&
+           hydraulics_get_state()->reservoir_level == sensors_read(SENSOR_HYD_RESERVOIR));
+    SensorData supply;
+    sensors_get_supply(&supply);
+    expect("Supply snapshot carries battery, alternator and ECU inputs",
+           supply.voltage == value(SENSOR_BATTERY_VOLTAGE) && supply.current == value(SENSOR_ALTERNATOR_CURRENT) &&
+           supply.temperature == value(SENSOR_ECU_TEMP));
+}
+
+static void check_spikes(void) {
+    quiet_begin();
+    start_idle();
+    sensors_inject_fault(SENSOR_COOLANT_TEMP, SENSOR_FAULT_SPIKES);
+    float worst = 0.0f;
+    for (int s = 0; s < 50; s++) {
+        step();
+        if (coolant_error() > worst) worst = coolant_error();
+    }
+    quiet_end();
+    const SensorChannelState* coolant = &sensors_get_state()->channels[SENSOR_COOLANT_TEMP];
+    expect("Ignition spikes removed by the median filter", coolant->spikes > 100 && worst < 0.5f);
+    expect("Spikes alone raise no circuit fault", coolant->valid && coolant->faults == 0);
+    printf("  %u spikes in 5 s, coolant within %.2f C of the model\n", coolant->spikes, worst);
+}
+
+// Inject a circuit fault, wait for its DTC, then remove it again
+static void check_circuit(SensorChannel channel, SensorFault fault, FaultId expected, int debounce_ms,
+                          const char* name) {
+    quiet_begin();
+    start_idle();
+    float before = value(channel);
+    float tolerance = spans[channel] * 0.01f;
+    sensors_inject_fault(channel, fault);
+    int elapsed_ms = 0;
+    bool held = true;
+    while (!fault_active(expected) && elapsed_ms < 5000) {
+        step();
+        elapsed_ms += STEP_MS;
+        held &= fabsf(value(channel) - before) < tolerance;
+    }
+    for (int s = 0; s < 10; s++) {
+        step();
+        held &= fabsf(value(channel) - before) < tolerance;
+    }
+    bool invalid = !sensors_valid(channel);
+
+    sensors_inject_fault(channel, SENSOR_FAULT_NONE);
+    int recovery_ms = 0;
+    while (fault_active(expected) && recovery_ms < 5000) {
+        step();
+        recovery_ms += STEP_MS;
+    }
+    quiet_end();
+
+    char label[96];
+    snprintf(label, sizeof(label), "%s: fault after %d ms, value held", name, elapsed_ms);
+    expect(label, elapsed_ms >= debounce_ms && elapsed_ms <= debounce_ms + 2 * STEP_MS && held && invalid);
+    snprintf(label, sizeof(label), "%s: recovered after %d ms", name, recovery_ms);
+    expect(label, recovery_ms <= 2 * STEP_MS && sensors_valid(channel));
+}
+
+// Plain per-channel filter, written for clarity rather than speed
+typedef struct {
+    float taps[SENSOR_MEDIAN_TAPS];
+    float iir;
+    int tap;
+    bool primed;
+    uint32_t spikes;
+    uint32_t out_of_range;
+} ReferenceFilter;
+
+static float median_of_taps(const float* taps) {
+    float sorted[SENSOR_MEDIAN_TAPS];
+    memcpy(sorted, taps, sizeof(sorted));
+    for (int i = 1; i < SENSOR_MEDIAN_TAPS; i++) {
+        for (int j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+            float swap = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = swap;
+        }
+    }
+    return sorted[SENSOR_MEDIAN_TAPS / 2];
+}
+
+static float oversampled(const uint16_t* rows, uint32_t sample, int channel) {
+    uint32_t sum = 0;
+    for (int o = 0; o < SENSOR_OVERSAMPLE; o++) {
+        sum += rows[((size_t)sample * SENSOR_OVERSAMPLE + o) * SENSOR_CHANNEL_COUNT + channel];
+    }
+    return (float)sum * (1.0f / SENSOR_OVERSAMPLE);
+}
+
+static void reference_block(ReferenceFilter* filters, const uint16_t* rows, uint32_t samples) {
+    const float shorted_at = 0.25f * (SENSOR_ADC_MAX / 5.0f);
+    const float open_at = 4.75f * (SENSOR_ADC_MAX / 5.0f);
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        ReferenceFilter* f = &filters[ch];
+        float alpha = 1000.0f / (SENSOR_SAMPLE_RATE_HZ * (float)taus_ms[ch] + 1000.0f);
+        if (!f->primed) {
+            float first = oversampled(rows, 0, ch);
+            for (int t = 0; t < SENSOR_MEDIAN_TAPS; t++) f->taps[t] = first;
+            f->iir = first;
+            f->primed = true;
+        }
+        for (uint32_t i = 0; i < samples; i++) {
+            float x = oversampled(rows, i, ch);
+            f->out_of_range += x < shorted_at || x > open_at;
+            f->taps[f->tap] = x;
+            f->tap = (f->tap + 1) % SENSOR_MEDIAN_TAPS;
+            float m = median_of_taps(f->taps);
+            f->spikes += fabsf(x - m) > SENSOR_SPIKE_COUNTS;
+            f->iir += alpha * (m - f->iir);
+        }
+    }
+}
+
+static uint16_t* read_replay(uint64_t* scans) {
+    FILE* file = fopen(REPLAY_FILE, "rb");
+    if (file == NULL) return NULL;
+    SensorReplayHeader header;
+    uint16_t* rows = NULL;
+    if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == SENSOR_REPLAY_MAGIC &&
+        header.channel_count == SENSOR_CHANNEL_COUNT) {
+        rows = malloc(header.scans * SENSOR_CHANNEL_COUNT * sizeof(uint16_t));
+        if (rows != NULL && fread(rows, SENSOR_CHANNEL_COUNT * sizeof(uint16_t), header.scans, file) != header.scans) {
+            free(rows);
+            rows = NULL;
+        }
+        *scans = header.scans;
+    }
+    fclose(file);
+    return rows;
+}
+
+static void check_replay(void) {
+    static float live[RECORD_STEPS][SENSOR_CHANNEL_COUNT];
+    static float live_counts[RECORD_STEPS][SENSOR_CHANNEL_COUNT];
+    static float replayed[RECORD_STEPS][SENSOR_CHANNEL_COUNT];
+
+    quiet_begin();
+    init_modules();
+    bool recording = sensors_record_open(REPLAY_FILE);
+    engine_start();
+    engine_set_throttle(70);
+    for (int s = 0; s < RECORD_STEPS; s++) {
+        step();
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+            live[s][ch] = value((SensorChannel)ch);
+            live_counts[s][ch] = sensors_get_state()->channels[ch].filtered_counts;
+        }
+    }
+    sensors_record_close();
+
+    init_modules();
+    bool replaying = sensors_replay_open(REPLAY_FILE);
+    engine_start();
+    engine_set_throttle(70);
+    for (int s = 0; s < RECORD_STEPS; s++) {
+        step();
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) replayed[s][ch] = value((SensorChannel)ch);
+    }
+    sensors_replay_close();
+    quiet_end();
+    expect("Raw conversions recorded and replayed", recording && replaying);
+    expect("Replay publishes exactly what the live run did", memcmp(live, replayed, sizeof(live)) == 0);
+
+    uint64_t scans = 0;
+    uint16_t* rows = read_replay(&scans);
+    uint32_t per_step = (uint32_t)(STEP_S * SENSOR_SAMPLE_RATE_HZ);
+    expect("Recording holds every conversion", rows != NULL &&
+           scans == (uint64_t)RECORD_STEPS * per_step * SENSOR_OVERSAMPLE);
+    if (rows == NULL) return;
+    ReferenceFilter filters[SENSOR_CHANNEL_COUNT] = {0};
+    float worst = 0.0f;
+    for (int s = 0; s < RECORD_STEPS; s++) {
+        reference_block(filters, rows + (size_t)s * per_step * SENSOR_OVERSAMPLE * SENSOR_CHANNEL_COUNT, per_step);
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+            float error = fabsf(filters[ch].iir - live_counts[s][ch]);
+            if (error > worst) worst = error;
+        }
+    }
+    free(rows);
+    char label[96];
+    snprintf(label, sizeof(label), "Batched filters match the reference (%.1e counts)", worst);
+    expect(label, worst < 1e-3f);
+}
+
+static void bench(uint32_t cycles) {
+    static const uint32_t blocks[] = { 10, 100, 1000 };
+    uint64_t scans = 0;
+    uint16_t* rows = read_replay(&scans);
+    if (rows == NULL) {
+        check_failures++;
+        return;
+    }
+    uint64_t replay_samples = scans / SENSOR_OVERSAMPLE;
+
+    printf("\nFiltering benchmark (%d inputs, %dx oversampling, %u cycles per block size):\n",
+           SENSOR_CHANNEL_COUNT, SENSOR_OVERSAMPLE, cycles);
+    printf("  %-7s %14s %14s %9s %14s\n", "Samples", "Batched ns", "Reference ns", "Speedup", "Sim ADC us");
+    for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+        uint32_t block = blocks[b];
+        real_t dt = real_from_float((float)block / SENSOR_SAMPLE_RATE_HZ);
+        uint32_t runs = cycles * 100 / block;
+        if (runs < 10) runs = 10;
+
+        // Whole update on replayed conversions: copy, filter, checks, publish
+        quiet_begin();
+        init_modules();
+        sensors_replay_open(REPLAY_FILE);
+        double start = now_ns();
+        for (uint32_t r = 0; r < runs; r++) sensors_update(dt);
+        double batched = (now_ns() - start) / ((double)runs * block * SENSOR_CHANNEL_COUNT);
+        sensors_replay_close();
+
+        // Same update on the simulated converter
+        init_modules();
+        start = now_ns();
+        for (uint32_t r = 0; r < runs; r++) sensors_update(dt);
+        double simulated_us = (now_ns() - start) / runs / 1000.0;
+        quiet_end();
+
+        // Reference filters alone on the same conversions
+        ReferenceFilter filters[SENSOR_CHANNEL_COUNT] = {0};
+        uint64_t position = 0;
+        start = now_ns();
+        for (uint32_t r = 0; r < runs; r++) {
+            if (position + block > replay_samples) position = 0;
+            reference_block(filters, rows + position * SENSOR_OVERSAMPLE * SENSOR_CHANNEL_COUNT, block);
+            position += block;
+        }
+        double reference = (now_ns() - start) / ((double)runs * block * SENSOR_CHANNEL_COUNT);
+        printf("  %-7u %14.2f %14.2f %8.1fx %14.1f\n", block, batched, reference, reference / batched,
+               simulated_us);
+    }
+    printf("  (ns per input per filtered sample)\n");
+    free(rows);
+}
+
+int main(int argc, char* argv[]) {
+    bool check_only = false;
+    uint32_t cycles = DEFAULT_CYCLES;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if (argv[i][0] != '-') {
+            cycles = (uint32_t)strtoul(argv[i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--check] [cycles]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (cycles < 10) cycles = 10;
+
+    printf("\nSensor checks:\n");
+    check_tracking();
+    check_spikes();
+    check_circuit(SENSOR_OIL_PRESSURE, SENSOR_FAULT_SHORTED, FAULT_SENSOR_OIL_PRESSURE_LOW,
+                  SENSOR_RANGE_DEBOUNCE_MS, "Oil pressure shorted");
+    check_circuit(SENSOR_HYD_OIL_TEMP, SENSOR_FAULT_OPEN, FAULT_SENSOR_HYD_OIL_TEMP_HIGH,
+                  SENSOR_RANGE_DEBOUNCE_MS, "Hydraulic oil temperature open");
+    check_circuit(SENSOR_BATTERY_VOLTAGE, SENSOR_FAULT_STUCK, FAULT_SENSOR_BATTERY_VOLTAGE_STUCK,
+                  SENSOR_STUCK_MS, "Battery voltage frozen");
+    check_replay();
+    if (check_report("Sensor") && !check_only) {
+        bench(cycles);
+    }
+    return check_failures == 0 ? 0 : 1;
+}
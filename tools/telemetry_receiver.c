@@ -0,0 +1,139 @@
+// Local stand-in for the cloud telemetry endpoint.
+// Accepts the ECU's HTTP POST uploads, decompresses and decodes each batch,
+// and prints what it received so the upload pipeline can be tested offline.
+//
+// Usage: telemetry_receiver [port] [max_batches]
+
+#include "telematics/telemetry_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define MAX_REQUEST (TELEMETRY_MAX_COMPRESSED + 1024)
+
+static uint8_t request[MAX_REQUEST];
+static uint8_t encoded[TELEMETRY_MAX_ENCODED];
+
+static void respond(int fd, const char* status) {
+    char response[128];
+    int n = snprintf(response, sizeof(response),
+                     "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status);
+    send(fd, response, (size_t)n, MSG_NOSIGNAL);
+}
+
+// Read one request; returns the body offset and length via out parameters
+static bool read_request(int fd, size_t* body_offset, size_t* body_length) {
+    size_t received = 0;
+    size_t header_end = 0;
+    size_t content_length = 0;
+
+    while (received < sizeof(request)) {
+        ssize_t n = recv(fd, request + received, sizeof(request) - received, 0);
+        if (n <= 0) return false;
+        received += (size_t)n;
+
+        if (header_end == 0) {
+            for (size_t i = 3; i < received; i++) {
+                if (memcmp(request + i - 3, "\r\n\r\n", 4) == 0) {
+                    header_end = i + 1;
+                    break;
+                }
+            }
+            if (header_end == 0) continue;
+
+            const char* line = (const char*)request;
+            while (line < (const char*)request + header_end) {
+                if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                    content_length = strtoul(line + 15, NULL, 10);
+                }
+                const char* next = memchr(line, '\n', (size_t)((const char*)request + header_end - line));
+                if (next == NULL) break;
+                line = next + 1;
+            }
+        }
+
+        if (header_end > 0 && received >= header_end + content_length) {
+            *body_offset = header_end;
+            *body_length = content_length;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    int port = argc > 1 ? atoi(argv[1]) : 8080;
+    int max_batches = argc > 2 ? atoi(argv[2]) : 0;
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(server, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(server, 8) < 0) {
+        perror("[RECEIVER] bind/listen");
+        return 1;
+    }
+    printf("[RECEIVER] Listening on 127.0.0.1:%d\n", port);
+    fflush(stdout);
+
+    static TelemetryBatch batch;
+    uint64_t total_samples = 0;
+    uint64_t total_bytes = 0;
+
+    for (int batches = 0; max_batches == 0 || batches < max_batches; ) {
+        int client = accept(server, NULL, NULL);
+        if (client < 0) continue;
+
+        size_t offset = 0;
+        size_t length = 0;
+        if (!read_request(client, &offset, &length)) {
+            respond(client, "400 Bad Request");
+            close(client);
+            continue;
+        }
+
+        size_t encoded_len = telemetry_decompress(request + offset, length, encoded, sizeof(encoded));
+        if (encoded_len == 0 || !telemetry_decode_batch(encoded, encoded_len, &batch)) {
+            printf("[RECEIVER] Rejected malformed batch (%zu bytes)\n", length);
+            respond(client, "422 Unprocessable Entity");
+            close(client);
+            continue;
+        }
+        respond(client, "204 No Content");
+        close(client);
+
+        batches++;
+        total_samples += batch.sample_count;
+        total_bytes += length;
+        if (batch.sample_count == 0) {
+            // The decoder refuses these; never index before the columns
+            printf("[RECEIVER] Batch %d: empty\n", batches);
+            fflush(stdout);
+            continue;
+        }
+        int last = batch.sample_count - 1;
+        printf("[RECEIVER] Batch %d: %u samples, %zu bytes (%zu encoded), %.2f bytes/sample\n",
+               batches, batch.sample_count, length, encoded_len,
+               (double)length / batch.sample_count);
+        printf("[RECEIVER]   last sample t=%d ms rpm=%d coolant=%.1f°C lat=%.7f lon=%.7f\n",
+               batch.columns[TLM_CH_TIMESTAMP_MS][last],
+               batch.columns[TLM_CH_ENGINE_RPM][last],
+               batch.columns[TLM_CH_COOLANT_TEMP][last] / 10.0,
+               batch.columns[TLM_CH_LATITUDE][last] / 1e7,
+               batch.columns[TLM_CH_LONGITUDE][last] / 1e7);
+        printf("[RECEIVER]   running total: %llu samples, %.2f bytes/sample\n",
+               (unsigned long long)total_samples, (double)total_bytes / (double)total_samples);
+        fflush(stdout);
+    }
+
+    close(server);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef TOOL_UTIL_H
+#define TOOL_UTIL_H
+
+// Helpers shared by the benches and check tools in tools/. Each tool is a
+// single translation unit, so everything here is static inline.
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static inline double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Module chatter goes to /dev/null between quiet_begin and quiet_end, so it
+// neither floods the report nor lands inside a timed region. Not nestable.
+static int quiet_saved_stdout = -1;
+
+static inline void quiet_begin(void) {
+    fflush(stdout);
+    quiet_saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+}
+
+static inline void quiet_end(void) {
+    fflush(stdout);
+    dup2(quiet_saved_stdout, STDOUT_FILENO);
+    close(quiet_saved_stdout);
+}
+
+// Check harness: each expect prints one result line and counts failures;
+// check_report prints the verdict and tells whether to go on to the bench
+static int check_failures = 0;
+
+static inline void expect(const char* name, bool ok) {
+    printf("  %-64s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok) check_failures++;
+}
+
+static inline bool check_report(const char* what) {
+    printf("%s check %s\n", what, check_failures == 0 ? "PASSED" : "FAILED");
+    return check_failures == 0;
+}
+
+#endif // TOOL_UTIL_H
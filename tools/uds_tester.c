@@ -0,0 +1,267 @@
+// Local service-tool stand-in for the UDS server (src/diagnostics/uds.c),
+// talking ISO-TP over the loopback CAN bus in the same process.
+//
+// The check runs session control, ReadDataByIdentifier, ReadDTCInformation
+// (count, list, freeze frame) and a full RequestUpload / TransferData /
+// RequestTransferExit of a test buffer, compares the bytes, and checks the
+// negative responses for the usual tester mistakes. The benchmark uploads
+// the buffer with several receiver block size / STmin settings and reports
+// in-process throughput and the time the same frames take on a 500 kbit/s
+// bus.
+//
+// Usage: uds_tester [--check] [upload KB]
+
+#include "canbus/canbus.h"
+#include "canbus/isotp.h"
+#include "diagnostics/diagnostics.h"
+#include "diagnostics/uds.h"
+#include "engine/engine_control.h"
+#include "tool_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define TEST_REGION_ADDRESS  0x20000000
+#define REPLY_TIMEOUT_NS     2000000000.0
+#define BUS_BITRATE          500000.0
+#define FRAME_BITS           120.0      // 11-bit ID, 8 data bytes, typical bit stuffing
+
+static IsoTpLink tester;
+static uint8_t reply[ISOTP_MAX_PAYLOAD];
+static uint32_t reply_length;
+static bool replied;
+
+static void on_reply(IsoTpLink* link, const uint8_t* data, uint32_t length, void* context) {
+    (void)link;
+    (void)context;
+    memcpy(reply, data, length);
+    reply_length = length;
+    replied = true;
+}
+
+// Send a request and run the bus until the response is complete
+static bool transact(const uint8_t* request, uint32_t length) {
+    replied = false;
+    if (!isotp_send(&tester, request, length)) return false;
+    double deadline = now_ns() + REPLY_TIMEOUT_NS;
+    while (!replied && now_ns() < deadline) {
+        canbus_dispatch(0);
+        isotp_poll(&tester);
+        uds_update();
+    }
+    return replied;
+}
+
+static bool expect_negative(uint8_t sid, uint8_t nrc) {
+    return reply_length == 3 && reply[0] == UDS_NEGATIVE_RESPONSE && reply[1] == sid && reply[2] == nrc;
+}
+
+static void start_tester(uint8_t block_size, uint8_t st_min) {
+    isotp_init(&tester, UDS_REQUEST_ID, UDS_RESPONSE_ID, block_size, st_min, on_reply, NULL);
+}
+
+// Upload [address, address + size) into out; false on any protocol error
+static bool upload(uint32_t address, uint32_t size, uint8_t* out) {
+    uint8_t request[11] = { UDS_SID_REQUEST_UPLOAD, 0x00, 0x44,
+                            (uint8_t)(address >> 24), (uint8_t)(address >> 16),
+                            (uint8_t)(address >> 8), (uint8_t)address,
+                            (uint8_t)(size >> 24), (uint8_t)(size >> 16),
+                            (uint8_t)(size >> 8), (uint8_t)size };
+    if (!transact(request, sizeof(request)) || reply_length != 4 ||
+        reply[0] != UDS_POSITIVE(UDS_SID_REQUEST_UPLOAD)) {
+        return false;
+    }
+    uint32_t max_block = (uint32_t)reply[2] << 8 | reply[3];
+    if (max_block <= 2) return false;
+
+    uint32_t received = 0;
+    uint8_t counter = 1;
+    while (received < size) {
+        uint8_t transfer[2] = { UDS_SID_TRANSFER_DATA, counter };
+        if (!transact(transfer, sizeof(transfer)) || reply_length < 3 || reply_length > max_block ||
+            reply[0] != UDS_POSITIVE(UDS_SID_TRANSFER_DATA) || reply[1] != counter ||
+            received + (reply_length - 2) > size) {
+            return false;
+        }
+        memcpy(out + received, reply + 2, reply_length - 2);
+        received += reply_length - 2;
+        counter++;
+    }
+    uint8_t exit_request[1] = { UDS_SID_TRANSFER_EXIT };
+    return transact(exit_request, 1) && reply_length == 1 && reply[0] == UDS_POSITIVE(UDS_SID_TRANSFER_EXIT);
+}
+
+static void run_checks(const uint8_t* region, uint32_t size) {
+    const DiagnosticsState* diag = diagnostics_get_state();
+    uint8_t* copy = malloc(size);
+
+    uint8_t upload_default[11] = { UDS_SID_REQUEST_UPLOAD, 0x00, 0x44, 0x20, 0, 0, 0, 0, 0, 0x10, 0 };
+    expect("RequestUpload refused in default session",
+           transact(upload_default, sizeof(upload_default)) &&
+           expect_negative(UDS_SID_REQUEST_UPLOAD, UDS_NRC_NOT_IN_ACTIVE_SESSION));
+
+    uint8_t extended[2] = { UDS_SID_SESSION_CONTROL, UDS_SESSION_EXTENDED };
+    expect("DiagnosticSessionControl extended",
+           transact(extended, 2) && reply_length == 6 &&
+           reply[0] == UDS_POSITIVE(UDS_SID_SESSION_CONTROL) && reply[1] == UDS_SESSION_EXTENDED);
+
+    uint8_t unknown_service[1] = { 0x31 };
+    expect("Unsupported service",
+           transact(unknown_service, 1) && expect_negative(0x31, UDS_NRC_SERVICE_NOT_SUPPORTED));
+
+    // VIN (17 bytes) makes a multi-frame response; engine speed follows
+    uint8_t rdbi[5] = { UDS_SID_READ_DATA_BY_ID, 0xF1, 0x90, 0x01, 0x00 };
+    expect("ReadDataByIdentifier VIN + engine speed",
+           transact(rdbi, sizeof(rdbi)) && reply_length == 1 + 2 + 17 + 2 + 2 &&
+           reply[0] == UDS_POSITIVE(UDS_SID_READ_DATA_BY_ID) &&
+           memcmp(reply + 3, "TRACTORECU0000001", 17) == 0 &&
+           reply[20] == 0x01 && reply[21] == 0x00 &&
+           (reply[22] << 8 | reply[23]) == engine_get_state()->current_rpm);
+
+    uint8_t bad_did[3] = { UDS_SID_READ_DATA_BY_ID, 0x12, 0x34 };
+    expect("Unknown data identifier",
+           transact(bad_did, 3) && expect_negative(UDS_SID_READ_DATA_BY_ID, UDS_NRC_REQUEST_OUT_OF_RANGE));
+
+    uint8_t count[3] = { UDS_SID_READ_DTC, UDS_DTC_COUNT_BY_MASK, UDS_DTC_TEST_FAILED };
+    int active = 0;
+    for (int i = 0; i < diag->fault_count; i++) active += diag->faults[i].active;
+    expect("ReadDTCInformation count of active DTCs",
+           transact(count, 3) && reply_length == 6 && reply[3] == UDS_DTC_FORMAT_J1939 &&
+           (reply[4] << 8 | reply[5]) == active);
+
+    uint8_t list[3] = { UDS_SID_READ_DTC, UDS_DTC_BY_MASK, UDS_DTC_CONFIRMED };
+    bool listed = transact(list, 3) && reply_length == 3u + 4u * diag->fault_count;
+    for (int i = 0; listed && i < diag->fault_count; i++) {
+        uint8_t dtc[3];
+        uds_encode_dtc(dtc, diag->faults[i].spn, diag->faults[i].fmi);
+        listed = memcmp(reply + 3 + 4 * i, dtc, 3) == 0 &&
+                 reply[6 + 4 * i] == (diag->faults[i].active ? 0x09 : 0x08);
+    }
+    expect("ReadDTCInformation fault history", listed);
+
+    // Freeze frame of the first fault: engine speed was 1800 rpm when it was recorded
+    uint8_t snapshot[6] = { UDS_SID_READ_DTC, UDS_DTC_SNAPSHOT_BY_DTC, 0, 0, 0, 0x01 };
+    uds_encode_dtc(snapshot + 2, diag->faults[0].spn, diag->faults[0].fmi);
+    expect("ReadDTCInformation freeze frame",
+           transact(snapshot, sizeof(snapshot)) && reply_length > 12 &&
+           reply[6] == 0x01 && reply[8] == 0x01 && reply[9] == 0x00 &&
+           (reply[10] << 8 | reply[11]) == 1800);
+
+    uint8_t early_transfer[2] = { UDS_SID_TRANSFER_DATA, 1 };
+    expect("TransferData without RequestUpload",
+           transact(early_transfer, 2) && expect_negative(UDS_SID_TRANSFER_DATA, UDS_NRC_REQUEST_SEQUENCE_ERROR));
+
+    memset(copy, 0, size);
+    expect("Upload of the test buffer", upload(TEST_REGION_ADDRESS, size, copy) &&
+           memcmp(copy, region, size) == 0);
+
+    // Start another upload and skip a block counter
+    uint8_t start[11] = { UDS_SID_REQUEST_UPLOAD, 0x00, 0x44, 0x20, 0, 0, 0, 0, 0, 0x40, 0 };
+    uint8_t skipped[2] = { UDS_SID_TRANSFER_DATA, 2 };
+    uint8_t repeat[2] = { UDS_SID_TRANSFER_DATA, 1 };
+    bool started = transact(start, sizeof(start));
+    expect("TransferData with a skipped counter",
+           started && transact(skipped, 2) &&
+           expect_negative(UDS_SID_TRANSFER_DATA, UDS_NRC_WRONG_BLOCK_COUNTER));
+    transact(repeat, 2);
+    uint8_t first[ISOTP_MAX_PAYLOAD];
+    uint32_t first_length = reply_length;
+    memcpy(first, reply, reply_length);
+    expect("TransferData repeat resends the block",
+           transact(repeat, 2) && reply_length == first_length && memcmp(reply, first, first_length) == 0);
+    uint8_t exit_early[1] = { UDS_SID_TRANSFER_EXIT };
+    expect("RequestTransferExit before the end",
+           transact(exit_early, 1) && expect_negative(UDS_SID_TRANSFER_EXIT, UDS_NRC_REQUEST_SEQUENCE_ERROR));
+    uint8_t back_to_default[2] = { UDS_SID_SESSION_CONTROL, UDS_SESSION_DEFAULT };
+    expect("Default session ends the upload",
+           transact(back_to_default, 2) && transact(early_transfer, 2) &&
+           expect_negative(UDS_SID_TRANSFER_DATA, UDS_NRC_REQUEST_SEQUENCE_ERROR));
+
+    free(copy);
+}
+
+static void bench(const uint8_t* region, uint32_t size) {
+    static const struct { uint8_t block_size; uint8_t st_min; uint32_t divisor; } settings[] = {
+        { 0, 0x00, 1 }, { 32, 0x00, 1 }, { 8, 0x00, 1 }, { 2, 0x00, 1 }, { 0, 0xF5, 16 }, { 0, 0x01, 64 },
+    };
+    uint8_t* copy = malloc(size);
+    uint8_t extended[2] = { UDS_SID_SESSION_CONTROL, UDS_SESSION_EXTENDED };
+
+    printf("\nUpload throughput (tester flow control; bus time at %.0f kbit/s):\n", BUS_BITRATE / 1000.0);
+    printf("  %-6s %-6s %9s %9s %11s %11s %11s\n", "BS", "STmin", "KB", "Frames",
+           "In-proc MB/s", "Bus s", "Bus KB/s");
+    for (size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); i++) {
+        uint32_t bytes = size / settings[i].divisor;
+        start_tester(settings[i].block_size, settings[i].st_min);
+        transact(extended, 2);
+        IsoTpStats server_before = uds_get_state()->link.stats;
+
+        double start = now_ns();
+        bool ok = upload(TEST_REGION_ADDRESS, bytes, copy) && memcmp(copy, region, bytes) == 0;
+        double seconds = (now_ns() - start) / 1e9;
+        if (!ok) {
+            printf("  %-6u 0x%02X   upload FAILED\n", settings[i].block_size, settings[i].st_min);
+            check_failures++;
+            continue;
+        }
+
+        // Every frame costs one frame time; consecutive frames are held
+        // apart by STmin when that is longer
+        const IsoTpStats* server = &uds_get_state()->link.stats;
+        uint32_t server_frames = server->frames_sent - server_before.frames_sent;
+        uint32_t consecutive = server_frames - (server->messages_sent - server_before.messages_sent);
+        uint32_t frames = server_frames + tester.stats.frames_sent;
+        double frame_s = FRAME_BITS / BUS_BITRATE;
+        double gap_s = isotp_st_min_us(settings[i].st_min) / 1e6;
+        double bus_s = frames * frame_s + consecutive * (gap_s > frame_s ? gap_s - frame_s : 0.0);
+        printf("  %-6u 0x%02X   %9.0f %9u %11.3f %11.2f %11.1f\n", settings[i].block_size,
+               settings[i].st_min, bytes / 1024.0, frames, bytes / seconds / 1e6, bus_s,
+               bytes / bus_s / 1024.0);
+    }
+    free(copy);
+}
+
+int main(int argc, char* argv[]) {
+    bool check_only = false;
+    long kilobytes = 1024;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if (argv[i][0] != '-') {
+            kilobytes = strtol(argv[i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--check] [upload KB]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (kilobytes < 64) kilobytes = 64;
+    uint32_t size = (uint32_t)kilobytes * 1024u;
+
+    canbus_init();
+    diagnostics_init();
+    uds_init(0, 0);
+    uint8_t* region = malloc(size);
+    for (uint32_t i = 0; i < size; i++) {
+        region[i] = (uint8_t)(i * 2654435761u >> 24);
+    }
+    uds_add_region(TEST_REGION_ADDRESS, region, size, "test buffer");
+
+    // Two faults with freeze frames; the second one is cleared again
+    engine_get_state()->current_rpm = 1800;
+    diagnostics_report_fault(FAULT_ENGINE_COOLANT_HIGH);
+    uds_update();
+    engine_get_state()->current_rpm = 900;
+    diagnostics_report_fault(FAULT_HYDRAULIC_PRESSURE_LOW);
+    uds_update();
+    diagnostics_clear_fault(SPN_HYDRAULIC_PRESSURE, FMI_DATA_BELOW_NORMAL);
+
+    printf("\nUDS checks over the loopback bus:\n");
+    start_tester(0, 0);
+    run_checks(region, size);
+    if (check_report("UDS") && !check_only) {
+        bench(region, size);
+    }
+    free(region);
+    return check_failures == 0 ? 0 : 1;
+}